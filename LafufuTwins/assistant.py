@@ -10,6 +10,8 @@ import ollama
 import pyttsx3
 import speech_recognition as sr
 
+import intents
+
 
 class VirtualAssistant:
     """Virtual Assistant that listens, processes, and responds using Ollama"""
@@ -25,6 +27,8 @@ class VirtualAssistant:
         self.recognizer = sr.Recognizer()
         self.tts_engine = pyttsx3.init()
         self.conversation_history = []
+        # Commands and canned questions are answered locally, without the LLM
+        self.intents = intents.IntentRouter()
 
         # Configure TTS engine
         self.tts_engine.setProperty("rate", 150)  # Speed of speech
@@ -114,29 +118,44 @@ class VirtualAssistant:
             print(f"❌ {error_msg}")
             return "I'm sorry, something went wrong."
 
-    def process_command(self, text: str) -> bool:
+    def process_command(self, text: str) -> Optional[bool]:
         """
-        Process special commands
+        Answer commands and canned questions locally
 
         Args:
             text: The command text
 
         Returns:
-            True if should continue, False if should exit
+            None if no local intent matched (ask the LLM),
+            True if answered, False if should exit
         """
-        text_lower = text.lower()
+        match = self.intents.route(text)
+        if match is None:
+            return None
 
-        # Exit commands
-        if any(cmd in text_lower for cmd in ["exit", "quit", "goodbye", "bye"]):
+        if match.name == intents.EXIT:
             self.speak("Goodbye! Have a great day!")
             return False
 
-        # Clear history command
-        if "clear history" in text_lower or "reset conversation" in text_lower:
+        if match.name == intents.CLEAR_HISTORY:
             self.conversation_history = []
             self.speak("Conversation history cleared.")
-            return True
-
+        elif match.name == intents.TIME:
+            self.speak(intents.time_reply())
+        elif match.name == intents.DATE:
+            self.speak(intents.date_reply())
+        elif match.name in (intents.VOLUME_UP, intents.VOLUME_DOWN, intents.VOLUME_SET):
+            volume = self.tts_engine.getProperty("volume")
+            if match.name == intents.VOLUME_SET:
+                volume = match.numbers[0] / 100.0
+            else:
+                volume += 0.1 if match.name == intents.VOLUME_UP else -0.1
+            self.tts_engine.setProperty("volume", min(1.0, max(0.1, volume)))
+            self.speak(f"Volume set to {round(self.tts_engine.getProperty('volume') * 100)} percent.")
+        elif match.name == intents.NOD:
+            self.speak("I would nod, but I don't have a head here.")
+        else:
+            self.speak(match.intent.reply or "Okay.")
         return True
 
     def run(self):
@@ -152,8 +171,11 @@ class VirtualAssistant:
                     continue
 
                 # Process special commands
-                if not self.process_command(user_input):
+                handled = self.process_command(user_input)
+                if handled is False:
                     break
+                if handled:
+                    continue
 
                 # Get response from Ollama
                 response = self.get_ollama_response(user_input)
@@ -169,6 +191,8 @@ class VirtualAssistant:
                 print(f"❌ Error in main loop: {e}")
                 continue
 
+        print(f"📊 {self.intents.summary()}")
+
 
 def test_microphone():
     """Test if microphone is working"""
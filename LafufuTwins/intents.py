@@ -0,0 +1,333 @@
+"""
+Local Intent Matching
+Answers simple commands without a round trip to the LLM
+"""
+
+import argparse
+import datetime
+import itertools
+import json
+import re
+import time
+from collections import deque
+from dataclasses import dataclass, field
+from typing import Dict, Iterable, List, Optional, Tuple
+
+# A transcript matches an intent when one of the intent's phrases covers it
+# completely, apart from these politeness / address words.
+FILLER_WORDS = frozenset(
+    "please hey hi ok okay so well um uh now just can could would will you me for "
+    "robot lafufu assistant percent".split()
+)
+
+NUMBER_TOKEN = "#"  # numbers in a transcript (digits or words) become this token
+
+_ONES = {
+    "zero": 0, "one": 1, "two": 2, "three": 3, "four": 4, "five": 5, "six": 6,
+    "seven": 7, "eight": 8, "nine": 9, "ten": 10, "eleven": 11, "twelve": 12,
+    "thirteen": 13, "fourteen": 14, "fifteen": 15, "sixteen": 16,
+    "seventeen": 17, "eighteen": 18, "nineteen": 19, "twice": 2,
+}
+_TENS = {
+    "twenty": 20, "thirty": 30, "forty": 40, "fifty": 50,
+    "sixty": 60, "seventy": 70, "eighty": 80, "ninety": 90,
+}
+
+
+# Intent names. Callers dispatch on these.
+EXIT = "exit"
+CLEAR_HISTORY = "clear_history"
+TIME = "time"
+DATE = "date"
+VOLUME_UP = "volume_up"
+VOLUME_DOWN = "volume_down"
+VOLUME_SET = "volume_set"
+NOD = "nod"
+CANNED = "canned"
+
+
+@dataclass(frozen=True)
+class Intent:
+    """
+    A named set of phrase templates
+
+    Templates are words plus `(a|b)` alternatives, `[optional words]` and
+    `#` for a number, e.g. "set [the] volume to #".
+    Canned answers are intents named CANNED with a `reply`.
+    """
+
+    name: str
+    phrases: Tuple[str, ...]
+    reply: Optional[str] = None
+
+
+@dataclass(frozen=True)
+class IntentMatch:
+    intent: Intent
+    phrase: str  # the expanded phrase that matched
+    numbers: Tuple[int, ...] = ()
+
+    @property
+    def name(self) -> str:
+        return self.intent.name
+
+
+DEFAULT_INTENTS: Tuple[Intent, ...] = (
+    Intent(EXIT, ("exit", "quit", "[good] bye [bye]", "goodbye", "see you later", "stop listening")),
+    Intent(CLEAR_HISTORY, (
+        "(clear|reset|forget) [the|our] (history|conversation)",
+        "start over",
+        "forget everything",
+    )),
+    Intent(TIME, (
+        "what time is it [now]",
+        "(whats|what is) the time [now]",
+        "tell me the time",
+        "do you know the time",
+        "time",
+    )),
+    Intent(DATE, (
+        "what (day|date) is it [today]",
+        "(whats|what is) [the] (date|day) [today]",
+        "(whats|what is) todays date",
+        "what day is today",
+        "tell me the date",
+    )),
+    Intent(VOLUME_UP, (
+        "[turn] [the] volume up", "turn it up", "louder", "speak (up|louder)",
+        "(increase|raise) [the] volume",
+    )),
+    Intent(VOLUME_DOWN, (
+        "[turn] [the] volume down", "turn it down", "quieter", "speak (softer|quieter)",
+        "(decrease|lower) [the] volume",
+    )),
+    Intent(VOLUME_SET, ("set [the] volume to #", "volume [to] #", "turn [the] volume to #")),
+    Intent(NOD, ("nod [your head]", "nod [your head] # [times]", "(say|show me a) yes")),
+    Intent(CANNED, ("who are you", "(whats|what is) your name", "introduce yourself"),
+           reply="I'm Lafufu, a small robot who loves talking about computer graphics."),
+    Intent(CANNED, ("how are you [doing] [today]",),
+           reply="I'm doing great, thanks for asking!"),
+    Intent(CANNED, ("what can you do", "help"),
+           reply="You can ask me anything. I can also tell the time and date, change the volume, or nod my head."),
+    Intent(CANNED, ("thank you", "thanks"), reply="You're welcome!"),
+)
+
+
+# Normalization ----------------------------------------------------------------
+
+
+def normalize(text: str) -> Tuple[List[str], List[int]]:
+    """
+    Lower-case words without punctuation; numbers become NUMBER_TOKEN
+
+    Returns:
+        (tokens, numbers): the numbers' values in order of appearance
+    """
+    words = re.sub(r"[^a-z0-9#\s]", " ", text.lower().replace("'", "").replace("’", "")).split()
+    tokens: List[str] = []
+    numbers: List[int] = []
+    for word in words:
+        value = int(word) if word.isdigit() else _ONES.get(word, _TENS.get(word))
+        if value is None:
+            if word == "hundred" and tokens and tokens[-1] == NUMBER_TOKEN:
+                numbers[-1] *= 100
+                continue
+            tokens.append(word)
+            continue
+        if tokens and tokens[-1] == NUMBER_TOKEN and numbers[-1] % 10 == 0 and numbers[-1] >= 20 and value < 10:
+            numbers[-1] += value  # "twenty five"
+            continue
+        tokens.append(NUMBER_TOKEN)
+        numbers.append(value)
+    return tokens, numbers
+
+
+def expand(template: str) -> List[Tuple[str, ...]]:
+    """All token sequences a phrase template stands for."""
+    choices: List[List[Tuple[str, ...]]] = []
+    for group, optional, word in re.findall(r"\(([^)]*)\)|\[([^\]]*)\]|([^\s()\[\]]+)", template):
+        if word:
+            choices.append([tuple(normalize(word)[0])])
+        else:
+            alternatives = [tuple(normalize(a)[0]) for a in (group or optional).split("|")]
+            choices.append(alternatives + ([()] if optional else []))
+    return [tuple(itertools.chain.from_iterable(combo)) for combo in itertools.product(*choices)]
+
+
+# Aho-Corasick over tokens -------------------------------------------------------
+
+
+class IntentMatcher:
+    """
+    Compiled matcher for a set of intents
+
+    All phrases are expanded and compiled into one Aho-Corasick automaton
+    over words, so a transcript is scanned once regardless of how many
+    phrases there are. A match counts only if the phrase covers the whole
+    transcript except FILLER_WORDS; the longest such phrase wins (earlier
+    intents win ties).
+    """
+
+    def __init__(self, intents: Iterable[Intent] = DEFAULT_INTENTS) -> None:
+        self.intents = tuple(intents)
+        # Pattern id -> (intent index, tokens)
+        self.patterns: List[Tuple[int, Tuple[str, ...]]] = []
+        seen = set()
+        for index, intent in enumerate(self.intents):
+            for template in intent.phrases:
+                for tokens in expand(template):
+                    if tokens and tokens not in seen:
+                        seen.add(tokens)
+                        self.patterns.append((index, tokens))
+        self._compile()
+
+    def _compile(self) -> None:
+        goto: List[Dict[str, int]] = [{}]
+        out: List[List[int]] = [[]]
+        for pid, (_, tokens) in enumerate(self.patterns):
+            state = 0
+            for token in tokens:
+                nxt = goto[state].get(token)
+                if nxt is None:
+                    nxt = goto[state][token] = len(goto)
+                    goto.append({})
+                    out.append([])
+                state = nxt
+            out[state].append(pid)
+
+        fail = [0] * len(goto)
+        queue = deque(goto[0].values())
+        while queue:
+            state = queue.popleft()
+            for token, nxt in goto[state].items():
+                queue.append(nxt)
+                f = fail[state]
+                while f and token not in goto[f]:
+                    f = fail[f]
+                fail[nxt] = goto[f].get(token, 0)
+                out[nxt].extend(out[fail[nxt]])
+
+        self._goto = goto
+        self._fail = fail
+        self._out = [tuple(o) for o in out]
+
+    def scan(self, tokens: List[str]) -> Iterable[Tuple[int, int, int]]:
+        """Yield `(start, end, pattern id)` for every phrase occurring in `tokens`."""
+        goto, fail, out, patterns = self._goto, self._fail, self._out, self.patterns
+        state = 0
+        for i, token in enumerate(tokens):
+            while state and token not in goto[state]:
+                state = fail[state]
+            state = goto[state].get(token, 0)
+            for pid in out[state]:
+                yield i + 1 - len(patterns[pid][1]), i + 1, pid
+
+    def match(self, text: str) -> Optional[IntentMatch]:
+        tokens, numbers = normalize(text)
+        if not tokens:
+            return None
+        best = None
+        for start, end, pid in self.scan(tokens):
+            if not all(t in FILLER_WORDS for t in itertools.chain(tokens[:start], tokens[end:])):
+                continue
+            index, phrase = self.patterns[pid]
+            key = (end - start, -index)
+            if best is None or key > best[0]:
+                best = (key, start, end, pid)
+        if best is None:
+            return None
+        _, start, end, pid = best
+        index, phrase = self.patterns[pid]
+        first = tokens[:start].count(NUMBER_TOKEN)
+        return IntentMatch(
+            intent=self.intents[index],
+            phrase=" ".join(phrase),
+            numbers=tuple(numbers[first:first + phrase.count(NUMBER_TOKEN)]),
+        )
+
+
+@dataclass
+class IntentRouter:
+    """
+    Matches each transcript and counts how many turns were served locally
+    """
+
+    matcher: IntentMatcher = field(default_factory=IntentMatcher)
+    turns: int = 0
+    counts: Dict[str, int] = field(default_factory=dict)
+
+    def route(self, text: str) -> Optional[IntentMatch]:
+        """
+        Args:
+            text: The transcript
+
+        Returns:
+            The matched intent, or None if the LLM should answer
+        """
+        match = self.matcher.match(text)
+        self.turns += 1
+        name = match.name if match is not None else "llm"
+        self.counts[name] = self.counts.get(name, 0) + 1
+        return match
+
+    @property
+    def local_share(self) -> float:
+        if not self.turns:
+            return 0.0
+        return 1.0 - self.counts.get("llm", 0) / self.turns
+
+    def summary(self) -> str:
+        detail = ", ".join(f"{name} {n}" for name, n in sorted(self.counts.items()))
+        return f"{self.local_share:.0%} of {self.turns} turns answered locally ({detail})"
+
+
+# Replies shared by the assistants ------------------------------------------------
+
+
+def time_reply(now: Optional[datetime.datetime] = None) -> str:
+    now = now or datetime.datetime.now()
+    return f"It's {now.strftime('%I:%M %p').lstrip('0')}."
+
+
+def date_reply(now: Optional[datetime.datetime] = None) -> str:
+    now = now or datetime.datetime.now()
+    return f"Today is {now.strftime('%A, %B')} {now.day}, {now.year}."
+
+
+def static_replies(intents: Iterable[Intent] = DEFAULT_INTENTS) -> List[str]:
+    """Replies that never change (worth keeping in a TTS cache)."""
+    return [intent.reply for intent in intents if intent.reply]
+
+
+def load_canned(path: str) -> List[Intent]:
+    """
+    Load extra canned answers from JSON
+
+    Expected format: [{"ask": ["who made you", ...], "say": "..."}, ...]
+    """
+    with open(path, "r", encoding="utf-8") as f:
+        raw = json.load(f)
+    if not isinstance(raw, list):
+        raise ValueError("Canned answers JSON must be a list")
+    return [Intent(CANNED, tuple(entry["ask"]), reply=entry["say"]) for entry in raw]
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Match transcripts against the local intents.")
+    parser.add_argument("text", nargs="+", help="Transcripts to match")
+    parser.add_argument("--repeat", type=int, default=10000, help="Matches per transcript for timing (default: %(default)s)")
+    args = parser.parse_args()
+
+    matcher = IntentMatcher()
+    print(f"{len(matcher.patterns)} phrases compiled")
+    for text in args.text:
+        started = time.perf_counter()
+        for _ in range(args.repeat):
+            match = matcher.match(text)
+        per_call_us = (time.perf_counter() - started) / args.repeat * 1e6
+        found = f"{match.name} ({match.phrase!r}, numbers={list(match.numbers)})" if match else "LLM"
+        print(f"{text!r:40} -> {found}  [{per_call_us:.1f} us]")
+
+
+if __name__ == "__main__":
+    main()
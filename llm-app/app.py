@@ -20,11 +20,21 @@ Where `history.json` looks like:
 
 import argparse
 import json
+import logging
+import os
 from dataclasses import dataclass
+from logging import DEBUG
 from typing import Generator, List, Literal, TypedDict
 
 import requests
 
+try:  # asynchronous ring-buffer logger when the repo root is on sys.path
+    from telemetry.ringlog import get_logger
+except ImportError:  # standalone: stdlib logging
+    from logging import getLogger as get_logger
+
+log = get_logger("llm")
+
 
 Role = Literal["user", "assistant", "system"]
 
@@ -117,9 +127,10 @@ class OllamaClient:
             "stream": True,
         }
 
-        # Debug: print the exact JSON payload we send to the LLM
-        print("Payload to Ollama:")
-        print(json.dumps(payload, indent=2, ensure_ascii=False))
+        # Debug: the exact JSON payload we send to the LLM (LOG_LEVEL=DEBUG).
+        # Checked here so the dump is not even built otherwise.
+        if log.isEnabledFor(DEBUG):
+            log.debug("Payload to Ollama:\n%s", json.dumps(payload, indent=2, ensure_ascii=False))
 
         with requests.post(url, json=payload, stream=True, timeout=120) as response:
             response.raise_for_status()
@@ -193,6 +204,8 @@ def parse_args() -> argparse.Namespace:
 
 def main() -> None:
     args = parse_args()
+    # Only used when the stdlib logger is the fallback; LOG_LEVEL=DEBUG shows payloads.
+    logging.basicConfig(level=os.environ.get("LOG_LEVEL", "INFO").upper(), format="[%(name)s] %(message)s")
 
     history: List[Message] | None = None
     if args.history:
@@ -0,0 +1,411 @@
+#!/usr/bin/env python3
+"""Stand-in LLM server for tests and benchmarks (no model, no GPU).
+
+Speaks the two APIs the clients in `app.py` use:
+- Ollama `POST /api/chat`: NDJSON chunks, or one JSON object with "stream": false
+- llama-server / OpenAI `POST /v1/chat/completions`: SSE `data:` chunks ending
+  in `data: [DONE]`, or one JSON object with "stream": false
+
+Replies come from one of three sources:
+- echo (default): "You said: <prompt>"
+- `--script replies.json`: {"default": "...", "rules": [{"match": "<regex>",
+  "reply": "...", "profile": {...overrides}}]}, first matching rule wins
+- `--recorded session.tcol`: the replies of a session recorded with
+  `main.py --record`, streamed with their recorded token timing
+
+Timing follows a `LatencyProfile`: time to first token, tokens/s, uniform
+jitter per token, an optional `<think>` prefix, and injected faults
+(HTTP 500, one stall, connection dropped mid-stream). Every request draws
+from its own RNG seeded with `--seed` and the request number, and tokens
+are written against absolute deadlines, so a run is reproducible to within
+scheduler noise.
+
+A request's `max_tokens` (OpenAI) or `options.num_predict` (Ollama) cuts
+the reply to that many tokens.
+
+`GET /_stub/stats` returns counters; `POST /_stub/profile` with a JSON
+object changes profile fields at runtime (e.g. between benchmark phases).
+
+Usage:
+  python stub_server.py --port 8080 --profile gpu
+  python stub_server.py --port 11434 --profile pi-cpu --think-tokens 40
+  python stub_server.py --profile flaky --seed 7 --script replies.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import random
+import re
+import sys
+import threading
+import time
+from dataclasses import asdict, dataclass, fields, replace
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import Any
+
+
+@dataclass(frozen=True)
+class LatencyProfile:
+    ttft_ms: float = 250.0
+    tokens_per_s: float = 40.0  # 0 = all tokens at once
+    jitter_ms: float = 0.0  # each token is delayed by uniform(0, jitter_ms)
+    think_tokens: int = 0  # length of a `<think>...</think>` prefix
+    error_rate: float = 0.0  # probability of HTTP 500 instead of a reply
+    stall_rate: float = 0.0  # probability of one stall of `stall_ms` mid-reply
+    stall_ms: float = 0.0
+    drop_rate: float = 0.0  # probability of closing the connection mid-reply
+
+
+PROFILES: dict[str, LatencyProfile] = {
+    "instant": LatencyProfile(ttft_ms=0.0, tokens_per_s=0.0),
+    "gpu": LatencyProfile(ttft_ms=250.0, tokens_per_s=40.0, jitter_ms=5.0),
+    "pi-cpu": LatencyProfile(ttft_ms=2500.0, tokens_per_s=4.0, jitter_ms=60.0, think_tokens=40),
+    "flaky": LatencyProfile(ttft_ms=400.0, tokens_per_s=25.0, jitter_ms=20.0,
+                            error_rate=0.1, stall_rate=0.2, stall_ms=2000.0, drop_rate=0.05),
+}
+
+THINK_WORDS = ("hmm", "the", "user", "wants", "a", "short", "friendly", "answer", "so", "I", "should", "reply")
+
+_TOKEN_RE = re.compile(r"\s*\S+|\s+")
+
+
+def tokenize(text: str) -> list[str]:
+    """Split a reply into word-sized tokens, whitespace attached to the next word."""
+    return _TOKEN_RE.findall(text)
+
+
+@dataclass
+class ReplyPlan:
+    """What one request gets: tokens with their offsets from the request, and faults."""
+
+    tokens: list[tuple[float, str]]
+    error: bool = False
+    stall_at: int | None = None  # index of the first token delayed by the stall
+    drop_after: int | None = None  # close the connection after this many tokens
+
+
+def plan_reply(text: str, profile: LatencyProfile, rng: random.Random,
+               recorded: list[tuple[float, str]] | None = None) -> ReplyPlan:
+    """Schedule `text` under `profile`; `recorded` (offset, token) pairs replace the rate."""
+    if rng.random() < profile.error_rate:
+        return ReplyPlan(tokens=[], error=True)
+    if recorded is not None:
+        offsets = [offset for offset, _ in recorded]
+        words = [token for _, token in recorded]
+    else:
+        words = tokenize(text)
+        if profile.think_tokens:
+            think = [" " + rng.choice(THINK_WORDS) for _ in range(profile.think_tokens)]
+            words = ["<think>", *think, "</think>", "\n\n", *words]
+        interval = 1.0 / profile.tokens_per_s if profile.tokens_per_s > 0 else 0.0
+        offsets = [
+            profile.ttft_ms / 1000.0 + i * interval + rng.uniform(0.0, profile.jitter_ms) / 1000.0
+            for i in range(len(words))
+        ]
+    stall_at = None
+    if words and rng.random() < profile.stall_rate:
+        stall_at = rng.randrange(len(words))
+        offsets = offsets[:stall_at] + [t + profile.stall_ms / 1000.0 for t in offsets[stall_at:]]
+    # Jitter must not reorder tokens.
+    for i in range(1, len(offsets)):
+        offsets[i] = max(offsets[i], offsets[i - 1])
+    drop_after = rng.randrange(len(words)) if words and rng.random() < profile.drop_rate else None
+    return ReplyPlan(tokens=list(zip(offsets, words)), stall_at=stall_at, drop_after=drop_after)
+
+
+# Reply sources ----------------------------------------------------------------
+
+
+class EchoReplies:
+    def reply(self, prompt: str) -> tuple[str, dict[str, Any], list[tuple[float, str]] | None]:
+        return f"You said: {prompt}", {}, None
+
+
+class ScriptedReplies:
+    def __init__(self, path: str | Path) -> None:
+        script = json.loads(Path(path).read_text(encoding="utf-8"))
+        self.default = script.get("default", "OK.")
+        self.rules = [
+            (re.compile(rule["match"], re.IGNORECASE), rule["reply"], rule.get("profile", {}))
+            for rule in script.get("rules", [])
+        ]
+
+    def reply(self, prompt: str) -> tuple[str, dict[str, Any], list[tuple[float, str]] | None]:
+        for pattern, text, overrides in self.rules:
+            if pattern.search(prompt):
+                return text, overrides, None
+        return self.default, {}, None
+
+
+class RecordedReplies:
+    """Replies of a recorded session, matched by prompt, else replayed in order."""
+
+    def __init__(self, path: str | Path) -> None:
+        # Recordings are read with the repo-level `telemetry` package.
+        repo_root = Path(__file__).resolve().parents[1]
+        if str(repo_root) not in sys.path:
+            sys.path.append(str(repo_root))
+        from telemetry.session import SessionLog
+
+        log = SessionLog(path)
+        self.replies: list[tuple[str, list[tuple[float, str]]]] = []
+        for request in log.select("llm/request"):
+            tokens = [e for e in log.select("llm/token") if e.turn == request.turn and e.t >= request.t]
+            self.replies.append((request.meta["prompt"], [(e.t - request.t, e.meta["text"]) for e in tokens]))
+        if not self.replies:
+            raise ValueError(f"{path} contains no LLM requests")
+        self._next = 0
+        self._lock = threading.Lock()
+
+    def reply(self, prompt: str) -> tuple[str, dict[str, Any], list[tuple[float, str]] | None]:
+        for recorded_prompt, tokens in self.replies:
+            if recorded_prompt == prompt:
+                return "", {}, tokens
+        with self._lock:
+            _, tokens = self.replies[self._next % len(self.replies)]
+            self._next += 1
+        return "", {}, tokens
+
+
+# Server -------------------------------------------------------------------
+
+
+@dataclass
+class StubStats:
+    requests: int = 0
+    replies: int = 0
+    errors: int = 0
+    stalls: int = 0
+    drops: int = 0
+    tokens: int = 0
+
+
+class StubLlmServer:
+    """Threaded HTTP server; `start()` serves in the background, `url` is its base URL."""
+
+    def __init__(self, host: str = "127.0.0.1", port: int = 8080, profile: LatencyProfile = PROFILES["gpu"],
+                 replies: Any = None, seed: int = 0, model: str = "stub") -> None:
+        self.profile = profile
+        self.replies = replies if replies is not None else EchoReplies()
+        self.seed = seed
+        self.model = model
+        self.stats = StubStats()
+        self._lock = threading.Lock()
+        self._httpd = ThreadingHTTPServer((host, port), _make_handler(self))
+        self._httpd.daemon_threads = True
+        self._thread: threading.Thread | None = None
+
+    @property
+    def url(self) -> str:
+        host, port = self._httpd.server_address[:2]
+        return f"http://{host}:{port}"
+
+    def next_plan(self, prompt: str, max_tokens: int | None = None) -> ReplyPlan:
+        with self._lock:
+            self.stats.requests += 1
+            n = self.stats.requests
+            profile = self.profile
+        text, overrides, recorded = self.replies.reply(prompt)
+        if overrides:
+            profile = replace(profile, **overrides)
+        plan = plan_reply(text, profile, random.Random(f"{self.seed}/{n}"), recorded)
+        if max_tokens is not None and len(plan.tokens) > max_tokens:
+            plan = replace(plan, tokens=plan.tokens[:max(0, max_tokens)])
+        with self._lock:
+            if plan.error:
+                self.stats.errors += 1
+            if plan.drop_after is not None:
+                self.stats.drops += 1
+            if plan.stall_at is not None:
+                self.stats.stalls += 1
+        return plan
+
+    def count_reply(self, tokens: int, completed: bool) -> None:
+        with self._lock:
+            self.stats.tokens += tokens
+            if completed:
+                self.stats.replies += 1
+
+    def update_profile(self, overrides: dict[str, Any]) -> LatencyProfile:
+        known = {f.name for f in fields(LatencyProfile)}
+        unknown = set(overrides) - known
+        if unknown:
+            raise ValueError(f"Unknown profile fields: {sorted(unknown)}")
+        with self._lock:
+            self.profile = replace(self.profile, **overrides)
+            return self.profile
+
+    def start(self) -> "StubLlmServer":
+        self._thread = threading.Thread(target=self._httpd.serve_forever, args=(0.05,), name="stub-llm", daemon=True)
+        self._thread.start()
+        return self
+
+    def serve_forever(self) -> None:
+        self._httpd.serve_forever()
+
+    def stop(self) -> None:
+        self._httpd.shutdown()
+        self._httpd.server_close()
+        if self._thread is not None:
+            self._thread.join()
+
+
+def _make_handler(server: StubLlmServer) -> type[BaseHTTPRequestHandler]:
+    class Handler(BaseHTTPRequestHandler):
+        # HTTP/1.0: streamed bodies end when the connection closes, like a dropped stream.
+        protocol_version = "HTTP/1.0"
+
+        def log_message(self, format: str, *args: Any) -> None:  # noqa: A002
+            pass  # one line per request would dominate a benchmark's output
+
+        def _json(self, status: int, body: Any) -> None:
+            data = json.dumps(body).encode("utf-8")
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def do_GET(self) -> None:  # noqa: N802
+            if self.path == "/_stub/stats":
+                self._json(200, {**asdict(server.stats), "profile": asdict(server.profile)})
+            elif self.path in ("/api/tags", "/v1/models"):
+                self._json(200, {"models": [{"name": server.model}], "data": [{"id": server.model}]})
+            elif self.path == "/health":
+                self._json(200, {"status": "ok"})
+            else:
+                self._json(404, {"error": "not found"})
+
+        def do_POST(self) -> None:  # noqa: N802
+            try:
+                body = json.loads(self.rfile.read(int(self.headers.get("Content-Length", 0))) or b"{}")
+            except json.JSONDecodeError:
+                self._json(400, {"error": "invalid JSON"})
+                return
+            if self.path == "/_stub/profile":
+                try:
+                    self._json(200, asdict(server.update_profile(body)))
+                except (ValueError, TypeError) as exc:
+                    self._json(400, {"error": str(exc)})
+                return
+            if self.path not in ("/api/chat", "/v1/chat/completions"):
+                self._json(404, {"error": "not found"})
+                return
+
+            received = time.perf_counter()
+            messages = body.get("messages") or []
+            prompt = messages[-1].get("content", "") if messages else ""
+            # OpenAI `max_tokens` / Ollama `options.num_predict` cut the reply short.
+            max_tokens = body.get("max_tokens", (body.get("options") or {}).get("num_predict"))
+            plan = server.next_plan(prompt, int(max_tokens) if isinstance(max_tokens, (int, float)) else None)
+            if plan.error:
+                self._json(500, {"error": "injected failure"})
+                return
+            openai = self.path == "/v1/chat/completions"
+            # Ollama's clients here send "stream": false but read line by line;
+            # OpenAI defaults to not streaming.
+            stream = body.get("stream", not openai)
+            if not stream:
+                self._reply_whole(plan, received, openai)
+            else:
+                self._reply_stream(plan, received, openai)
+
+        def _wait(self, received: float, offset: float) -> None:
+            delay = received + offset - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+
+        def _reply_whole(self, plan: ReplyPlan, received: float, openai: bool) -> None:
+            if plan.tokens:
+                self._wait(received, plan.tokens[-1][0])
+            text = "".join(token for _, token in plan.tokens)
+            server.count_reply(len(plan.tokens), completed=True)
+            if openai:
+                self._json(200, {
+                    "id": f"chatcmpl-stub-{server.stats.requests}",
+                    "object": "chat.completion",
+                    "model": server.model,
+                    "choices": [{"index": 0, "message": {"role": "assistant", "content": text}, "finish_reason": "stop"}],
+                })
+            else:
+                self._json(200, {"model": server.model, "message": {"role": "assistant", "content": text}, "done": True})
+
+        def _reply_stream(self, plan: ReplyPlan, received: float, openai: bool) -> None:
+            self.send_response(200)
+            self.send_header("Content-Type", "text/event-stream" if openai else "application/x-ndjson")
+            self.end_headers()
+            sent = 0
+            completed = False
+            try:
+                for offset, token in plan.tokens:
+                    if plan.drop_after is not None and sent >= plan.drop_after:
+                        return  # the connection closes without a final chunk
+                    self._wait(received, offset)
+                    self.wfile.write(self._chunk(token, openai))
+                    self.wfile.flush()
+                    sent += 1
+                if openai:
+                    self.wfile.write(self._chunk("", openai, finish=True) + b"data: [DONE]\n\n")
+                else:
+                    self.wfile.write(self._chunk("", openai, finish=True))
+                completed = True
+            except (BrokenPipeError, ConnectionResetError):
+                pass  # client went away
+            finally:
+                server.count_reply(sent, completed)
+
+        def _chunk(self, token: str, openai: bool, finish: bool = False) -> bytes:
+            if openai:
+                chunk = {
+                    "object": "chat.completion.chunk",
+                    "model": server.model,
+                    "choices": [{"index": 0, "delta": {"content": token} if token else {},
+                                 "finish_reason": "stop" if finish else None}],
+                }
+                return b"data: " + json.dumps(chunk).encode("utf-8") + b"\n\n"
+            chunk = {"model": server.model, "message": {"role": "assistant", "content": token}, "done": finish}
+            return json.dumps(chunk).encode("utf-8") + b"\n"
+
+    return Handler
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Stand-in LLM server with scripted replies and latency profiles.")
+    parser.add_argument("--host", default="127.0.0.1", help="Bind address (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=8080, help="Port; 8080 = llama-server, 11434 = Ollama (default: %(default)s).")
+    parser.add_argument("--profile", choices=sorted(PROFILES), default="gpu", help="Base latency profile (default: %(default)s).")
+    for field in fields(LatencyProfile):
+        parser.add_argument(f"--{field.name.replace('_', '-')}", dest=field.name, type=type(field.default),
+                            help=f"Override the profile's {field.name}.")
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--script", help="JSON file with scripted replies.")
+    source.add_argument("--recorded", help="Session recording (main.py --record) to take replies and timing from.")
+    parser.add_argument("--seed", type=int, default=0, help="RNG seed for jitter and faults (default: %(default)s).")
+    parser.add_argument("--model", default="stub", help="Model name reported back (default: %(default)s).")
+    return parser.parse_args()
+
+
+def main() -> None:
+    args = parse_args()
+    overrides = {f.name: getattr(args, f.name) for f in fields(LatencyProfile) if getattr(args, f.name) is not None}
+    profile = replace(PROFILES[args.profile], **overrides)
+    if args.script:
+        replies: Any = ScriptedReplies(args.script)
+    elif args.recorded:
+        replies = RecordedReplies(args.recorded)
+    else:
+        replies = EchoReplies()
+
+    server = StubLlmServer(args.host, args.port, profile, replies, seed=args.seed, model=args.model)
+    print(f"Stub LLM on {server.url} ({args.profile}: {profile})")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
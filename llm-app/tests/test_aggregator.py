@@ -0,0 +1,63 @@
+import sys
+import threading
+import time
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.aggregator import StateAggregator
+from mqtt.pi_mqtt_app import TOPIC_COMMANDS, TOPIC_STATE, PiMqttApp
+from mqtt.topics import DeviceTopics, device_from_topic
+from mqtt.transport import LoopbackBroker
+
+
+def test_default_device_keeps_original_topics_and_others_are_namespaced():
+    assert DeviceTopics().state == TOPIC_STATE == "siggraph/pi/state"
+    assert DeviceTopics().commands == TOPIC_COMMANDS
+    robot = DeviceTopics("robot-07")
+    assert robot.state == "siggraph/robot-07/state"
+    assert robot.client_id == "pi-mqtt-app-robot-07"
+    assert device_from_topic("siggraph/robot-07/state/bin") == "robot-07"
+    assert device_from_topic("siggraph/_all/robots") is None
+    assert device_from_topic("llm/text") is None
+    for bad in ("", "a/b", "+", "#", "_all", "x" * 33):
+        with pytest.raises(ValueError):
+            DeviceTopics(bad)
+
+
+@pytest.mark.parametrize("fmt", ["json", "bin", "delta"])
+def test_aggregator_tracks_every_robot_over_loopback(fmt):
+    broker = LoopbackBroker()
+    aggregator = StateAggregator(fmt=fmt, transport=broker)
+    aggregator.connect()
+    for _ in range(200):
+        if broker.subscriber_count("siggraph/x/state" + aggregator.suffix):
+            break
+        time.sleep(0.005)
+
+    ids = [f"robot-{i}" for i in range(5)]
+    apps = [PiMqttApp(state_formats=[fmt], publish_rate_hz=100.0, transport=broker, device_id=d) for d in ids]
+    threads = [threading.Thread(target=app.start, daemon=True) for app in apps]
+    for t in threads:
+        t.start()
+    try:
+        for _ in range(400):
+            if set(aggregator.snapshot()) == set(ids):
+                break
+            time.sleep(0.005)
+    finally:
+        for app in apps:
+            app.stop()
+        for t in threads:
+            t.join(timeout=2.0)
+        aggregator.stop()
+
+    table = aggregator.snapshot()
+    assert set(table) == set(ids)
+    assert all(s.decode_errors == 0 and s.state.timestamp > 0 for s in table.values())
+    assert '"robot-3"' in aggregator.table_json()
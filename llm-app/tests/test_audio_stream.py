@@ -0,0 +1,97 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.audio_stream import (
+    CODEC_PCM16,
+    FRAME_BYTES,
+    FRAME_SAMPLES,
+    SAMPLE_RATE,
+    AudioDecoder,
+    AudioStreamPublisher,
+    opus_available,
+    pack_frame,
+    resolve_codec,
+    unpack_frame,
+)
+from mqtt.topics import DeviceTopics
+from mqtt.transport import LoopbackBroker
+
+
+def test_pcm_is_cut_into_timestamped_frames_and_ends_with_a_marker():
+    sent = []
+    stream = AudioStreamPublisher(lambda t, p: sent.append((t, p)), topic="siggraph/pi/audio", codec="pcm16")
+    pcm = bytes(range(256)) * ((FRAME_BYTES * 2 + 100) // 256 + 1)
+    pcm = pcm[: FRAME_BYTES * 2 + 100]
+
+    stream.begin_utterance()
+    # Odd chunk sizes: framing must not depend on how the tee reads.
+    stream.send(pcm[:1000], 100.0)
+    stream.send(pcm[1000:], 100.0 + 500 / SAMPLE_RATE)
+    stream.end_utterance()
+
+    frames = [unpack_frame(p) for _, p in sent]
+    assert [f.seq for f in frames] == [0, 1, 2, 3]
+    assert [f.samples for f in frames] == [FRAME_SAMPLES, FRAME_SAMPLES, 50, 0]
+    assert frames[-1].is_end
+    assert frames[1].play_time == pytest.approx(100.0 + FRAME_SAMPLES / SAMPLE_RATE)
+    assert b"".join(AudioDecoder().decode(f) for f in frames[:-1]) == pcm
+    assert {t for t, _ in sent} == {"siggraph/pi/audio"}
+
+    stats = stream.stats()
+    assert (stats.frames, stats.utterances) == (3, 1)
+    assert stats.audio_seconds == pytest.approx(len(pcm) / 2 / SAMPLE_RATE)
+
+
+def test_each_utterance_gets_a_new_id_and_restarts_seq():
+    sent = []
+    stream = AudioStreamPublisher(lambda t, p: sent.append(p), topic="a", codec="pcm16")
+    for _ in range(2):
+        stream.begin_utterance()
+        stream.send(bytes(FRAME_BYTES), 0.0)
+        stream.end_utterance()
+
+    frames = [unpack_frame(p) for p in sent]
+    assert [(f.utterance, f.seq) for f in frames] == [(1, 0), (1, 1), (2, 0), (2, 1)]
+
+
+def test_unpack_rejects_other_payloads():
+    with pytest.raises(ValueError):
+        unpack_frame(b"PA")
+    with pytest.raises(ValueError):
+        unpack_frame(b'{"op": "append", "seq": 1, "text": "hi"}')
+    with pytest.raises(ValueError):
+        unpack_frame(pack_frame(7, 1, 0, 0.0, 10, b""))
+
+
+@pytest.mark.skipif(opus_available(), reason="opuslib is installed")
+def test_opus_requires_opuslib_and_auto_falls_back_to_pcm():
+    assert resolve_codec("auto") == CODEC_PCM16
+    with pytest.raises(ImportError):
+        resolve_codec("opus")
+
+
+def test_frames_reach_a_subscriber_over_loopback():
+    broker = LoopbackBroker()
+    topic = DeviceTopics("robot-02").audio
+    received = []
+    sub = broker.create_client("twin")
+    sub.on_message = lambda c, u, msg: received.append(unpack_frame(msg.payload))
+    sub.connect()
+    sub.subscribe(topic)
+    pub = broker.create_client("pi")
+    pub.connect()
+
+    stream = AudioStreamPublisher(lambda t, p: pub.publish(t, p), topic=topic, codec="pcm16")
+    stream.send(bytes(FRAME_BYTES * 3), 5.0)
+    stream.end_utterance()
+    sub.loop(timeout=0)
+
+    assert [f.seq for f in received] == [0, 1, 2, 3]
+    assert received[-1].is_end
@@ -0,0 +1,86 @@
+import sys
+import time
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.clock_sync import ClockSync, ClockSyncClient, make_pong
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.transport import LoopbackBroker
+
+
+PI_OFFSET = 1_700_000_000.0  # Pi wall clock minus subscriber monotonic clock
+
+
+class Clocks:
+    def __init__(self) -> None:
+        self.local = 50.0
+
+    def pi(self) -> float:
+        return self.local + PI_OFFSET
+
+
+def _exchange(sync: ClockSync, clocks: Clocks, up: float, down: float) -> None:
+    ping = sync.make_ping()
+    clocks.local += up
+    _, pong = make_pong(ping, received_at=clocks.pi(), clock=clocks.pi)
+    clocks.local += down
+    sync.on_pong(pong)
+
+
+def test_min_rtt_sample_wins_over_asymmetric_slow_exchanges():
+    clocks = Clocks()
+    sync = ClockSync("ue-1", clock=lambda: clocks.local)
+
+    _exchange(sync, clocks, up=0.080, down=0.005)  # queued on the way up: offset off by ~37 ms
+    assert sync.offset == pytest.approx(PI_OFFSET + 0.0375)
+    _exchange(sync, clocks, up=0.002, down=0.002)
+    _exchange(sync, clocks, up=0.050, down=0.001)
+
+    assert sync.rtt == pytest.approx(0.004)
+    assert sync.offset == pytest.approx(PI_OFFSET, abs=1e-6)
+    assert sync.pi_time_now() == pytest.approx(clocks.pi(), abs=1e-6)
+    assert sync.one_way_latency(clocks.pi() - 0.010) == pytest.approx(0.010, abs=1e-6)
+
+
+def test_unmatched_and_malformed_pongs_are_ignored():
+    sync = ClockSync("web")
+    assert sync.on_pong(b'{"seq": 99, "t0": 0, "t1": 0, "t2": 0}') is None
+    assert sync.on_pong(b"nope") is None
+    assert sync.stale == 2 and not sync.synced
+    assert make_pong(b'{"id": "a/b", "seq": 1, "t0": 0}', received_at=0.0) is None
+    with pytest.raises(ValueError):
+        ClockSync("#")
+
+
+def test_pi_app_answers_pings_over_loopback():
+    broker = LoopbackBroker()
+    app = PiMqttApp(transport=broker)
+    app.client.connect()
+    app.client.loop_start()
+
+    viewer = broker.create_client("viewer")
+    sync_client = ClockSyncClient(viewer, ClockSync("viewer"), interval_s=0.01)
+    viewer.on_message = lambda client, userdata, msg: sync_client.handle_message(msg)
+    viewer.connect()
+    viewer.loop_start()
+    try:
+        sync_client.start()
+        for _ in range(200):
+            if sync_client.sync.pongs >= 3:
+                break
+            time.sleep(0.005)
+    finally:
+        sync_client.stop()
+        viewer.loop_stop()
+        app.client.loop_stop()
+
+    sync = sync_client.sync
+    assert sync.pongs >= 3
+    assert sync.error_bound < 0.05
+    assert sync.pi_time_now() == pytest.approx(time.time(), abs=0.05)
@@ -0,0 +1,136 @@
+import json
+import sys
+import threading
+import time
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.commands import (
+    ActionWorker,
+    CommandDispatcher,
+    CommandError,
+    GestureCommand,
+    SetPublishRateCommand,
+    SetStateCommand,
+    SpeakCommand,
+    parse_command,
+)
+
+
+@pytest.mark.parametrize(
+    "payload, expected",
+    [
+        ({"cmd": "speak", "text": " Hi "}, SpeakCommand(text="Hi")),
+        ({"cmd": "speak", "text": "Bonjour", "lang": "fr"}, SpeakCommand(text="Bonjour", lang="fr")),
+        ({"cmd": "gesture", "name": "nod", "times": 2}, GestureCommand(name="nod", times=2)),
+        ({"cmd": "set_state", "app_state": "Listening"}, SetStateCommand(app_state="Listening")),
+        ({"cmd": "set_publish_rate", "rate_hz": 60}, SetPublishRateCommand(rate_hz=60.0)),
+    ],
+)
+def test_parse_command_builds_typed_commands(payload, expected):
+    command, sent_at = parse_command(json.dumps(payload).encode("utf-8"))
+    assert command == expected
+    assert sent_at is None
+
+
+@pytest.mark.parametrize(
+    "payload",
+    [
+        b"not json",
+        b"[1, 2]",
+        b'{"cmd": "teleport"}',
+        b'{"cmd": "speak", "text": "   "}',
+        b'{"cmd": "gesture", "name": "wave"}',
+        b'{"cmd": "gesture", "name": "nod", "times": 0}',
+        b'{"cmd": "set_state", "app_state": "Dancing"}',
+        b'{"cmd": "set_publish_rate", "rate_hz": true}',
+    ],
+)
+def test_parse_command_rejects_invalid_payloads(payload):
+    with pytest.raises(CommandError):
+        parse_command(payload)
+
+
+def test_dispatcher_counts_drops_invalid_and_handler_errors():
+    dispatcher = CommandDispatcher(capacity=2)
+
+    def boom(command):
+        raise RuntimeError("motor jammed")
+
+    dispatcher.register(GestureCommand.KIND, boom)
+    dispatcher.offer(b'{"cmd": "speak", "text": "dropped"}')
+    dispatcher.offer(b"garbage")
+    dispatcher.offer(b'{"cmd": "gesture", "name": "nod", "sent_at": 1.0}')
+
+    assert dispatcher.dropped == 1
+    assert dispatcher.run_pending() == 2
+    assert dispatcher.invalid == 1
+
+    stats = dispatcher.stats()[GestureCommand.KIND]
+    assert stats.count == 1
+    assert stats.errors == 1
+    assert stats.end_to_end_mean_ms is not None
+
+
+def test_dispatcher_thread_handles_commands():
+    dispatcher = CommandDispatcher()
+    done = []
+    dispatcher.register(SetStateCommand.KIND, done.append)
+    dispatcher.start()
+    try:
+        dispatcher.offer(b'{"cmd": "set_state", "app_state": "Thinking"}')
+        for _ in range(200):
+            if done:
+                break
+            time.sleep(0.005)
+    finally:
+        dispatcher.stop()
+
+    assert done == [SetStateCommand(app_state="Thinking")]
+
+
+def test_action_worker_runs_slow_actions_off_the_caller_and_drops_overflow():
+    release = threading.Event()
+    done = []
+    worker = ActionWorker(capacity=1)
+    try:
+        started = time.monotonic()
+        assert worker.submit(lambda: (release.wait(5.0), done.append("speak")))
+        for _ in range(200):  # the first action is running, so the queue is empty again
+            if worker._queue.empty():
+                break
+            time.sleep(0.005)
+        assert worker.submit(lambda: done.append("nod"))
+        assert not worker.submit(lambda: done.append("dropped"))
+        assert time.monotonic() - started < 1.0
+        release.set()
+    finally:
+        worker.stop(timeout=5.0)
+
+    assert done == ["speak", "nod"]
+    assert worker.dropped == 1
+
+
+def test_action_worker_stop_returns_while_the_queue_is_full():
+    release = threading.Event()
+    done = []
+    worker = ActionWorker(capacity=1)
+    assert worker.submit(lambda: (release.wait(5.0), done.append("speak")))
+    for _ in range(200):
+        if worker._queue.empty():
+            break
+        time.sleep(0.005)
+    assert worker.submit(lambda: done.append("nod"))
+
+    started = time.monotonic()
+    worker.stop(timeout=0.2)
+    assert time.monotonic() - started < 1.0
+    release.set()
+    worker._thread.join(timeout=5.0)
+    assert done == ["speak"]  # the waiting action was abandoned
@@ -0,0 +1,66 @@
+import math
+import random
+import sys
+from array import array
+from pathlib import Path
+
+import pytest
+
+# Ensure s2t-llm-t2s (which contains `endpointing` and its benchmark) is on sys.path so it can be imported
+ORCHESTRATOR_DIR = Path(__file__).resolve().parents[2] / "s2t-llm-t2s"
+if str(ORCHESTRATOR_DIR) not in sys.path:
+    sys.path.insert(0, str(ORCHESTRATOR_DIR))
+
+from bench_endpointing import SAMPLE_RATE, _partial_for, render
+from endpointing import Endpointer, EndpointPolicy, FixedPolicy, estimate_pitch, text_cues
+
+
+def test_text_cues_spot_unfinished_sentences_and_questions():
+    assert not text_cues("I went to the keynote and").complete
+    assert not text_cues("can you explain the").complete
+    assert not text_cues("I want to know um").complete
+    assert text_cues("hey robot what is SIGGRAPH Asia").question
+    assert text_cues("Tell me a joke.").complete and not text_cues("Tell me a joke.").question
+    assert not text_cues("").complete
+
+    policy = EndpointPolicy(min_wait=0.3, max_wait=2.0)
+    assert policy.decide("what time is it", None, None).wait_s == pytest.approx(0.35)
+    assert policy.decide("so I was thinking about the", None, None).wait_s == pytest.approx(1.8)
+    # Falling pitch and a fade out shorten the wait, within the bounds.
+    assert policy.decide("that was great", -10.0, -30.0).wait_s == pytest.approx(0.3)
+    assert policy.decide(None, 0.0, 0.0).wait_s == pytest.approx(1.4)
+
+
+def test_pitch_is_estimated_from_a_voiced_frame():
+    frame = array("h", (int(8000 * math.sin(2 * math.pi * 150.0 * i / SAMPLE_RATE)) for i in range(480)))
+    assert estimate_pitch(frame.tobytes(), SAMPLE_RATE) == pytest.approx(150.0, rel=0.05)
+    assert estimate_pitch(bytes(960), SAMPLE_RATE) is None
+
+
+def _run(parts, policy, with_text=True):
+    pcm, spans, speech_end = render(parts, random.Random(3))
+    endpointer = Endpointer(
+        SAMPLE_RATE, energy_threshold=300.0, policy=policy,
+        partial=_partial_for(parts, spans) if with_text else None, partial_async=False,
+    )
+    for offset in range(0, len(pcm), 2048):
+        if endpointer.feed(pcm[offset:offset + 2048]):
+            break
+    return endpointer, speech_end
+
+
+def test_endpointer_waits_through_a_hesitation_and_ends_quickly_after_a_question():
+    parts = [
+        {"say": "can you explain the", "s": 0.8, "end": "level"},
+        {"pause": 1.0},
+        {"say": "difference between rasterization and ray tracing", "s": 1.2, "end": "rise"},
+    ]
+    endpointer, speech_end = _run(parts, EndpointPolicy())
+    assert endpointer.t > speech_end  # not cut during the pause
+    assert endpointer.endpoint_delay < 0.5
+    assert endpointer.transcript == "can you explain the difference between rasterization and ray tracing"
+    assert [d.reason.split(",")[0] for d in endpointer.decisions] == ["incomplete", "question"]
+
+    # A fixed 0.5 s threshold cuts the same utterance at the pause.
+    fixed, speech_end = _run(parts, FixedPolicy(0.5), with_text=False)
+    assert fixed.t < speech_end and fixed.decision.reason == "fixed"
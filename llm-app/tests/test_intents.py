@@ -0,0 +1,60 @@
+import datetime
+import json
+import sys
+from pathlib import Path
+
+# Ensure LafufuTwins (which contains `intents`) is on sys.path so it can be imported.
+# Appended: the directory also has a `main.py` that must not shadow anything.
+INTENTS_DIR = Path(__file__).resolve().parents[2] / "LafufuTwins"
+if str(INTENTS_DIR) not in sys.path:
+    sys.path.append(str(INTENTS_DIR))
+
+import intents
+from intents import CANNED, Intent, IntentMatcher, IntentRouter, expand, normalize
+
+
+def test_normalization_turns_numbers_into_slots_and_templates_expand():
+    assert normalize("Set the volume to seventy-five %, please!") == (
+        ["set", "the", "volume", "to", "#", "please"], [75]
+    )
+    assert normalize("What's one hundred?") == (["whats", "#"], [100])
+    assert sorted(expand("(clear|reset) [the] history")) == [
+        ("clear", "history"), ("clear", "the", "history"), ("reset", "history"), ("reset", "the", "history"),
+    ]
+
+
+def test_only_whole_utterances_match_and_the_rest_falls_through_to_the_llm():
+    matcher = IntentMatcher()
+    cases = {
+        "What time is it?": (intents.TIME, ()),
+        "Hey robot, what's the date today": (intents.DATE, ()),
+        "Could you nod your head three times please": (intents.NOD, (3,)),
+        "volume 40": (intents.VOLUME_SET, (40,)),
+        "Goodbye!": (intents.EXIT, ()),
+        "who are you": (CANNED, ()),
+    }
+    for text, (name, numbers) in cases.items():
+        match = matcher.match(text)
+        assert match is not None and (match.name, match.numbers) == (name, numbers), text
+
+    # Substrings of longer requests are not commands (the old check exited on these).
+    for text in ("Say goodbye to my friend", "What time is the keynote?", "Tell me about SIGGRAPH", ""):
+        assert matcher.match(text) is None, text
+
+
+def test_router_tracks_the_local_share_and_canned_answers_load_from_json(tmp_path):
+    path = tmp_path / "canned.json"
+    path.write_text(json.dumps([{"ask": ["who (made|built) you"], "say": "A team of students."}]))
+    router = IntentRouter(IntentMatcher(intents.load_canned(str(path)) + list(intents.DEFAULT_INTENTS)))
+
+    assert router.route("Who built you?").intent.reply == "A team of students."
+    assert router.route("thanks").intent.reply == "You're welcome!"
+    assert router.route("Explain ray tracing") is None
+    assert router.route("louder").name == intents.VOLUME_UP
+    assert router.local_share == 0.75 and router.counts == {CANNED: 2, "llm": 1, intents.VOLUME_UP: 1}
+    assert "A team of students." in intents.static_replies(router.matcher.intents)
+
+    noon = datetime.datetime(2025, 12, 14, 12, 5)
+    assert intents.time_reply(noon) == "It's 12:05 PM."
+    assert intents.date_reply(noon) == "Today is Sunday, December 14, 2025."
+    assert IntentMatcher([Intent("x", ("a b c", "b"))]).match("b") is not None
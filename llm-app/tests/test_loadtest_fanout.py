@@ -0,0 +1,23 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.loadtest_fanout import FanoutConfig, run
+
+
+@pytest.mark.parametrize("fmt", ["json", "bin", "delta"])
+def test_fanout_over_loopback_delivers_every_sample_to_every_subscriber(fmt):
+    report = run(FanoutConfig(subscribers=3, publishers=2, rate_hz=200.0, fmt=fmt,
+                              seconds=0.2, drain_s=0.1, transport="loopback"))
+
+    assert report.published > 0
+    assert report.expected_deliveries == report.published * 3
+    assert report.delivered == report.expected_deliveries
+    assert report.loss_pct == 0.0
+    assert 0.0 <= report.latency_p50_ms <= report.latency_max_ms
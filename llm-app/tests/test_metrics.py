@@ -0,0 +1,100 @@
+import json
+import sys
+import urllib.request
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt` and `telemetry`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.transport import LoopbackBroker
+from telemetry.instruments import PipelineMetrics, mqtt_app_collector
+from telemetry.metrics import MetricsHttpServer, Registry, bucket_quantile, compact_payload
+
+
+def test_prometheus_text_has_cumulative_buckets_and_escaped_labels():
+    registry = Registry()
+    registry.counter("robot_turns_total", "Voice turns").inc(3)
+    registry.gauge("robot_speaking", "1 while speaking").set(1)
+    hist = registry.histogram("robot_stt_seconds", "STT latency", buckets=(0.1, 1.0))
+    for value in (0.05, 0.1, 0.5, 2.0):
+        hist.observe(value)
+    registry.counter("mqtt_sent_total", "Sent", ["topic"]).labels('a"b').inc()
+
+    text = registry.render()
+    assert "# TYPE robot_turns_total counter\nrobot_turns_total 3\n" in text
+    assert "robot_speaking 1\n" in text
+    assert 'robot_stt_seconds_bucket{le="0.1"} 2\n' in text
+    assert 'robot_stt_seconds_bucket{le="1"} 3\n' in text
+    assert 'robot_stt_seconds_bucket{le="+Inf"} 4\n' in text
+    assert "robot_stt_seconds_count 4\nrobot_stt_seconds_sum" not in text  # sum comes first
+    assert "robot_stt_seconds_sum 2.65\nrobot_stt_seconds_count 4\n" in text
+    assert 'mqtt_sent_total{topic="a\\"b"} 1\n' in text
+
+    with pytest.raises(ValueError):
+        registry.counter("robot_turns_total", "Voice turns").inc(-1)
+    with pytest.raises(ValueError):
+        registry.gauge("robot_turns_total", "same name, other kind")
+
+
+def test_compact_snapshot_summarizes_histograms_from_buckets():
+    registry = Registry()
+    hist = registry.histogram("lat_seconds", "Latency", buckets=(0.1, 0.2, 0.4))
+    for _ in range(50):
+        hist.observe(0.15)
+    for _ in range(50):
+        hist.observe(0.3)
+    registry.counter("unused_total", "Never incremented")
+
+    snapshot = json.loads(compact_payload(registry))
+    count, total, p50, p90, p99 = snapshot["m"]["lat_seconds"]
+    assert count == 100 and total == pytest.approx(22.5)
+    assert p50 == pytest.approx(0.2) and 0.2 < p90 <= 0.4
+    assert "unused_total" not in snapshot["m"]
+    assert bucket_quantile((0.1,), [0, 5], 0.5) == 0.1  # everything above the last bound
+
+
+class FakeLlm:
+    def chat_stream(self, prompt, history=None):
+        yield from ("a", "b", "c")
+
+
+def test_pipeline_and_mqtt_metrics_reach_http_endpoint_and_metrics_topic():
+    registry = Registry()
+    metrics = PipelineMetrics(registry)
+    assert "".join(metrics.wrap_llm(FakeLlm()).chat_stream("hi")) == "abc"
+    metrics.record_transcript("hello", 0.3)
+
+    broker = LoopbackBroker()
+    app = PiMqttApp(transport=broker, metrics_payload=lambda: compact_payload(registry))
+    registry.register_collector(mqtt_app_collector(app))
+    app.client.connect("localhost", 1883)
+    received = []
+    listener = broker.create_client("dashboard")
+    listener.on_message = lambda client, userdata, msg: received.append(json.loads(msg.payload))
+    listener.connect("localhost", 1883)
+    listener.subscribe(app.topics.metrics)
+
+    app.publish_state()
+    app.publish_metrics()
+    app.publish_metrics()  # not due yet
+    listener.loop(timeout=0.1)
+    assert len(received) == 1
+    values = received[0]["m"]
+    assert values["robot_llm_chunks_total"] == 3
+    assert values["robot_stt_results_total{ok}"] == 1
+    assert values[f"mqtt_outbound_sent_total{{{app.topics.state}/bin}}"] == 1  # binary only by default
+
+    server = MetricsHttpServer(registry, port=0).start()
+    try:
+        with urllib.request.urlopen(server.url, timeout=5) as r:
+            assert r.headers["Content-Type"].startswith("text/plain; version=0.0.4")
+            text = r.read().decode()
+    finally:
+        server.stop()
+    assert "robot_llm_first_token_seconds_count 1\n" in text
+    assert f'mqtt_outbound_sent_total{{topic="{app.topics.metrics}"}} 1\n' in text
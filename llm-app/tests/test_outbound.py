@@ -0,0 +1,132 @@
+import sys
+import threading
+from pathlib import Path
+from types import SimpleNamespace
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.outbound import LATEST, RELIABLE, OutboundQueue, fifo
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.transport import LoopbackBroker
+
+
+class SlowClient:
+    """Accepts publishes but only acknowledges them when told to (a stalled link)."""
+
+    def __init__(self) -> None:
+        self.on_publish = None
+        self.published = []
+        self._mid = 0
+
+    def publish(self, topic, payload=None, qos=0, retain=False):
+        self._mid += 1
+        self.published.append((topic, payload, qos, self._mid))
+        return SimpleNamespace(rc=0, mid=self._mid)
+
+    def ack_all(self):
+        for *_, mid in list(self.published):
+            self.on_publish(self, None, mid)
+
+
+def test_latest_policy_keeps_one_pending_sample_and_sends_the_newest():
+    client = SlowClient()
+    queue = OutboundQueue(client, [("s/#", LATEST)])
+    encoded = []
+
+    def encoder(n):
+        return lambda: encoded.append(n) or str(n)
+
+    for n in range(10):
+        queue.publish("s/state", encoder(n))
+    assert [p for _, p, _, _ in client.published] == ["0"]
+
+    client.ack_all()
+    assert [p for _, p, _, _ in client.published] == ["0", "9"]
+    # Superseded samples were never encoded.
+    assert encoded == [0, 9]
+
+    stats = queue.stats()["s/state"]
+    assert (stats.offered, stats.sent, stats.dropped, stats.max_depth) == (10, 2, 8, 1)
+    assert stats.inflight == 1
+
+
+def test_fifo_policy_drops_oldest_when_full_and_drains_in_order():
+    client = SlowClient()
+    queue = OutboundQueue(client, [("t", fifo(depth=3, max_inflight=1))])
+    for n in range(6):
+        queue.publish("t", str(n))
+
+    for _ in range(4):
+        client.ack_all()
+    assert [p for _, p, _, _ in client.published] == ["0", "3", "4", "5"]
+    assert queue.stats()["t"].dropped == 2
+
+
+def test_reliable_policy_bypasses_queueing_at_qos_1():
+    client = SlowClient()
+    queue = OutboundQueue(client, [("c", RELIABLE)])
+    for n in range(5):
+        queue.publish("c", str(n))
+    assert [(p, qos) for _, p, qos, _ in client.published] == [(str(n), 1) for n in range(5)]
+    assert queue.stats()["c"].inflight == 5
+
+
+def test_disconnect_frees_qos0_slots_and_resume_sends_the_pending_sample():
+    client = SlowClient()
+    queue = OutboundQueue(client, [("s", LATEST)])
+    queue.publish("s", "old")
+    queue.publish("s", "new")
+    queue.on_disconnect()
+    queue.resume()
+    assert [p for _, p, _, _ in client.published] == ["old", "new"]
+    assert queue.stats()["s"].lost == 1
+
+
+class MutexClient(SlowClient):
+    """Like paho: publish() and the network thread's on_publish share a message mutex."""
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.mutex = threading.Lock()
+        self.entered = threading.Event()
+
+    def publish(self, topic, payload=None, qos=0, retain=False):
+        self.entered.set()
+        with self.mutex:
+            return super().publish(topic, payload, qos, retain)
+
+
+def test_an_ack_on_the_network_thread_during_a_publish_does_not_deadlock():
+    client = MutexClient()
+    queue = OutboundQueue(client, [("c", RELIABLE)])
+    queue.publish("c", "first")
+
+    client.mutex.acquire()  # the network thread is inside paho, handling the PUBACK
+    sender = threading.Thread(target=queue.publish, args=("c", "second"), daemon=True)
+    sender.start()
+    assert client.entered.wait(1.0)
+    acker = threading.Thread(target=client.on_publish, args=(client, None, 1), daemon=True)
+    acker.start()
+    acker.join(timeout=1.0)
+    assert not acker.is_alive()  # on_publish did not wait for the blocked sender
+    client.mutex.release()
+    sender.join(timeout=1.0)
+    assert not sender.is_alive()
+
+    assert [p for _, p, _, _ in client.published] == ["first", "second"]
+    assert queue.stats()["c"].inflight == 1
+
+
+def test_pi_app_state_flows_through_loopback_without_queueing():
+    broker = LoopbackBroker()
+    app = PiMqttApp(transport=broker)
+    app.client.connect()
+    for _ in range(5):
+        app.publish_state()
+
+    stats = app.outbound.stats()[app.topics.state + "/bin"]
+    # Loopback acknowledges inside publish(): nothing waits or is dropped.
+    assert (stats.sent, stats.dropped, stats.inflight, stats.depth) == (5, 0, 0, 0)
@@ -0,0 +1,98 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt import pacing
+from mqtt.pacing import DeadlineTicker, LatestValueSlot
+
+
+class FakeClock:
+    def __init__(self) -> None:
+        self.now = 1000.0
+
+    def monotonic(self) -> float:
+        return self.now
+
+    def sleep(self, seconds: float) -> None:
+        self.now += seconds
+
+
+@pytest.fixture
+def clock(monkeypatch):
+    fake = FakeClock()
+    monkeypatch.setattr(pacing.time, "monotonic", fake.monotonic)
+    monkeypatch.setattr(pacing.time, "sleep", fake.sleep)
+    return fake
+
+
+def test_ticker_wakes_on_absolute_deadlines_despite_work(clock):
+    ticker = DeadlineTicker(rate_hz=100.0)
+    wakes = []
+    for _ in range(5):
+        assert ticker.wait()
+        wakes.append(clock.now)
+        clock.now += 0.004  # work inside the tick must not push later deadlines
+
+    assert wakes == pytest.approx([1000.0, 1000.01, 1000.02, 1000.03, 1000.04])
+    assert ticker.stats().dropped == 0
+    assert ticker.stats().actual_hz == pytest.approx(100.0)
+
+
+def test_ticker_skips_and_counts_missed_deadlines(clock):
+    ticker = DeadlineTicker(rate_hz=100.0)
+    ticker.wait()
+    clock.now += 0.035  # overrun: the 10 ms tick runs late, 20 and 30 ms are skipped
+    ticker.wait()
+    ticker.wait()
+
+    stats = ticker.stats()
+    assert stats.ticks == 3
+    assert stats.dropped == 2
+    assert clock.now == pytest.approx(1000.04)
+
+
+def test_set_rate_is_applied_by_the_ticker_thread_at_its_next_wait(clock):
+    ticker = DeadlineTicker(rate_hz=100.0)
+    ticker.wait()
+    ticker.wait()
+    ticker.set_rate(10.0)  # e.g. from the command thread
+    assert ticker.rate_hz == 10.0
+    assert ticker.stats().target_hz == 100.0 and ticker.stats().ticks == 2
+
+    wakes = []
+    for _ in range(3):
+        ticker.wait()
+        wakes.append(clock.now)
+    assert wakes == pytest.approx([1000.01, 1000.11, 1000.21])
+    assert ticker.stats().target_hz == 10.0 and ticker.stats().ticks == 3
+    with pytest.raises(ValueError):
+        ticker.set_rate(0.0)
+    assert ticker.rate_hz == 10.0
+
+
+def test_ticker_rejects_out_of_range_rates():
+    with pytest.raises(ValueError):
+        DeadlineTicker(rate_hz=0.0)
+    with pytest.raises(ValueError):
+        DeadlineTicker(rate_hz=pacing.MAX_RATE_HZ * 2)
+
+
+def test_latest_value_slot_coalesces_unread_writes():
+    slot: LatestValueSlot[int] = LatestValueSlot()
+    assert slot.get() == (0, None)
+
+    slot.put(1)
+    slot.put(2)
+    slot.put(3)
+    assert slot.get() == (3, 3)
+    assert slot.overwritten == 2
+
+    slot.put(4)
+    assert slot.get() == (4, 4)
+    assert slot.overwritten == 2
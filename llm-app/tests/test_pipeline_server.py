@@ -0,0 +1,121 @@
+import random
+import sys
+import threading
+import time
+from pathlib import Path
+
+# Ensure s2t-llm-t2s (which contains the pipeline server and client) is on sys.path so they can be imported
+ORCHESTRATOR_DIR = Path(__file__).resolve().parents[2] / "s2t-llm-t2s"
+if str(ORCHESTRATOR_DIR) not in sys.path:
+    sys.path.insert(0, str(ORCHESTRATOR_DIR))
+
+from bench_endpointing import SAMPLE_RATE, render
+from pipeline_client import PipelineClient, stream_until_turn
+from pipeline_server import (
+    REPLY_SAMPLE_RATE,
+    BatchConfig,
+    FairQueue,
+    PipelineServer,
+    SentenceSplitter,
+    SimCosts,
+    _ServerMetrics,
+    sim_engines,
+    stt_stage,
+)
+from telemetry.metrics import Registry
+
+
+def test_fair_queue_serves_sessions_round_robin():
+    q = FairQueue()
+    for job in ("a1", "a2", "a3"):
+        q.put("a", job)
+    q.put("b", "b1")
+    q.put("c", "c1")
+    q.put("b", "b2")
+
+    assert [q.get() for _ in range(6)] == ["a1", "b1", "c1", "a2", "b2", "a3"]
+    q.close()
+    assert q.get() is None
+
+
+def test_sentence_splitter_cuts_streamed_text():
+    splitter = SentenceSplitter()
+    out = []
+    for piece in ("Lafufu thinks ", "so. Dr. Who is ", "a show! And", " that is all"):
+        out += splitter.feed(piece)
+    assert out == ["Lafufu thinks so.", "Dr. Who is a show!"]
+    assert splitter.flush() == ["And that is all"]
+
+
+class RecordingStt:
+    def __init__(self):
+        self.batches = []
+
+    def transcribe(self, pcm, sample_rate):
+        return self.transcribe_batch([(pcm, sample_rate)])[0]
+
+    def transcribe_batch(self, items):
+        seconds = [len(pcm) // 2 // rate for pcm, rate in items]
+        self.batches.append(seconds)
+        return [f"{s} s" for s in seconds]
+
+
+def _utterance(seconds):
+    return bytes(2 * 10 * seconds), 10  # 10 Hz "audio": cheap to build
+
+
+def test_stt_batches_utterances_that_arrive_together_and_splits_by_padding():
+    stt = RecordingStt()
+    stage = stt_stage([stt], _ServerMetrics(Registry()), BatchConfig(max_batch=3, max_wait_s=0.2, max_padding=0.5))
+    try:
+        futures = [stage.submit(f"robot-{i}", _utterance(s)) for i, s in enumerate((2, 9, 2, 8))]
+        assert [f.result(timeout=5.0) for f in futures] == ["2 s", "9 s", "2 s", "8 s"]
+    finally:
+        stage.close()
+    # The first three fill a batch, but padding 2 s to 9 s is too much: 9 s goes
+    # back and runs next, with the 8 s one.
+    assert stt.batches == [[2, 2], [9, 8]]
+
+
+def test_stt_batch_waits_at_most_max_wait():
+    stt = RecordingStt()
+    stage = stt_stage([stt], _ServerMetrics(Registry()), BatchConfig(max_batch=8, max_wait_s=0.05))
+    try:
+        started = time.perf_counter()
+        assert stage.submit("robot-0", _utterance(1)).result(timeout=5.0) == "1 s"
+        assert time.perf_counter() - started < 1.0
+    finally:
+        stage.close()
+    assert stt.batches == [[1]]
+
+
+def test_robots_share_one_server_and_get_text_and_audio_back():
+    fast = SimCosts(stt_base_s=0.01, stt_per_audio_s=0.0, llm_first_token_s=0.01, llm_tokens_per_s=2000.0,
+                    reply_words=12, tts_base_s=0.01, tts_per_char_s=0.0)
+    server = PipelineServer(sim_engines(fast, llm_slots=1, tts_workers=1), port=0, slo_s=5.0).start()
+    host, port = server.address
+    pcm, _, _ = render([{"say": "hello", "s": 0.6, "end": "fall"}], random.Random(1))
+    turns = {}
+
+    def robot(name):
+        client = PipelineClient(host, port, name, SAMPLE_RATE).connect()
+        turns[name] = stream_until_turn(client, pcm, realtime=False, timeout=20.0)
+        client.close()
+
+    threads = [threading.Thread(target=robot, args=(f"robot-{i}",)) for i in range(3)]
+    try:
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join(timeout=30.0)
+    finally:
+        server.stop()
+
+    assert sorted(turns) == ["robot-0", "robot-1", "robot-2"]
+    for name, turn in turns.items():
+        assert turn.transcript.startswith("simulated utterance")
+        assert turn.reply.startswith("Lafufu thinks that is a fine question.")
+        assert len(turn.pcm) > REPLY_SAMPLE_RATE  # over half a second of speech
+        assert turn.report["robot"] == name and turn.report["slo_met"]
+        assert turn.report["first_text_s"] <= turn.report["first_audio_s"] <= turn.report["done_s"]
+    assert set(server.slo.summary()) == set(turns)
@@ -0,0 +1,69 @@
+import io
+import sys
+from pathlib import Path
+
+# Ensure the repo root (which contains `telemetry`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from telemetry.ringlog import DEBUG, INFO, WARNING, Logger, RingLog
+
+
+def _ring(capacity=64):
+    # Not started: the test drives the writer with flush().
+    return RingLog(capacity=capacity, stream=io.StringIO())
+
+
+def test_records_are_formatted_by_the_writer_in_order_and_levels_filter_at_the_call_site():
+    ring = _ring()
+    log = Logger("MQTT", ring, INFO, rate_limit=0)
+    payload = {"big": "x" * 10}
+    log.debug("Payload %s", payload)
+    log.info("Connected to %s:%d", "localhost", 1883)
+    log.warning("Ignoring invalid command: %s", "bad json")
+    log.error("bad format %d", "not a number")
+    assert ring.stream.getvalue() == ""  # nothing written on the calling thread
+
+    ring.flush()
+    lines = ring.stream.getvalue().splitlines()
+    assert [line.split(" ", 1)[1] for line in lines[:2]] == [
+        "I [MQTT] Connected to localhost:1883",
+        "W [MQTT] Ignoring invalid command: bad json",
+    ]
+    assert lines[2].split(" ", 1)[1].startswith("E [MQTT] 'bad format %d' % ('not a number',) failed")
+    assert not log.isEnabledFor(DEBUG) and log.isEnabledFor(WARNING)
+
+    log.setLevel("DEBUG")
+    log.debug("now %s", "visible")
+    ring.flush()
+    assert ring.stream.getvalue().endswith("D [MQTT] now visible\n")
+
+
+def test_repeated_messages_are_rate_limited_per_call_site():
+    ring = _ring(capacity=1024)
+    log = Logger("stepper", ring, INFO, rate_limit=3)
+    for i in range(50):
+        log.info("step %d", i)
+    log.info("other site")
+    ring.flush()
+    lines = ring.stream.getvalue().splitlines()
+    assert [line.split("] ", 1)[1] for line in lines] == ["step 0", "step 1", "step 2", "other site"]
+
+    # The next window's first record reports what the previous one swallowed.
+    log._sites["step %d"][0] -= 1.0
+    log.info("step %d", 99)
+    ring.flush()
+    assert ring.stream.getvalue().splitlines()[-1].endswith("step 99 (47 similar suppressed)")
+
+
+def test_writer_that_falls_behind_loses_the_oldest_records_and_says_so():
+    ring = _ring(capacity=8)
+    log = Logger("MQTT", ring, INFO, rate_limit=0)
+    for i in range(20):
+        log.info("msg %d", i)
+    ring.flush()
+    lines = ring.stream.getvalue().splitlines()
+    assert "12 records dropped" in lines[0]
+    assert [line.split("] ", 1)[1] for line in lines[1:]] == [f"msg {i}" for i in range(12, 20)]
+    assert ring.dropped == 12 and ring.written == 8
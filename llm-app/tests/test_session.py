@@ -0,0 +1,187 @@
+import sys
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+
+# Ensure the repo root (which contains `mqtt` and `telemetry`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.commands import SpeakCommand
+from telemetry.session import (
+    Pacer,
+    ReplayLlm,
+    ReplayMicrophone,
+    ReplayPlayer,
+    ReplayStt,
+    ReplayTts,
+    ReplayTurns,
+    SessionLog,
+    SessionRecorder,
+    replay_commands,
+)
+
+
+@dataclass
+class Msg:
+    role: str
+    content: str
+
+
+class FakeLlm:
+    def chat_stream(self, prompt, history=None):
+        yield from ("Hel", "lo ", prompt)
+
+
+class FakeMotors:
+    def __init__(self):
+        self.calls = []
+
+    def start_talking_motion(self):
+        self.calls.append("start")
+
+    def stop_talking_motion(self):
+        self.calls.append("stop")
+
+
+def _record_turn(recorder, tmp_path, published):
+    recorder.begin_turn()
+    recorder.record_utterance(b"\x01\x02" * 800, 16000, 2, listen_s=0.5)
+    recorder.record_transcript("world", latency_s=0.2)
+    reply = "".join(recorder.wrap_llm(FakeLlm()).chat_stream("world", [Msg("system", "Be brief.")]))
+
+    def synthesize(text, path, lang="en"):
+        Path(path).write_bytes(b"ID3 mp3 for " + text.encode())
+        return Path(path)
+
+    path = recorder.wrap_synthesize(synthesize)(reply, tmp_path / "speech.mp3")
+    motors = recorder.wrap_motors(FakeMotors())
+    motors.start_talking_motion()
+    recorder.wrap_play(lambda p: None)(path)
+    motors.stop_talking_motion()
+    recorder.tap_publish(lambda topic, payload, retain=False: published.append(payload))("t", b"{}")
+    recorder.record_command(SpeakCommand(text="remote"))
+    recorder.end_turn()
+    return reply
+
+
+def test_recorded_session_replays_the_same_content_through_stand_ins(tmp_path):
+    published = []
+    recorder = SessionRecorder(tmp_path / "s.tcol")
+    reply = _record_turn(recorder, tmp_path, published)
+    recorder.close()
+    assert reply == "Hello world" and published == [b"{}"]
+
+    log = SessionLog(tmp_path / "s.tcol")
+    assert log.complete and len(log.select("llm/token")) == 3
+    pacer = Pacer(speed=0)
+    mic = ReplayMicrophone(log, pacer)
+    assert mic.next_turn()
+    assert mic.listen() == (b"\x01\x02" * 800, 16000, 2)
+    assert ReplayStt(log, pacer).transcribe() == "world"
+    assert "".join(ReplayLlm(log, pacer).chat_stream("world")) == "Hello world"
+    out = ReplayTts(log, pacer).synthesize(reply, tmp_path / "replayed.mp3")
+    assert out.read_bytes() == b"ID3 mp3 for Hello world"
+    ReplayPlayer(log, pacer).play(out)
+    assert [e.kind for e in log.select("motor/start_talking") + log.select("motor/stop_talking")] == [
+        "motor/start_talking", "motor/stop_talking"]
+    assert not mic.next_turn()
+
+    offered = []
+    replay_commands(log, offered.append, pacer, threading.Event()).join(timeout=1.0)
+    assert offered == [b'{"cmd": "speak", "text": "remote", "lang": "en"}']
+
+
+class FailingLlm:
+    def chat_stream(self, prompt, history=None):
+        yield "Um"
+        raise TimeoutError("primary too slow")
+
+
+def test_replay_keeps_a_backup_fallback_apart_from_the_failed_request(tmp_path):
+    recorder = SessionRecorder(tmp_path / "fallback.tcol")
+    recorder.begin_turn()
+    try:
+        "".join(recorder.wrap_llm(FailingLlm()).chat_stream("world"))
+    except TimeoutError:
+        pass
+    assert "".join(recorder.wrap_llm(FakeLlm()).chat_stream("world")) == "Hello world"
+    recorder.end_turn()
+    recorder.close()
+
+    replay = ReplayLlm(SessionLog(tmp_path / "fallback.tcol"), Pacer(speed=0))
+    assert "".join(replay.chat_stream("world")) == "Um"
+    assert "".join(replay.chat_stream("world")) == "Hello world"
+
+
+def test_replay_routes_an_intent_turn_and_an_llm_turn_as_recorded(tmp_path):
+    def synthesize(text, path, lang="en"):
+        Path(path).write_bytes(text.encode())
+        return Path(path)
+
+    recorder = SessionRecorder(tmp_path / "routes.tcol")
+    speak = recorder.wrap_synthesize(synthesize)
+    llm = recorder.wrap_llm(FakeLlm())
+    recorder.begin_turn()  # answered locally: no LLM request
+    recorder.record_transcript("nod three times", latency_s=0.1)
+    recorder.record_route("nod", (3,))
+    speak("Nodding.", tmp_path / "a.mp3")
+    recorder.end_turn()
+    recorder.begin_turn()
+    recorder.record_transcript("story", latency_s=0.1)
+    recorder.record_route("llm")
+    speak("".join(llm.chat_stream("story")), tmp_path / "b.mp3")
+    recorder.end_turn()
+    recorder.close()
+
+    log = SessionLog(tmp_path / "routes.tcol")
+    pacer = Pacer(speed=0)
+    mic, turns = ReplayMicrophone(log, pacer), ReplayTurns(log)
+    replay_llm, tts = ReplayLlm(log, pacer), ReplayTts(log, pacer)
+
+    assert mic.next_turn() and turns.route(mic.turn) == ("nod", (3,))
+    assert tts.synthesize("", tmp_path / "out.mp3").read_bytes() == b"Nodding."
+    assert mic.next_turn() and turns.route(mic.turn) == ("llm", ())
+    assert "".join(replay_llm.chat_stream("story")) == "Hello story"
+    assert tts.synthesize("", tmp_path / "out.mp3").read_bytes() == b"Hello story"
+    assert turns.route(99) is None  # not recorded (older sessions): the matcher decides
+
+
+def test_replay_speaks_the_recorded_filler_ahead_of_the_reply(tmp_path):
+    def synthesize(text, path, lang="en"):
+        Path(path).write_bytes(text.encode())
+        return Path(path)
+
+    recorder = SessionRecorder(tmp_path / "filler.tcol")
+    speak = recorder.wrap_synthesize(synthesize)
+    recorder.begin_turn()
+    recorder.record_route("llm")
+    speak("One moment.", tmp_path / "f.mp3")
+    speak("".join(recorder.wrap_llm(FakeLlm()).chat_stream("story")), tmp_path / "r.mp3")
+    recorder.record("turn", "budget", {"degradations": [
+        {"action": "filler", "reason": "no reply fits the deadline", "filler": "One moment."},
+        {"action": "max_tokens", "reason": "reply would not fit"},
+    ]})
+    recorder.end_turn()
+    recorder.close()
+
+    log = SessionLog(tmp_path / "filler.tcol")
+    mic, turns, tts = ReplayMicrophone(log, Pacer(0)), ReplayTurns(log), ReplayTts(log, Pacer(0))
+    assert mic.next_turn() and turns.filler(mic.turn) == "One moment."
+    assert tts.synthesize("One moment.", tmp_path / "out.mp3").read_bytes() == b"One moment."
+    assert tts.synthesize("Hello story", tmp_path / "out.mp3").read_bytes() == b"Hello story"
+    assert turns.filler(mic.turn + 1) is None
+
+
+def test_session_cut_short_is_readable_up_to_the_last_sealed_group(tmp_path):
+    recorder = SessionRecorder(tmp_path / "cut.tcol")
+    try:
+        for _ in range(300):  # more than one row group
+            recorder.record("llm", "token", {"text": "x"})
+        # No close(): the process died.
+        log = SessionLog(tmp_path / "cut.tcol")
+        assert not log.complete
+        assert len(log.events) == 256
+    finally:
+        recorder._writer.abandon()
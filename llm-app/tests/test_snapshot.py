@@ -0,0 +1,101 @@
+import sys
+from dataclasses import replace
+from pathlib import Path
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.snapshot import SnapshotJoin, make_request, parse_request
+from mqtt.state_bus import StateBus
+from mqtt.state_codec import StateDecoder, StateEncoder
+from mqtt.transport import LoopbackBroker
+
+
+def _pi_app(broker: LoopbackBroker) -> tuple[PiMqttApp, StateBus]:
+    bus = StateBus()
+    bus.set("dialogue", "Hello, I am Lafufu.")
+    bus.set("app_state", "Speaking")
+    app = PiMqttApp(state_formats=["json", "bin"], state_source=bus, transport=broker)
+    app.client.connect()
+    app.client.loop(timeout=0)  # CONNACK -> subscriptions
+    return app, bus
+
+
+def _joiner(broker: LoopbackBroker, join: SnapshotJoin, states: list):
+    client = broker.create_client(join.client_id)
+    client.on_connect = lambda c, u, f, rc: join.on_connect(c)
+    client.on_message = lambda c, u, msg: join.handle_message(msg)
+    join.on_state = states.append
+    client.connect()
+    client.loop(timeout=0)
+    return client
+
+
+def test_retained_snapshot_syncs_a_late_joiner_including_dialogue():
+    broker = LoopbackBroker()
+    app, _ = _pi_app(broker)
+    app.publish_state()
+
+    states = []
+    join = SnapshotJoin("ue-1", fmt="bin", request=False)
+    client = _joiner(broker, join, states)
+    client.loop(timeout=0)
+
+    assert join.first_source == "retained"
+    assert states[0].dialogue == "Hello, I am Lafufu."
+    assert states[0].app_state == "Speaking"
+
+
+def test_snapshot_request_is_answered_with_the_current_state():
+    broker = LoopbackBroker()
+    app, bus = _pi_app(broker)
+    app.publish_state()
+    bus.set("head_rot_yaw", 42.0)  # newer than the retained frame
+
+    states = []
+    join = SnapshotJoin("web-1", fmt="json", retained=False)
+    client = _joiner(broker, join, states)
+    app.client.loop(timeout=0)  # Pi handles the request
+    client.loop(timeout=0)
+
+    assert join.first_source == "reply"
+    assert states[0].head_rot_yaw == 42.0
+    assert states[0].dialogue == "Hello, I am Lafufu."
+
+
+def test_retained_snapshot_refreshes_when_dialogue_changes():
+    broker = LoopbackBroker()
+    app, bus = _pi_app(broker)
+    app.snapshot_interval_s = 3600.0
+    app.publish_state()
+    bus.set("dialogue", "Something new")
+    app.publish_state()
+
+    states = []
+    client = _joiner(broker, SnapshotJoin("ue-2", request=False), states)
+    client.loop(timeout=0)
+    assert states[0].dialogue == "Something new"
+
+
+def test_keyframes_decode_alone_and_leave_the_stream_refresh_alone():
+    encoder = StateEncoder(refresh_every=100)
+    state = replace(StateBus().sample(), dialogue="hi")
+
+    first = encoder.encode(state)  # defines the dialogue on the stream
+    keyframe = encoder.encode(state, keyframe=True)
+    second = encoder.encode(state)
+
+    assert StateDecoder().decode(keyframe).dialogue == "hi"
+    assert len(second) < len(first)  # stream still relies on the earlier definition
+    fresh = StateDecoder()
+    assert fresh.decode(second).dialogue == "" and not fresh.dialogue_known
+
+
+def test_request_parsing_rejects_bad_ids_and_formats():
+    assert parse_request(make_request("ue-1", "json")) == ("ue-1", "json")
+    assert parse_request(make_request("a/b")) is None
+    assert parse_request(make_request("ue-1", "delta")) is None
+    assert parse_request(b"not json") is None
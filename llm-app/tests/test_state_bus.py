@@ -0,0 +1,54 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.state_bus import APP_STATE_IDLE, APP_STATE_SPEAKING, StateBus
+
+
+def test_sample_reports_defaults_then_latest_writes():
+    bus = StateBus()
+    state = bus.sample(timestamp=12.5)
+    assert state.timestamp == 12.5
+    assert state.app_state == APP_STATE_IDLE
+    assert state.is_speaking is False
+
+    bus.set("app_state", APP_STATE_SPEAKING)
+    bus.set("is_speaking", True)
+    bus.set("dialogue", "Hello")
+    state = bus.sample()
+    assert (state.app_state, state.is_speaking, state.dialogue) == (APP_STATE_SPEAKING, True, "Hello")
+    assert bus.version("app_state") == 1
+
+
+def test_bound_getter_is_read_only_when_sampled():
+    bus = StateBus()
+    calls = []
+
+    def pitch():
+        calls.append(1)
+        return 42.0
+
+    bus.bind("head_rot_pitch", pitch)
+    assert calls == []
+    assert bus.sample().head_rot_pitch == 42.0
+    assert len(calls) == 1
+
+    bus.bind("head_rot_pitch", None)
+    assert bus.get("head_rot_pitch") == 0.0
+
+
+def test_subscribers_and_unknown_fields():
+    bus = StateBus()
+    seen = []
+    bus.subscribe("audio_level", lambda field, value: seen.append((field, value)))
+    bus.set("audio_level", 0.5)
+    assert seen == [("audio_level", 0.5)]
+
+    with pytest.raises(KeyError):
+        bus.set("timestamp", 1.0)
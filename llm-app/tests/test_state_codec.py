@@ -0,0 +1,106 @@
+import json
+import sys
+from dataclasses import asdict, replace
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.pi_state import PI_STATE_FLOAT_FIELDS, PiState
+from mqtt.state_codec import FIXED_FRAME_SIZE, MAX_FRAME_SIZE, StateDecoder, StateEncoder
+
+
+def _state(**overrides) -> PiState:
+    state = PiState(
+        timestamp=1734000000.125,
+        dialogue="Lafufu thinks hello",
+        app_state="Speaking",
+        arm_pos_x=1.0,
+        arm_pos_y=2.0,
+        arm_pos_z=3.0,
+        arm_rot_pitch=4.0,
+        arm_rot_yaw=5.0,
+        arm_rot_roll=6.0,
+        head_pos_x=7.0,
+        head_pos_y=8.0,
+        head_pos_z=170.0,
+        head_rot_pitch=10.0,
+        head_rot_yaw=11.5,
+        head_rot_roll=12.0,
+        eyes_open=True,
+        audio_level=0.25,
+        is_speaking=True,
+    )
+    return replace(state, **overrides)
+
+
+def test_round_trip_preserves_all_fields():
+    state = _state()
+    decoded = StateDecoder().decode(StateEncoder().encode(state))
+
+    assert decoded.timestamp == state.timestamp
+    assert decoded.dialogue == state.dialogue
+    assert decoded.app_state == state.app_state
+    assert decoded.eyes_open is True
+    assert decoded.is_speaking is True
+    for name in PI_STATE_FLOAT_FIELDS:
+        assert getattr(decoded, name) == pytest.approx(getattr(state, name))
+
+
+def test_frame_is_much_smaller_than_json():
+    state = _state()
+    encoder = StateEncoder()
+    first = encoder.encode(state)
+    second = encoder.encode(state)
+
+    # The dialogue text is only carried when it changes.
+    assert len(first) == FIXED_FRAME_SIZE + 2 + len(state.dialogue)
+    assert len(second) == FIXED_FRAME_SIZE
+    assert len(second) * 5 < len(json.dumps(asdict(state)))
+
+
+def test_late_joiner_learns_dialogue_on_refresh():
+    encoder = StateEncoder(refresh_every=3)
+    frames = [encoder.encode(_state()) for _ in range(4)]
+
+    late = StateDecoder()
+    assert late.decode(frames[1]).dialogue == ""
+    assert late.decode(frames[2]).dialogue == ""
+    assert late.decode(frames[3]).dialogue == "Lafufu thinks hello"
+
+
+def test_unknown_app_state_and_empty_dialogue_are_sent_inline():
+    encoder = StateEncoder()
+    decoder = StateDecoder()
+
+    decoded = decoder.decode(encoder.encode(_state(app_state="Dancing", dialogue="", eyes_open=False)))
+
+    assert decoded.app_state == "Dancing"
+    assert decoded.dialogue == ""
+    assert decoded.eyes_open is False
+
+
+def test_encode_into_writes_into_caller_buffer():
+    buf = bytearray(MAX_FRAME_SIZE)
+    n = StateEncoder().encode_into(_state(dialogue=""), buf, offset=0)
+
+    assert n == FIXED_FRAME_SIZE
+    assert StateDecoder().decode(memoryview(buf)[:n]).head_pos_z == pytest.approx(170.0)
+
+
+def test_decoder_rejects_foreign_payloads():
+    with pytest.raises(ValueError):
+        StateDecoder().decode(json.dumps(asdict(_state())).encode("utf-8"))
+
+
+def test_truncated_frames_raise_value_error():
+    # Dialogue definition and inline app_state tails, cut at every length.
+    frame = StateEncoder().encode(_state(app_state="Dancing"))
+    assert len(frame) > FIXED_FRAME_SIZE + 1 + len("Dancing")
+    for n in range(len(frame)):
+        with pytest.raises(ValueError):
+            StateDecoder().decode(frame[:n])
@@ -0,0 +1,124 @@
+import sys
+from dataclasses import replace
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.pi_state import PiState
+from mqtt.state_delta import HEADER_SIZE, DeltaDecoder, DeltaEncoder
+
+
+BASE = PiState(
+    timestamp=100.0,
+    dialogue="",
+    app_state="Idle",
+    arm_pos_x=0.0,
+    arm_pos_y=0.0,
+    arm_pos_z=0.0,
+    arm_rot_pitch=0.0,
+    arm_rot_yaw=0.0,
+    arm_rot_roll=0.0,
+    head_pos_x=0.0,
+    head_pos_y=0.0,
+    head_pos_z=170.0,
+    head_rot_pitch=0.0,
+    head_rot_yaw=0.0,
+    head_rot_roll=0.0,
+    eyes_open=True,
+    audio_level=0.0,
+    is_speaking=False,
+)
+
+
+def test_unchanged_samples_cost_only_header_and_mask():
+    encoder = DeltaEncoder(keyframe_interval=100)
+    keyframe = encoder.encode(BASE)
+    delta = encoder.encode(replace(BASE, timestamp=100.1))
+
+    assert len(keyframe) > len(delta)
+    assert len(delta) == HEADER_SIZE + 4
+
+
+def test_decoder_rebuilds_full_state_from_deltas():
+    encoder = DeltaEncoder(keyframe_interval=100)
+    decoder = DeltaDecoder()
+
+    samples = [
+        BASE,
+        replace(BASE, timestamp=100.1, head_rot_yaw=12.5),
+        replace(BASE, timestamp=100.2, head_rot_yaw=12.5, app_state="Speaking", is_speaking=True),
+        replace(BASE, timestamp=100.3, head_rot_yaw=12.5, app_state="Speaking", is_speaking=True,
+                dialogue="Lafufu thinks so"),
+    ]
+    decoded = [decoder.decode(encoder.encode(s)) for s in samples]
+
+    last = decoded[-1]
+    assert last.timestamp == pytest.approx(100.3)
+    assert last.head_rot_yaw == pytest.approx(12.5)
+    assert last.app_state == "Speaking"
+    assert last.is_speaking is True
+    assert last.dialogue == "Lafufu thinks so"
+    assert last.head_pos_z == pytest.approx(170.0)
+
+
+def test_changes_below_threshold_are_not_sent():
+    encoder = DeltaEncoder(keyframe_interval=100, thresholds={"head_rot_yaw": 1.0})
+    decoder = DeltaDecoder()
+    decoder.decode(encoder.encode(BASE))
+
+    # Creeping by less than the threshold per step is still sent once the
+    # accumulated error exceeds it, because comparisons use the last sent value.
+    values = []
+    for i in range(1, 6):
+        state = decoder.decode(encoder.encode(replace(BASE, head_rot_yaw=0.4 * i)))
+        values.append(state.head_rot_yaw)
+
+    assert values[0] == 0.0
+    assert values[2] == pytest.approx(1.2)
+    assert all(abs(v - 0.4 * (i + 1)) <= 1.0 for i, v in enumerate(values))
+
+
+def test_gap_waits_for_keyframe_and_join_request_forces_one():
+    encoder = DeltaEncoder(keyframe_interval=100)
+    decoder = DeltaDecoder()
+
+    decoder.decode(encoder.encode(BASE))
+    encoder.encode(replace(BASE, head_rot_yaw=5.0))  # lost on the wire
+    assert decoder.decode(encoder.encode(replace(BASE, head_rot_yaw=6.0))) is None
+    assert decoder.needs_keyframe
+    assert decoder.gaps == 1
+
+    encoder.request_keyframe()
+    state = decoder.decode(encoder.encode(replace(BASE, head_rot_yaw=7.0)))
+    assert state is not None
+    assert state.head_rot_yaw == pytest.approx(7.0)
+
+
+def test_late_joiner_waits_for_periodic_keyframe():
+    encoder = DeltaEncoder(keyframe_interval=3)
+    frames = [encoder.encode(replace(BASE, timestamp=100.0 + i)) for i in range(4)]
+
+    late = DeltaDecoder()
+    assert late.decode(frames[1]) is None
+    assert late.decode(frames[2]) is None
+    assert late.decode(frames[3]).timestamp == pytest.approx(103.0)
+
+
+def test_truncated_frames_raise_value_error():
+    encoder = DeltaEncoder(keyframe_interval=100)
+    keyframe = encoder.encode(replace(BASE, dialogue="Lafufu thinks so"))
+    delta = encoder.encode(replace(BASE, timestamp=100.1, head_rot_yaw=12.5, app_state="Speaking",
+                                   is_speaking=True, dialogue="Lafufu thinks hello"))
+    for n in range(len(keyframe)):
+        with pytest.raises(ValueError):
+            DeltaDecoder().decode(keyframe[:n])
+    for n in range(len(delta)):
+        decoder = DeltaDecoder()
+        decoder.decode(keyframe)  # so the delta is applied rather than ignored
+        with pytest.raises(ValueError):
+            decoder.decode(delta[:n])
@@ -0,0 +1,92 @@
+import json
+import random
+import sys
+import time
+import urllib.error
+import urllib.request
+from pathlib import Path
+
+import pytest
+
+# Ensure llm-app (which contains `stub_server`) is on sys.path so it can be imported
+LLM_APP_DIR = Path(__file__).resolve().parents[1]
+if str(LLM_APP_DIR) not in sys.path:
+    sys.path.insert(0, str(LLM_APP_DIR))
+
+from stub_server import PROFILES, LatencyProfile, StubLlmServer, plan_reply
+
+
+@pytest.fixture
+def server():
+    stub = StubLlmServer(port=0, profile=PROFILES["instant"]).start()
+    yield stub
+    stub.stop()
+
+
+def _post(url, body):
+    request = urllib.request.Request(url, data=json.dumps(body).encode(), headers={"Content-Type": "application/json"})
+    return urllib.request.urlopen(request, timeout=5)
+
+
+def _chat(prompt, stream=True):
+    return {"model": "x", "messages": [{"role": "user", "content": prompt}], "stream": stream}
+
+
+def test_openai_sse_stream_carries_the_reply_and_ends_with_done(server):
+    with _post(server.url + "/v1/chat/completions", _chat("hi")) as r:
+        lines = [line.decode().strip() for line in r if line.strip()]
+    assert lines[-1] == "data: [DONE]"
+    chunks = [json.loads(line[len("data: "):]) for line in lines[:-1]]
+    assert "".join(c["choices"][0]["delta"].get("content", "") for c in chunks) == "You said: hi"
+
+
+def test_ollama_ndjson_stream_ends_with_a_done_chunk(server):
+    with _post(server.url + "/api/chat", _chat("hi")) as r:
+        chunks = [json.loads(line) for line in r if line.strip()]
+    assert "".join(c["message"]["content"] for c in chunks) == "You said: hi"
+    assert chunks[-1]["done"] and not any(c["done"] for c in chunks[:-1])
+
+
+def test_max_tokens_cuts_the_reply(server):
+    with _post(server.url + "/v1/chat/completions", {**_chat("one two three four"), "max_tokens": 2}) as r:
+        lines = [line.decode().strip() for line in r if line.strip()]
+    chunks = [json.loads(line[len("data: "):]) for line in lines[:-1]]
+    assert len([c for c in chunks if c["choices"][0]["delta"].get("content")]) == 2
+
+
+def test_time_to_first_token_follows_the_profile(server):
+    server.update_profile({"ttft_ms": 150.0, "tokens_per_s": 100.0})
+    started = time.perf_counter()
+    with _post(server.url + "/v1/chat/completions", _chat("one two three")) as r:
+        first = r.readline()
+        ttft = time.perf_counter() - started
+        rest = r.read()
+    total = time.perf_counter() - started
+    assert first.startswith(b"data: ")
+    assert 0.15 <= ttft < 0.4
+    assert total >= 0.15 + 4 / 100.0 and b"[DONE]" in rest
+
+
+def test_injected_errors_and_drops(server):
+    server.update_profile({"error_rate": 1.0})
+    with pytest.raises(urllib.error.HTTPError) as excinfo:
+        _post(server.url + "/api/chat", _chat("hi"))
+    excinfo.value.close()
+    assert excinfo.value.code == 500
+
+    server.update_profile({"error_rate": 0.0, "drop_rate": 1.0})
+    with _post(server.url + "/v1/chat/completions", _chat("a b c d e f")) as r:
+        body = r.read()
+    assert b"[DONE]" not in body
+    assert server.stats.errors == 1 and server.stats.drops == 1
+
+
+def test_plans_are_reproducible_per_seed_and_keep_token_order():
+    profile = LatencyProfile(ttft_ms=100.0, tokens_per_s=20.0, jitter_ms=80.0, think_tokens=5, stall_rate=1.0, stall_ms=500.0)
+    a = plan_reply("Hello there, friend.", profile, random.Random("1/1"))
+    b = plan_reply("Hello there, friend.", profile, random.Random("1/1"))
+    assert a == b
+    assert a.tokens[0][1] == "<think>" and "".join(t for _, t in a.tokens).endswith("Hello there, friend.")
+    offsets = [t for t, _ in a.tokens]
+    assert offsets == sorted(offsets) and offsets[0] >= 0.1
+    assert a.stall_at is not None
@@ -0,0 +1,123 @@
+import json
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt` and `telemetry`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.state_bus import StateBus
+from mqtt.transport import LoopbackBroker
+from telemetry.colfile import ColumnReader, ColumnWriter, column_stats
+from telemetry.query import llm_turns, summarize_table
+from telemetry.recorder import EVENTS_TABLE, STATE_TABLE, TelemetryRecorder
+
+SCHEMA = [("t", "d"), ("pitch", "f"), ("speaking", "B"), ("mode", "cat"), ("note", "str")]
+
+
+def _rows(n):
+    return [
+        (100.0 + i * 0.1, float(i % 5), i % 4 < 2, "Speaking" if i % 4 < 2 else "Idle", f"row {i}")
+        for i in range(n)
+    ]
+
+
+def _columns(rows):
+    return {name: [row[i] for row in rows] for i, (name, _) in enumerate(SCHEMA)}
+
+
+def test_row_groups_round_trip_and_range_reads_skip_groups(tmp_path):
+    path = tmp_path / "a.tcol"
+    rows = _rows(10)
+    with ColumnWriter(path, SCHEMA, "t", group_rows=4) as writer:
+        for row in rows:
+            writer.append(row)
+
+    with ColumnReader(path) as reader:
+        assert reader.complete and [g.rows for g in reader.groups] == [4, 4, 2]
+        assert reader.read(["note", "mode"])["note"] == [f"row {i}" for i in range(10)]
+        assert len(reader.groups_in(100.45, 100.65)) == 1
+        data = reader.read(["pitch"], 100.25, 100.65)
+        assert data["t"] == [row[0] for row in rows[3:7]]
+        assert data["pitch"] == [3.0, 4.0, 0.0, 1.0]
+
+
+def test_merged_group_stats_match_stats_over_all_rows(tmp_path):
+    path = tmp_path / "b.tcol"
+    rows = _rows(10)
+    with ColumnWriter(path, SCHEMA, "t", group_rows=4) as writer:
+        for row in rows:
+            writer.append(row)
+
+    expected = column_stats(SCHEMA, _columns(rows), "t")["columns"]
+    with ColumnReader(path) as reader:
+        merged = reader.summarize()["columns"]
+        cut = reader.summarize(100.15, 100.75)
+    assert merged["pitch"]["travel"] == expected["pitch"]["travel"]
+    assert merged["speaking"]["sum"] == expected["speaking"]["sum"] == 6
+    assert merged["mode"]["counts"] == expected["mode"]["counts"]
+    for mode, seconds in expected["mode"]["seconds"].items():
+        assert abs(merged["mode"]["seconds"][mode] - seconds) < 1e-9
+    assert cut["rows"] == 6 and cut["columns"]["pitch"]["first"] == 2.0
+
+
+def test_reader_recovers_groups_from_a_file_without_footer(tmp_path):
+    path = tmp_path / "c.tcol"
+    writer = ColumnWriter(path, SCHEMA, "t", group_rows=4)
+    try:
+        for row in _rows(9):
+            writer.append(row)  # two full groups written, one row still buffered
+
+        with ColumnReader(path) as reader:
+            assert not reader.complete
+            assert reader.rows == 8
+    finally:
+        writer.abandon()
+
+
+def test_background_write_errors_surface_on_the_next_flush_and_close(tmp_path):
+    def disk_full(buffers):
+        raise OSError("No space left on device")
+
+    with ThreadPoolExecutor(max_workers=1) as executor:
+        writer = ColumnWriter(tmp_path / "d.tcol", SCHEMA, "t", group_rows=4, executor=executor)
+        writer._write_group = disk_full
+        rows = _rows(9)
+        for row in rows[:4]:
+            writer.append(row)  # the first group's write fails in the background
+        with pytest.raises(OSError, match="No space"):
+            for row in rows[4:8]:
+                writer.append(row)
+        with pytest.raises(OSError, match="No space"):
+            writer.close()
+
+
+def test_recorder_persists_state_and_events_for_the_query(tmp_path):
+    broker = LoopbackBroker()
+    recorder = TelemetryRecorder(tmp_path, transport=broker, group_rows=2)
+    recorder.client.connect()
+    recorder.client.loop(timeout=0)
+    bus = StateBus()
+    app = PiMqttApp(state_source=bus, transport=broker)
+    app.client.connect()
+    for speaking in (False, True, True):
+        bus.set("is_speaking", speaking)
+        app.publish_state()
+    text = broker.create_client("llm")
+    text.connect()
+    for message in ({"op": "begin", "turn": 1}, {"op": "append", "turn": 1, "text": "Hi"}, {"op": "end", "turn": 1}):
+        text.publish("siggraph/pi/llm/text", json.dumps(message))
+    recorder.client.loop(timeout=0)
+    recorder.close()
+
+    state = summarize_table(tmp_path, "pi", STATE_TABLE)
+    assert state.stats["rows"] == 3
+    assert state.stats["columns"]["is_speaking"]["sum"] == 2
+    events = summarize_table(tmp_path, "pi", EVENTS_TABLE)
+    assert events.stats["columns"]["kind"]["counts"] == {"llm/text:begin": 1, "llm/text:append": 1, "llm/text:end": 1}
+    assert len(llm_turns(tmp_path, "pi").duration_s) == 1
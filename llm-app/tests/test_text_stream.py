@@ -0,0 +1,83 @@
+import json
+import sys
+import time
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.text_stream import TOPIC_LLM_TEXT, ThinkBlockFilter, TextStreamPublisher
+
+
+class Recorder:
+    def __init__(self) -> None:
+        self.messages = []
+
+    def __call__(self, topic, payload):
+        assert topic == TOPIC_LLM_TEXT
+        self.messages.append(json.loads(payload))
+
+
+def test_appends_within_window_are_coalesced_until_end_of_turn():
+    sent = Recorder()
+    stream = TextStreamPublisher(sent, window_s=10.0)
+    try:
+        stream.begin_turn()
+        for token in ("Hel", "lo", " there", "!"):
+            stream.append(token)
+        assert [m["op"] for m in sent.messages] == ["begin"]
+        stream.end_turn()
+    finally:
+        stream.close()
+
+    assert [(m["op"], m["seq"]) for m in sent.messages] == [("begin", 0), ("append", 1), ("end", 2)]
+    assert sent.messages[1]["text"] == "Hello there!"
+    assert stream.stats().appends == 4
+
+
+def test_window_expiry_flushes_without_end_of_turn():
+    sent = Recorder()
+    stream = TextStreamPublisher(sent, window_s=0.01)
+    try:
+        stream.append("tick")  # opens turn 1 implicitly
+        for _ in range(200):
+            if len(sent.messages) == 2:
+                break
+            time.sleep(0.005)
+        assert sent.messages[1] == {"op": "append", "turn": 1, "seq": 1, "text": "tick"}
+    finally:
+        stream.close()
+    assert sent.messages[-1]["op"] == "end"
+
+
+def test_zero_window_sends_every_append_and_new_turn_restarts_seq():
+    sent = Recorder()
+    stream = TextStreamPublisher(sent, window_s=0.0)
+    stream.append("a")
+    stream.append("b")
+    stream.begin_turn()
+    stream.close()
+
+    assert [(m["op"], m["turn"], m["seq"]) for m in sent.messages] == [
+        ("begin", 1, 0), ("append", 1, 1), ("append", 1, 2), ("end", 1, 3),
+        ("begin", 2, 0), ("end", 2, 1),
+    ]
+
+
+@pytest.mark.parametrize(
+    "chunks, expected",
+    [
+        (["Hi <thi", "nk>plan</th", "ink> there"], "Hi  there"),
+        (["<thinking>x</thinking>ok"], "ok"),
+        (["a < b", " <3"], "a < b <3"),
+        (["unterminated <think>secret"], "unterminated "),
+    ],
+)
+def test_think_block_filter_handles_tags_split_across_chunks(chunks, expected):
+    f = ThinkBlockFilter()
+    out = "".join(f.feed(c) for c in chunks) + f.flush()
+    assert out == expected
@@ -0,0 +1,111 @@
+import json
+import sys
+import threading
+import time
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (which contains `mqtt`) is on sys.path so it can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.insert(0, str(REPO_ROOT))
+
+from mqtt.commands import SpeakCommand
+from mqtt.pi_mqtt_app import TOPIC_COMMANDS, TOPIC_STATE, PiMqttApp
+from mqtt.state_codec import StateDecoder
+from mqtt.transport import MQTT_ERR_NO_CONN, LoopbackBroker, topic_matches
+
+
+@pytest.mark.parametrize(
+    "topic_filter, topic, expected",
+    [
+        ("siggraph/pi/state", "siggraph/pi/state", True),
+        ("siggraph/+/state", "siggraph/pi/state", True),
+        ("siggraph/+/state", "siggraph/pi/state/bin", False),
+        ("siggraph/#", "siggraph/pi/state/bin", True),
+        ("siggraph/pi/state/#", "siggraph/pi/state", True),
+        ("siggraph/pi/state", "siggraph/pi", False),
+    ],
+)
+def test_topic_matches(topic_filter, topic, expected):
+    assert topic_matches(topic_filter, topic) is expected
+
+
+def _connected(broker, client_id):
+    client = broker.create_client(client_id)
+    client.connect()
+    return client
+
+
+def test_loopback_delivers_the_published_object_without_copying():
+    broker = LoopbackBroker()
+    sub_a = _connected(broker, "a")
+    sub_b = _connected(broker, "b")
+    received = []
+    for sub in (sub_a, sub_b):
+        sub.on_message = lambda client, userdata, msg: received.append(msg)
+        sub.subscribe("siggraph/+/state/#")
+        sub.subscribe("siggraph/pi/state/bin")  # overlapping filter: still one delivery
+
+    payload = bytearray(b"\x01\x02")
+    pub = _connected(broker, "pub")
+    assert pub.publish("siggraph/pi/state/bin", payload).rc == 0
+    sub_a.loop(timeout=0)
+    sub_b.loop(timeout=0)
+
+    assert len(received) == 2
+    assert received[0] is received[1]
+    assert received[0].payload is payload
+
+    pub.disconnect()
+    assert pub.publish("siggraph/pi/state", "x").rc == MQTT_ERR_NO_CONN
+
+
+def test_retained_messages_reach_late_subscribers():
+    broker = LoopbackBroker()
+    pub = _connected(broker, "pub")
+    pub.publish("siggraph/pi/state", '{"app_state": "Idle"}', retain=True)
+
+    sub = _connected(broker, "sub")
+    received = []
+    sub.on_message = lambda client, userdata, msg: received.append(msg.payload)
+    sub.subscribe("siggraph/pi/#")
+    sub.loop(timeout=0)
+    assert received == [b'{"app_state": "Idle"}']
+
+
+def test_pi_app_end_to_end_over_loopback():
+    broker = LoopbackBroker()
+    app = PiMqttApp(transport=broker, publish_rate_hz=200.0)
+    spoken = []
+    app.commands.register(SpeakCommand.KIND, spoken.append)
+
+    viewer = _connected(broker, "viewer")
+    frames = []
+    viewer.on_message = lambda client, userdata, msg: frames.append(msg.payload)
+    viewer.subscribe(TOPIC_STATE + "/bin")
+    viewer.loop_start()
+
+    runner = threading.Thread(target=app.start, daemon=True)
+    runner.start()
+    try:
+        remote = _connected(broker, "remote")
+        for _ in range(200):
+            if broker.subscriber_count(TOPIC_COMMANDS):
+                break
+            time.sleep(0.005)
+        remote.publish(TOPIC_COMMANDS, json.dumps({"cmd": "speak", "text": "hi"}))
+        for _ in range(200):
+            if spoken and len(frames) >= 5:
+                break
+            time.sleep(0.005)
+    finally:
+        app.stop()
+        runner.join(timeout=2.0)
+        viewer.loop_stop()
+
+    assert spoken == [SpeakCommand(text="hi")]
+    decoder = StateDecoder()
+    states = [decoder.decode(frame) for frame in frames[:5]]
+    assert all(s.timestamp > 0 for s in states)
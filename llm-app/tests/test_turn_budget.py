@@ -0,0 +1,146 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+# Ensure the repo root (`telemetry`) and s2t-llm-t2s (`turn_budget`) are on sys.path so they can be imported
+REPO_ROOT = Path(__file__).resolve().parents[2]
+for p in (REPO_ROOT, REPO_ROOT / "s2t-llm-t2s"):
+    if str(p) not in sys.path:
+        sys.path.insert(0, str(p))
+
+from telemetry.metrics import Registry
+from turn_budget import (
+    LLM_BACKUP,
+    LLM_PRIMARY,
+    MIN_REPLY_TOKENS,
+    STT_FALLBACK,
+    LatencyModel,
+    TtsCache,
+    TurnScheduler,
+)
+
+
+class FakeClock:
+    def __init__(self):
+        self.now = 100.0
+
+    def __call__(self):
+        return self.now
+
+
+def _scheduler(clock, **kwargs):
+    # safety 1.0 so the arithmetic below is exact
+    kwargs.setdefault("target_s", 5.0)
+    return TurnScheduler(max_tokens=256, model=LatencyModel(safety=1.0), clock=clock, **kwargs)
+
+
+def _observe_servers(m):
+    for _ in range(10):
+        m.observe("llm_ttft:" + LLM_PRIMARY, 1.0)
+        m.observe("llm_token:" + LLM_PRIMARY, 0.03)
+        m.observe("llm_ttft:" + LLM_BACKUP, 0.2)
+        m.observe("llm_token:" + LLM_BACKUP, 0.01)
+        m.observe("tts_overhead", 0.4)
+        m.observe("tts_char", 0.005)
+
+
+def test_a_reply_that_fits_is_not_degraded():
+    clock = FakeClock()
+    scheduler = _scheduler(clock, target_s=20.0, have_backup_llm=True)
+    _observe_servers(scheduler.model)
+    turn = scheduler.begin_turn(heard=clock.now)
+    clock.now += 1.0  # STT took a second
+    assert turn.remaining() == pytest.approx(19.0)
+    plan = scheduler.plan_llm(turn)
+    assert (plan.variant, plan.max_tokens, plan.filler) == (LLM_PRIMARY, 256, None)
+    assert plan.timeout == pytest.approx(19.0)
+    assert turn.report.degradations == []
+
+
+def test_reply_is_capped_then_moved_to_backup_then_covered_by_a_filler():
+    clock = FakeClock()
+    scheduler = _scheduler(clock, have_backup_llm=True, fillers=("One moment.",))
+    _observe_servers(scheduler.model)
+
+    assert scheduler.token_cap(LLM_PRIMARY, 4.61) == 64  # (4.61 - 1.0 - 0.4) / (0.03 + 0.02)
+    assert scheduler.token_cap(LLM_PRIMARY, 2.02) == 12  # under MIN_REPLY_TOKENS
+    assert scheduler.token_cap(LLM_BACKUP, 2.02) == 47
+
+    cases = (
+        # Time spent before the LLM is planned, then the plan.
+        (0.39, (LLM_PRIMARY, 64, None), ["max_tokens"]),
+        (2.98, (LLM_BACKUP, 47, None), ["llm_backup", "max_tokens"]),
+        # Nothing fits: filler, then the reply gets a fresh 5 s on the faster server.
+        (4.5, (LLM_BACKUP, 146, "One moment."), ["filler", "llm_backup", "max_tokens"]),
+    )
+    for spent, expected, actions in cases:
+        turn = scheduler.begin_turn(heard=clock.now)
+        clock.now += spent
+        assert turn.remaining() == pytest.approx(5.0 - spent)
+        plan = scheduler.plan_llm(turn)
+        assert (plan.variant, plan.max_tokens, plan.filler) == expected
+        assert [d["action"] for d in turn.report.degradations] == actions
+    # The filler is in the turn's report, so a replay can speak it again.
+    assert turn.report.degradations[0]["filler"] == "One moment."
+
+
+def test_a_turn_past_its_deadline_gets_the_minimum_reply_and_timeout():
+    clock = FakeClock()
+    scheduler = _scheduler(clock)
+    _observe_servers(scheduler.model)
+    turn = scheduler.begin_turn(heard=clock.now)
+    clock.now += 6.0  # already a second late, no filler or backup to fall back on
+    assert turn.remaining() == pytest.approx(-1.0)
+    plan = scheduler.plan_llm(turn)
+    assert (plan.variant, plan.max_tokens, plan.filler) == (LLM_PRIMARY, MIN_REPLY_TOKENS, None)
+    assert plan.timeout == 1.0
+    assert [d["action"] for d in turn.report.degradations] == ["max_tokens"]
+
+
+def test_stt_fallback_is_chosen_when_the_primary_is_predicted_late():
+    clock = FakeClock()
+    scheduler = _scheduler(clock, have_stt_fallback=True)
+    turn = scheduler.begin_turn(heard=clock.now)
+    plan = scheduler.plan_stt(turn)
+    assert plan.timeout == 1.5 and plan.fallback  # 30% of 5 s; priors fit
+
+    for _ in range(5):
+        scheduler.observe_stt("google", 3.0)
+        scheduler.observe_stt(STT_FALLBACK, 0.8)
+    plan = scheduler.plan_stt(turn)
+    assert plan.variant == STT_FALLBACK and not plan.fallback
+    assert turn.report.degradations[-1]["action"] == "stt_fallback"
+
+
+def test_turn_reports_feed_metrics_and_move_the_safety_factor(tmp_path):
+    registry = Registry()
+    clock = FakeClock()
+    scheduler = TurnScheduler(target_s=1.0, registry=registry, clock=clock)
+    calls = []
+
+    def synthesize(text, output_path, lang="en"):
+        clock.now += 1.5
+        calls.append(text)
+        Path(output_path).write_bytes(b"mp3:" + text.encode())
+        return Path(output_path)
+
+    cache = TtsCache(synthesize, tmp_path / "cache")
+    speak = scheduler.wrap_synthesize(cache)
+    play = scheduler.wrap_play(lambda path: None)
+
+    safety = scheduler.model.safety
+    turn = scheduler.begin_turn(heard=clock.now)
+    play(speak("Hello.", tmp_path / "speech.mp3"))  # 1.5 s of synthesis: a miss
+    report = scheduler.end_turn(turn)
+    assert report.first_audio_s == 1.5 and report.met is False
+    assert report.stages["tts"] == {"chars": 6, "seconds": 1.5}
+    assert scheduler.model.safety > safety
+
+    assert speak("Hello.", tmp_path / "speech.mp3").read_bytes() == b"mp3:Hello."
+    assert calls == ["Hello."] and cache.hits == 1
+    assert cache.prewarm(("Hello.", "One moment.")) == ["Hello.", "One moment."]
+
+    text = registry.render()
+    assert "robot_first_audio_seconds_count 1\n" in text
+    assert "robot_turn_budget_missed_total 1\n" in text
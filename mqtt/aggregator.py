@@ -0,0 +1,263 @@
+"""Fleet view: follow every robot's state stream and keep the latest per robot.
+
+Subscribes to `siggraph/+/state<suffix>` for one wire format, decodes each
+robot's stream with its own decoder (binary frames intern dialogue strings
+and delta frames depend on the previous sample, so decoders can't be
+shared), and keeps a table of `RobotStatus` entries keyed by device id.
+
+Each update replaces the robot's entry with a new immutable object, so
+dashboards can read `snapshot()` from any thread without locks. Decoding
+runs on the MQTT network thread; it is a few microseconds per frame, which
+keeps dozens of robots at 60 Hz well within one core (see
+`loadtest_robots.py`).
+
+For json and bin the retained snapshots (`state<suffix>/snapshot`, see
+snapshot.py) are followed too, so a freshly started aggregator lists every
+robot at once instead of after each one's next tick.
+
+Optionally the table is published as JSON on `TOPIC_AGGREGATE` (retained)
+for web dashboards.
+
+Run from the repository root:
+    python3 -m mqtt.aggregator --format bin --print-interval 2
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import threading
+import time
+from dataclasses import asdict, dataclass
+from typing import Any
+
+from telemetry.ringlog import get_logger
+
+from .pi_mqtt_app import BROKER_HOST, BROKER_PORT, KEEPALIVE
+from .pi_state import PiState
+from .snapshot import SNAPSHOT_FORMATS, SNAPSHOT_SUFFIX
+from .state_codec import STATE_FORMAT_SUFFIXES, StateDecoder
+from .state_delta import JOIN_SUFFIX, DeltaDecoder
+from .topics import TOPIC_AGGREGATE, TOPIC_ROOT, all_devices, device_from_topic
+from .transport import PahoTransport, Transport
+
+
+log = get_logger("MQTT")
+
+OFFLINE_AFTER_SECONDS = 2.0
+KEYFRAME_REQUEST_INTERVAL_SECONDS = 0.5
+RATE_SMOOTHING = 0.1  # EWMA weight of the newest inter-arrival interval
+
+
+@dataclass(frozen=True)
+class RobotStatus:
+    device_id: str
+    state: PiState
+    received_at: float  # aggregator's time.time() at receipt
+    messages: int
+    rate_hz: float  # smoothed receive rate
+    decode_errors: int
+
+    def age(self, now: float | None = None) -> float:
+        return (time.time() if now is None else now) - self.received_at
+
+    def online(self, now: float | None = None) -> bool:
+        return self.age(now) < OFFLINE_AFTER_SECONDS
+
+
+class _JsonDecoder:
+    @staticmethod
+    def decode(payload: bytes) -> PiState:
+        return PiState(**json.loads(payload))
+
+
+class _Stream:
+    """Per-robot decoding state, touched only on the network thread."""
+
+    __slots__ = ("decoder", "messages", "errors", "last_at", "interval", "keyframe_requested_at")
+
+    def __init__(self, decoder: Any) -> None:
+        self.decoder = decoder
+        self.messages = 0
+        self.errors = 0
+        self.last_at: float | None = None
+        self.interval: float | None = None
+        self.keyframe_requested_at = 0.0
+
+
+def _make_decoder(fmt: str) -> Any:
+    if fmt == "json":
+        return _JsonDecoder()
+    if fmt == "bin":
+        return StateDecoder()
+    return DeltaDecoder()
+
+
+class StateAggregator:
+    """Latest-state table for every robot publishing in one format."""
+
+    def __init__(
+        self,
+        broker_host: str = BROKER_HOST,
+        broker_port: int = BROKER_PORT,
+        fmt: str = "bin",
+        transport: Transport | None = None,
+        client_id: str = "state-aggregator",
+    ) -> None:
+        if fmt not in STATE_FORMAT_SUFFIXES:
+            raise ValueError(f"Unknown state format {fmt!r}; expected one of {sorted(STATE_FORMAT_SUFFIXES)}")
+        self.broker_host = broker_host
+        self.broker_port = broker_port
+        self.fmt = fmt
+        self.suffix = STATE_FORMAT_SUFFIXES[fmt]
+        self.topic_filter = all_devices("state" + self.suffix)
+        self.snapshot_filter = all_devices("state" + self.suffix + SNAPSHOT_SUFFIX) if fmt in SNAPSHOT_FORMATS else None
+
+        self._streams: dict[str, _Stream] = {}
+        self._table: dict[str, RobotStatus] = {}
+        self.unrouted = 0
+
+        transport = transport if transport is not None else PahoTransport()
+        self.client = transport.create_client(client_id)
+        self.client.on_connect = self._on_connect
+        self.client.on_message = self._on_message
+
+    # MQTT ---------------------------------------------------------------
+
+    def _on_connect(self, client, userdata, flags, rc):  # type: ignore[override]
+        if rc != 0:
+            log.error("Aggregator failed to connect, return code %s", rc)
+            return
+        # Frames may have been missed while disconnected: start every robot's
+        # decoder afresh (delta streams then request a keyframe).
+        self._streams.clear()
+        client.subscribe(self.topic_filter, qos=0)
+        if self.snapshot_filter is not None:
+            client.subscribe(self.snapshot_filter, qos=0)
+        log.info("Aggregator subscribed to %s", self.topic_filter)
+
+    def _on_message(self, client, userdata, msg):  # type: ignore[override]
+        received_at = time.time()
+        device_id = device_from_topic(msg.topic)
+        if device_id is None:
+            self.unrouted += 1
+            return
+
+        stream = self._streams.get(device_id)
+        if stream is None:
+            stream = self._streams[device_id] = _Stream(_make_decoder(self.fmt))
+
+        stream.messages += 1
+        # Snapshots are extra copies on their own cadence; keep them out of the rate.
+        if not msg.topic.endswith(SNAPSHOT_SUFFIX):
+            if stream.last_at is not None:
+                dt = received_at - stream.last_at
+                stream.interval = dt if stream.interval is None else stream.interval + RATE_SMOOTHING * (dt - stream.interval)
+            stream.last_at = received_at
+
+        try:
+            state = stream.decoder.decode(msg.payload)
+        except (ValueError, TypeError, KeyError) as exc:
+            stream.errors += 1
+            if stream.errors == 1:
+                log.warning("Aggregator: bad frame from %s: %s", device_id, exc)
+            return
+        if state is None:  # delta stream waiting for a keyframe (fresh join or gap)
+            if received_at - stream.keyframe_requested_at >= KEYFRAME_REQUEST_INTERVAL_SECONDS:
+                stream.keyframe_requested_at = received_at
+                self._request_keyframe(device_id)
+            return
+
+        self._table[device_id] = RobotStatus(
+            device_id=device_id,
+            state=state,
+            received_at=received_at,
+            messages=stream.messages,
+            rate_hz=(1.0 / stream.interval) if stream.interval else 0.0,
+            decode_errors=stream.errors,
+        )
+
+    def _request_keyframe(self, device_id: str) -> None:
+        join_topic = f"{TOPIC_ROOT}/{device_id}/state{self.suffix}{JOIN_SUFFIX}"
+        self.client.publish(join_topic, payload=b"", qos=0, retain=False)
+
+    # Public API ---------------------------------------------------------
+
+    def connect(self) -> None:
+        self.client.connect(self.broker_host, self.broker_port, KEEPALIVE)
+        self.client.loop_start()
+
+    def stop(self) -> None:
+        try:
+            self.client.disconnect()
+        finally:
+            self.client.loop_stop()
+
+    def snapshot(self) -> dict[str, RobotStatus]:
+        """Latest status per robot (a copy; safe to read from any thread)."""
+        return dict(self._table)
+
+    def table_json(self, now: float | None = None) -> str:
+        now = time.time() if now is None else now
+        return json.dumps({
+            "ts": now,
+            "robots": {
+                device_id: {
+                    "online": status.online(now),
+                    "age_ms": round(status.age(now) * 1000.0, 1),
+                    "rate_hz": round(status.rate_hz, 1),
+                    "messages": status.messages,
+                    "decode_errors": status.decode_errors,
+                    "state": asdict(status.state),
+                }
+                for device_id, status in sorted(self.snapshot().items())
+            },
+        })
+
+    def publish_table(self) -> None:
+        self.client.publish(TOPIC_AGGREGATE, payload=self.table_json(), qos=0, retain=True)
+
+
+def _print_table(aggregator: StateAggregator) -> None:
+    now = time.time()
+    rows = sorted(aggregator.snapshot().values(), key=lambda s: s.device_id)
+    online = sum(1 for s in rows if s.online(now))
+    print(f"--- {online}/{len(rows)} robots online ---")
+    for s in rows:
+        print(
+            f"{s.device_id:<16} {'up ' if s.online(now) else 'OFF'} {s.rate_hz:6.1f} Hz  age {s.age(now) * 1000:7.1f} ms  "
+            f"{s.state.app_state:<10} speaking={s.state.is_speaking!s:<5} {s.state.dialogue[:40]!r}"
+        )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Aggregate all robots' state streams into one table.")
+    parser.add_argument("--host", default=BROKER_HOST, help="Broker host (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=BROKER_PORT, help="Broker port (default: %(default)s).")
+    parser.add_argument("--format", dest="fmt", choices=sorted(STATE_FORMAT_SUFFIXES), default="bin",
+                        help="State stream to follow (default: %(default)s).")
+    parser.add_argument("--print-interval", type=float, default=2.0, help="Seconds between table prints (default: %(default)s).")
+    parser.add_argument("--publish-interval", type=float, default=0.5,
+                        help=f"Seconds between {TOPIC_AGGREGATE} updates, 0 = off (default: %(default)s).")
+    args = parser.parse_args()
+
+    aggregator = StateAggregator(args.host, args.port, fmt=args.fmt)
+    aggregator.connect()
+    stop = threading.Event()
+    next_print = time.monotonic() + args.print_interval
+    step = min(x for x in (args.print_interval, args.publish_interval) if x > 0)
+    try:
+        while not stop.wait(step):
+            if args.publish_interval > 0:
+                aggregator.publish_table()
+            if time.monotonic() >= next_print:
+                next_print += args.print_interval
+                _print_table(aggregator)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        aggregator.stop()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+"""Robot speech audio on `siggraph/<device>/audio`, for the twin to play along.
+
+The speaker tees the PCM it plays into `AudioStreamPublisher`, which cuts it
+into 20 ms frames, encodes each one and publishes it with the Pi time at
+which the robot plays it. Browsers receive the same frames over the broker's
+WebSocket listener (port 9001) and play them through a jitter buffer
+(`s2t-llm-t2s/mqtt_demo/web/audioplayer.js`).
+
+Codecs
+------
+- Opus (`pip install opuslib`, needs libopus): ~24 kbit/s for speech.
+- 16-bit little-endian PCM: the fallback when opuslib is missing,
+  768 kbit/s at 48 kHz mono. Fine on a LAN; use Opus anywhere else.
+
+Wire format (one MQTT message per frame, little-endian)
+-------------------------------------------------------
+    offset  size  field
+    0       2     magic b"PA"
+    2       1     version (1)
+    3       1     codec (0 = PCM s16le, 1 = Opus)
+    4       2     utterance id (wraps at 65536)
+    6       4     frame seq within the utterance, from 0
+    10      8     Pi `time.time()` at which the frame's first sample plays
+    18      2     valid samples in the frame (<= 960; 0 = end of utterance)
+    20      ...   codec payload
+
+Audio is always 48 kHz mono; Opus frames are padded to a full 20 ms.
+
+Measure bitrate, encode CPU and latency with `bench_audio_stream.py`.
+"""
+
+from __future__ import annotations
+
+import os
+import struct
+import time
+from dataclasses import dataclass
+from typing import Any, Callable
+
+try:
+    import opuslib
+except (ImportError, OSError):  # OSError: binding present but libopus missing
+    opuslib = None
+
+
+SAMPLE_RATE = 48000
+FRAME_MS = 20
+FRAME_SAMPLES = SAMPLE_RATE * FRAME_MS // 1000
+FRAME_BYTES = FRAME_SAMPLES * 2  # s16 mono
+
+MAGIC = b"PA"
+VERSION = 1
+CODEC_PCM16 = 0
+CODEC_OPUS = 1
+CODEC_NAMES = {"pcm16": CODEC_PCM16, "opus": CODEC_OPUS}
+
+_HEADER = struct.Struct("<2sBBHIdH")
+HEADER_SIZE = _HEADER.size
+
+DEFAULT_CODEC = os.environ.get("AUDIO_STREAM_CODEC", "auto")
+DEFAULT_BITRATE = int(os.environ.get("AUDIO_STREAM_BITRATE", "24000"))
+
+
+def opus_available() -> bool:
+    return opuslib is not None
+
+
+def resolve_codec(name: str = DEFAULT_CODEC) -> int:
+    """Codec id for "auto" | "opus" | "pcm16"; "auto" prefers Opus when available."""
+    if name == "auto":
+        return CODEC_OPUS if opuslib is not None else CODEC_PCM16
+    if name not in CODEC_NAMES:
+        raise ValueError(f"Unknown audio codec {name!r}; expected auto, opus or pcm16")
+    if CODEC_NAMES[name] == CODEC_OPUS and opuslib is None:
+        raise ImportError("opuslib is required for Opus audio (pip install opuslib; apt install libopus0)")
+    return CODEC_NAMES[name]
+
+
+@dataclass(frozen=True)
+class AudioFrame:
+    codec: int
+    utterance: int
+    seq: int
+    play_time: float  # Pi time.time() of the first sample
+    samples: int  # 0 marks the end of an utterance
+    payload: bytes
+
+    @property
+    def is_end(self) -> bool:
+        return self.samples == 0
+
+
+def pack_frame(codec: int, utterance: int, seq: int, play_time: float, samples: int, payload: bytes) -> bytes:
+    return _HEADER.pack(MAGIC, VERSION, codec, utterance & 0xFFFF, seq, play_time, samples) + payload
+
+
+def unpack_frame(data: bytes) -> AudioFrame:
+    if len(data) < HEADER_SIZE:
+        raise ValueError(f"Audio frame too short: {len(data)} bytes")
+    magic, version, codec, utterance, seq, play_time, samples = _HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"Not an audio frame (magic {magic!r}, version {version})")
+    if codec not in (CODEC_PCM16, CODEC_OPUS) or samples > FRAME_SAMPLES:
+        raise ValueError(f"Bad audio frame header (codec {codec}, {samples} samples)")
+    return AudioFrame(codec, utterance, seq, play_time, samples, bytes(data[HEADER_SIZE:]))
+
+
+class _Encoder:
+    """Frame encoder for one codec; Opus keeps state across an utterance."""
+
+    def __init__(self, codec: int, bitrate: int) -> None:
+        self.codec = codec
+        self.bitrate = bitrate
+        self._opus: Any = None
+        if codec == CODEC_OPUS:
+            self._opus = opuslib.Encoder(SAMPLE_RATE, 1, opuslib.APPLICATION_VOIP)
+            self._opus.bitrate = bitrate
+
+    def encode(self, pcm: bytes) -> bytes:
+        if self.codec == CODEC_PCM16:
+            return pcm
+        if len(pcm) < FRAME_BYTES:
+            pcm = pcm + bytes(FRAME_BYTES - len(pcm))
+        return self._opus.encode(pcm, FRAME_SAMPLES)
+
+
+class AudioDecoder:
+    """Subscriber side: frame payload back to s16le PCM (one decoder per stream)."""
+
+    def __init__(self) -> None:
+        self._opus: Any = None
+
+    def decode(self, frame: AudioFrame) -> bytes:
+        if frame.codec == CODEC_PCM16:
+            return frame.payload
+        if opuslib is None:
+            raise ImportError("opuslib is required to decode Opus audio")
+        if self._opus is None:
+            self._opus = opuslib.Decoder(SAMPLE_RATE, 1)
+        return self._opus.decode(frame.payload, FRAME_SAMPLES)[: frame.samples * 2]
+
+
+@dataclass
+class AudioStreamStats:
+    frames: int
+    utterances: int
+    audio_seconds: float
+    payload_bytes: int  # including headers, i.e. what goes on the wire per message
+    encode_cpu_s: float  # CPU time spent in the encoder (thread time)
+
+    @property
+    def bitrate_kbps(self) -> float:
+        return self.payload_bytes * 8 / self.audio_seconds / 1000.0 if self.audio_seconds else 0.0
+
+    @property
+    def encode_cpu_percent(self) -> float:
+        """Encoder CPU as a share of one core while audio is playing."""
+        return 100.0 * self.encode_cpu_s / self.audio_seconds if self.audio_seconds else 0.0
+
+    def summary(self) -> str:
+        per_frame = self.encode_cpu_s / self.frames * 1e6 if self.frames else 0.0
+        return (
+            f"{self.frames} frames / {self.utterances} utterances, {self.audio_seconds:.1f} s audio, "
+            f"{self.bitrate_kbps:.1f} kbit/s, encode {per_frame:.0f} us/frame ({self.encode_cpu_percent:.2f}% of a core)"
+        )
+
+
+class AudioStreamPublisher:
+    """Frames, encodes and publishes the PCM of each utterance.
+
+    Feed s16le 48 kHz mono PCM with `send(pcm, play_time)` in playback order,
+    bracketed by `begin_utterance()` / `end_utterance()`. Chunks of any size
+    are accepted; `play_time` is the Pi time at which the chunk's first sample
+    plays. Calls come from one thread (the speaker's tee).
+    """
+
+    def __init__(
+        self,
+        publish: Callable[[str, bytes], Any],
+        topic: str,
+        codec: str = DEFAULT_CODEC,
+        bitrate: int = DEFAULT_BITRATE,
+    ) -> None:
+        self._publish = publish
+        self.topic = topic
+        self.codec = resolve_codec(codec)
+        self.bitrate = bitrate
+        self._encoder: _Encoder | None = None
+        self._utterance = 0
+        self._seq = 0
+        self._pending = b""
+        self._pending_time = 0.0
+
+        self._frames = 0
+        self._utterances = 0
+        self._samples = 0
+        self._bytes = 0
+        self._encode_cpu = 0.0
+
+    def begin_utterance(self) -> None:
+        if self._encoder is not None:
+            self.end_utterance()
+        self._utterance = (self._utterance + 1) & 0xFFFF
+        self._seq = 0
+        self._pending = b""
+        self._encoder = _Encoder(self.codec, self.bitrate)
+        self._utterances += 1
+
+    def send(self, pcm: bytes, play_time: float) -> None:
+        if self._encoder is None:
+            self.begin_utterance()
+        if not self._pending:
+            self._pending_time = play_time
+        self._pending += pcm
+        while len(self._pending) >= FRAME_BYTES:
+            self._emit(self._pending[:FRAME_BYTES])
+            self._pending = self._pending[FRAME_BYTES:]
+
+    def end_utterance(self) -> None:
+        """Flush the partial last frame and publish the end marker."""
+        if self._encoder is None:
+            return
+        if len(self._pending) >= 2:
+            self._emit(self._pending[: len(self._pending) // 2 * 2])
+        self._pending = b""
+        self._publish(self.topic, pack_frame(self.codec, self._utterance, self._seq, self._pending_time, 0, b""))
+        self._encoder = None
+
+    def _emit(self, pcm: bytes) -> None:
+        samples = len(pcm) // 2
+        started = time.thread_time()
+        payload = self._encoder.encode(pcm)
+        self._encode_cpu += time.thread_time() - started
+
+        message = pack_frame(self.codec, self._utterance, self._seq, self._pending_time, samples, payload)
+        self._publish(self.topic, message)
+        self._seq += 1
+        self._frames += 1
+        self._samples += samples
+        self._bytes += len(message)
+        self._pending_time += samples / SAMPLE_RATE
+
+    def stats(self) -> AudioStreamStats:
+        return AudioStreamStats(
+            frames=self._frames,
+            utterances=self._utterances,
+            audio_seconds=self._samples / SAMPLE_RATE,
+            payload_bytes=self._bytes,
+            encode_cpu_s=self._encode_cpu,
+        )
@@ -0,0 +1,162 @@
+"""Bitrate, encode CPU and delivery latency of the speech audio stream.
+
+Streams `--seconds` of audio through `AudioStreamPublisher` in real time
+(one 20 ms frame per tick, stamped `--lead-ms` ahead of "now", like the
+speaker's tee) to a subscriber in the same process that decodes every frame.
+Both ends share a clock, so latency is measured directly:
+
+- latency: publish -> decoded at the subscriber (transport + decode)
+- late: frames decoded after their play time; a twin playing in step with
+  the robot would have to drop or delay them. Raise AUDIO_TEE_LEAD_MS above
+  p99 latency plus the browser's output latency to avoid them.
+
+Glass-to-glass for a browser is this latency plus the jitter-buffer delay
+and the sound card's output latency (both shown by the web page).
+
+The input is a synthetic voice-like signal unless `--input` names an audio
+file (decoded with ffmpeg). Uses `LoopbackBroker` unless `--host` is given.
+
+Run from the repository root:
+    python3 -m mqtt.bench_audio_stream --codec pcm16
+    python3 -m mqtt.bench_audio_stream --host localhost --input s2t-llm-t2s/speech.mp3
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import subprocess
+import threading
+import time
+
+from .audio_stream import (
+    FRAME_BYTES,
+    FRAME_SAMPLES,
+    SAMPLE_RATE,
+    AudioDecoder,
+    AudioStreamPublisher,
+    opus_available,
+    unpack_frame,
+)
+from .pacing import DeadlineTicker
+from .topics import DeviceTopics
+from .transport import LoopbackBroker, PahoTransport
+
+
+def synthetic_voice(seconds: float) -> bytes:
+    """Harmonics of a gliding 120-180 Hz pitch, amplitude-modulated at syllable rate."""
+    out = bytearray()
+    phase = 0.0
+    for i in range(int(seconds * SAMPLE_RATE)):
+        t = i / SAMPLE_RATE
+        f0 = 150.0 + 30.0 * math.sin(2 * math.pi * 0.5 * t)
+        phase += 2 * math.pi * f0 / SAMPLE_RATE
+        envelope = max(0.0, math.sin(2 * math.pi * 4.0 * t))
+        value = sum(math.sin(k * phase) / k for k in range(1, 6)) * envelope * 0.3
+        out += int(max(-1.0, min(1.0, value)) * 32767).to_bytes(2, "little", signed=True)
+    return bytes(out)
+
+
+def decode_file(path: str) -> bytes:
+    cmd = ["ffmpeg", "-loglevel", "error", "-i", path, "-f", "s16le", "-ac", "1", "-ar", str(SAMPLE_RATE), "-"]
+    return subprocess.run(cmd, check=True, capture_output=True).stdout
+
+
+def _percentile(ordered: list[float], q: float) -> float:
+    return ordered[min(len(ordered) - 1, int(len(ordered) * q))]
+
+
+def run(args: argparse.Namespace, pcm: bytes) -> None:
+    transport = PahoTransport() if args.host else LoopbackBroker()
+    topic = DeviceTopics().audio
+    lead = args.lead_ms / 1000.0
+    frames = len(pcm) // FRAME_BYTES
+
+    latencies: list[float] = []
+    late = 0
+    decode_cpu = 0.0
+    done = threading.Event()
+    decoder = AudioDecoder()
+
+    def on_message(client, userdata, msg) -> None:
+        nonlocal late, decode_cpu
+        frame = unpack_frame(msg.payload)
+        if frame.is_end:
+            done.set()
+            return
+        started = time.thread_time()
+        decoder.decode(frame)
+        decode_cpu += time.thread_time() - started
+        now = time.time()
+        latencies.append(now - (frame.play_time - lead))
+        if now > frame.play_time:
+            late += 1
+
+    subscribed = threading.Event()
+    sub = transport.create_client("bench-audio-sub")
+    sub.on_message = on_message
+    sub.on_connect = lambda client, userdata, flags, rc: (client.subscribe(topic, qos=0), subscribed.set())
+    sub.connect(args.host or "loopback", args.port, 60)
+    sub.loop_start()
+    pub_client = transport.create_client("bench-audio-pub")
+    pub_client.connect(args.host or "loopback", args.port, 60)
+    pub_client.loop_start()
+    subscribed.wait(5.0)
+    time.sleep(0.2)  # let the broker register the subscription
+
+    publisher = AudioStreamPublisher(
+        lambda t, p: pub_client.publish(t, p, qos=0), topic=topic, codec=args.codec, bitrate=args.bitrate
+    )
+    ticker = DeadlineTicker(1000.0 / 20)
+    publisher.begin_utterance()
+    for i in range(frames):
+        ticker.wait()
+        publisher.send(pcm[i * FRAME_BYTES:(i + 1) * FRAME_BYTES], time.time() + lead)
+    publisher.end_utterance()
+    done.wait(5.0)
+
+    for client in (pub_client, sub):
+        client.loop_stop()
+        client.disconnect()
+
+    stats = publisher.stats()
+    print(f"codec {'opus' if publisher.codec else 'pcm16'} via {'broker ' + args.host if args.host else 'loopback'}")
+    print(f"  publisher: {stats.summary()}")
+    print(f"  pacing   : {ticker.stats().summary()}")
+    if not latencies:
+        print("  subscriber: nothing received")
+        return
+    ordered = sorted(latencies)
+    per_frame = decode_cpu / len(latencies) * 1e6
+    print(
+        f"  subscriber: {len(latencies)}/{frames} frames, latency p50 {_percentile(ordered, 0.5) * 1000:.2f} ms "
+        f"p99 {_percentile(ordered, 0.99) * 1000:.2f} ms max {ordered[-1] * 1000:.2f} ms, "
+        f"decode {per_frame:.0f} us/frame"
+    )
+    print(f"  late for a {args.lead_ms:g} ms lead: {late} frames")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark the robot speech audio stream.")
+    parser.add_argument("--codec", choices=("auto", "opus", "pcm16"), default="auto",
+                        help="Frame codec (default: %(default)s, i.e. Opus when opuslib is installed).")
+    parser.add_argument("--bitrate", type=int, default=24000, help="Opus bitrate in bit/s (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=5.0, help="Synthetic audio length (default: %(default)s).")
+    parser.add_argument("--input", default=None, help="Audio file to stream instead (decoded with ffmpeg).")
+    parser.add_argument("--lead-ms", type=float, default=60.0,
+                        help="How far ahead of play time frames are sent, as AUDIO_TEE_LEAD_MS (default: %(default)s).")
+    parser.add_argument("--host", default=None, help="Measure through the broker on this host instead of loopback.")
+    parser.add_argument("--port", type=int, default=1883, help="Broker port (default: %(default)s).")
+    args = parser.parse_args()
+    if args.codec == "opus" and not opus_available():
+        parser.error("--codec opus needs opuslib (pip install opuslib) and libopus")
+
+    pcm = decode_file(args.input) if args.input else synthetic_voice(args.seconds)
+    if len(pcm) < FRAME_BYTES:
+        parser.error("input is shorter than one frame")
+    print(f"{len(pcm) // 2 / SAMPLE_RATE:.1f} s of audio, {len(pcm) // FRAME_BYTES} frames of {FRAME_SAMPLES} samples")
+    run(args, pcm)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,131 @@
+"""State freshness and buffered memory through a network stall.
+
+Publishes binary state at `--rate` for `--seconds` into a simulated link
+that writes at most `--link-rate` messages/s and stops entirely for
+`--stall` seconds in the middle (a Wi-Fi hiccup, a stuck subscriber
+backing up the broker). Compares handing every sample to the client, as
+paho does by default, with `OutboundQueue`'s latest-value policy.
+
+Reports the most messages/bytes buffered at once and the age of the
+samples delivered after the stall.
+
+Run from the repository root:
+    python3 -m mqtt.bench_outbound --rate 60 --stall 2
+"""
+
+from __future__ import annotations
+
+import argparse
+import threading
+import time
+from collections import deque
+from types import SimpleNamespace
+
+from .outbound import LATEST, OutboundQueue
+from .pacing import DeadlineTicker
+from .state_bus import StateBus
+from .state_codec import StateEncoder, peek_timestamp
+from .transport import MQTT_ERR_SUCCESS
+
+
+class SimulatedLink:
+    """paho-like client: unbounded send buffer drained by a network thread."""
+
+    def __init__(self, link_rate: float) -> None:
+        self.on_publish = None
+        self.link_rate = link_rate
+        self.stalled = threading.Event()
+        self._buffer: deque[tuple[int, bytes]] = deque()
+        self._buffered_bytes = 0
+        self._mid = 0
+        self._lock = threading.Lock()
+        self._stop = threading.Event()
+        self.peak_messages = 0
+        self.peak_bytes = 0
+        self.delivered: list[tuple[float, float]] = []  # (written_at, sample timestamp)
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def publish(self, topic, payload=None, qos=0, retain=False):
+        with self._lock:
+            self._mid += 1
+            self._buffer.append((self._mid, payload))
+            self._buffered_bytes += len(payload)
+            self.peak_messages = max(self.peak_messages, len(self._buffer))
+            self.peak_bytes = max(self.peak_bytes, self._buffered_bytes)
+            return SimpleNamespace(rc=MQTT_ERR_SUCCESS, mid=self._mid)
+
+    def _run(self) -> None:
+        while not self._stop.wait(1.0 / self.link_rate):
+            if self.stalled.is_set():
+                continue
+            with self._lock:
+                if not self._buffer:
+                    continue
+                mid, payload = self._buffer.popleft()
+                self._buffered_bytes -= len(payload)
+            self.delivered.append((time.time(), peek_timestamp(payload)))
+            if self.on_publish is not None:
+                self.on_publish(self, None, mid)
+
+    def close(self) -> None:
+        self._stop.set()
+        self._thread.join()
+
+
+def _run(args: argparse.Namespace, queued: bool) -> None:
+    link = SimulatedLink(args.link_rate)
+    topic = "siggraph/pi/state/bin"
+    if queued:
+        outbound = OutboundQueue(link, [(topic, LATEST)])
+        publish = outbound.publish
+    else:
+        publish = lambda t, p: link.publish(t, p)  # noqa: E731
+    bus = StateBus()
+    encoder = StateEncoder()
+
+    ticker = DeadlineTicker(args.rate)
+    started = time.monotonic()
+    stall_start = (args.seconds - args.stall) / 2
+    stall_end = None
+    while time.monotonic() - started < args.seconds:
+        ticker.wait()
+        elapsed = time.monotonic() - started
+        if stall_start <= elapsed < stall_start + args.stall:
+            link.stalled.set()
+        elif link.stalled.is_set():
+            link.stalled.clear()
+            stall_end = time.time()
+        state = bus.sample()
+        if queued:
+            publish(topic, lambda s=state: encoder.encode(s))
+        else:
+            publish(topic, encoder.encode(state))
+    link.close()
+
+    after = sorted(w - ts for w, ts in link.delivered if stall_end is not None and w >= stall_end)
+    line = f"{'outbound latest' if queued else 'direct (paho)':<16}: peak buffer {link.peak_messages} msgs / {link.peak_bytes} B"
+    if after:
+        line += (
+            f", after stall: {len(after)} delivered, age p50 {after[len(after) // 2] * 1000:.0f} ms "
+            f"max {after[-1] * 1000:.0f} ms"
+        )
+    print(line)
+    if queued:
+        print(f"{'':<16}  {outbound.stats()[topic].summary()}")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Compare direct publishing with the outbound queue through a stall.")
+    parser.add_argument("--rate", type=float, default=60.0, help="State publish rate in Hz (default: %(default)s).")
+    parser.add_argument("--link-rate", type=float, default=200.0, help="Messages/s the link can write (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=6.0, help="Run length (default: %(default)s).")
+    parser.add_argument("--stall", type=float, default=2.0, help="Stall length in the middle of the run (default: %(default)s).")
+    args = parser.parse_args()
+
+    _run(args, queued=False)
+    _run(args, queued=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,65 @@
+"""Compare sleep-after-work pacing with `DeadlineTicker` at high rates.
+
+Each tick performs a simulated publish of `--work-ms` (+/- 50%) CPU time.
+The legacy loop (`publish(); time.sleep(interval)`) is measured against the
+deadline ticker for achieved rate, jitter and dropped ticks.
+
+Run from the repository root:
+    python3 -m mqtt.bench_pacing --rates 10 60 120 240 --seconds 3
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import time
+
+from .pacing import DeadlineTicker
+
+
+def _busy(seconds: float) -> None:
+    end = time.perf_counter() + seconds
+    while time.perf_counter() < end:
+        pass
+
+
+def _legacy(rate: float, seconds: float, work) -> tuple[float, float]:
+    """Return (achieved Hz, mean interval error ms) for the sleep-after-work loop."""
+    interval = 1.0 / rate
+    start = time.monotonic()
+    stamps = []
+    while time.monotonic() - start < seconds:
+        stamps.append(time.monotonic())
+        work()
+        time.sleep(interval)
+    deltas = [b - a for a, b in zip(stamps, stamps[1:])]
+    error_ms = sum(abs(d - interval) for d in deltas) / len(deltas) * 1000.0
+    return len(stamps) / seconds, error_ms
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark publisher pacing strategies.")
+    parser.add_argument("--rates", type=float, nargs="+", default=[10.0, 60.0, 120.0, 240.0],
+                        help="Target rates in Hz (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=3.0, help="Duration per run (default: %(default)s).")
+    parser.add_argument("--work-ms", type=float, default=0.5, help="Mean simulated work per tick (default: %(default)s).")
+    args = parser.parse_args()
+
+    rng = random.Random(7)
+
+    def work() -> None:
+        _busy(args.work_ms / 1000.0 * rng.uniform(0.5, 1.5))
+
+    for rate in args.rates:
+        legacy_hz, legacy_err = _legacy(rate, args.seconds, work)
+        print(f"{rate:>6g} Hz  legacy : rate {legacy_hz:.1f} Hz, mean interval error {legacy_err:.2f} ms")
+
+        ticker = DeadlineTicker(rate)
+        end = time.monotonic() + args.seconds
+        while time.monotonic() < end and ticker.wait():
+            work()
+        print(f"{rate:>6g} Hz  ticker : {ticker.stats().summary()}")
+
+
+if __name__ == "__main__":
+    main()
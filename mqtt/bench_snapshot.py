@@ -0,0 +1,106 @@
+"""Time-to-first-valid-state for subscribers joining mid-session.
+
+Runs a `PiMqttApp` at `--rate` with a dialogue set, then lets `--joiners`
+subscribers connect one after another at random tick phases. Each one
+uses `SnapshotJoin` in one of four modes and reports the time from connect
+to its first decoded state whose dialogue is known:
+
+- stream:   live stream only (waits for a tick, binary waits for the next
+            dialogue definition too)
+- retained: plus the retained snapshot
+- request:  plus a snapshot request
+- both:     retained snapshot and request (what clients should do)
+
+Uses `LoopbackBroker` unless `--host` is given.
+
+Run from the repository root:
+    python3 -m mqtt.bench_snapshot --rate 10 --joiners 20
+    python3 -m mqtt.bench_snapshot --host localhost --format json
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import threading
+import time
+
+from .pi_mqtt_app import PiMqttApp
+from .snapshot import SnapshotJoin
+from .state_bus import StateBus
+from .transport import LoopbackBroker, PahoTransport
+
+MODES = {
+    "stream": (False, False),
+    "retained": (True, False),
+    "request": (False, True),
+    "both": (True, True),
+}
+
+
+def _join_once(transport, args: argparse.Namespace, mode: str, n: int) -> tuple[float | None, str | None]:
+    retained, request = MODES[mode]
+    join = SnapshotJoin(f"bench-join-{mode}-{n}", fmt=args.fmt, retained=retained, request=request)
+    synced = threading.Event()
+
+    def on_message(client, userdata, msg) -> None:
+        join.handle_message(msg)
+        if join.time_to_first_state is not None:
+            synced.set()
+
+    client = transport.create_client(join.client_id)
+    client.on_connect = lambda c, userdata, flags, rc: join.on_connect(c)
+    client.on_message = on_message
+    client.connect(args.host or "loopback", args.port, 60)
+    client.loop_start()
+    synced.wait(args.timeout)
+    client.loop_stop()
+    client.disconnect()
+    return join.time_to_first_state, join.first_source
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Measure late-joiner time to first valid state.")
+    parser.add_argument("--rate", type=float, default=10.0, help="Pi state publish rate in Hz (default: %(default)s).")
+    parser.add_argument("--format", dest="fmt", choices=("json", "bin"), default="bin",
+                        help="State format the joiners follow (default: %(default)s).")
+    parser.add_argument("--joiners", type=int, default=20, help="Joins per mode (default: %(default)s).")
+    parser.add_argument("--timeout", type=float, default=5.0, help="Give up on a join after this long (default: %(default)s).")
+    parser.add_argument("--host", default=None, help="Measure through the broker on this host instead of loopback.")
+    parser.add_argument("--port", type=int, default=1883, help="Broker port (default: %(default)s).")
+    args = parser.parse_args()
+
+    transport = PahoTransport() if args.host else LoopbackBroker()
+    bus = StateBus()
+    bus.set("dialogue", "Hello, I am Lafufu.")
+    bus.set("app_state", "Speaking")
+    app = PiMqttApp(args.host or "loopback", args.port, state_formats=[args.fmt], publish_rate_hz=args.rate,
+                    state_source=bus, transport=transport, device_id="pi")
+    threading.Thread(target=app.start, name="pi-mqtt-app", daemon=True).start()
+    time.sleep(1.0)  # let the first retained snapshot land
+
+    print(f"{args.fmt} state at {args.rate:g} Hz, {args.joiners} joins per mode via {'broker ' + args.host if args.host else 'loopback'}")
+    try:
+        for mode in MODES:
+            times: list[float] = []
+            sources: dict[str, int] = {}
+            for n in range(args.joiners):
+                time.sleep(random.uniform(0.0, 1.0 / args.rate))  # random tick phase
+                elapsed, source = _join_once(transport, args, mode, n)
+                if elapsed is not None:
+                    times.append(elapsed)
+                    sources[source] = sources.get(source, 0) + 1
+            if not times:
+                print(f"{mode:<9}: no join synced within {args.timeout:g} s")
+                continue
+            times.sort()
+            print(
+                f"{mode:<9}: {len(times)}/{args.joiners} synced, p50 {times[len(times) // 2] * 1000:7.2f} ms "
+                f"max {times[-1] * 1000:7.2f} ms, first valid state from {sources}"
+            )
+    finally:
+        app.stop()
+
+
+if __name__ == "__main__":
+    main()
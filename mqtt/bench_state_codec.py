@@ -0,0 +1,96 @@
+"""Benchmark JSON vs binary `PiState` encoding.
+
+Reports per-sample encode/decode cost, payload size and the resulting
+bandwidth at a given publish rate. No broker is needed.
+
+Run from the repository root:
+    python3 -m mqtt.bench_state_codec --rate 100 --samples 20000
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import time
+from dataclasses import asdict
+
+from .pi_state import PiState
+from .state_codec import MAX_FRAME_SIZE, StateDecoder, StateEncoder
+
+
+def _sample_states(n: int) -> list[PiState]:
+    """Deterministic states resembling the example publisher's output."""
+    states = []
+    for i in range(n):
+        t = (i * 0.01) % 10.0
+        speaking = (i // 300) % 2 == 0
+        states.append(
+            PiState(
+                timestamp=1734000000.0 + i * 0.01,
+                dialogue="Lafufu thinks she doesn't know." if speaking else "",
+                app_state="Speaking" if speaking else "Idle",
+                arm_pos_x=t,
+                arm_pos_y=0.0,
+                arm_pos_z=0.0,
+                arm_rot_pitch=0.0,
+                arm_rot_yaw=(t / 10.0) * 360.0,
+                arm_rot_roll=0.0,
+                head_pos_x=0.0,
+                head_pos_y=0.0,
+                head_pos_z=170.0,
+                head_rot_pitch=0.0,
+                head_rot_yaw=(t / 10.0) * 45.0,
+                head_rot_roll=0.0,
+                eyes_open=(int(t) % 4) != 0,
+                audio_level=0.75 if speaking else 0.1,
+                is_speaking=speaking,
+            )
+        )
+    return states
+
+
+def _time_per_call(fn, items) -> float:
+    """Return mean microseconds per call of `fn` over `items`."""
+    start = time.perf_counter_ns()
+    for item in items:
+        fn(item)
+    return (time.perf_counter_ns() - start) / len(items) / 1000.0
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark PiState wire formats.")
+    parser.add_argument("--samples", type=int, default=20000, help="Samples per measurement (default: %(default)s).")
+    parser.add_argument("--rate", type=float, default=100.0, help="Publish rate in Hz for bandwidth (default: %(default)s).")
+    args = parser.parse_args()
+
+    states = _sample_states(args.samples)
+
+    json_payloads = [json.dumps(asdict(s)).encode("utf-8") for s in states]
+    json_encode_us = _time_per_call(lambda s: json.dumps(asdict(s)), states)
+    json_decode_us = _time_per_call(json.loads, json_payloads)
+
+    encoder = StateEncoder()
+    bin_payloads = [encoder.encode(s) for s in states]
+    buf = bytearray(MAX_FRAME_SIZE)
+    encoder = StateEncoder()
+    bin_encode_into_us = _time_per_call(lambda s: encoder.encode_into(s, buf), states)
+    encoder = StateEncoder()
+    bin_encode_us = _time_per_call(encoder.encode, states)
+    decoder = StateDecoder()
+    bin_decode_us = _time_per_call(decoder.decode, bin_payloads)
+
+    rows = [
+        ("json", json_encode_us, json_decode_us, json_payloads),
+        ("bin (encode_into)", bin_encode_into_us, bin_decode_us, bin_payloads),
+        ("bin (encode)", bin_encode_us, bin_decode_us, bin_payloads),
+    ]
+
+    print(f"{args.samples} samples, bandwidth at {args.rate:g} Hz")
+    print(f"{'format':<20}{'encode us':>12}{'decode us':>12}{'bytes/sample':>15}{'bytes/s':>12}")
+    for name, enc_us, dec_us, payloads in rows:
+        mean_bytes = sum(len(p) for p in payloads) / len(payloads)
+        print(f"{name:<20}{enc_us:>12.2f}{dec_us:>12.2f}{mean_bytes:>15.1f}{mean_bytes * args.rate:>12.0f}")
+
+
+if __name__ == "__main__":
+    main()
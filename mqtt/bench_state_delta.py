@@ -0,0 +1,107 @@
+"""Benchmark delta state publishing against full-state JSON and binary.
+
+Synthesizes a show-like trace (slow head/arm motion, speaking turns with a
+fluctuating audio level) at several publish rates and reports bandwidth and
+encoder CPU for each format. No broker is needed.
+
+Run from the repository root:
+    python3 -m mqtt.bench_state_delta --rates 10 60 120 240 --seconds 60
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import random
+import time
+from dataclasses import asdict
+
+from .pi_state import PiState
+from .state_codec import StateEncoder
+from .state_delta import DEFAULT_KEYFRAME_INTERVAL, DeltaDecoder, DeltaEncoder
+
+
+def _trace(rate_hz: float, seconds: float, seed: int = 1) -> list[PiState]:
+    rng = random.Random(seed)
+    states = []
+    for i in range(int(rate_hz * seconds)):
+        t = i / rate_hz
+        speaking = (t % 12.0) < 5.0
+        states.append(
+            PiState(
+                timestamp=1734000000.0 + t,
+                dialogue="Lafufu thinks the weather is lovely today." if speaking else "",
+                app_state="Speaking" if speaking else "Listening",
+                arm_pos_x=10.0 * math.sin(t * 0.2),
+                arm_pos_y=0.0,
+                arm_pos_z=0.0,
+                arm_rot_pitch=0.0,
+                arm_rot_yaw=20.0 * math.sin(t * 0.1),
+                arm_rot_roll=0.0,
+                head_pos_x=0.0,
+                head_pos_y=0.0,
+                head_pos_z=170.0,
+                head_rot_pitch=8.0 * math.sin(t * 3.0) if speaking else 0.0,
+                head_rot_yaw=45.0 * math.sin(t * 0.05),
+                head_rot_roll=0.0,
+                eyes_open=(t % 4.0) > 0.15,
+                audio_level=rng.uniform(0.5, 1.0) if speaking else 0.0,
+                is_speaking=speaking,
+            )
+        )
+    return states
+
+
+def _measure(encode, states: list[PiState]) -> tuple[float, int]:
+    """Return (mean encode microseconds, total payload bytes)."""
+    total = 0
+    start = time.perf_counter_ns()
+    for s in states:
+        total += len(encode(s))
+    elapsed_us = (time.perf_counter_ns() - start) / 1000.0
+    return elapsed_us / len(states), total
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark delta-encoded PiState publishing.")
+    parser.add_argument("--rates", type=float, nargs="+", default=[10.0, 60.0, 120.0, 240.0],
+                        help="Publish rates in Hz (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=60.0, help="Trace length per rate (default: %(default)s).")
+    parser.add_argument("--keyframe-interval", type=int, default=DEFAULT_KEYFRAME_INTERVAL,
+                        help="Samples between keyframes (default: %(default)s).")
+    args = parser.parse_args()
+
+    print(f"{'rate Hz':>8}  {'format':<6}{'us/sample':>11}{'cpu %':>8}{'bytes/sample':>14}{'KiB/s':>9}{'vs json':>9}")
+    for rate in args.rates:
+        states = _trace(rate, args.seconds)
+
+        delta_encoder = DeltaEncoder(keyframe_interval=args.keyframe_interval)
+        formats = [
+            ("json", lambda s: json.dumps(asdict(s))),
+            ("bin", StateEncoder().encode),
+            ("delta", delta_encoder.encode),
+        ]
+
+        json_bytes = None
+        for name, encode in formats:
+            us, total = _measure(encode, states)
+            if json_bytes is None:
+                json_bytes = total
+            per_sample = total / len(states)
+            print(
+                f"{rate:>8g}  {name:<6}{us:>11.2f}{us * rate / 1e4:>8.3f}{per_sample:>14.1f}"
+                f"{per_sample * rate / 1024:>9.2f}{total / json_bytes:>9.1%}"
+            )
+
+        # Sanity check: the reference decoder reproduces the trace.
+        encoder, decoder = DeltaEncoder(keyframe_interval=args.keyframe_interval), DeltaDecoder()
+        worst = 0.0
+        for s in states:
+            d = decoder.decode(encoder.encode(s))
+            worst = max(worst, abs(d.head_rot_yaw - s.head_rot_yaw))
+        print(f"{'':>8}  max head_rot_yaw reconstruction error: {worst:.3f} deg")
+
+
+if __name__ == "__main__":
+    main()
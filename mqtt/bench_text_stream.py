@@ -0,0 +1,91 @@
+"""Measure `llm/text` publish overhead for per-token vs coalesced streaming.
+
+A producer emits `--tokens` synthetic tokens at each `--rates` tokens/s into
+a `TextStreamPublisher` per `--windows-ms` value (0 = one message per
+token). Reports messages, bytes, time spent in publish, the producer's
+cost per `append`, and the largest gap between messages (roughly the
+longest a token waited before going out).
+
+Without `--host` the publish call only serialises (measures our overhead);
+with `--host` it goes through paho to a real broker.
+
+Run from the repository root:
+    python3 -m mqtt.bench_text_stream --rates 50 200 1000 --windows-ms 0 20 50
+    python3 -m mqtt.bench_text_stream --host localhost
+"""
+
+from __future__ import annotations
+
+import argparse
+import os
+import time
+
+from .text_stream import TextStreamPublisher
+
+
+def _make_publish(host: str | None, port: int):
+    if host is None:
+        return (lambda topic, payload: None), (lambda: None)
+
+    import paho.mqtt.client as mqtt
+
+    client = mqtt.Client(client_id=f"bench-text-stream-{os.getpid()}", clean_session=True)
+    client.connect(host, port, 60)
+    client.loop_start()
+
+    def close() -> None:
+        client.loop_stop()
+        client.disconnect()
+
+    return (lambda topic, payload: client.publish(topic, payload, qos=0)), close
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark coalesced LLM text streaming.")
+    parser.add_argument("--rates", type=float, nargs="+", default=[50.0, 200.0, 1000.0],
+                        help="Token rates per second (default: %(default)s).")
+    parser.add_argument("--windows-ms", type=float, nargs="+", default=[0.0, 20.0, 50.0],
+                        help="Coalescing windows to compare (default: %(default)s).")
+    parser.add_argument("--tokens", type=int, default=2000, help="Tokens per run (default: %(default)s).")
+    parser.add_argument("--host", default=None, help="Publish to this broker instead of a no-op sink.")
+    parser.add_argument("--port", type=int, default=1883, help="Broker port (default: %(default)s).")
+    args = parser.parse_args()
+
+    publish, close = _make_publish(args.host, args.port)
+    token = "tok "
+    try:
+        for rate in args.rates:
+            interval = 1.0 / rate
+            for window_ms in args.windows_ms:
+                sent_at: list[float] = []
+                # Wrap publish to timestamp each message for the token-delay estimate.
+                stream = TextStreamPublisher(
+                    lambda t, p: (sent_at.append(time.perf_counter()), publish(t, p)),
+                    window_s=window_ms / 1000.0,
+                )
+                stream.begin_turn()
+                start = time.perf_counter()
+                append_s = 0.0
+                for i in range(args.tokens):
+                    delay = start + i * interval - time.perf_counter()
+                    if delay > 0:
+                        time.sleep(delay)
+                    t0 = time.perf_counter()
+                    stream.append(token)
+                    append_s += time.perf_counter() - t0
+                stream.close()
+
+                stats = stream.stats()
+                gaps = [b - a for a, b in zip(sent_at, sent_at[1:])]
+                max_gap_ms = max(gaps) * 1000.0 if gaps else 0.0
+                print(
+                    f"{rate:>6g} tok/s  window {window_ms:>4g} ms : {stats.summary()}; "
+                    f"producer append {append_s / args.tokens * 1e6:.1f} us/token, "
+                    f"max gap between messages {max_gap_ms:.1f} ms"
+                )
+    finally:
+        close()
+
+
+if __name__ == "__main__":
+    main()
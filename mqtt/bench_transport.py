@@ -0,0 +1,89 @@
+"""Publish-to-callback latency of the loopback transport vs a real broker.
+
+A publisher sends `--count` binary state frames on `siggraph/pi/state/bin`;
+a subscriber in the same process timestamps each delivery. Always measures
+`LoopbackBroker`; with `--host` also measures the same path through paho
+and the broker.
+
+Run from the repository root:
+    python3 -m mqtt.bench_transport --count 5000
+    python3 -m mqtt.bench_transport --host localhost
+"""
+
+from __future__ import annotations
+
+import argparse
+import threading
+import time
+
+from .pi_mqtt_app import TOPIC_STATE
+from .state_bus import StateBus
+from .state_codec import StateEncoder
+from .transport import LoopbackBroker, PahoTransport
+
+TOPIC = TOPIC_STATE + "/bin"
+
+
+def _run(transport, count: int, host: str, port: int) -> list[float]:
+    latencies: list[float] = []
+    sent: dict[int, float] = {}
+    done = threading.Event()
+
+    def on_message(client, userdata, msg) -> None:
+        latencies.append(time.perf_counter() - sent[len(latencies)])
+        if len(latencies) == count:
+            done.set()
+
+    subscribed = threading.Event()
+    sub = transport.create_client("bench-transport-sub")
+    sub.on_message = on_message
+    sub.on_connect = lambda client, userdata, flags, rc: (client.subscribe(TOPIC, qos=0), subscribed.set())
+    sub.connect(host, port, 60)
+    sub.loop_start()
+    pub = transport.create_client("bench-transport-pub")
+    pub.connect(host, port, 60)
+    pub.loop_start()
+    subscribed.wait(5.0)
+    time.sleep(0.2)  # let the broker register the subscription
+
+    encoder = StateEncoder()
+    frame = encoder.encode(StateBus().sample())
+    for i in range(count):
+        sent[i] = time.perf_counter()
+        pub.publish(TOPIC, frame, qos=0)
+        # Pace lightly so we measure delivery latency, not queueing.
+        time.sleep(0.0002)
+    done.wait(10.0)
+
+    for client in (pub, sub):
+        client.loop_stop()
+        client.disconnect()
+    return latencies
+
+
+def _report(name: str, latencies: list[float], count: int) -> None:
+    if not latencies:
+        print(f"{name:<9}: nothing received")
+        return
+    ordered = sorted(latencies)
+    n = len(ordered)
+    print(
+        f"{name:<9}: {n}/{count} delivered, latency p50 {ordered[n // 2] * 1e6:.0f} us, "
+        f"p99 {ordered[min(n - 1, int(n * 0.99))] * 1e6:.0f} us, max {ordered[-1] * 1e6:.0f} us"
+    )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark loopback vs broker delivery latency.")
+    parser.add_argument("--count", type=int, default=5000, help="Messages per run (default: %(default)s).")
+    parser.add_argument("--host", default=None, help="Also measure through the broker on this host.")
+    parser.add_argument("--port", type=int, default=1883, help="Broker port (default: %(default)s).")
+    args = parser.parse_args()
+
+    _report("loopback", _run(LoopbackBroker(), args.count, "loopback", 0), args.count)
+    if args.host:
+        _report("broker", _run(PahoTransport(), args.count, args.host, args.port), args.count)
+
+
+if __name__ == "__main__":
+    main()
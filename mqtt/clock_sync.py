@@ -0,0 +1,215 @@
+"""NTP-style clock sync between the Pi and its subscribers over MQTT.
+
+`PiState.timestamp` is the Pi's `time.time()`. A subscriber that knows the
+offset between its own clock and the Pi's can place samples on a shared
+timeline (interpolate / schedule animation) and measure true one-way
+latency.
+
+Exchange (JSON; topics are per device, see topics.DeviceTopics)
+---------------------------------------------------------------
+subscriber -> `siggraph/pi/clock/ping`:
+    {"id": "ue-1", "seq": 12, "t0": <subscriber clock at send>}
+Pi -> `siggraph/pi/clock/pong/<id>`:
+    {"seq": 12, "t0": ..., "t1": <Pi time at receive>, "t2": <Pi time at reply>}
+
+The subscriber stamps t3 on receipt. As in NTP:
+    offset = ((t1 - t0) + (t2 - t3)) / 2     (Pi clock - subscriber clock)
+    rtt    = (t3 - t0) - (t2 - t1)
+The error of a sample is at most rtt / 2, so `ClockSync` keeps a sliding
+window of samples and uses the one with the smallest RTT; pinging every
+second or so keeps the estimate tracking clock drift.
+
+The subscriber side uses a monotonic clock, so its own wall-clock steps
+(NTP corrections, manual changes) don't disturb the estimate.
+"""
+
+from __future__ import annotations
+
+import json
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Any, Callable
+
+from .topics import DEFAULT_DEVICE_ID, DeviceTopics, valid_client_id
+
+
+# Default device's topics.
+TOPIC_CLOCK_PING = DeviceTopics().clock_ping
+TOPIC_CLOCK_PONG = DeviceTopics().clock_pong  # + "/<id>"
+
+DEFAULT_WINDOW = 16
+DEFAULT_PING_INTERVAL_SECONDS = 1.0
+MAX_OUTSTANDING_PINGS = 64
+
+
+def pong_topic(client_id: str, prefix: str = TOPIC_CLOCK_PONG) -> str:
+    return f"{prefix}/{client_id}"
+
+
+def make_pong(
+    payload: bytes | str,
+    received_at: float,
+    clock: Callable[[], float] = time.time,
+    pong_prefix: str = TOPIC_CLOCK_PONG,
+) -> tuple[str, bytes] | None:
+    """Pi side: build `(topic, payload)` answering a ping, or None if it is malformed.
+
+    `received_at` (t1) should be taken as early as possible in the message
+    callback; t2 is read just before returning.
+    """
+    try:
+        ping = json.loads(payload)
+    except (json.JSONDecodeError, UnicodeDecodeError):
+        return None
+    if not isinstance(ping, dict) or not valid_client_id(ping.get("id")):
+        return None
+    seq, t0 = ping.get("seq"), ping.get("t0")
+    if not isinstance(seq, int) or not isinstance(t0, (int, float)):
+        return None
+    reply = {"seq": seq, "t0": t0, "t1": received_at, "t2": clock()}
+    return pong_topic(ping["id"], pong_prefix), json.dumps(reply).encode("utf-8")
+
+
+@dataclass(frozen=True)
+class ClockSample:
+    offset: float  # Pi clock - local clock, seconds
+    rtt: float
+    local_time: float  # local clock at t3
+
+
+class ClockSync:
+    """Subscriber side estimator: builds pings, consumes pongs, maps clocks."""
+
+    def __init__(self, client_id: str, clock: Callable[[], float] = time.monotonic, window: int = DEFAULT_WINDOW) -> None:
+        if not valid_client_id(client_id):
+            raise ValueError(f"client_id must be 1..64 chars without '/', '+' or '#': {client_id!r}")
+        self.client_id = client_id
+        self.clock = clock
+        self._seq = 0
+        self._outstanding: dict[int, float] = {}
+        self._samples: deque[ClockSample] = deque(maxlen=window)
+        self._best: ClockSample | None = None
+        self.pongs = 0
+        self.stale = 0
+
+    # Exchange -----------------------------------------------------------
+
+    def make_ping(self) -> bytes:
+        """Payload for `TOPIC_CLOCK_PING`; remembers t0 for the matching pong."""
+        self._seq += 1
+        t0 = self.clock()
+        self._outstanding[self._seq] = t0
+        if len(self._outstanding) > MAX_OUTSTANDING_PINGS:
+            # Pongs that never arrived: forget the oldest.
+            del self._outstanding[min(self._outstanding)]
+        return json.dumps({"id": self.client_id, "seq": self._seq, "t0": t0}).encode("utf-8")
+
+    def on_pong(self, payload: bytes | str, received_at: float | None = None) -> ClockSample | None:
+        """Fold a pong into the estimate; returns the new sample (None if unmatched)."""
+        t3 = self.clock() if received_at is None else received_at
+        try:
+            pong = json.loads(payload)
+            seq, t1, t2 = pong["seq"], float(pong["t1"]), float(pong["t2"])
+        except (json.JSONDecodeError, UnicodeDecodeError, KeyError, TypeError, ValueError):
+            self.stale += 1
+            return None
+        t0 = self._outstanding.pop(seq, None)
+        if t0 is None:
+            self.stale += 1
+            return None
+
+        sample = ClockSample(offset=((t1 - t0) + (t2 - t3)) / 2.0, rtt=max(0.0, (t3 - t0) - (t2 - t1)), local_time=t3)
+        self._samples.append(sample)
+        self._best = min(self._samples, key=lambda s: s.rtt)
+        self.pongs += 1
+        return sample
+
+    # Estimate -----------------------------------------------------------
+
+    @property
+    def synced(self) -> bool:
+        return self._best is not None
+
+    @property
+    def offset(self) -> float:
+        """Pi clock minus local clock (seconds), from the lowest-RTT recent sample."""
+        if self._best is None:
+            raise RuntimeError("No pong received yet")
+        return self._best.offset
+
+    @property
+    def rtt(self) -> float:
+        if self._best is None:
+            raise RuntimeError("No pong received yet")
+        return self._best.rtt
+
+    @property
+    def error_bound(self) -> float:
+        """Worst-case error of `offset` (half the chosen sample's RTT)."""
+        return self.rtt / 2.0
+
+    def pi_time_now(self) -> float:
+        """The Pi's `time.time()` right now, as estimated locally."""
+        return self.clock() + self.offset
+
+    def to_local(self, pi_time: float) -> float:
+        """Convert a Pi timestamp (e.g. `PiState.timestamp`) to the local clock."""
+        return pi_time - self.offset
+
+    def one_way_latency(self, pi_timestamp: float, received_at: float | None = None) -> float:
+        """Seconds between the Pi stamping a sample and it arriving here."""
+        local = self.clock() if received_at is None else received_at
+        return local + self.offset - pi_timestamp
+
+
+class ClockSyncClient:
+    """Drives a `ClockSync` over a paho-compatible client that is already connected.
+
+    Subscribes to this client's pong topic and pings every `interval_s` from
+    a background thread. Pongs are handled in the client's on_message chain
+    via `handle_message`, which returns True for messages it consumed.
+    """
+
+    def __init__(
+        self,
+        client: Any,
+        sync: ClockSync,
+        interval_s: float = DEFAULT_PING_INTERVAL_SECONDS,
+        device_id: str = DEFAULT_DEVICE_ID,
+    ) -> None:
+        self.client = client
+        self.sync = sync
+        self.interval_s = interval_s
+        self.device_topics = DeviceTopics(device_id)
+        self.topic = pong_topic(sync.client_id, self.device_topics.clock_pong)
+        self._stop_event = threading.Event()
+        self._thread: threading.Thread | None = None
+
+    def handle_message(self, msg: Any) -> bool:
+        if msg.topic != self.topic:
+            return False
+        self.sync.on_pong(msg.payload)
+        return True
+
+    def ping(self) -> None:
+        self.client.publish(self.device_topics.clock_ping, self.sync.make_ping(), qos=0)
+
+    def start(self) -> None:
+        self.client.subscribe(self.topic, qos=0)
+        if self._thread is None:
+            self._stop_event.clear()
+            self._thread = threading.Thread(target=self._run, name="clock-sync", daemon=True)
+            self._thread.start()
+
+    def _run(self) -> None:
+        while not self._stop_event.is_set():
+            self.ping()
+            self._stop_event.wait(self.interval_s)
+
+    def stop(self) -> None:
+        self._stop_event.set()
+        if self._thread is not None:
+            self._thread.join(timeout=1.0)
+            self._thread = None
@@ -0,0 +1,334 @@
+"""Typed commands for `siggraph/pi/commands` and their dispatch pipeline.
+
+paho calls `on_message` on its network thread, so anything slow there stalls
+keepalives and publishing. `CommandDispatcher.offer` therefore only appends
+the raw payload to a bounded queue; parsing, validation and the handlers run
+on the dispatcher's own thread.
+
+Wire format (JSON object, one command per message)
+--------------------------------------------------
+    {"cmd": "speak", "text": "Hello!", "lang": "en"}
+    {"cmd": "gesture", "name": "nod", "times": 2}
+    {"cmd": "set_state", "app_state": "Listening"}
+    {"cmd": "set_publish_rate", "rate_hz": 60}
+
+An optional numeric "sent_at" (sender's `time.time()`) is used for
+end-to-end latency when sender and Pi share a clock.
+"""
+
+from __future__ import annotations
+
+import json
+import queue
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Callable, ClassVar, Union
+
+from telemetry.ringlog import get_logger
+
+from .state_bus import APP_STATES
+
+
+# A misbehaving publisher can flood invalid commands; the logger rate-limits them.
+log = get_logger("MQTT")
+
+COMMAND_QUEUE_CAPACITY = 256
+ACTION_QUEUE_CAPACITY = 16
+LATENCY_WINDOW = 1024
+
+GESTURES: tuple[str, ...] = ("nod",)
+
+
+class CommandError(ValueError):
+    """Raised for payloads that are not a valid command."""
+
+
+@dataclass(frozen=True)
+class SpeakCommand:
+    KIND: ClassVar[str] = "speak"
+    text: str
+    lang: str = "en"
+
+
+@dataclass(frozen=True)
+class GestureCommand:
+    KIND: ClassVar[str] = "gesture"
+    name: str
+    times: int = 1
+
+
+@dataclass(frozen=True)
+class SetStateCommand:
+    KIND: ClassVar[str] = "set_state"
+    app_state: str
+
+
+@dataclass(frozen=True)
+class SetPublishRateCommand:
+    KIND: ClassVar[str] = "set_publish_rate"
+    rate_hz: float
+
+
+Command = Union[SpeakCommand, GestureCommand, SetStateCommand, SetPublishRateCommand]
+
+
+def _field(obj: dict, key: str, kind: type | tuple[type, ...], default=None, required: bool = True):
+    value = obj.get(key, default)
+    if value is None and not required:
+        return default
+    # bool is an int subclass; never accept it where a number is expected.
+    if not isinstance(value, kind) or isinstance(value, bool):
+        raise CommandError(f"Field {key!r} must be {getattr(kind, '__name__', kind)}, got {value!r}")
+    return value
+
+
+def parse_command(payload: bytes | str) -> tuple[Command, float | None]:
+    """Parse one command payload into `(command, sent_at)`.
+
+    Raises CommandError if the payload is malformed or fails validation.
+    """
+    try:
+        obj = json.loads(payload)
+    except (json.JSONDecodeError, UnicodeDecodeError) as exc:
+        raise CommandError(f"Command is not valid JSON: {exc}") from exc
+    if not isinstance(obj, dict):
+        raise CommandError("Command must be a JSON object")
+
+    sent_at = obj.get("sent_at")
+    if not isinstance(sent_at, (int, float)) or isinstance(sent_at, bool):
+        sent_at = None
+
+    cmd = obj.get("cmd")
+    if cmd == SpeakCommand.KIND:
+        text = _field(obj, "text", str).strip()
+        if not text:
+            raise CommandError("speak requires non-empty 'text'")
+        return SpeakCommand(text=text, lang=_field(obj, "lang", str, "en", required=False)), sent_at
+
+    if cmd == GestureCommand.KIND:
+        name = _field(obj, "name", str)
+        if name not in GESTURES:
+            raise CommandError(f"Unknown gesture {name!r}; expected one of {GESTURES}")
+        times = _field(obj, "times", int, 1, required=False)
+        if not 1 <= times <= 10:
+            raise CommandError(f"gesture 'times' must be 1..10, got {times}")
+        return GestureCommand(name=name, times=times), sent_at
+
+    if cmd == SetStateCommand.KIND:
+        app_state = _field(obj, "app_state", str)
+        if app_state not in APP_STATES:
+            raise CommandError(f"Unknown app_state {app_state!r}; expected one of {APP_STATES}")
+        return SetStateCommand(app_state=app_state), sent_at
+
+    if cmd == SetPublishRateCommand.KIND:
+        return SetPublishRateCommand(rate_hz=float(_field(obj, "rate_hz", (int, float)))), sent_at
+
+    raise CommandError(f"Unknown command {cmd!r}")
+
+
+@dataclass
+class CommandStats:
+    """Latency summary for one command kind (milliseconds)."""
+
+    count: int
+    errors: int
+    queue_mean_ms: float
+    total_p50_ms: float
+    total_p99_ms: float
+    total_max_ms: float
+    end_to_end_mean_ms: float | None
+
+    def summary(self) -> str:
+        e2e = "" if self.end_to_end_mean_ms is None else f", e2e mean {self.end_to_end_mean_ms:.2f}"
+        return (
+            f"n={self.count} err={self.errors} queue mean {self.queue_mean_ms:.2f}, "
+            f"total p50 {self.total_p50_ms:.2f} p99 {self.total_p99_ms:.2f} max {self.total_max_ms:.2f}{e2e} ms"
+        )
+
+
+class _KindStats:
+    def __init__(self) -> None:
+        self.count = 0
+        self.errors = 0
+        self.queue_s: deque[float] = deque(maxlen=LATENCY_WINDOW)
+        self.total_s: deque[float] = deque(maxlen=LATENCY_WINDOW)
+        self.e2e_s: deque[float] = deque(maxlen=LATENCY_WINDOW)
+
+    def snapshot(self) -> CommandStats:
+        total = sorted(self.total_s)
+        n = len(total)
+
+        def pct(p: float) -> float:
+            return total[min(n - 1, int(n * p))] * 1000.0 if n else 0.0
+
+        return CommandStats(
+            count=self.count,
+            errors=self.errors,
+            queue_mean_ms=(sum(self.queue_s) / len(self.queue_s) * 1000.0) if self.queue_s else 0.0,
+            total_p50_ms=pct(0.5),
+            total_p99_ms=pct(0.99),
+            total_max_ms=(total[-1] * 1000.0) if n else 0.0,
+            end_to_end_mean_ms=(sum(self.e2e_s) / len(self.e2e_s) * 1000.0) if self.e2e_s else None,
+        )
+
+
+class CommandDispatcher:
+    """Bounded command queue plus a worker thread that runs the handlers.
+
+    The queue is a `deque(maxlen=capacity)`: appends and pops are atomic, so
+    the network thread never takes a lock, and when the queue is full the
+    oldest pending command is dropped (and counted) in favour of the newest.
+
+    Handlers run one at a time on the dispatcher thread; long-running work
+    (speech, gestures) should be handed to its subsystem or an `ActionWorker`
+    rather than block later commands.
+    """
+
+    def __init__(self, capacity: int = COMMAND_QUEUE_CAPACITY) -> None:
+        self._queue: deque[tuple[float, bytes]] = deque(maxlen=capacity)
+        self._ready = threading.Event()
+        self._stop_event = threading.Event()
+        self._thread: threading.Thread | None = None
+
+        self._handlers: dict[str, Callable[[Command], None]] = {}
+        # Written on the dispatcher thread, read by `stats()` on the publisher/metrics thread.
+        self._stats: dict[str, _KindStats] = {}
+        self._stats_lock = threading.Lock()
+
+        self.received = 0
+        self.dropped = 0
+        self.invalid = 0
+        self.unhandled = 0
+
+    def register(self, kind: str, handler: Callable[[Command], None]) -> None:
+        """Route commands of `kind` (e.g. `SpeakCommand.KIND`) to `handler`."""
+        self._handlers[kind] = handler
+
+    def offer(self, payload: bytes) -> None:
+        """Queue a raw payload. Cheap and non-blocking: call from the network thread."""
+        if len(self._queue) == self._queue.maxlen:
+            self.dropped += 1
+        self._queue.append((time.monotonic(), payload))
+        self.received += 1
+        self._ready.set()
+
+    def run_pending(self) -> int:
+        """Parse and dispatch everything queued so far; return how many ran."""
+        n = 0
+        while True:
+            try:
+                received_at, payload = self._queue.popleft()
+            except IndexError:
+                return n
+            n += 1
+            self._dispatch(received_at, payload)
+
+    def _dispatch(self, received_at: float, payload: bytes) -> None:
+        started = time.monotonic()
+        try:
+            command, sent_at = parse_command(payload)
+        except CommandError as exc:
+            self.invalid += 1
+            log.warning("Ignoring invalid command: %s", exc)
+            return
+
+        handler = self._handlers.get(command.KIND)
+        if handler is None:
+            self.unhandled += 1
+            log.warning("No handler registered for command %r", command.KIND)
+            return
+
+        failed = False
+        try:
+            handler(command)
+        except Exception as exc:  # noqa: BLE001
+            failed = True
+            log.error("Command %r failed: %s", command.KIND, exc)
+
+        finished = time.monotonic()
+        with self._stats_lock:
+            stats = self._stats.setdefault(command.KIND, _KindStats())
+            stats.errors += failed
+            stats.count += 1
+            stats.queue_s.append(started - received_at)
+            stats.total_s.append(finished - received_at)
+            if sent_at is not None:
+                stats.e2e_s.append(time.time() - sent_at)
+
+    def stats(self) -> dict[str, CommandStats]:
+        with self._stats_lock:
+            return {kind: s.snapshot() for kind, s in self._stats.items()}
+
+    # Thread lifecycle ---------------------------------------------------
+
+    def _run(self) -> None:
+        while not self._stop_event.is_set():
+            self._ready.wait(timeout=0.5)
+            # Clear before draining so an offer during the drain re-arms the event.
+            self._ready.clear()
+            self.run_pending()
+
+    def start(self) -> None:
+        if self._thread is not None:
+            return
+        self._stop_event.clear()
+        self._thread = threading.Thread(target=self._run, name="mqtt-commands", daemon=True)
+        self._thread.start()
+
+    def stop(self, timeout: float = 1.0) -> None:
+        self._stop_event.set()
+        self._ready.set()
+        if self._thread is not None:
+            self._thread.join(timeout=timeout)
+            self._thread = None
+
+
+class ActionWorker:
+    """Runs slow command actions (speech, gestures) in order on their own thread.
+
+    A handler calls `submit` and returns at once, so the dispatcher goes on
+    to the next command (a `set_publish_rate` is not held up behind seconds
+    of speech). When `capacity` actions are already waiting the new one is
+    dropped and counted rather than queued behind them.
+    """
+
+    def __init__(self, name: str = "command-actions", capacity: int = ACTION_QUEUE_CAPACITY) -> None:
+        self._queue: queue.Queue[Callable[[], None] | None] = queue.Queue(maxsize=capacity)
+        self._abandon = threading.Event()
+        self._thread = threading.Thread(target=self._run, name=name, daemon=True)
+        self._thread.start()
+        self.dropped = 0
+        self.errors = 0
+
+    def submit(self, action: Callable[[], None]) -> bool:
+        """Queue `action`; False if the queue is full and it was dropped."""
+        try:
+            self._queue.put_nowait(action)
+        except queue.Full:
+            self.dropped += 1
+            log.warning("Dropping command action: %d already waiting", self._queue.maxsize)
+            return False
+        return True
+
+    def _run(self) -> None:
+        while not self._abandon.is_set() and (action := self._queue.get()) is not None:
+            try:
+                action()
+            except Exception as exc:  # noqa: BLE001
+                self.errors += 1
+                log.error("Command action failed: %s", exc)
+
+    def stop(self, timeout: float = 1.0) -> None:
+        """Finish the queued actions (up to `timeout`) and end the thread.
+
+        If the queue stays full for the whole `timeout` (a long speech is
+        running), the waiting actions are abandoned once it ends.
+        """
+        deadline = time.monotonic() + timeout
+        try:
+            self._queue.put(None, timeout=timeout)
+        except queue.Full:
+            self._abandon.set()
+        self._thread.join(timeout=max(0.0, deadline - time.monotonic()))
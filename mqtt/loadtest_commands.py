@@ -0,0 +1,93 @@
+"""Flood `siggraph/pi/commands` against a local broker and report dispatch latency.
+
+Starts an in-process `PiMqttApp` (state publishing at its normal rate) with
+stand-in speak/gesture/set_state handlers that take `--handler-ms` each,
+then publishes `--count` mixed commands from a second client as fast as
+possible (or at `--rate`). Reports publisher throughput, queue drops and the
+dispatcher's per-command latency, plus the state publisher's tick stats so
+keepalive/publish stalls show up as dropped ticks.
+
+Run from the repository root with Mosquitto listening on localhost:1883:
+    python3 -m mqtt.loadtest_commands --count 20000 --rate 0
+"""
+
+from __future__ import annotations
+
+import argparse
+import itertools
+import json
+import os
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+from .commands import GestureCommand, SetStateCommand, SpeakCommand
+from .pi_mqtt_app import BROKER_HOST, BROKER_PORT, KEEPALIVE, TOPIC_COMMANDS, PiMqttApp
+
+
+_COMMANDS = (
+    {"cmd": "speak", "text": "Lafufu thinks this is a load test."},
+    {"cmd": "gesture", "name": "nod", "times": 1},
+    {"cmd": "set_state", "app_state": "Listening"},
+)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Load-test the MQTT command dispatch pipeline.")
+    parser.add_argument("--host", default=BROKER_HOST, help="Broker host (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=BROKER_PORT, help="Broker port (default: %(default)s).")
+    parser.add_argument("--count", type=int, default=20000, help="Commands to send (default: %(default)s).")
+    parser.add_argument("--rate", type=float, default=0.0, help="Commands per second, 0 = flood (default: %(default)s).")
+    parser.add_argument("--qos", type=int, choices=(0, 1), default=0, help="Publish QoS (default: %(default)s).")
+    parser.add_argument("--handler-ms", type=float, default=0.05, help="Simulated handler time (default: %(default)s).")
+    parser.add_argument("--settle", type=float, default=2.0, help="Seconds to wait for the queue to drain (default: %(default)s).")
+    args = parser.parse_args()
+
+    def handler(_command) -> None:
+        if args.handler_ms > 0:
+            time.sleep(args.handler_ms / 1000.0)
+
+    app = PiMqttApp(broker_host=args.host, broker_port=args.port)
+    for kind in (SpeakCommand.KIND, GestureCommand.KIND, SetStateCommand.KIND):
+        app.commands.register(kind, handler)
+
+    app_thread = threading.Thread(target=app.start, name="pi-mqtt-app", daemon=True)
+    app_thread.start()
+    time.sleep(1.0)  # let the app connect and subscribe
+
+    sender = mqtt.Client(client_id=f"command-flood-{os.getpid()}", clean_session=True)
+    sender.connect(args.host, args.port, KEEPALIVE)
+    sender.loop_start()
+
+    interval = 1.0 / args.rate if args.rate > 0 else 0.0
+    start = time.monotonic()
+    for i, template in zip(range(args.count), itertools.cycle(_COMMANDS)):
+        if interval:
+            delay = start + i * interval - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        payload = json.dumps({**template, "sent_at": time.time()})
+        sender.publish(TOPIC_COMMANDS, payload=payload, qos=args.qos, retain=False)
+    send_seconds = time.monotonic() - start
+
+    time.sleep(args.settle)
+    sender.loop_stop()
+    sender.disconnect()
+
+    dispatcher = app.commands
+    publisher_stats = app.ticker.stats()
+    app.stop()
+
+    print(f"sent {args.count} commands in {send_seconds:.2f} s ({args.count / send_seconds:.0f}/s, qos {args.qos})")
+    print(
+        f"received {dispatcher.received}, dropped (queue full) {dispatcher.dropped}, "
+        f"invalid {dispatcher.invalid}, lost in transit {args.count - dispatcher.received}"
+    )
+    for kind, stats in sorted(dispatcher.stats().items()):
+        print(f"  {kind:<18} {stats.summary()}")
+    print(f"state publisher during load: {publisher_stats.summary()}")
+
+
+if __name__ == "__main__":
+    main()
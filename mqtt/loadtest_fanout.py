@@ -0,0 +1,333 @@
+"""Fan-out load test: M state publishers x N subscribers through a broker.
+
+Each publisher encodes `PiState` samples in the chosen wire format at a
+fixed rate (same encoders and `DeadlineTicker` as `PiMqttApp`) on
+`siggraph/loadtest/<i>/state<suffix>`; every subscriber subscribes to all
+of them, so the broker delivers M x rate x N messages per second.
+Latency comes from the timestamp embedded in each sample, loss from
+sent vs received counts once the publishers have stopped and the
+subscribers have drained.
+
+Publishers and subscriber groups run in separate processes so the Python
+side doesn't bottleneck on one GIL. `--pi-app` also runs a real
+`PiMqttApp` on `siggraph/pi/state<suffix>` (don't use it while the show's
+own app is connected: both use the same client id). `--transport
+loopback` runs everything as threads on the in-process broker, useful for
+checking the harness itself.
+
+Latencies compare wall clocks, so all processes must share a host.
+
+Run from the repository root with Mosquitto listening on localhost:1883:
+    python3 -m mqtt.loadtest_fanout --subscribers 1 4 16 --publishers 2 --rate 60 --format bin
+    python3 -m mqtt.loadtest_fanout --subscribers 8 --format json --seconds 30 --json report.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import multiprocessing
+import os
+import queue
+import threading
+import time
+from array import array
+from dataclasses import asdict, dataclass, field
+
+from .pacing import DeadlineTicker, TickStats
+from .pi_mqtt_app import BROKER_HOST, BROKER_PORT, KEEPALIVE, TOPIC_STATE, PiMqttApp
+from .state_bus import StateBus
+from .state_codec import STATE_FORMAT_SUFFIXES, StateEncoder, peek_timestamp
+from .state_delta import DeltaEncoder, peek_header
+from .transport import MQTT_ERR_SUCCESS, LoopbackBroker, PahoTransport
+
+
+TOPIC_PREFIX = "siggraph/loadtest"
+LATENCY_SAMPLE_CAP = 200_000  # per subscriber; later deliveries are counted only
+SUBSCRIBE_SETTLE_SECONDS = 0.5
+
+
+@dataclass
+class FanoutConfig:
+    subscribers: int = 4
+    publishers: int = 1
+    rate_hz: float = 60.0
+    fmt: str = "bin"
+    seconds: float = 10.0
+    qos: int = 0
+    drain_s: float = 2.0
+    pi_app: bool = False
+    transport: str = "paho"
+    host: str = BROKER_HOST
+    port: int = BROKER_PORT
+    procs: int = 0  # subscriber processes; 0 = one per CPU (at most one per subscriber)
+
+
+@dataclass
+class FanoutReport:
+    config: dict
+    published: int
+    publish_errors: int
+    published_bytes: int
+    expected_deliveries: int
+    delivered: int
+    loss_pct: float
+    worst_subscriber_loss_pct: float
+    delivered_per_s: float
+    delivered_mbit_s: float
+    latency_p50_ms: float
+    latency_p90_ms: float
+    latency_p99_ms: float
+    latency_max_ms: float
+    publisher_ticks_dropped: int
+    publisher_actual_hz: list[float] = field(default_factory=list)
+
+    def summary(self) -> str:
+        c = self.config
+        return (
+            f"{c['publishers']} pub x {c['rate_hz']:g} Hz -> {c['subscribers']} sub [{c['fmt']}, qos {c['qos']}]: "
+            f"{self.delivered}/{self.expected_deliveries} delivered ({self.loss_pct:.2f}% loss, worst sub "
+            f"{self.worst_subscriber_loss_pct:.2f}%), {self.delivered_per_s:.0f} msg/s, "
+            f"{self.delivered_mbit_s:.2f} Mbit/s, latency p50 {self.latency_p50_ms:.2f} p90 {self.latency_p90_ms:.2f} "
+            f"p99 {self.latency_p99_ms:.2f} max {self.latency_max_ms:.2f} ms, "
+            f"publisher ticks dropped {self.publisher_ticks_dropped}"
+        )
+
+
+def _make_encoder(fmt: str):
+    if fmt == "json":
+        return PiMqttApp._encode_state_json
+    if fmt == "bin":
+        return StateEncoder().encode
+    return DeltaEncoder().encode
+
+
+def _timestamp_reader(fmt: str):
+    if fmt == "json":
+        return lambda payload: json.loads(payload)["timestamp"]
+    if fmt == "bin":
+        return peek_timestamp
+    return lambda payload: peek_header(payload)[2]
+
+
+def _topic_filters(cfg: FanoutConfig) -> list[str]:
+    suffix = STATE_FORMAT_SUFFIXES[cfg.fmt]
+    filters = [f"{TOPIC_PREFIX}/+/state{suffix}"]
+    if cfg.pi_app:
+        filters.append(TOPIC_STATE + suffix)
+    return filters
+
+
+# Workers (module level so they can run in spawned processes) -------------
+
+def _publisher(index: int, cfg: FanoutConfig, transport, start, stop, results) -> None:
+    client = transport.create_client(f"loadtest-pub-{os.getpid()}-{index}")
+    client.connect(cfg.host, cfg.port, KEEPALIVE)
+    client.loop_start()
+
+    encode = _make_encoder(cfg.fmt)
+    bus = StateBus()
+    topic = f"{TOPIC_PREFIX}/{index}/state{STATE_FORMAT_SUFFIXES[cfg.fmt]}"
+    sent = errors = nbytes = 0
+
+    start.wait()
+    ticker = DeadlineTicker(cfg.rate_hz)
+    while ticker.wait(stop):
+        now = time.time()
+        bus.set("head_rot_yaw", (now % 10.0) * 4.5)
+        payload = encode(bus.sample(now))
+        if client.publish(topic, payload=payload, qos=cfg.qos, retain=False).rc == MQTT_ERR_SUCCESS:
+            sent += 1
+            nbytes += len(payload)
+        else:
+            errors += 1
+
+    client.loop_stop()
+    client.disconnect()
+    results.put(("pub", sent, errors, nbytes, ticker.stats()))
+
+
+def _subscriber_group(ids: list[int], cfg: FanoutConfig, transport, ready, stop, results) -> None:
+    read_timestamp = _timestamp_reader(cfg.fmt)
+    filters = _topic_filters(cfg)
+    connected = threading.Semaphore(0)
+    clients = []
+
+    for sub_id in ids:
+        stats = {"received": 0, "bytes": 0, "bad": 0, "latency": array("d")}
+
+        def on_connect(client, userdata, flags, rc):
+            for topic_filter in filters:
+                client.subscribe(topic_filter, qos=cfg.qos)
+            connected.release()
+
+        def on_message(client, userdata, msg, stats=stats):
+            received_at = time.time()
+            stats["received"] += 1
+            stats["bytes"] += len(msg.payload)
+            try:
+                latency = received_at - read_timestamp(msg.payload)
+            except (ValueError, KeyError, TypeError):
+                stats["bad"] += 1
+                return
+            if len(stats["latency"]) < LATENCY_SAMPLE_CAP:
+                stats["latency"].append(latency)
+
+        client = transport.create_client(f"loadtest-sub-{os.getpid()}-{sub_id}")
+        client.on_connect = on_connect
+        client.on_message = on_message
+        client.connect(cfg.host, cfg.port, KEEPALIVE)
+        client.loop_start()
+        clients.append((sub_id, client, stats))
+
+    for _ in ids:
+        connected.acquire(timeout=10.0)
+    time.sleep(SUBSCRIBE_SETTLE_SECONDS)  # let SUBACKs land before anyone publishes
+    ready.release()
+
+    stop.wait()
+    for sub_id, client, stats in clients:
+        client.loop_stop()
+        client.disconnect()
+        results.put(("sub", sub_id, stats["received"], stats["bytes"], stats["bad"], stats["latency"].tolist()))
+
+
+# Orchestration ------------------------------------------------------------
+
+def run(cfg: FanoutConfig) -> FanoutReport:
+    """Run one load-test configuration and return its report."""
+    if cfg.fmt not in STATE_FORMAT_SUFFIXES:
+        raise ValueError(f"Unknown format {cfg.fmt!r}; expected one of {sorted(STATE_FORMAT_SUFFIXES)}")
+
+    if cfg.transport == "loopback":
+        transport = LoopbackBroker()
+        spawn, make_event, make_semaphore, results = threading.Thread, threading.Event, threading.Semaphore, queue.Queue()
+    else:
+        ctx = multiprocessing.get_context("spawn")
+        transport = PahoTransport()
+        spawn, make_event, make_semaphore, results = ctx.Process, ctx.Event, ctx.Semaphore, ctx.Queue()
+
+    start, pub_stop, sub_stop = make_event(), make_event(), make_event()
+    ready = make_semaphore(0)
+
+    procs = cfg.procs or os.cpu_count() or 1
+    procs = max(1, min(procs, cfg.subscribers))
+    groups = [list(range(cfg.subscribers))[i::procs] for i in range(procs)]
+    workers = [spawn(target=_subscriber_group, args=(g, cfg, transport, ready, sub_stop, results), daemon=True)
+               for g in groups]
+    workers += [spawn(target=_publisher, args=(i, cfg, transport, start, pub_stop, results), daemon=True)
+                for i in range(cfg.publishers)]
+    for w in workers:
+        w.start()
+    for _ in groups:
+        ready.acquire(timeout=30.0)
+
+    app = app_thread = None
+    if cfg.pi_app:
+        app = PiMqttApp(cfg.host, cfg.port, state_formats=[cfg.fmt], publish_rate_hz=cfg.rate_hz, transport=transport)
+        app_thread = threading.Thread(target=app.start, name="pi-mqtt-app", daemon=True)
+
+    start.set()
+    if app_thread is not None:
+        app_thread.start()
+    time.sleep(cfg.seconds)
+    pub_stop.set()
+    app_stats: TickStats | None = None
+    if app is not None:
+        app_stats = app.ticker.stats()
+        app.stop()
+    time.sleep(cfg.drain_s)
+    sub_stop.set()
+
+    pub_results, sub_results = [], []
+    for _ in range(cfg.publishers + cfg.subscribers):
+        item = results.get(timeout=30.0)
+        (pub_results if item[0] == "pub" else sub_results).append(item)
+    for w in workers:
+        w.join(timeout=5.0)
+
+    published = sum(r[1] for r in pub_results)
+    tick_stats = [r[4] for r in pub_results]
+    if app_stats is not None:
+        published += app_stats.ticks
+        tick_stats.append(app_stats)
+
+    expected = published * cfg.subscribers
+    delivered = sum(r[2] for r in sub_results)
+    latencies = sorted(lat for r in sub_results for lat in r[5])
+    n = len(latencies)
+
+    def pct(p: float) -> float:
+        return latencies[min(n - 1, int(n * p))] * 1000.0 if n else 0.0
+
+    def loss(received: int, wanted: int) -> float:
+        return max(0.0, (wanted - received) / wanted * 100.0) if wanted else 0.0
+
+    return FanoutReport(
+        config=asdict(cfg),
+        published=published,
+        publish_errors=sum(r[2] for r in pub_results),
+        published_bytes=sum(r[3] for r in pub_results),
+        expected_deliveries=expected,
+        delivered=delivered,
+        loss_pct=loss(delivered, expected),
+        worst_subscriber_loss_pct=max((loss(r[2], published) for r in sub_results), default=0.0),
+        delivered_per_s=delivered / cfg.seconds,
+        delivered_mbit_s=sum(r[3] for r in sub_results) * 8 / cfg.seconds / 1e6,
+        latency_p50_ms=pct(0.5),
+        latency_p90_ms=pct(0.9),
+        latency_p99_ms=pct(0.99),
+        latency_max_ms=latencies[-1] * 1000.0 if n else 0.0,
+        publisher_ticks_dropped=sum(s.dropped for s in tick_stats),
+        publisher_actual_hz=[round(s.actual_hz, 2) for s in tick_stats],
+    )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Load-test MQTT state fan-out through the broker.")
+    parser.add_argument("--host", default=BROKER_HOST, help="Broker host (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=BROKER_PORT, help="Broker port (default: %(default)s).")
+    parser.add_argument("--transport", choices=("paho", "loopback"), default="paho",
+                        help="paho = real broker; loopback = in-process threads (default: %(default)s).")
+    parser.add_argument("--subscribers", type=int, nargs="+", default=[1, 4, 16],
+                        help="Subscriber counts to sweep (default: %(default)s).")
+    parser.add_argument("--publishers", type=int, default=1, help="Simulated publishers (default: %(default)s).")
+    parser.add_argument("--rate", type=float, default=60.0, help="Samples/s per publisher (default: %(default)s).")
+    parser.add_argument("--format", dest="fmt", choices=sorted(STATE_FORMAT_SUFFIXES), default="bin",
+                        help="Payload format (default: %(default)s).")
+    parser.add_argument("--qos", type=int, choices=(0, 1), default=0, help="Publish/subscribe QoS (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=10.0, help="Publishing time per run (default: %(default)s).")
+    parser.add_argument("--drain", type=float, default=2.0, help="Seconds to wait for in-flight messages (default: %(default)s).")
+    parser.add_argument("--procs", type=int, default=0, help="Subscriber processes, 0 = CPU count (default: %(default)s).")
+    parser.add_argument("--pi-app", action="store_true", help="Also run a real PiMqttApp publisher.")
+    parser.add_argument("--json", default=None, help="Write all reports to this JSON file.")
+    args = parser.parse_args()
+
+    reports = []
+    for subscribers in args.subscribers:
+        cfg = FanoutConfig(
+            subscribers=subscribers,
+            publishers=args.publishers,
+            rate_hz=args.rate,
+            fmt=args.fmt,
+            seconds=args.seconds,
+            qos=args.qos,
+            drain_s=args.drain,
+            pi_app=args.pi_app,
+            transport=args.transport,
+            host=args.host,
+            port=args.port,
+            procs=args.procs,
+        )
+        report = run(cfg)
+        print(report.summary())
+        reports.append(report)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump([asdict(r) for r in reports], f, indent=2)
+        print(f"wrote {args.json}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,137 @@
+"""Load-test the aggregator with dozens of simulated robots on one broker.
+
+Starts `--robots` real `PiMqttApp` instances (device ids `robot-00`,
+`robot-01`, ...; example state data) spread over `--procs` processes, and
+one `StateAggregator` in this process. While they run, the aggregator's
+table is sampled every 100 ms to measure:
+
+- coverage: robots present / online in the table
+- staleness: now - PiState.timestamp of each robot's latest entry
+- per-robot receive rate vs the configured publish rate
+- aggregator throughput, decode errors and CPU time (paho mode only; in
+  loopback mode everything shares this process)
+
+Run from the repository root with Mosquitto listening on localhost:1883:
+    python3 -m mqtt.loadtest_robots --robots 48 --rate 30 --format bin --seconds 20
+"""
+
+from __future__ import annotations
+
+import argparse
+import multiprocessing
+import os
+import sys
+import threading
+import time
+
+from .aggregator import StateAggregator
+from .pi_mqtt_app import BROKER_HOST, BROKER_PORT, PiMqttApp
+from .state_codec import STATE_FORMAT_SUFFIXES
+from .transport import LoopbackBroker, PahoTransport
+
+SAMPLE_INTERVAL_SECONDS = 0.1
+
+
+def device_ids(count: int) -> list[str]:
+    width = max(2, len(str(count - 1)))
+    return [f"robot-{i:0{width}d}" for i in range(count)]
+
+
+def _robot_group(ids: list[str], fmt: str, rate_hz: float, host: str, port: int, transport, stop, quiet: bool) -> None:
+    """Run one PiMqttApp per device id until `stop` is set."""
+    if quiet:
+        sys.stdout = open(os.devnull, "w")  # only ever set in a worker process
+    apps = [PiMqttApp(host, port, state_formats=[fmt], publish_rate_hz=rate_hz, transport=transport, device_id=d)
+            for d in ids]
+    threads = [threading.Thread(target=app.start, name=f"robot-{app.topics.device_id}", daemon=True) for app in apps]
+    for t in threads:
+        t.start()
+    stop.wait()
+    for app in apps:
+        app.stop()
+    for t in threads:
+        t.join(timeout=2.0)
+
+
+def _pct(values: list[float], p: float) -> float:
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p))]
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Many simulated robots -> one aggregator through the broker.")
+    parser.add_argument("--host", default=BROKER_HOST, help="Broker host (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=BROKER_PORT, help="Broker port (default: %(default)s).")
+    parser.add_argument("--transport", choices=("paho", "loopback"), default="paho",
+                        help="paho = real broker; loopback = all in this process (default: %(default)s).")
+    parser.add_argument("--robots", type=int, default=32, help="Simulated robots (default: %(default)s).")
+    parser.add_argument("--rate", type=float, default=30.0, help="State rate per robot in Hz (default: %(default)s).")
+    parser.add_argument("--format", dest="fmt", choices=sorted(STATE_FORMAT_SUFFIXES), default="bin",
+                        help="State format robots publish (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=15.0, help="Measurement time (default: %(default)s).")
+    parser.add_argument("--warmup", type=float, default=3.0, help="Seconds before measuring (default: %(default)s).")
+    parser.add_argument("--procs", type=int, default=0, help="Robot processes, 0 = CPU count (default: %(default)s).")
+    parser.add_argument("--verbose", action="store_true", help="Show the robots' own [MQTT] output.")
+    args = parser.parse_args()
+
+    ids = device_ids(args.robots)
+    if args.transport == "loopback":
+        transport = LoopbackBroker()
+        spawn, stop = threading.Thread, threading.Event()
+    else:
+        ctx = multiprocessing.get_context("spawn")
+        transport = PahoTransport()
+        spawn, stop = ctx.Process, ctx.Event()
+
+    aggregator = StateAggregator(args.host, args.port, fmt=args.fmt, transport=transport)
+    aggregator.connect()
+
+    procs = max(1, min(args.procs or os.cpu_count() or 1, args.robots))
+    quiet = not args.verbose and args.transport != "loopback"
+    workers = [spawn(target=_robot_group, args=(ids[i::procs], args.fmt, args.rate, args.host, args.port, transport, stop, quiet),
+                     daemon=True) for i in range(procs)]
+    for w in workers:
+        w.start()
+
+    time.sleep(args.warmup)
+    start_counts = {d: s.messages for d, s in aggregator.snapshot().items()}
+    cpu_start, wall_start = time.process_time(), time.monotonic()
+    staleness: list[float] = []
+    min_online = args.robots
+    end = wall_start + args.seconds
+    while time.monotonic() < end:
+        time.sleep(SAMPLE_INTERVAL_SECONDS)
+        now = time.time()
+        table = aggregator.snapshot()
+        min_online = min(min_online, sum(1 for s in table.values() if s.online(now)))
+        staleness.extend(now - s.state.timestamp for s in table.values())
+    wall = time.monotonic() - wall_start
+    cpu = time.process_time() - cpu_start
+    table = aggregator.snapshot()
+
+    stop.set()
+    for w in workers:
+        w.join(timeout=5.0)
+    aggregator.stop()
+
+    rates = [(s.messages - start_counts.get(d, 0)) / wall for d, s in table.items()]
+    total = sum(rates)
+    errors = sum(s.decode_errors for s in table.values())
+    missing = sorted(set(ids) - set(table))
+
+    print(f"{args.robots} robots x {args.rate:g} Hz [{args.fmt}, {args.transport}] for {wall:.1f} s")
+    print(f"  coverage : {len(table)}/{args.robots} robots in table, min online {min_online}"
+          + (f", never seen: {', '.join(missing[:8])}{' ...' if len(missing) > 8 else ''}" if missing else ""))
+    print(f"  rate     : aggregate {total:.0f} msg/s (expected {args.robots * args.rate:.0f}), "
+          f"per robot min {min(rates, default=0):.1f} / mean {total / max(1, len(rates)):.1f} Hz")
+    print(f"  staleness: p50 {_pct(staleness, 0.5) * 1000:.1f} ms, p99 {_pct(staleness, 0.99) * 1000:.1f} ms, "
+          f"max {max(staleness, default=0) * 1000:.1f} ms (sampled every {SAMPLE_INTERVAL_SECONDS * 1000:.0f} ms)")
+    cpu_note = "" if args.transport == "paho" else " (includes robots: loopback)"
+    print(f"  aggregator: {errors} decode errors, {aggregator.unrouted} unrouted, "
+          f"CPU {cpu / wall * 100:.1f}% of one core{cpu_note}, {cpu / max(1.0, total * wall) * 1e6:.1f} us/msg")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,294 @@
+"""Per-topic outbound policies between the app and the MQTT client.
+
+paho queues every `publish` in memory until its network thread has written
+it. When the broker or the link is slow, state samples therefore pile up,
+RSS grows and subscribers receive seconds-old poses late. `OutboundQueue`
+decides per topic what may wait:
+
+- `latest`: at most `max_inflight` messages handed to the client and one
+  pending; a newer message replaces the pending one (drop-oldest with a
+  depth of 1). Used for state, which is only worth sending fresh.
+- `fifo`: a bounded queue of `depth` messages behind the in-flight ones;
+  when full the oldest is dropped. Used for text and audio.
+- `reliable`: passed straight to the client at QoS 1 and never dropped
+  here (paho retries until the broker acknowledges). Used for commands.
+
+A message is in flight from `client.publish` until paho's `on_publish`
+(written to the socket for QoS 0, PUBACK for QoS 1); that span is the
+publish-to-ack latency tracked per topic. Payloads may be callables that
+are evaluated only when the message is actually sent, so stateful encoders
+(interned strings, deltas) never reference a frame that was dropped.
+
+Policies are matched by MQTT topic filter, first match wins.
+"""
+
+from __future__ import annotations
+
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Any, Callable, Sequence, Union
+
+from .topics import DeviceTopics
+from .transport import MQTT_ERR_SUCCESS, topic_matches
+
+
+POLICY_LATEST = "latest"
+POLICY_FIFO = "fifo"
+POLICY_RELIABLE = "reliable"
+
+LATENCY_WINDOW = 1024
+
+Payload = Union[str, bytes, None, Callable[[], Union[str, bytes]]]
+
+
+@dataclass(frozen=True)
+class TopicPolicy:
+    kind: str
+    depth: int = 1  # pending messages kept (latest: always 1)
+    max_inflight: int = 1
+    qos: int = 0
+
+    def __post_init__(self) -> None:
+        if self.kind not in (POLICY_LATEST, POLICY_FIFO, POLICY_RELIABLE):
+            raise ValueError(f"Unknown outbound policy {self.kind!r}")
+        if self.depth < 1 or self.max_inflight < 1:
+            raise ValueError("depth and max_inflight must be >= 1")
+
+
+LATEST = TopicPolicy(POLICY_LATEST)
+RELIABLE = TopicPolicy(POLICY_RELIABLE, qos=1)
+
+
+def fifo(depth: int, max_inflight: int = 4) -> TopicPolicy:
+    return TopicPolicy(POLICY_FIFO, depth=depth, max_inflight=max_inflight)
+
+
+def default_policies(topics: DeviceTopics) -> list[tuple[str, TopicPolicy]]:
+    """Policies for one robot's topics; anything else gets `DEFAULT_POLICY`."""
+    return [
+        (topics.state, LATEST),
+        (topics.state + "/#", LATEST),  # /bin, /delta; the delta join topic is inbound only
+        (topics.llm_text, fifo(256)),
+        (topics.audio, fifo(25)),  # 0.5 s; older speech is useless to a live twin
+        (topics.commands, RELIABLE),
+        (topics.metrics, LATEST),
+    ]
+
+
+DEFAULT_POLICY = fifo(64)
+
+
+@dataclass
+class OutboundStats:
+    topic: str
+    policy: str
+    depth: int  # pending now
+    max_depth: int  # most pending at once
+    inflight: int
+    offered: int
+    sent: int
+    dropped: int  # superseded or pushed out of a full queue
+    failed: int  # client refused (e.g. not connected)
+    lost: int  # in flight when the connection dropped
+    ack_p50_ms: float
+    ack_p99_ms: float
+    ack_max_ms: float
+
+    def summary(self) -> str:
+        return (
+            f"{self.policy}: offered {self.offered}, sent {self.sent}, dropped {self.dropped}, failed {self.failed}, "
+            f"lost {self.lost}, depth {self.depth} (max {self.max_depth}), inflight {self.inflight}, "
+            f"ack p50 {self.ack_p50_ms:.2f} ms p99 {self.ack_p99_ms:.2f} ms max {self.ack_max_ms:.2f} ms"
+        )
+
+
+class _Topic:
+    __slots__ = (
+        "topic", "policy", "pending", "inflight", "offered", "sent", "dropped", "failed", "lost", "max_depth", "latencies",
+    )
+
+    def __init__(self, topic: str, policy: TopicPolicy) -> None:
+        self.topic = topic
+        self.policy = policy
+        self.pending: deque[tuple[Payload, bool]] = deque()
+        self.inflight = 0
+        self.offered = 0
+        self.sent = 0
+        self.dropped = 0
+        self.failed = 0
+        self.lost = 0
+        self.max_depth = 0
+        self.latencies: deque[float] = deque(maxlen=LATENCY_WINDOW)
+
+
+class OutboundQueue:
+    """Applies per-topic policies to everything published through it.
+
+    Installs itself as the client's `on_publish` callback. Call
+    `on_disconnect()` / `resume()` from the client's disconnect / connect
+    callbacks so in-flight accounting restarts and queued messages drain.
+    Thread-safe; messages handed over while the queue is draining are sent
+    from whichever thread frees a slot (the caller or the network thread).
+    """
+
+    def __init__(
+        self,
+        client: Any,
+        policies: Sequence[tuple[str, TopicPolicy]] = (),
+        default: TopicPolicy = DEFAULT_POLICY,
+    ) -> None:
+        self.client = client
+        self._policies = list(policies)
+        self._default = default
+        self._topics: dict[str, _Topic] = {}
+        self._inflight: dict[int, tuple[_Topic, float]] = {}
+        # Guards the bookkeeping only and is never held across
+        # `client.publish`: paho calls on_publish with its message mutex held,
+        # and publish() takes that mutex, so holding both would deadlock.
+        self._lock = threading.Lock()
+        # Messages with a reserved in-flight slot, in send order. One thread
+        # at a time (whoever holds `_send_lock`) hands them to the client.
+        self._ready: deque[tuple[_Topic, Payload, bool]] = deque()
+        self._send_lock = threading.Lock()
+        self._sending = False
+        self._early_acks: set[int] = set()  # acked before the sender registered the mid
+        client.on_publish = self._on_publish
+
+    def policy_for(self, topic: str) -> TopicPolicy:
+        for topic_filter, policy in self._policies:
+            if topic_matches(topic_filter, topic):
+                return policy
+        return self._default
+
+    def publish(self, topic: str, payload: Payload = None, retain: bool = False) -> None:
+        with self._lock:
+            entry = self._topics.get(topic)
+            if entry is None:
+                entry = self._topics[topic] = _Topic(topic, self.policy_for(topic))
+            entry.offered += 1
+            policy = entry.policy
+
+            if policy.kind == POLICY_RELIABLE or (not entry.pending and entry.inflight < policy.max_inflight):
+                entry.inflight += 1
+                self._ready.append((entry, payload, retain))
+            else:
+                if policy.kind == POLICY_LATEST:
+                    if entry.pending:
+                        entry.pending.clear()
+                        entry.dropped += 1
+                elif len(entry.pending) >= policy.depth:
+                    entry.pending.popleft()
+                    entry.dropped += 1
+                entry.pending.append((payload, retain))
+                entry.max_depth = max(entry.max_depth, len(entry.pending))
+        self._pump()
+
+    def _pump(self) -> None:
+        """Send the ready messages, unless another thread is already sending (it sends ours too)."""
+        while self._ready:
+            if not self._send_lock.acquire(blocking=False):
+                return
+            try:
+                while True:
+                    with self._lock:
+                        if not self._ready:
+                            break
+                        entry, payload, retain = self._ready.popleft()
+                        self._sending = True
+                    self._send(entry, payload, retain)
+            finally:
+                self._send_lock.release()
+            # Loop: a message readied after the last check found the send lock
+            # still taken and left it to us.
+
+    def _send(self, entry: _Topic, payload: Payload, retain: bool) -> None:
+        """Hand one message to the client: under `_send_lock`, without `_lock`."""
+        info = None
+        sent_at = time.perf_counter()
+        try:
+            if callable(payload):
+                payload = payload()
+            sent_at = time.perf_counter()
+            info = self.client.publish(entry.topic, payload=payload, qos=entry.policy.qos, retain=retain)
+        finally:
+            with self._lock:
+                self._sending = False
+                early, self._early_acks = self._early_acks, set()
+                mid = getattr(info, "mid", None)
+                if info is None or info.rc != MQTT_ERR_SUCCESS:
+                    entry.failed += 1
+                    entry.inflight -= 1
+                    self._drain(entry)
+                elif mid is None or mid in early:
+                    # Written before publish() returned (or untrackable): no wait.
+                    entry.sent += 1
+                    entry.inflight -= 1
+                    entry.latencies.append(time.perf_counter() - sent_at)
+                    self._drain(entry)
+                else:
+                    entry.sent += 1
+                    self._inflight[mid] = (entry, sent_at)
+
+    def _drain(self, entry: _Topic) -> None:
+        """Move pending messages into free in-flight slots; call with `_lock` held."""
+        while entry.pending and entry.inflight < entry.policy.max_inflight:
+            payload, retain = entry.pending.popleft()
+            entry.inflight += 1
+            self._ready.append((entry, payload, retain))
+
+    def _on_publish(self, client: Any, userdata: Any, mid: int, *rest: Any) -> None:
+        with self._lock:
+            found = self._inflight.pop(mid, None)
+            if found is None:
+                if self._sending:
+                    # The network thread can ack before publish() has returned.
+                    self._early_acks.add(mid)
+                return  # or a publish that bypassed the queue
+            entry, sent_at = found
+            entry.inflight -= 1
+            entry.latencies.append(time.perf_counter() - sent_at)
+            self._drain(entry)
+        # Inside a send (paho writing several packets from publish()) the send
+        # lock is taken and the sender picks these up after publish() returns.
+        self._pump()
+
+    def on_disconnect(self) -> None:
+        """Forget in-flight messages; paho discards unsent QoS 0 packets on reconnect."""
+        with self._lock:
+            for entry, _ in self._inflight.values():
+                if entry.policy.qos == 0:
+                    entry.inflight -= 1
+                    entry.lost += 1
+            self._inflight = {mid: v for mid, v in self._inflight.items() if v[0].policy.qos > 0}
+
+    def resume(self) -> None:
+        """Send whatever queued up while the connection was down."""
+        with self._lock:
+            for entry in list(self._topics.values()):
+                self._drain(entry)
+        self._pump()
+
+    def stats(self) -> dict[str, OutboundStats]:
+        with self._lock:
+            snapshot = {topic: (entry, sorted(entry.latencies)) for topic, entry in self._topics.items()}
+        result = {}
+        for topic, (entry, lat) in snapshot.items():
+            n = len(lat)
+            result[topic] = OutboundStats(
+                topic=topic,
+                policy=entry.policy.kind,
+                depth=len(entry.pending),
+                max_depth=entry.max_depth,
+                inflight=entry.inflight,
+                offered=entry.offered,
+                sent=entry.sent,
+                dropped=entry.dropped,
+                failed=entry.failed,
+                lost=entry.lost,
+                ack_p50_ms=lat[n // 2] * 1000.0 if n else 0.0,
+                ack_p99_ms=lat[min(n - 1, int(n * 0.99))] * 1000.0 if n else 0.0,
+                ack_max_ms=lat[-1] * 1000.0 if n else 0.0,
+            )
+        return result
@@ -0,0 +1,169 @@
+"""Drift-free pacing for the state publisher.
+
+`time.sleep(interval)` after doing the work makes every tick last
+`interval + work`, so the real rate drifts below the target and the error
+grows with the rate. `DeadlineTicker` instead wakes on absolute monotonic
+deadlines (`start + k * period`); if a tick overruns by more than a period the
+missed deadlines are skipped and counted rather than replayed in a burst.
+
+`LatestValueSlot` lets producers hand over state at their own pace: writes
+replace the previous value, and the publisher samples whatever is newest at
+each tick.
+"""
+
+from __future__ import annotations
+
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Generic, TypeVar
+
+
+MAX_RATE_HZ = 500.0
+
+T = TypeVar("T")
+
+
+class LatestValueSlot(Generic[T]):
+    """Single-value mailbox where newer writes overwrite older ones.
+
+    `put` and `get` are a single reference store/load each, so producers and
+    the publisher never block each other. `overwritten` counts values that
+    were replaced before anyone read them.
+    """
+
+    def __init__(self) -> None:
+        self._entry: tuple[int, T | None] = (0, None)
+        self._read_version = 0
+        self.overwritten = 0
+
+    def put(self, value: T) -> None:
+        version = self._entry[0] + 1
+        if self._entry[0] != self._read_version:
+            self.overwritten += 1
+        self._entry = (version, value)
+
+    def get(self) -> tuple[int, T | None]:
+        """Return `(version, value)`; version 0 means nothing was put yet."""
+        entry = self._entry
+        self._read_version = entry[0]
+        return entry
+
+
+@dataclass
+class TickStats:
+    """Snapshot of a ticker's behaviour since it was (re)started."""
+
+    target_hz: float
+    actual_hz: float
+    ticks: int
+    dropped: int
+    jitter_mean_ms: float
+    jitter_p99_ms: float
+    jitter_max_ms: float
+
+    def summary(self) -> str:
+        return (
+            f"rate {self.actual_hz:.1f}/{self.target_hz:g} Hz, ticks {self.ticks}, dropped {self.dropped}, "
+            f"jitter mean {self.jitter_mean_ms:.2f} ms p99 {self.jitter_p99_ms:.2f} ms max {self.jitter_max_ms:.2f} ms"
+        )
+
+
+class DeadlineTicker:
+    """Wake at `rate_hz` on absolute monotonic deadlines.
+
+    Jitter is the lateness of each wake-up relative to its deadline; the last
+    `window` values are kept for the percentile.
+    """
+
+    def __init__(self, rate_hz: float, window: int = 2048) -> None:
+        self._lateness: deque[float] = deque(maxlen=window)
+        self._rate_lock = threading.Lock()
+        self._pending_rate: float | None = None
+        self._restart(self._checked(rate_hz))
+
+    @property
+    def rate_hz(self) -> float:
+        """The requested rate, including one `set_rate` has not applied yet."""
+        with self._rate_lock:
+            return self._pending_rate if self._pending_rate is not None else self._rate_hz
+
+    def set_rate(self, rate_hz: float) -> None:
+        """Change the rate from any thread.
+
+        The ticker thread applies it at its next `wait`, where deadlines and
+        counters restart; the wait already in progress keeps the old period.
+        """
+        rate_hz = self._checked(rate_hz)
+        with self._rate_lock:
+            self._pending_rate = rate_hz
+
+    @staticmethod
+    def _checked(rate_hz: float) -> float:
+        if not 0.0 < rate_hz <= MAX_RATE_HZ:
+            raise ValueError(f"rate_hz must be in (0, {MAX_RATE_HZ:g}], got {rate_hz}")
+        return rate_hz
+
+    def _restart(self, rate_hz: float) -> None:
+        self._rate_hz = rate_hz
+        self._period = 1.0 / rate_hz
+        self._start = time.monotonic()
+        self._index = 0
+        self._ticks = 0
+        self._dropped = 0
+        self._first_wake = 0.0
+        self._last_wake = 0.0
+        self._lateness.clear()
+
+    def wait(self, stop_event: threading.Event | None = None) -> bool:
+        """Block until the next deadline. Returns False if `stop_event` was set.
+
+        Only the ticker thread calls this; it is the only writer of the
+        deadline state.
+        """
+        if self._pending_rate is not None:
+            with self._rate_lock:
+                rate_hz, self._pending_rate = self._pending_rate, None
+            if rate_hz is not None:
+                self._restart(rate_hz)
+        deadline = self._start + self._index * self._period
+        delay = deadline - time.monotonic()
+        if delay > 0:
+            if stop_event is not None:
+                if stop_event.wait(delay):
+                    return False
+            else:
+                time.sleep(delay)
+        elif stop_event is not None and stop_event.is_set():
+            return False
+
+        now = time.monotonic()
+        self._lateness.append(max(0.0, now - deadline))
+        if self._ticks == 0:
+            self._first_wake = now
+        self._last_wake = now
+        self._ticks += 1
+
+        # Next deadline; skip (and count) any we have already missed.
+        next_index = self._index + 1
+        behind = int((now - self._start) / self._period) + 1
+        if behind > next_index:
+            self._dropped += behind - next_index
+            next_index = behind
+        self._index = next_index
+        return True
+
+    def stats(self) -> TickStats:
+        span = self._last_wake - self._first_wake
+        lateness = sorted(self._lateness)
+        n = len(lateness)
+        return TickStats(
+            target_hz=self._rate_hz,
+            actual_hz=(self._ticks - 1) / span if span > 0 else 0.0,
+            ticks=self._ticks,
+            dropped=self._dropped,
+            jitter_mean_ms=(sum(lateness) / n * 1000.0) if n else 0.0,
+            jitter_p99_ms=(lateness[min(n - 1, int(n * 0.99))] * 1000.0) if n else 0.0,
+            jitter_max_ms=(lateness[-1] * 1000.0) if n else 0.0,
+        )
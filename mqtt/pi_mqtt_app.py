@@ -11,155 +11,317 @@ Install dependencies
 --------------------
     pip install paho-mqtt
 
-Run on the Pi
--------------
-    python3 pi_mqtt_app.py
+Run on the Pi (from the repository root)
+----------------------------------------
+    python3 -m mqtt.pi_mqtt_app
 
 Then, in Unreal, configure your MQTT client to connect to:
     host: <PI_IP_ADDRESS>
     port: 1883
-    topic (subscribe): siggraph/pi/state
+    topic (subscribe): siggraph/pi/state       (JSON)
+                   or: siggraph/pi/state/bin   (compact binary, see state_codec.py)
     topic (optional, publish from UE): siggraph/pi/commands
+    topic (optional, subscribe): siggraph/pi/metrics (JSON, when given `metrics_payload`)
+
+Consumers in the same process (and tests) can skip the broker entirely by
+passing `transport=LoopbackBroker()` (see transport.py).
 """
 
 import json
+import os
 import random
 import signal
 import sys
 import threading
 import time
-from dataclasses import dataclass, asdict
+from dataclasses import asdict
+from functools import partial
+from typing import Callable, Sequence
+
+from telemetry.ringlog import get_logger
 
-import paho.mqtt.client as mqtt
+from .clock_sync import make_pong
+from .commands import CommandDispatcher, SetPublishRateCommand
+from .outbound import OutboundQueue, default_policies
+from .pacing import DeadlineTicker, LatestValueSlot
+from .pi_state import PiState
+from .snapshot import DEFAULT_SNAPSHOT_INTERVAL_SECONDS, SNAPSHOT_FORMATS, parse_request, reply_topic, retained_topic
+from .state_bus import StateBus
+from .state_codec import STATE_FORMAT_SUFFIXES, StateEncoder
+from .state_delta import JOIN_SUFFIX, DeltaEncoder
+from .topics import DEFAULT_DEVICE_ID, DeviceTopics
+from .transport import PahoTransport, Transport
 
 
 BROKER_HOST = "localhost"  # on the Pi this should be fine; UE uses the Pi's IP address
 BROKER_PORT = 1883
 KEEPALIVE = 60
 
-TOPIC_STATE = "siggraph/pi/state"      # Pi -> Unreal (state data)
-TOPIC_COMMANDS = "siggraph/pi/commands"  # Unreal -> Pi (optional commands)
+# Topics of the default device; other robots use DeviceTopics(<device_id>).
+TOPIC_STATE = DeviceTopics().state        # Pi -> Unreal (state data)
+TOPIC_COMMANDS = DeviceTopics().commands  # Unreal -> Pi (optional commands)
+# Delta-stream subscribers publish here to request a keyframe.
+TOPIC_STATE_DELTA_JOIN = TOPIC_STATE + STATE_FORMAT_SUFFIXES["delta"] + JOIN_SUFFIX
 
 PUBLISH_INTERVAL_SECONDS = 0.1  # 10 Hz example
+PUBLISH_RATE_HZ = 1.0 / PUBLISH_INTERVAL_SECONDS  # PI_PUBLISH_RATE_HZ=60..120 for smooth UE animation
+STATS_REPORT_INTERVAL_SECONDS = 10.0
+METRICS_INTERVAL_SECONDS = 5.0
 
+# Payload formats published for each state sample; subscribers pick one by
+# topic suffix (see state_codec.STATE_FORMAT_SUFFIXES).
+DEFAULT_STATE_FORMATS: tuple[str, ...] = ("bin",)
 
-@dataclass
-class PiState:
-    """Payload sent from the Pi to Unreal.
-
-    You can treat this as the canonical schema on both sides (Python + UE).
-
-    FIELDS
-    ------
-    - dialogue: latest utterance or transcript text.
-    - app_state: high-level state label (e.g. "Idle", "Listening", "Speaking").
-    - arm_*: position/rotation of a tracked arm in Pi/world space.
-    - head_*: position/rotation of the head.
-    - eyes_open: whether eyes are currently open.
-    - audio_level: normalized audio level 0..1.
-    - is_speaking: whether audio is considered active speech.
-    """
-
-    timestamp: float
-
-    # Conversational context
-    dialogue: str
-    app_state: str
-
-    # Arm pose
-    arm_pos_x: float
-    arm_pos_y: float
-    arm_pos_z: float
-    arm_rot_pitch: float
-    arm_rot_yaw: float
-    arm_rot_roll: float
-
-    # Head pose
-    head_pos_x: float
-    head_pos_y: float
-    head_pos_z: float
-    head_rot_pitch: float
-    head_rot_yaw: float
-    head_rot_roll: float
-
-    # Eyes & audio
-    eyes_open: bool
-    audio_level: float
-    is_speaking: bool
+# Callbacks run on paho's network thread and the report on the publish loop;
+# neither should wait on the terminal.
+log = get_logger("MQTT")
 
 
 class PiMqttApp:
-    def __init__(self, broker_host: str = BROKER_HOST, broker_port: int = BROKER_PORT) -> None:
+    def __init__(
+        self,
+        broker_host: str = BROKER_HOST,
+        broker_port: int = BROKER_PORT,
+        state_formats: Sequence[str] = DEFAULT_STATE_FORMATS,
+        publish_rate_hz: float = PUBLISH_RATE_HZ,
+        state_source: StateBus | None = None,
+        transport: Transport | None = None,
+        device_id: str = DEFAULT_DEVICE_ID,
+        snapshot_interval_s: float = DEFAULT_SNAPSHOT_INTERVAL_SECONDS,
+        metrics_payload: Callable[[], str | bytes] | None = None,
+        metrics_interval_s: float = METRICS_INTERVAL_SECONDS,
+    ) -> None:
         self.broker_host = broker_host
         self.broker_port = broker_port
-        self.client = mqtt.Client(client_id="pi-mqtt-app", clean_session=True)
+        # All topics and the client id are namespaced per robot, so several
+        # units can share one broker.
+        self.topics = DeviceTopics(device_id)
+        self._topic_delta_join = self.topics.state + STATE_FORMAT_SUFFIXES["delta"] + JOIN_SUFFIX
+        self.transport = transport if transport is not None else PahoTransport()
+        self.client = self.transport.create_client(self.topics.client_id)
 
         # Attach callbacks
         self.client.on_connect = self._on_connect
         self.client.on_message = self._on_message
         self.client.on_disconnect = self._on_disconnect
 
+        # Everything the app publishes goes through per-topic policies, so a
+        # slow link can't make paho buffer stale state without bound.
+        # Other publishers in the process (LLM text, audio) should use
+        # `outbound.publish` as well.
+        self.outbound = OutboundQueue(self.client, default_policies(self.topics))
+
         self._stop_event = threading.Event()
+        self.ticker = DeadlineTicker(publish_rate_hz)
+
+        # Live pipeline state, sampled once per tick. Without a bus, producers
+        # can hand over whole samples via update_state() instead; the publish
+        # loop only ever sends the latest one.
+        self.state_source = state_source
+        self.state_slot: LatestValueSlot[PiState] = LatestValueSlot()
+
+        # Commands are parsed and handled off paho's network thread; other
+        # subsystems (speech pipeline, motors) register their own handlers.
+        self.commands = CommandDispatcher()
+        self.commands.register(SetPublishRateCommand.KIND, lambda cmd: self.set_publish_rate(cmd.rate_hz))
+
+        self._delta_encoder: DeltaEncoder | None = None
+        self._bin_encoder: StateEncoder | None = None
+        # Stream encodes run under the outbound queue's lock, snapshot
+        # replies on the network thread; both share the binary encoder so
+        # its dialogue ids mean the same on every topic.
+        self._bin_lock = threading.Lock()
+        self._state_publishers: list[tuple[str, Callable[[PiState], str | bytes]]] = []
+        for fmt in state_formats:
+            if fmt not in STATE_FORMAT_SUFFIXES:
+                raise ValueError(f"Unknown state format {fmt!r}; expected one of {sorted(STATE_FORMAT_SUFFIXES)}")
+            self._state_publishers.append((self.topics.state + STATE_FORMAT_SUFFIXES[fmt], self._make_state_encoder(fmt)))
+
+        # Late joiners: retained self-contained frames for the full-state
+        # formats, refreshed periodically and whenever the sticky fields
+        # change, plus on-demand replies (see snapshot.py).
+        self.snapshot_interval_s = snapshot_interval_s
+        self._snapshot_encoders: dict[str, Callable[[PiState], str | bytes]] = {
+            "json": self._encode_state_json,
+            "bin": self._encode_bin_keyframe,
+        }
+        self._snapshot_topics = [
+            (retained_topic(self.topics.state + STATE_FORMAT_SUFFIXES[fmt]), self._snapshot_encoders[fmt])
+            for fmt in SNAPSHOT_FORMATS
+            if fmt in state_formats
+        ] or [(retained_topic(self.topics.state + STATE_FORMAT_SUFFIXES["bin"]), self._encode_bin_keyframe)]
+        self._snapshot_key: tuple | None = None
+        self._next_snapshot = 0.0
+
+        # Optional metrics snapshot (e.g. telemetry.metrics.compact_payload),
+        # published to `<prefix>/metrics` from the publish loop.
+        self.metrics_payload = metrics_payload
+        self.metrics_interval_s = metrics_interval_s
+        self._next_metrics = 0.0
+
+    def _make_state_encoder(self, fmt: str) -> Callable[[PiState], str | bytes]:
+        if fmt == "json":
+            return self._encode_state_json
+        if fmt == "bin":
+            return self._encode_bin
+        self._delta_encoder = DeltaEncoder()
+        return self._delta_encoder.encode
+
+    def _encode_bin(self, state: PiState) -> bytes:
+        with self._bin_lock:
+            if self._bin_encoder is None:
+                self._bin_encoder = StateEncoder()
+            return self._bin_encoder.encode(state)
+
+    def _encode_bin_keyframe(self, state: PiState) -> bytes:
+        with self._bin_lock:
+            if self._bin_encoder is None:
+                self._bin_encoder = StateEncoder()
+            return self._bin_encoder.encode(state, keyframe=True)
 
     # MQTT callbacks -----------------------------------------------------
 
     def _on_connect(self, client, userdata, flags, rc):  # type: ignore[override]
         if rc == 0:
-            print("[MQTT] Connected to broker")
+            log.info("Connected to broker")
             # Subscribe to commands coming from Unreal
-            client.subscribe(TOPIC_COMMANDS, qos=0)
-            print(f"[MQTT] Subscribed to commands topic: {TOPIC_COMMANDS}")
+            client.subscribe(self.topics.commands, qos=0)
+            log.info("Subscribed to commands topic: %s", self.topics.commands)
+            client.subscribe(self.topics.clock_ping, qos=0)
+            client.subscribe(self.topics.snapshot_request, qos=0)
+            if self._delta_encoder is not None:
+                client.subscribe(self._topic_delta_join, qos=0)
+                # Anyone who subscribed before this (re)connect may have missed frames.
+                self._delta_encoder.request_keyframe()
+            self.outbound.resume()
         else:
-            print(f"[MQTT] Failed to connect, return code {rc}")
+            log.error("Failed to connect, return code %s", rc)
 
     def _on_disconnect(self, client, userdata, rc):  # type: ignore[override]
-        print(f"[MQTT] Disconnected from broker (rc={rc})")
+        (log.info if rc == 0 else log.warning)("Disconnected from broker (rc=%s)", rc)
+        self.outbound.on_disconnect()
 
     def _on_message(self, client, userdata, msg):  # type: ignore[override]
-        payload = msg.payload.decode("utf-8", errors="ignore")
-        print(f"[MQTT] Received message on {msg.topic}: {payload}")
-        # TODO: Parse and act on commands from Unreal here.
+        if msg.topic == self.topics.clock_ping:
+            # Answered right here (not via the dispatcher) so queueing delay
+            # doesn't widen the t1..t2 window subscribers have to trust.
+            received_at = time.time()
+            pong = make_pong(msg.payload, received_at, pong_prefix=self.topics.clock_pong)
+            if pong is not None:
+                client.publish(pong[0], payload=pong[1], qos=0, retain=False)
+            return
+
+        if msg.topic == self.topics.snapshot_request:
+            self._answer_snapshot_request(client, msg.payload)
+            return
+
+        if msg.topic == self._topic_delta_join:
+            if self._delta_encoder is not None:
+                self._delta_encoder.request_keyframe()
+            return
+
+        if msg.topic == self.topics.commands:
+            self.commands.offer(msg.payload)
+
+    def _answer_snapshot_request(self, client, payload) -> None:
+        request = parse_request(payload)
+        if request is None:
+            return
+        client_id, fmt = request
+        # Sent directly, like pongs: one-off topics would only clutter the
+        # outbound queue's per-topic table.
+        payload = self._snapshot_encoders[fmt](self.current_state())
+        client.publish(reply_topic(client_id, self.topics.snapshot_reply), payload=payload, qos=0, retain=False)
+        if self._delta_encoder is not None:
+            self._delta_encoder.request_keyframe()
 
     # Public API ---------------------------------------------------------
 
     def start(self) -> None:
         """Connect to the broker and start the publish loop in the main thread."""
-        print(f"[MQTT] Connecting to {self.broker_host}:{self.broker_port} ...")
+        log.info("Connecting to %s:%d ...", self.broker_host, self.broker_port)
         self.client.connect(self.broker_host, self.broker_port, KEEPALIVE)
 
-        # Run the MQTT network loop in a background thread
+        # Run the MQTT network loop and the command dispatcher in background threads
         self.client.loop_start()
+        self.commands.start()
 
+        next_report = time.monotonic() + STATS_REPORT_INTERVAL_SECONDS
         try:
-            while not self._stop_event.is_set():
+            while self.ticker.wait(self._stop_event):
                 self.publish_state()
-                time.sleep(PUBLISH_INTERVAL_SECONDS)
+                self.publish_metrics()
+
+                if time.monotonic() >= next_report:
+                    next_report += STATS_REPORT_INTERVAL_SECONDS
+                    log.info("Publisher %s", self.ticker.stats().summary())
+                    for kind, stats in self.commands.stats().items():
+                        log.info("Command %s: %s", kind, stats.summary())
+                    for topic, stats in self.outbound.stats().items():
+                        log.info("Outbound %s: %s", topic, stats.summary())
         except KeyboardInterrupt:
-            print("\n[MQTT] Stopping due to keyboard interrupt...")
+            log.info("Stopping due to keyboard interrupt...")
         finally:
             self.stop()
 
+    def set_publish_rate(self, rate_hz: float) -> None:
+        """Change the state publish rate; takes effect from the next tick."""
+        self.ticker.set_rate(rate_hz)
+
+    def update_state(self, state: PiState) -> None:
+        """Offer a new state sample; superseded samples are never sent."""
+        self.state_slot.put(state)
+
     def stop(self) -> None:
         self._stop_event.set()
+        self.commands.stop()
         try:
             self.client.disconnect()
         finally:
             self.client.loop_stop()
-            print("[MQTT] Client stopped")
+            log.info("Client stopped")
 
     # Data generation / publishing --------------------------------------
 
-    def publish_state(self) -> None:
-        """Publish one state sample to Unreal.
-
-        Replace the body of this function to pull real data from sensors,
-        files, or other parts of your application.
+    def current_state(self) -> PiState:
+        """The state bus sample if one is attached, otherwise the latest
+        sample given to `update_state`, or example data if there is none yet.
         """
-        state = self._generate_example_state()
-        payload = json.dumps(asdict(state))
-        result = self.client.publish(TOPIC_STATE, payload=payload, qos=0, retain=False)
-        if result.rc != mqtt.MQTT_ERR_SUCCESS:
-            print(f"[MQTT] Failed to publish state: rc={result.rc}")
+        if self.state_source is not None:
+            return self.state_source.sample()
+        _, state = self.state_slot.get()
+        return state if state is not None else self._generate_example_state()
+
+    def publish_state(self) -> None:
+        """Publish one state sample to Unreal (and refresh the retained snapshot when due)."""
+        state = self.current_state()
+        # Encoding is deferred until the sample actually goes out, so the
+        # stateful encoders never build on a sample the queue dropped.
+        for topic, encode in self._state_publishers:
+            self.outbound.publish(topic, partial(encode, state))
+
+        key = (state.dialogue, state.app_state, state.is_speaking)
+        now = time.monotonic()
+        if key != self._snapshot_key or now >= self._next_snapshot:
+            self._snapshot_key = key
+            self._next_snapshot = now + self.snapshot_interval_s
+            for topic, encode in self._snapshot_topics:
+                self.outbound.publish(topic, partial(encode, state), retain=True)
+
+    def publish_metrics(self, force: bool = False) -> None:
+        """Publish the metrics snapshot if one is configured and it is due."""
+        if self.metrics_payload is None:
+            return
+        now = time.monotonic()
+        if not force and now < self._next_metrics:
+            return
+        self._next_metrics = now + self.metrics_interval_s
+        # Rendered lazily: if the link is slow, only the newest snapshot is built.
+        self.outbound.publish(self.topics.metrics, self.metrics_payload)
+
+    @staticmethod
+    def _encode_state_json(state: PiState) -> str:
+        return json.dumps(asdict(state))
 
     def _generate_example_state(self) -> PiState:
         """Generate example data.
@@ -220,7 +382,7 @@ class PiMqttApp:
 
 def _install_signal_handlers(app: PiMqttApp) -> None:
     def handler(signum, frame):  # type: ignore[override]
-        print(f"\n[MQTT] Caught signal {signum}, shutting down...")
+        log.info("Caught signal %s, shutting down...", signum)
         app.stop()
         sys.exit(0)
 
@@ -229,6 +391,12 @@ def _install_signal_handlers(app: PiMqttApp) -> None:
 
 
 if __name__ == "__main__":
-    app = PiMqttApp()
+    formats = os.environ.get("PI_STATE_FORMATS", ",".join(DEFAULT_STATE_FORMATS))
+    rate_hz = float(os.environ.get("PI_PUBLISH_RATE_HZ", PUBLISH_RATE_HZ))
+    app = PiMqttApp(
+        state_formats=[f.strip() for f in formats.split(",") if f.strip()],
+        publish_rate_hz=rate_hz,
+        device_id=os.environ.get("PI_DEVICE_ID", DEFAULT_DEVICE_ID),
+    )
     _install_signal_handlers(app)
     app.start()
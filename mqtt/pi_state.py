@@ -0,0 +1,73 @@
+"""Canonical `PiState` schema shared by the Pi publisher and its decoders.
+
+Kept free of any MQTT dependency so subscribers, codecs and tests can import
+it without paho-mqtt installed.
+"""
+
+from dataclasses import dataclass, fields
+
+
+@dataclass
+class PiState:
+    """Payload sent from the Pi to Unreal.
+
+    You can treat this as the canonical schema on both sides (Python + UE).
+
+    FIELDS
+    ------
+    - dialogue: latest utterance or transcript text.
+    - app_state: high-level state label (e.g. "Idle", "Listening", "Speaking").
+    - arm_*: position/rotation of a tracked arm in Pi/world space.
+    - head_*: position/rotation of the head.
+    - eyes_open: whether eyes are currently open.
+    - audio_level: normalized audio level 0..1.
+    - is_speaking: whether audio is considered active speech.
+    """
+
+    timestamp: float
+
+    # Conversational context
+    dialogue: str
+    app_state: str
+
+    # Arm pose
+    arm_pos_x: float
+    arm_pos_y: float
+    arm_pos_z: float
+    arm_rot_pitch: float
+    arm_rot_yaw: float
+    arm_rot_roll: float
+
+    # Head pose
+    head_pos_x: float
+    head_pos_y: float
+    head_pos_z: float
+    head_rot_pitch: float
+    head_rot_yaw: float
+    head_rot_roll: float
+
+    # Eyes & audio
+    eyes_open: bool
+    audio_level: float
+    is_speaking: bool
+
+
+# Field names in declaration order; the wire formats index into this tuple.
+PI_STATE_FIELDS: tuple[str, ...] = tuple(f.name for f in fields(PiState))
+
+# Float-valued pose/audio fields, in the order they are packed on the wire.
+PI_STATE_FLOAT_FIELDS: tuple[str, ...] = (
+    "arm_pos_x",
+    "arm_pos_y",
+    "arm_pos_z",
+    "arm_rot_pitch",
+    "arm_rot_yaw",
+    "arm_rot_roll",
+    "head_pos_x",
+    "head_pos_y",
+    "head_pos_z",
+    "head_rot_pitch",
+    "head_rot_yaw",
+    "head_rot_roll",
+    "audio_level",
+)
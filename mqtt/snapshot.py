@@ -0,0 +1,141 @@
+"""Late-joiner snapshots: a new subscriber is in sync within one round trip.
+
+State frames are not retained (a broker storing every 60 Hz sample would be
+wasteful), and binary frames only repeat the dialogue text every few
+frames. Without help, a UE client or web page that connects mid-session
+therefore waits for the next tick, and longer still for the dialogue. Two
+mechanisms close that gap:
+
+Retained keyframes
+    `PiMqttApp` publishes a self-contained frame (binary frames always
+    carry the dialogue definition) retained on `<state topic>/snapshot`,
+    e.g. `siggraph/pi/state/bin/snapshot`, every `PI_SNAPSHOT_INTERVAL_S`
+    (default 1 s) and immediately when dialogue, app_state or is_speaking
+    change. The broker hands it to a subscriber together with its SUBACK.
+
+Snapshot request
+    subscriber -> `siggraph/pi/snapshot/request`: {"id": "ue-1", "format": "bin"}
+    Pi -> `siggraph/pi/snapshot/reply/ue-1`: the current state as a keyframe
+    For poses fresher than the retained frame. Answered on the network
+    thread, like clock pings; also makes the delta stream send a keyframe.
+
+Binary snapshots come from the same encoder as `state/bin`, so one
+`StateDecoder` can decode the stream, the retained frame and the reply.
+
+`SnapshotJoin` does both for Python subscribers and records how long the
+first valid state took (see `bench_snapshot.py`).
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import time
+from typing import Any, Callable
+
+from .pi_state import PiState
+from .state_codec import STATE_FORMAT_SUFFIXES, StateDecoder
+from .topics import DEFAULT_DEVICE_ID, DeviceTopics, valid_client_id
+
+
+SNAPSHOT_SUFFIX = "/snapshot"
+SNAPSHOT_FORMATS = ("json", "bin")
+DEFAULT_SNAPSHOT_INTERVAL_SECONDS = float(os.environ.get("PI_SNAPSHOT_INTERVAL_S", "1.0"))
+
+
+def retained_topic(state_topic: str) -> str:
+    """Retained snapshot topic for a state stream topic (e.g. `siggraph/pi/state/bin`)."""
+    return state_topic + SNAPSHOT_SUFFIX
+
+
+def reply_topic(client_id: str, prefix: str = DeviceTopics().snapshot_reply) -> str:
+    return f"{prefix}/{client_id}"
+
+
+def make_request(client_id: str, fmt: str = "bin") -> bytes:
+    return json.dumps({"id": client_id, "format": fmt}).encode("utf-8")
+
+
+def parse_request(payload: bytes | str) -> tuple[str, str] | None:
+    """`(client_id, format)` of a snapshot request, or None if it is malformed."""
+    try:
+        request = json.loads(payload)
+    except (json.JSONDecodeError, UnicodeDecodeError):
+        return None
+    if not isinstance(request, dict) or not valid_client_id(request.get("id")):
+        return None
+    fmt = request.get("format", "bin")
+    if fmt not in SNAPSHOT_FORMATS:
+        return None
+    return request["id"], fmt
+
+
+class SnapshotJoin:
+    """Subscriber side: follow one robot's state, synced as soon as possible.
+
+    Call `on_connect(client)` from the client's connect callback and feed
+    every message to `handle_message`; decoded states go to `on_state`.
+    `time_to_first_state` is the time from `on_connect` to the first
+    decoded state whose dialogue is known, and `first_source` says which
+    message delivered it ("retained", "reply" or "stream").
+    """
+
+    def __init__(
+        self,
+        client_id: str,
+        fmt: str = "bin",
+        device_id: str = DEFAULT_DEVICE_ID,
+        on_state: Callable[[PiState], None] | None = None,
+        retained: bool = True,
+        request: bool = True,
+        clock: Callable[[], float] = time.perf_counter,
+    ) -> None:
+        if fmt not in SNAPSHOT_FORMATS:
+            raise ValueError(f"Snapshots exist for {SNAPSHOT_FORMATS}, not {fmt!r}")
+        self.client_id = client_id
+        self.fmt = fmt
+        self.topics = DeviceTopics(device_id)
+        self.state_topic = self.topics.state + STATE_FORMAT_SUFFIXES[fmt]
+        self.retained_topic = retained_topic(self.state_topic)
+        self.reply_topic = reply_topic(client_id, self.topics.snapshot_reply)
+        self.on_state = on_state
+        self.use_retained = retained
+        self.use_request = request
+        self.clock = clock
+        self._decoder = StateDecoder() if fmt == "bin" else None
+        self.joined_at: float | None = None
+        self.time_to_first_state: float | None = None
+        self.first_source: str | None = None
+
+    def on_connect(self, client: Any) -> None:
+        self.joined_at = self.clock()
+        client.subscribe(self.state_topic, qos=0)
+        if self.use_retained:
+            client.subscribe(self.retained_topic, qos=0)
+        if self.use_request:
+            client.subscribe(self.reply_topic, qos=0)
+            client.publish(self.topics.snapshot_request, make_request(self.client_id, self.fmt), qos=0)
+
+    def handle_message(self, msg: Any) -> bool:
+        if msg.topic == self.state_topic:
+            source = "stream"
+        elif msg.topic == self.retained_topic:
+            source = "retained"
+        elif msg.topic == self.reply_topic:
+            source = "reply"
+        else:
+            return False
+        if self._decoder is not None:
+            state = self._decoder.decode(msg.payload)
+            # Binary frames name the dialogue by id; it is only usable once defined.
+            dialogue_known = self._decoder.dialogue_known
+        else:
+            state = PiState(**json.loads(msg.payload))
+            dialogue_known = True
+        if self.time_to_first_state is None and self.joined_at is not None and dialogue_known:
+            self.time_to_first_state = self.clock() - self.joined_at
+            self.first_source = source
+        if self.on_state is not None:
+            self.on_state(state)
+        return True
+
@@ -0,0 +1,100 @@
+"""In-process event bus carrying the live robot state.
+
+The orchestrator, playback engine and motor controller each own a few
+`PiState` fields and write them here as things happen; `PiMqttApp` samples
+the bus once per publish tick. Writers never wait on the publisher:
+
+- every field is a slot holding a `(version, value)` tuple that its single
+  writer replaces with one reference store (atomic under the GIL);
+- fast-changing values such as motor positions can instead be *bound* to a
+  getter that is only evaluated when the bus is sampled, so the motor loop
+  pays nothing per step;
+- optional per-field subscribers are called synchronously on the writer's
+  thread and should be cheap.
+
+Field ownership (one writer per field)
+--------------------------------------
+- orchestrator (s2t-llm-t2s/main.py): app_state, dialogue
+- playback (t2s1/robot_speech.py): is_speaking, audio_level
+- motors (t2s1/motor_controller.py): head_* / arm_* poses
+"""
+
+from __future__ import annotations
+
+import time
+from typing import Any, Callable
+
+from .pi_state import PI_STATE_FIELDS, PiState
+
+
+APP_STATE_IDLE = "Idle"
+APP_STATE_LISTENING = "Listening"
+APP_STATE_THINKING = "Thinking"
+APP_STATE_SPEAKING = "Speaking"
+APP_STATES: tuple[str, ...] = (APP_STATE_IDLE, APP_STATE_LISTENING, APP_STATE_THINKING, APP_STATE_SPEAKING)
+
+# Values reported before any writer has set a field.
+DEFAULT_STATE: dict[str, Any] = {
+    **{name: 0.0 for name in PI_STATE_FIELDS},
+    "dialogue": "",
+    "app_state": APP_STATE_IDLE,
+    "eyes_open": True,
+    "is_speaking": False,
+}
+
+
+class _Slot:
+    __slots__ = ("entry", "probe", "subscribers")
+
+    def __init__(self, value: Any) -> None:
+        self.entry: tuple[int, Any] = (0, value)
+        self.probe: Callable[[], Any] | None = None
+        self.subscribers: list[Callable[[str, Any], None]] = []
+
+
+class StateBus:
+    """Named single-writer slots for every `PiState` field except `timestamp`."""
+
+    def __init__(self) -> None:
+        self._slots = {name: _Slot(DEFAULT_STATE[name]) for name in PI_STATE_FIELDS if name != "timestamp"}
+
+    def _slot(self, field: str) -> _Slot:
+        try:
+            return self._slots[field]
+        except KeyError:
+            raise KeyError(f"Unknown state field {field!r}") from None
+
+    def set(self, field: str, value: Any) -> None:
+        """Publish a new value for `field` (call only from that field's owner)."""
+        slot = self._slot(field)
+        slot.entry = (slot.entry[0] + 1, value)
+        for callback in slot.subscribers:
+            callback(field, value)
+
+    def bind(self, field: str, getter: Callable[[], Any] | None) -> None:
+        """Sample `field` from `getter` at read time instead of from its slot.
+
+        Pass None to unbind and fall back to the last `set` value.
+        """
+        self._slot(field).probe = getter
+
+    def subscribe(self, field: str, callback: Callable[[str, Any], None]) -> None:
+        """Call `callback(field, value)` whenever `field` is `set`."""
+        self._slot(field).subscribers.append(callback)
+
+    def get(self, field: str) -> Any:
+        slot = self._slot(field)
+        probe = slot.probe
+        return probe() if probe is not None else slot.entry[1]
+
+    def version(self, field: str) -> int:
+        """Number of `set` calls on `field` so far (bound getters don't count)."""
+        return self._slot(field).entry[0]
+
+    def sample(self, timestamp: float | None = None) -> PiState:
+        """Snapshot every field into a `PiState` stamped with `timestamp` (default: now)."""
+        values = {}
+        for name, slot in self._slots.items():
+            probe = slot.probe
+            values[name] = probe() if probe is not None else slot.entry[1]
+        return PiState(timestamp=time.time() if timestamp is None else timestamp, **values)
@@ -0,0 +1,276 @@
+"""Compact binary wire format for `PiState`.
+
+JSON costs ~500 bytes and an `asdict` + `json.dumps` per sample. This module
+packs the same data into a versioned fixed layout that subscribers select by
+topic suffix (see `STATE_FORMAT_SUFFIXES`), so JSON stays available for
+debugging next to it.
+
+Layout (version 1, little-endian)
+---------------------------------
+    offset  size  field
+    0       2     magic b"PS"
+    2       1     format version
+    3       1     flags: bit 0 eyes_open, bit 1 is_speaking,
+                  bit 2 app_state inline, bit 3 dialogue definition follows
+    4       8     timestamp (float64, Pi wall-clock seconds)
+    12      52    13 x float32, in `PI_STATE_FLOAT_FIELDS` order
+    64      1     app_state code (index into `APP_STATES`, 0xFF = inline)
+    65      2     dialogue id (uint16, 0 = empty string)
+    67      ...   u8 length + UTF-8 app_state     if the inline flag is set
+                  u16 length + UTF-8 dialogue      if the definition flag is set
+
+Strings are interned: the dialogue text is only carried when its id changes
+and every `refresh_every` frames after that, so subscribers that join late
+learn the current text within a fraction of a second.
+"""
+
+from __future__ import annotations
+
+import struct
+
+from .pi_state import PI_STATE_FLOAT_FIELDS, PiState
+
+
+FORMAT_VERSION = 1
+MAGIC = b"PS"
+
+# Topic suffix per payload format, appended to the base state topic.
+STATE_FORMAT_SUFFIXES: dict[str, str] = {
+    "json": "",
+    "bin": "/bin",
+    "delta": "/delta",  # see state_delta.py
+}
+
+# Well-known app_state labels are sent as a one-byte code.
+APP_STATES: tuple[str, ...] = ("", "Idle", "Listening", "Thinking", "Speaking")
+APP_STATE_INLINE = 0xFF
+
+FLAG_EYES_OPEN = 0x01
+FLAG_IS_SPEAKING = 0x02
+FLAG_APP_STATE_INLINE = 0x04
+FLAG_DIALOGUE_DEF = 0x08
+
+# Upper bound on distinct dialogue strings kept by the encoder before its
+# table is reset (ids are then reassigned and re-defined on the wire).
+MAX_INTERNED_STRINGS = 1024
+MAX_APP_STATE_BYTES = 0xFF
+MAX_DIALOGUE_BYTES = 0xFFFF
+
+_FIXED = struct.Struct("<2sBBd13fBH")
+_U8 = struct.Struct("<B")
+_U16 = struct.Struct("<H")
+
+FIXED_FRAME_SIZE = _FIXED.size
+MAX_FRAME_SIZE = FIXED_FRAME_SIZE + 1 + MAX_APP_STATE_BYTES + 2 + MAX_DIALOGUE_BYTES
+
+_APP_STATE_CODES = {label: code for code, label in enumerate(APP_STATES)}
+_TIMESTAMP = struct.Struct("<d")
+_TIMESTAMP_OFFSET = 4  # after magic, version, flags
+
+
+def peek_timestamp(payload: bytes | bytearray | memoryview) -> float:
+    """Return a frame's timestamp without decoding it (no validation)."""
+    return _TIMESTAMP.unpack_from(payload, _TIMESTAMP_OFFSET)[0]
+
+
+def require(payload: bytes | bytearray | memoryview, end: int, what: str) -> None:
+    """Raise ValueError if `payload` ends before byte `end` (a truncated frame)."""
+    if len(payload) < end:
+        raise ValueError(f"{what} truncated: {len(payload)} bytes, need {end}")
+
+
+def utf8_truncated(text: str, limit: int) -> bytes:
+    data = text.encode("utf-8")
+    if len(data) <= limit:
+        return data
+    # Cut on a character boundary so decoders never see a split code point.
+    return data[:limit].decode("utf-8", errors="ignore").encode("utf-8")
+
+
+class StateEncoder:
+    """Encode `PiState` samples into the binary layout.
+
+    `encode_into` writes into a caller-provided buffer and allocates nothing
+    once the current strings have been interned; `encode` wraps it around an
+    internal buffer for callers (like paho) that need an immutable payload.
+    """
+
+    def __init__(self, refresh_every: int = 10) -> None:
+        self.refresh_every = max(1, refresh_every)
+        self._buf = bytearray(MAX_FRAME_SIZE)
+        self._view = memoryview(self._buf)
+
+        self._dialogue_ids: dict[str, tuple[int, bytes]] = {}
+        self._next_dialogue_id = 1
+        self._last_dialogue_id = -1
+        self._frames_since_def = 0
+
+        self._inline_app_states: dict[str, bytes] = {}
+
+    def _intern_dialogue(self, dialogue: str) -> tuple[int, bytes]:
+        entry = self._dialogue_ids.get(dialogue)
+        if entry is not None:
+            return entry
+
+        if self._next_dialogue_id > MAX_INTERNED_STRINGS:
+            self._dialogue_ids.clear()
+            self._next_dialogue_id = 1
+
+        entry = (self._next_dialogue_id, utf8_truncated(dialogue, MAX_DIALOGUE_BYTES))
+        self._next_dialogue_id += 1
+        self._dialogue_ids[dialogue] = entry
+        return entry
+
+    def _inline_app_state(self, app_state: str) -> bytes:
+        data = self._inline_app_states.get(app_state)
+        if data is None:
+            if len(self._inline_app_states) >= MAX_INTERNED_STRINGS:
+                self._inline_app_states.clear()
+            data = utf8_truncated(app_state, MAX_APP_STATE_BYTES)
+            self._inline_app_states[app_state] = data
+        return data
+
+    def encode_into(self, state: PiState, buf: bytearray, offset: int = 0, keyframe: bool = False) -> int:
+        """Write one frame for `state` into `buf` at `offset`; return its length.
+
+        A `keyframe` always carries the dialogue definition, so it decodes on
+        its own (late-joiner snapshots), and leaves the stream's refresh
+        bookkeeping untouched.
+        """
+        flags = 0
+        if state.eyes_open:
+            flags |= FLAG_EYES_OPEN
+        if state.is_speaking:
+            flags |= FLAG_IS_SPEAKING
+
+        app_state_code = _APP_STATE_CODES.get(state.app_state, APP_STATE_INLINE)
+        app_state_bytes = b""
+        if app_state_code == APP_STATE_INLINE:
+            flags |= FLAG_APP_STATE_INLINE
+            app_state_bytes = self._inline_app_state(state.app_state)
+
+        if state.dialogue:
+            dialogue_id, dialogue_bytes = self._intern_dialogue(state.dialogue)
+        else:
+            dialogue_id, dialogue_bytes = 0, b""
+
+        if keyframe:
+            if dialogue_id:
+                flags |= FLAG_DIALOGUE_DEF
+        else:
+            self._frames_since_def += 1
+            if dialogue_id and (
+                dialogue_id != self._last_dialogue_id or self._frames_since_def >= self.refresh_every
+            ):
+                flags |= FLAG_DIALOGUE_DEF
+                self._frames_since_def = 0
+            self._last_dialogue_id = dialogue_id
+
+        _FIXED.pack_into(
+            buf,
+            offset,
+            MAGIC,
+            FORMAT_VERSION,
+            flags,
+            state.timestamp,
+            state.arm_pos_x,
+            state.arm_pos_y,
+            state.arm_pos_z,
+            state.arm_rot_pitch,
+            state.arm_rot_yaw,
+            state.arm_rot_roll,
+            state.head_pos_x,
+            state.head_pos_y,
+            state.head_pos_z,
+            state.head_rot_pitch,
+            state.head_rot_yaw,
+            state.head_rot_roll,
+            state.audio_level,
+            app_state_code,
+            dialogue_id,
+        )
+        pos = offset + FIXED_FRAME_SIZE
+
+        if flags & FLAG_APP_STATE_INLINE:
+            _U8.pack_into(buf, pos, len(app_state_bytes))
+            pos += 1
+            buf[pos : pos + len(app_state_bytes)] = app_state_bytes
+            pos += len(app_state_bytes)
+
+        if flags & FLAG_DIALOGUE_DEF:
+            _U16.pack_into(buf, pos, len(dialogue_bytes))
+            pos += 2
+            buf[pos : pos + len(dialogue_bytes)] = dialogue_bytes
+            pos += len(dialogue_bytes)
+
+        return pos - offset
+
+    def encode(self, state: PiState, keyframe: bool = False) -> bytes:
+        """Encode `state` and return an immutable copy of the frame."""
+        n = self.encode_into(state, self._buf, keyframe=keyframe)
+        return bytes(self._view[:n])
+
+
+class StateDecoder:
+    """Rebuild `PiState` from binary frames, tracking the interned strings.
+
+    Until a dialogue definition has been received for the current id the
+    decoded `dialogue` is the empty string and `dialogue_known` is False.
+    """
+
+    def __init__(self) -> None:
+        self._dialogues: dict[int, str] = {0: ""}
+        self.dialogue_known = True  # for the last decoded frame
+
+    def decode(self, payload: bytes | bytearray | memoryview) -> PiState:
+        if len(payload) < FIXED_FRAME_SIZE:
+            raise ValueError(f"PiState frame too short: {len(payload)} bytes")
+
+        (
+            magic,
+            version,
+            flags,
+            timestamp,
+            *floats,
+            app_state_code,
+            dialogue_id,
+        ) = _FIXED.unpack_from(payload, 0)
+
+        if magic != MAGIC:
+            raise ValueError(f"Not a PiState frame (magic={magic!r})")
+        if version != FORMAT_VERSION:
+            raise ValueError(f"Unsupported PiState format version {version}")
+
+        pos = FIXED_FRAME_SIZE
+
+        if flags & FLAG_APP_STATE_INLINE:
+            require(payload, pos + 1, "PiState frame")
+            (n,) = _U8.unpack_from(payload, pos)
+            pos += 1
+            require(payload, pos + n, "PiState frame")
+            app_state = bytes(payload[pos : pos + n]).decode("utf-8", errors="replace")
+            pos += n
+        elif app_state_code < len(APP_STATES):
+            app_state = APP_STATES[app_state_code]
+        else:
+            raise ValueError(f"Unknown app_state code {app_state_code}")
+
+        if flags & FLAG_DIALOGUE_DEF:
+            require(payload, pos + 2, "PiState frame")
+            (n,) = _U16.unpack_from(payload, pos)
+            pos += 2
+            require(payload, pos + n, "PiState frame")
+            self._dialogues[dialogue_id] = bytes(payload[pos : pos + n]).decode("utf-8", errors="replace")
+            pos += n
+
+        values = dict(zip(PI_STATE_FLOAT_FIELDS, floats))
+        dialogue = self._dialogues.get(dialogue_id)
+        self.dialogue_known = dialogue is not None
+        return PiState(
+            timestamp=timestamp,
+            dialogue=dialogue or "",
+            app_state=app_state,
+            eyes_open=bool(flags & FLAG_EYES_OPEN),
+            is_speaking=bool(flags & FLAG_IS_SPEAKING),
+            **values,
+        )
@@ -0,0 +1,288 @@
+"""Delta-encoded `PiState` stream with periodic keyframes.
+
+Most fields are unchanged between consecutive samples, so instead of the full
+state this stream sends a keyframe every `keyframe_interval` samples (or as
+soon as a subscriber asks for one) and, in between, only the fields that
+moved by more than their quantization threshold since they were last sent.
+
+Layout (version 1, little-endian)
+---------------------------------
+Every frame starts with a 14-byte header:
+
+    0   2  magic b"PD"
+    2   1  format version
+    3   1  kind (0 = keyframe, 1 = delta)
+    4   2  sequence number (uint16, wraps)
+    6   8  timestamp (float64)
+
+Keyframe body: a complete `state_codec` frame (dialogue text included).
+
+Delta body:
+
+    u32 change mask: bits 0..12 float fields in `PI_STATE_FLOAT_FIELDS` order,
+        bit 13 eyes_open, bit 14 is_speaking, bit 15 app_state, bit 16 dialogue
+    float32 per changed float field, in bit order
+    u8 bool bits (bit 0 eyes_open, bit 1 is_speaking) if bit 13 or 14 is set
+    u8 length + UTF-8 app_state                    if bit 15 is set
+    u16 length + UTF-8 dialogue                    if bit 16 is set
+
+A subscriber that joins late, or detects a sequence gap, publishes anything to
+the `/delta/join` topic to get a keyframe on the next sample.
+"""
+
+from __future__ import annotations
+
+import struct
+from dataclasses import replace
+from typing import Mapping
+
+from .pi_state import PI_STATE_FLOAT_FIELDS, PiState
+from .state_codec import (
+    MAX_APP_STATE_BYTES,
+    MAX_DIALOGUE_BYTES,
+    MAX_FRAME_SIZE,
+    StateDecoder,
+    StateEncoder,
+    require,
+    utf8_truncated,
+)
+
+
+FORMAT_VERSION = 1
+MAGIC = b"PD"
+
+KIND_KEYFRAME = 0
+KIND_DELTA = 1
+
+# Suffix (relative to the delta state topic) that subscribers publish to in
+# order to request a keyframe.
+JOIN_SUFFIX = "/join"
+
+DEFAULT_KEYFRAME_INTERVAL = 50
+
+# Changes smaller than these are not sent; positions are in cm, rotations in
+# degrees, audio_level is normalized 0..1.
+DEFAULT_THRESHOLDS: dict[str, float] = {
+    **{name: 0.05 for name in PI_STATE_FLOAT_FIELDS if "_pos_" in name},
+    **{name: 0.1 for name in PI_STATE_FLOAT_FIELDS if "_rot_" in name},
+    "audio_level": 0.02,
+}
+
+_NUM_FLOATS = len(PI_STATE_FLOAT_FIELDS)
+BIT_EYES_OPEN = 1 << _NUM_FLOATS
+BIT_IS_SPEAKING = 1 << (_NUM_FLOATS + 1)
+BIT_APP_STATE = 1 << (_NUM_FLOATS + 2)
+BIT_DIALOGUE = 1 << (_NUM_FLOATS + 3)
+
+_HEADER = struct.Struct("<2sBBHd")
+_MASK = struct.Struct("<I")
+_F32 = struct.Struct("<f")
+_U8 = struct.Struct("<B")
+_U16 = struct.Struct("<H")
+
+HEADER_SIZE = _HEADER.size
+
+MAX_DELTA_FRAME_SIZE = HEADER_SIZE + max(
+    MAX_FRAME_SIZE,
+    _MASK.size + _NUM_FLOATS * 4 + 1 + 1 + MAX_APP_STATE_BYTES + 2 + MAX_DIALOGUE_BYTES,
+)
+
+
+def peek_header(payload: bytes | bytearray | memoryview) -> tuple[int, int, float]:
+    """Return `(kind, seq, timestamp)` of a delta frame without decoding it."""
+    _magic, _version, kind, seq, timestamp = _HEADER.unpack_from(payload, 0)
+    return kind, seq, timestamp
+
+
+class DeltaEncoder:
+    """Turn a sequence of `PiState` samples into keyframes and deltas."""
+
+    def __init__(
+        self,
+        keyframe_interval: int = DEFAULT_KEYFRAME_INTERVAL,
+        thresholds: Mapping[str, float] | None = None,
+    ) -> None:
+        self.keyframe_interval = max(1, keyframe_interval)
+        merged = {**DEFAULT_THRESHOLDS, **(thresholds or {})}
+        self._thresholds = tuple(merged[name] for name in PI_STATE_FLOAT_FIELDS)
+
+        # refresh_every=1: keyframes always carry the dialogue text.
+        self._key_encoder = StateEncoder(refresh_every=1)
+        self._buf = bytearray(MAX_DELTA_FRAME_SIZE)
+        self._view = memoryview(self._buf)
+
+        self._seq = 0
+        self._since_keyframe = 0
+        self._keyframe_requested = True
+
+        # Last values actually put on the wire.
+        self._sent_floats = [0.0] * _NUM_FLOATS
+        self._sent_eyes_open = False
+        self._sent_is_speaking = False
+        self._sent_app_state = ""
+        self._sent_dialogue = ""
+
+    def request_keyframe(self) -> None:
+        """Make the next encoded frame a keyframe (e.g. a subscriber joined).
+
+        Safe to call from another thread such as paho's network loop.
+        """
+        self._keyframe_requested = True
+
+    def encode_into(self, state: PiState, buf: bytearray, offset: int = 0) -> int:
+        """Write the next frame for `state` into `buf`; return its length."""
+        seq = self._seq
+        self._seq = (seq + 1) & 0xFFFF
+        self._since_keyframe += 1
+
+        if self._keyframe_requested or self._since_keyframe >= self.keyframe_interval:
+            self._keyframe_requested = False
+            self._since_keyframe = 0
+            return self._encode_keyframe(state, seq, buf, offset)
+        return self._encode_delta(state, seq, buf, offset)
+
+    def encode(self, state: PiState) -> bytes:
+        n = self.encode_into(state, self._buf)
+        return bytes(self._view[:n])
+
+    def _encode_keyframe(self, state: PiState, seq: int, buf: bytearray, offset: int) -> int:
+        _HEADER.pack_into(buf, offset, MAGIC, FORMAT_VERSION, KIND_KEYFRAME, seq, state.timestamp)
+        n = self._key_encoder.encode_into(state, buf, offset + HEADER_SIZE)
+
+        sent = self._sent_floats
+        for i, name in enumerate(PI_STATE_FLOAT_FIELDS):
+            sent[i] = getattr(state, name)
+        self._sent_eyes_open = state.eyes_open
+        self._sent_is_speaking = state.is_speaking
+        self._sent_app_state = state.app_state
+        self._sent_dialogue = state.dialogue
+        return HEADER_SIZE + n
+
+    def _encode_delta(self, state: PiState, seq: int, buf: bytearray, offset: int) -> int:
+        _HEADER.pack_into(buf, offset, MAGIC, FORMAT_VERSION, KIND_DELTA, seq, state.timestamp)
+        mask_pos = offset + HEADER_SIZE
+        pos = mask_pos + _MASK.size
+        mask = 0
+
+        sent = self._sent_floats
+        thresholds = self._thresholds
+        for i, name in enumerate(PI_STATE_FLOAT_FIELDS):
+            value = getattr(state, name)
+            if abs(value - sent[i]) > thresholds[i]:
+                mask |= 1 << i
+                sent[i] = value
+                _F32.pack_into(buf, pos, value)
+                pos += 4
+
+        if state.eyes_open != self._sent_eyes_open:
+            mask |= BIT_EYES_OPEN
+            self._sent_eyes_open = state.eyes_open
+        if state.is_speaking != self._sent_is_speaking:
+            mask |= BIT_IS_SPEAKING
+            self._sent_is_speaking = state.is_speaking
+        if mask & (BIT_EYES_OPEN | BIT_IS_SPEAKING):
+            _U8.pack_into(buf, pos, (1 if state.eyes_open else 0) | (2 if state.is_speaking else 0))
+            pos += 1
+
+        if state.app_state != self._sent_app_state:
+            mask |= BIT_APP_STATE
+            self._sent_app_state = state.app_state
+            data = utf8_truncated(state.app_state, MAX_APP_STATE_BYTES)
+            _U8.pack_into(buf, pos, len(data))
+            pos += 1
+            buf[pos : pos + len(data)] = data
+            pos += len(data)
+
+        if state.dialogue != self._sent_dialogue:
+            mask |= BIT_DIALOGUE
+            self._sent_dialogue = state.dialogue
+            data = utf8_truncated(state.dialogue, MAX_DIALOGUE_BYTES)
+            _U16.pack_into(buf, pos, len(data))
+            pos += 2
+            buf[pos : pos + len(data)] = data
+            pos += len(data)
+
+        _MASK.pack_into(buf, mask_pos, mask)
+        return pos - offset
+
+
+class DeltaDecoder:
+    """Reference decoder: rebuilds full `PiState` samples from the stream.
+
+    `decode` returns None while no keyframe has been seen, and again after a
+    sequence gap until the next keyframe arrives; `needs_keyframe` tells the
+    caller when to publish a join request.
+    """
+
+    def __init__(self) -> None:
+        self._key_decoder = StateDecoder()
+        self._state: PiState | None = None
+        self._expected_seq: int | None = None
+        self.gaps = 0
+
+    @property
+    def needs_keyframe(self) -> bool:
+        return self._state is None
+
+    def decode(self, payload: bytes | bytearray | memoryview) -> PiState | None:
+        if len(payload) < HEADER_SIZE:
+            raise ValueError(f"Delta frame too short: {len(payload)} bytes")
+
+        magic, version, kind, seq, timestamp = _HEADER.unpack_from(payload, 0)
+        if magic != MAGIC:
+            raise ValueError(f"Not a PiState delta frame (magic={magic!r})")
+        if version != FORMAT_VERSION:
+            raise ValueError(f"Unsupported delta format version {version}")
+
+        expected = self._expected_seq
+        self._expected_seq = (seq + 1) & 0xFFFF
+
+        if kind == KIND_KEYFRAME:
+            self._state = self._key_decoder.decode(memoryview(payload)[HEADER_SIZE:])
+            return self._state
+        if kind != KIND_DELTA:
+            raise ValueError(f"Unknown delta frame kind {kind}")
+
+        if self._state is None:
+            return None
+        if seq != expected:
+            self.gaps += 1
+            self._state = None
+            return None
+
+        require(payload, HEADER_SIZE + _MASK.size, "Delta frame")
+        (mask,) = _MASK.unpack_from(payload, HEADER_SIZE)
+        pos = HEADER_SIZE + _MASK.size
+        changes: dict[str, object] = {"timestamp": timestamp}
+
+        for i, name in enumerate(PI_STATE_FLOAT_FIELDS):
+            if mask & (1 << i):
+                require(payload, pos + 4, "Delta frame")
+                (changes[name],) = _F32.unpack_from(payload, pos)
+                pos += 4
+
+        if mask & (BIT_EYES_OPEN | BIT_IS_SPEAKING):
+            require(payload, pos + 1, "Delta frame")
+            (bits,) = _U8.unpack_from(payload, pos)
+            pos += 1
+            changes["eyes_open"] = bool(bits & 1)
+            changes["is_speaking"] = bool(bits & 2)
+
+        if mask & BIT_APP_STATE:
+            require(payload, pos + 1, "Delta frame")
+            (n,) = _U8.unpack_from(payload, pos)
+            pos += 1
+            require(payload, pos + n, "Delta frame")
+            changes["app_state"] = bytes(payload[pos : pos + n]).decode("utf-8", errors="replace")
+            pos += n
+
+        if mask & BIT_DIALOGUE:
+            require(payload, pos + 2, "Delta frame")
+            (n,) = _U16.unpack_from(payload, pos)
+            pos += 2
+            require(payload, pos + n, "Delta frame")
+            changes["dialogue"] = bytes(payload[pos : pos + n]).decode("utf-8", errors="replace")
+            pos += n
+
+        self._state = replace(self._state, **changes)
+        return self._state
@@ -0,0 +1,260 @@
+"""Incremental LLM text on `llm/text`, coalesced into a few messages per second.
+
+Publishing one MQTT packet per token costs a JSON encode, a socket write and
+a broker fan-out each; at a few hundred tokens/s that is mostly overhead.
+`TextStreamPublisher.append` only buffers the text; a flusher thread sends
+whatever has accumulated once the coalescing window (default 50 ms) has
+passed since the first unsent character, or sooner if `max_chars` pile up.
+
+Wire format (JSON object per message, `seq` counts from 0 within a turn)
+-------------------------------------------------------------------------
+    {"op": "begin",  "turn": 7, "seq": 0, "ts": 1718000000.0}
+    {"op": "append", "turn": 7, "seq": 1, "text": "Hello the"}
+    {"op": "append", "turn": 7, "seq": 2, "text": "re, I am Lafufu."}
+    {"op": "end",    "turn": 7, "seq": 3, "ts": 1718000001.2}
+
+Subscribers concatenate `append` texts in `seq` order; a `begin` (or any
+message with a newer `turn`) starts a fresh reply.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import threading
+import time
+from dataclasses import dataclass
+from typing import Any, Callable
+
+
+TOPIC_LLM_TEXT = "llm/text"
+
+DEFAULT_WINDOW_SECONDS = float(os.environ.get("LLM_TEXT_WINDOW_MS", "50")) / 1000.0
+DEFAULT_MAX_CHARS = 512
+
+OP_BEGIN = "begin"
+OP_APPEND = "append"
+OP_END = "end"
+
+_THINK_TAGS = (("<think>", "</think>"), ("<thinking>", "</thinking>"))
+
+
+@dataclass
+class TextStreamStats:
+    """Counters for one publisher; `publish_ms` covers encoding plus the `publish` call."""
+
+    appends: int
+    messages: int
+    chars: int
+    payload_bytes: int
+    publish_ms: float
+
+    def summary(self) -> str:
+        ratio = self.appends / self.messages if self.messages else 0.0
+        per_msg = self.publish_ms / self.messages if self.messages else 0.0
+        return (
+            f"{self.appends} appends -> {self.messages} messages ({ratio:.1f}x coalescing), "
+            f"{self.payload_bytes} bytes, publish {self.publish_ms:.1f} ms total / {per_msg * 1000:.0f} us per message"
+        )
+
+
+class TextStreamPublisher:
+    """Streams one reply at a time to a topic as begin/append/end messages.
+
+    `publish(topic, payload)` is called from the flusher thread (and from
+    `end_turn`'s caller); for paho pass `lambda t, p: client.publish(t, p)`.
+    A window of 0 sends every append immediately.
+    """
+
+    def __init__(
+        self,
+        publish: Callable[[str, bytes], Any],
+        topic: str = TOPIC_LLM_TEXT,
+        window_s: float = DEFAULT_WINDOW_SECONDS,
+        max_chars: int = DEFAULT_MAX_CHARS,
+    ) -> None:
+        if window_s < 0:
+            raise ValueError(f"window_s must be >= 0, got {window_s}")
+        self._publish = publish
+        self.topic = topic
+        self.window_s = window_s
+        self.max_chars = max_chars
+
+        self._cond = threading.Condition()
+        self._pending: list[str] = []
+        self._pending_chars = 0
+        self._deadline: float | None = None  # monotonic time the pending text must go out
+        self._turn = 0
+        self._seq = 0
+        self._open = False
+        self._closed = False
+        # Held across take-pending-and-send so the flusher and end_turn can
+        # never put an append on the wire after its turn's `end`.
+        self._send_lock = threading.RLock()
+
+        self._appends = 0
+        self._messages = 0
+        self._chars = 0
+        self._bytes = 0
+        self._publish_s = 0.0
+
+        self._thread: threading.Thread | None = None
+        if window_s > 0:
+            self._thread = threading.Thread(target=self._run, name="llm-text-flush", daemon=True)
+            self._thread.start()
+
+    # Producer API -------------------------------------------------------
+
+    def begin_turn(self) -> int:
+        """Start a new reply (ending any open one) and return its turn number."""
+        with self._send_lock:
+            self.end_turn()
+            self._turn += 1
+            self._seq = 0
+            self._open = True
+            self._send(OP_BEGIN, ts=time.time())
+            return self._turn
+
+    def append(self, text: str) -> None:
+        """Queue `text` for the current turn; returns without publishing."""
+        if not text:
+            return
+        if not self._open:
+            self.begin_turn()
+        with self._cond:
+            self._appends += 1
+            self._pending.append(text)
+            self._pending_chars += len(text)
+            if self._thread is None:
+                flush_now = True
+            else:
+                flush_now = False
+                if self._deadline is None:
+                    self._deadline = time.monotonic() + self.window_s
+                if self._pending_chars >= self.max_chars:
+                    self._deadline = 0.0
+                self._cond.notify()
+        if flush_now:
+            self.flush()
+
+    def end_turn(self) -> None:
+        """Flush the rest of the reply and send `end`."""
+        with self._send_lock:
+            if not self._open:
+                return
+            self.flush()
+            self._open = False
+            self._send(OP_END, ts=time.time())
+
+    def flush(self) -> None:
+        """Publish pending text now, regardless of the window."""
+        with self._send_lock:
+            with self._cond:
+                if not self._pending:
+                    return
+                text = "".join(self._pending)
+                self._pending.clear()
+                self._pending_chars = 0
+                self._deadline = None
+            self._send(OP_APPEND, text=text)
+
+    def close(self) -> None:
+        self.end_turn()
+        with self._cond:
+            self._closed = True
+            self._cond.notify()
+        if self._thread is not None:
+            self._thread.join(timeout=1.0)
+            self._thread = None
+
+    def stats(self) -> TextStreamStats:
+        return TextStreamStats(
+            appends=self._appends,
+            messages=self._messages,
+            chars=self._chars,
+            payload_bytes=self._bytes,
+            publish_ms=self._publish_s * 1000.0,
+        )
+
+    # Internals ----------------------------------------------------------
+
+    def _send(self, op: str, **fields: Any) -> None:
+        # Caller holds _send_lock, so seq order is wire order.
+        message = {"op": op, "turn": self._turn, "seq": self._seq, **fields}
+        self._seq += 1
+        started = time.perf_counter()
+        payload = json.dumps(message, ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+        self._publish(self.topic, payload)
+        self._publish_s += time.perf_counter() - started
+        self._messages += 1
+        self._bytes += len(payload)
+        self._chars += len(fields.get("text", ""))
+
+    def _run(self) -> None:
+        while True:
+            with self._cond:
+                while not self._closed:
+                    if self._deadline is None:
+                        self._cond.wait()
+                        continue
+                    remaining = self._deadline - time.monotonic()
+                    if remaining <= 0:
+                        break
+                    self._cond.wait(remaining)
+                if self._closed:
+                    return
+            self.flush()
+
+
+class ThinkBlockFilter:
+    """Streaming counterpart of `strip_think_blocks` for incremental text.
+
+    Drops `<think>...</think>` / `<thinking>...</thinking>` sections from a
+    sequence of chunks, holding back a chunk tail that could be the start of
+    a tag split across chunks.
+    """
+
+    def __init__(self) -> None:
+        self._buf = ""
+        self._close_tag: str | None = None
+
+    def feed(self, chunk: str) -> str:
+        """Return the visible text that is safe to emit after `chunk`."""
+        self._buf += chunk
+        out: list[str] = []
+        while self._buf:
+            if self._close_tag is not None:
+                end = self._buf.find(self._close_tag)
+                if end < 0:
+                    # Keep only what could be the start of the closing tag.
+                    self._buf = self._buf[-(len(self._close_tag) - 1):]
+                    break
+                self._buf = self._buf[end + len(self._close_tag):]
+                self._close_tag = None
+                continue
+
+            start = self._buf.find("<")
+            if start < 0:
+                out.append(self._buf)
+                self._buf = ""
+                break
+            out.append(self._buf[:start])
+            self._buf = self._buf[start:]
+            for open_tag, close_tag in _THINK_TAGS:
+                if self._buf.startswith(open_tag):
+                    self._buf = self._buf[len(open_tag):]
+                    self._close_tag = close_tag
+                    break
+            else:
+                if any(tag.startswith(self._buf) for tag, _ in _THINK_TAGS):
+                    break  # could still become an opening tag: wait for more
+                out.append("<")
+                self._buf = self._buf[1:]
+        return "".join(out)
+
+    def flush(self) -> str:
+        """Return any held-back text at the end of the stream."""
+        rest = "" if self._close_tag is not None else self._buf
+        self._buf = ""
+        self._close_tag = None
+        return rest
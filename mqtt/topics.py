@@ -0,0 +1,119 @@
+"""Per-device MQTT topic namespace, so several robots can share one broker.
+
+Every robot publishes and subscribes under `siggraph/<device_id>/...` and
+connects with client id `pi-mqtt-app-<device_id>`. The default device id
+"pi" keeps the original topic names (`siggraph/pi/state`, ...).
+
+Dashboards and the aggregator use the wildcard filters below to follow all
+robots at once. Device ids starting with "_" are reserved for fleet-wide
+topics such as `TOPIC_AGGREGATE`.
+"""
+
+from __future__ import annotations
+
+from dataclasses import dataclass
+
+
+TOPIC_ROOT = "siggraph"
+DEFAULT_DEVICE_ID = "pi"
+CLIENT_ID_PREFIX = "pi-mqtt-app"
+
+# Published by the aggregator: JSON table of every robot's latest state.
+TOPIC_AGGREGATE = f"{TOPIC_ROOT}/_all/robots"
+
+MAX_DEVICE_ID_LENGTH = 32
+MAX_CLIENT_ID_LENGTH = 64
+
+
+def validate_device_id(device_id: str) -> str:
+    """Return `device_id` if it is usable as one topic level, else raise ValueError."""
+    if (
+        not isinstance(device_id, str)
+        or not 0 < len(device_id) <= MAX_DEVICE_ID_LENGTH
+        or device_id.startswith("_")
+        or any(c in device_id for c in "/+# ")
+    ):
+        raise ValueError(
+            f"Invalid device id {device_id!r}: 1..{MAX_DEVICE_ID_LENGTH} chars, "
+            "no '/', '+', '#' or spaces, not starting with '_'"
+        )
+    return device_id
+
+
+def valid_client_id(client_id: object) -> bool:
+    """True if `client_id` can be appended as one topic level (clock pongs, snapshot replies)."""
+    return (
+        isinstance(client_id, str)
+        and 0 < len(client_id) <= MAX_CLIENT_ID_LENGTH
+        and not any(c in client_id for c in "/+#")
+    )
+
+
+@dataclass(frozen=True)
+class DeviceTopics:
+    """All topic names for one robot."""
+
+    device_id: str = DEFAULT_DEVICE_ID
+
+    def __post_init__(self) -> None:
+        validate_device_id(self.device_id)
+
+    @property
+    def prefix(self) -> str:
+        return f"{TOPIC_ROOT}/{self.device_id}"
+
+    @property
+    def client_id(self) -> str:
+        return f"{CLIENT_ID_PREFIX}-{self.device_id}"
+
+    @property
+    def state(self) -> str:
+        return f"{self.prefix}/state"
+
+    @property
+    def commands(self) -> str:
+        return f"{self.prefix}/commands"
+
+    @property
+    def clock_ping(self) -> str:
+        return f"{self.prefix}/clock/ping"
+
+    @property
+    def clock_pong(self) -> str:
+        """Prefix for pong replies; each subscriber appends `/<its id>`."""
+        return f"{self.prefix}/clock/pong"
+
+    @property
+    def llm_text(self) -> str:
+        return f"{self.prefix}/llm/text"
+
+    @property
+    def audio(self) -> str:
+        return f"{self.prefix}/audio"
+
+    @property
+    def metrics(self) -> str:
+        """Compact JSON metrics snapshot (see telemetry/metrics.py)."""
+        return f"{self.prefix}/metrics"
+
+    @property
+    def snapshot_request(self) -> str:
+        return f"{self.prefix}/snapshot/request"
+
+    @property
+    def snapshot_reply(self) -> str:
+        """Prefix for snapshot replies; each requester appends `/<its id>`."""
+        return f"{self.prefix}/snapshot/reply"
+
+
+def all_devices(suffix: str) -> str:
+    """Wildcard filter for `suffix` (e.g. "state/bin") across every device."""
+    return f"{TOPIC_ROOT}/+/{suffix}"
+
+
+def device_from_topic(topic: str) -> str | None:
+    """Device id of a `siggraph/<device_id>/...` topic, or None for other topics."""
+    parts = topic.split("/", 2)
+    if len(parts) < 3 or parts[0] != TOPIC_ROOT or not parts[1] or parts[1].startswith("_"):
+        return None
+    return parts[1]
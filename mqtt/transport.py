@@ -0,0 +1,265 @@
+"""Client transports for `PiMqttApp`: paho over TCP, or an in-process loopback.
+
+`PiMqttApp` only needs the slice of paho's `Client` API it already uses
+(connect / loop_start / loop_stop / disconnect / publish / subscribe and
+the on_connect / on_message / on_disconnect callbacks). A transport is any
+object with `create_client(client_id)` returning such a client.
+
+`PahoTransport` (the default) talks to a real broker. `LoopbackBroker`
+routes between `LoopbackClient`s in the same process: no sockets, no
+serialisation, and the payload object handed to `publish` is the one every
+subscriber receives (treat it as read-only). `str` payloads are encoded to
+bytes once per publish so subscribers see bytes, as with paho.
+
+Single-host consumers (a local UI, a recorder) and tests can therefore run
+the full publish/subscribe path without Mosquitto.
+"""
+
+from __future__ import annotations
+
+import itertools
+import threading
+import time
+from collections import deque
+from typing import Any, Callable, Protocol
+
+try:
+    import paho.mqtt.client as paho
+except ImportError:  # loopback-only deployments and tests
+    paho = None
+
+
+# Return codes, same values as paho's.
+MQTT_ERR_SUCCESS = 0
+MQTT_ERR_NO_CONN = 4
+
+
+class Transport(Protocol):
+    def create_client(self, client_id: str) -> Any:
+        """Return a paho-compatible client."""
+
+
+class PahoTransport:
+    """Clients that connect to a real broker with paho-mqtt."""
+
+    def create_client(self, client_id: str) -> Any:
+        if paho is None:
+            raise ImportError("paho-mqtt is required for broker connections (pip install paho-mqtt)")
+        return paho.Client(client_id=client_id, clean_session=True)
+
+
+def topic_matches(topic_filter: str, topic: str) -> bool:
+    """MQTT filter matching with `+` (one level) and `#` (remaining levels)."""
+    if topic_filter == topic:
+        return True
+    filter_levels = topic_filter.split("/")
+    topic_levels = topic.split("/")
+    for i, level in enumerate(filter_levels):
+        if level == "#":
+            return True
+        if i >= len(topic_levels):
+            return False
+        if level != "+" and level != topic_levels[i]:
+            return False
+    return len(filter_levels) == len(topic_levels)
+
+
+class LoopbackMessage:
+    """Mirrors the attributes of paho's `MQTTMessage` that callbacks read."""
+
+    __slots__ = ("topic", "payload", "qos", "retain", "mid", "timestamp")
+
+    def __init__(self, topic: str, payload: Any, qos: int, retain: bool, mid: int) -> None:
+        self.topic = topic
+        self.payload = payload
+        self.qos = qos
+        self.retain = retain
+        self.mid = mid
+        self.timestamp = time.monotonic()
+
+
+class LoopbackMessageInfo:
+    """Mirrors paho's `MQTTMessageInfo`; loopback publishes complete immediately."""
+
+    __slots__ = ("rc", "mid")
+
+    def __init__(self, rc: int, mid: int) -> None:
+        self.rc = rc
+        self.mid = mid
+
+    def is_published(self) -> bool:
+        return self.rc == MQTT_ERR_SUCCESS
+
+    def wait_for_publish(self, timeout: float | None = None) -> None:
+        return None
+
+
+class LoopbackBroker:
+    """In-process router between `LoopbackClient`s; also a `Transport`.
+
+    The subscription table is copy-on-write: subscribe/unsubscribe build a
+    new tuple under a lock and swap the reference, so `route` (the hot path)
+    reads it without locking.
+    """
+
+    def __init__(self) -> None:
+        self._lock = threading.Lock()
+        self._subscriptions: tuple[tuple[str, "LoopbackClient"], ...] = ()
+        self._retained: dict[str, LoopbackMessage] = {}
+        self._mids = itertools.count(1)
+        self.routed = 0
+
+    def create_client(self, client_id: str) -> "LoopbackClient":
+        return LoopbackClient(self, client_id)
+
+    def subscribe(self, client: "LoopbackClient", topic_filter: str) -> None:
+        with self._lock:
+            if (topic_filter, client) not in self._subscriptions:
+                self._subscriptions += ((topic_filter, client),)
+            retained = [m for t, m in self._retained.items() if topic_matches(topic_filter, t)]
+        for message in retained:
+            client._deliver(message)
+
+    def unsubscribe(self, client: "LoopbackClient", topic_filter: str | None = None) -> None:
+        """Drop `client`'s subscription to `topic_filter`, or all of them if None."""
+        with self._lock:
+            self._subscriptions = tuple(
+                (f, c) for f, c in self._subscriptions
+                if c is not client or (topic_filter is not None and f != topic_filter)
+            )
+
+    def subscriber_count(self, topic: str) -> int:
+        """Number of distinct clients a message on `topic` would reach."""
+        return len({id(c) for f, c in self._subscriptions if topic_matches(f, topic)})
+
+    def route(self, topic: str, payload: Any, qos: int = 0, retain: bool = False) -> int:
+        """Deliver one message to every matching subscriber; return its mid."""
+        if isinstance(payload, str):
+            payload = payload.encode("utf-8")
+        elif payload is None:
+            payload = b""
+        mid = next(self._mids)
+        message = LoopbackMessage(topic, payload, qos, retain, mid)
+        if retain:
+            with self._lock:
+                if payload:
+                    self._retained[topic] = message
+                else:
+                    self._retained.pop(topic, None)  # empty retained payload clears it
+        delivered: set[int] = set()
+        for topic_filter, client in self._subscriptions:
+            # Overlapping filters deliver once per client, like Mosquitto's default.
+            if id(client) not in delivered and topic_matches(topic_filter, topic):
+                delivered.add(id(client))
+                client._deliver(message)
+        self.routed += 1
+        return mid
+
+
+class LoopbackClient:
+    """paho-compatible client attached to a `LoopbackBroker`.
+
+    As with paho, message and connect callbacks run on the client's network thread once
+    `loop_start` has been called, or inside `loop()` when driven manually.
+    Incoming messages queue on an unbounded deque until then.
+    """
+
+    def __init__(self, broker: LoopbackBroker, client_id: str = "") -> None:
+        self.broker = broker
+        self.client_id = client_id
+        self.on_connect: Callable | None = None
+        self.on_message: Callable | None = None
+        self.on_disconnect: Callable | None = None
+        self.on_publish: Callable | None = None
+        self.userdata: Any = None
+
+        self._connected = False
+        self._inbox: deque[LoopbackMessage | None] = deque()  # None = CONNACK event
+        self._ready = threading.Event()
+        self._stop_event = threading.Event()
+        self._thread: threading.Thread | None = None
+
+    # Connection ---------------------------------------------------------
+
+    def connect(self, host: str = "loopback", port: int = 0, keepalive: int = 60) -> int:
+        """Attach to the broker; on_connect fires from the network loop."""
+        self._connected = True
+        self._inbox.append(None)
+        self._ready.set()
+        return MQTT_ERR_SUCCESS
+
+    def disconnect(self) -> int:
+        if not self._connected:
+            return MQTT_ERR_NO_CONN
+        self._connected = False
+        self.broker.unsubscribe(self)
+        if self.on_disconnect is not None:
+            self.on_disconnect(self, self.userdata, 0)
+        return MQTT_ERR_SUCCESS
+
+    def is_connected(self) -> bool:
+        return self._connected
+
+    # Pub/sub ------------------------------------------------------------
+
+    def publish(self, topic: str, payload: Any = None, qos: int = 0, retain: bool = False) -> LoopbackMessageInfo:
+        if not self._connected:
+            return LoopbackMessageInfo(MQTT_ERR_NO_CONN, 0)
+        mid = self.broker.route(topic, payload, qos, retain)
+        # Delivery is complete already; like paho writing inline, on_publish
+        # fires before publish() returns.
+        if self.on_publish is not None:
+            self.on_publish(self, self.userdata, mid)
+        return LoopbackMessageInfo(MQTT_ERR_SUCCESS, mid)
+
+    def subscribe(self, topic: str, qos: int = 0) -> tuple[int, int]:
+        if not self._connected:
+            return MQTT_ERR_NO_CONN, 0
+        self.broker.subscribe(self, topic)
+        return MQTT_ERR_SUCCESS, 0
+
+    def unsubscribe(self, topic: str) -> tuple[int, int]:
+        self.broker.unsubscribe(self, topic)
+        return MQTT_ERR_SUCCESS, 0
+
+    # Network loop -------------------------------------------------------
+
+    def _deliver(self, message: LoopbackMessage) -> None:
+        self._inbox.append(message)
+        self._ready.set()
+
+    def loop(self, timeout: float = 1.0) -> int:
+        """Run pending callbacks on the calling thread (waits up to `timeout` for one)."""
+        if not self._inbox:
+            self._ready.wait(timeout)
+        # Clear before draining so a delivery during the drain re-arms the event.
+        self._ready.clear()
+        while True:
+            try:
+                message = self._inbox.popleft()
+            except IndexError:
+                return MQTT_ERR_SUCCESS
+            if message is None:
+                if self.on_connect is not None:
+                    self.on_connect(self, self.userdata, {}, 0)
+            elif self.on_message is not None:
+                self.on_message(self, self.userdata, message)
+
+    def _run(self) -> None:
+        while not self._stop_event.is_set():
+            self.loop(timeout=0.5)
+
+    def loop_start(self) -> int:
+        if self._thread is None:
+            self._stop_event.clear()
+            self._thread = threading.Thread(target=self._run, name=f"loopback-{self.client_id}", daemon=True)
+            self._thread.start()
+        return MQTT_ERR_SUCCESS
+
+    def loop_stop(self) -> int:
+        self._stop_event.set()
+        self._ready.set()
+        if self._thread is not None and self._thread is not threading.current_thread():
+            self._thread.join(timeout=1.0)
+        self._thread = None
+        return MQTT_ERR_SUCCESS
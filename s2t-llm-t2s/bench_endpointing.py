@@ -0,0 +1,197 @@
+"""End-of-turn detection on a labelled corpus: fixed silence vs. `Endpointer`.
+
+`endpoint_corpus.jsonl` lists utterances as speech parts and pauses:
+
+    {"id": "m-and", "parts": [{"say": "i went to the keynote and", "s": 1.4, "end": "level"},
+                              {"pause": 0.9},
+                              {"say": "it was about neural rendering", "s": 1.5, "end": "fall"}]}
+
+Each part is rendered as a voiced signal (harmonics of a pitch contour with
+syllable-rate amplitude modulation and a noise floor) whose ending follows
+`end`: "fall" (statement: falling pitch, fading energy), "rise" (question),
+"level" (held pitch and energy: a hesitation) or "mid" (cut off mid-phrase).
+The utterance is followed by 2.5 s of silence. The partial transcript at a
+pause is the text of the parts spoken so far, available at once, i.e. a
+streaming recognizer; a slower recognizer only shifts decisions towards
+the acoustic-only policy.
+
+For each policy it reports the mean and p90 endpoint delay (silence waited
+after the last word, for utterances that were not cut) and the premature
+cut rate (the turn ended during a pause inside the utterance).
+
+`--sessions a.tcol ...` also runs the acoustic-only policy over the mic
+utterances of recorded sessions (`main.py --record`); they were captured
+with a 1.8 s pause threshold, so any endpoint before their last speech is
+a premature cut.
+
+Run from this directory:
+    python bench_endpointing.py
+    python bench_endpointing.py --sessions ../show-1.tcol
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import random
+import sys
+from array import array
+from pathlib import Path
+
+from endpointing import Endpointer, EndpointPolicy, FixedPolicy
+
+BASE_DIR = Path(__file__).resolve().parent
+SAMPLE_RATE = 16000
+TRAILING_SILENCE_S = 2.5
+NOISE_RMS = 60.0
+SPEECH_RMS = 3000.0
+ENERGY_THRESHOLD = 300.0
+
+
+def _contour(end: str, u: float) -> tuple[float, float]:
+    """(f0 Hz, gain) at relative position u in [0, 1] of a speech part."""
+    tail = max(0.0, (u - 0.6) / 0.4)  # 0 until the last 40%
+    if end == "fall":
+        return 170.0 - 50.0 * tail, 1.0 - 0.8 * tail
+    if end == "rise":
+        return 150.0 + 60.0 * tail, 1.0 - 0.5 * tail
+    if end == "level":
+        return 150.0, 1.0
+    return 160.0 + 10.0 * math.sin(6.0 * u), 1.0  # "mid"
+
+
+def render(parts: list[dict], rng: random.Random) -> tuple[bytes, list[tuple[float, float]], float]:
+    """PCM, the (start, end) of each speech part, and the end of the last one."""
+    samples = array("h")
+    spans = []
+    t = 0.0
+    phase = 0.0
+    for part in parts:
+        if "pause" in part:
+            n = int(part["pause"] * SAMPLE_RATE)
+            samples.extend(int(rng.gauss(0.0, NOISE_RMS)) for _ in range(n))
+            t += n / SAMPLE_RATE
+            continue
+        n = int(part["s"] * SAMPLE_RATE)
+        attack = int(0.05 * SAMPLE_RATE)
+        for i in range(n):
+            u = i / n
+            f0, gain = _contour(part["end"], u)
+            phase += 2.0 * math.pi * f0 / SAMPLE_RATE
+            syllable = 0.75 + 0.25 * math.sin(2.0 * math.pi * 4.0 * i / SAMPLE_RATE)
+            env = min(1.0, i / attack) * gain * syllable
+            value = math.sin(phase) + 0.5 * math.sin(2 * phase) + 0.3 * math.sin(3 * phase)
+            samples.append(int(max(-32000.0, min(32000.0, SPEECH_RMS * 1.2 * env * value + rng.gauss(0.0, NOISE_RMS)))))
+        spans.append((t, t + n / SAMPLE_RATE))
+        t += n / SAMPLE_RATE
+    n = int(TRAILING_SILENCE_S * SAMPLE_RATE)
+    samples.extend(int(rng.gauss(0.0, NOISE_RMS)) for _ in range(n))
+    return samples.tobytes(), spans, spans[-1][1]
+
+
+def _partial_for(parts: list[dict], spans: list[tuple[float, float]]):
+    texts = [p["say"] for p in parts if "say" in p]
+
+    def partial(audio: bytes) -> str | None:
+        t = len(audio) / 2 / SAMPLE_RATE
+        # The captured audio starts with up to PRE_ROLL_S of silence before the
+        # first word; compare against span ends with that slack.
+        spoken = [text for text, (_, end) in zip(texts, spans) if end <= t + 0.3]
+        return " ".join(spoken) or None
+
+    return partial
+
+
+def evaluate(policy_factory, corpus, use_text: bool, use_acoustics: bool = True) -> dict:
+    delays, cuts = [], 0
+    for item, (pcm, spans, speech_end) in corpus:
+        endpointer = Endpointer(
+            SAMPLE_RATE,
+            energy_threshold=ENERGY_THRESHOLD,
+            policy=policy_factory(),
+            partial=_partial_for(item["parts"], spans) if use_text else None,
+            partial_async=False,
+            use_acoustics=use_acoustics,
+        )
+        step = 1024 * 2  # sr.Microphone's default CHUNK
+        for offset in range(0, len(pcm), step):
+            if endpointer.feed(pcm[offset:offset + step]):
+                break
+        ended_at = endpointer.t if endpointer.ended else len(pcm) / 2 / SAMPLE_RATE
+        if ended_at < speech_end - 1e-6:
+            cuts += 1
+        else:
+            delays.append(ended_at - speech_end)
+    delays.sort()
+    return {
+        "mean": sum(delays) / len(delays) if delays else float("nan"),
+        "p90": delays[min(len(delays) - 1, int(len(delays) * 0.9))] if delays else float("nan"),
+        "cut_rate": cuts / len(corpus),
+        "cuts": cuts,
+    }
+
+
+def load_corpus(path: Path, seed: int) -> list:
+    rng = random.Random(seed)
+    items = [json.loads(line) for line in path.read_text(encoding="utf-8").splitlines() if line.strip()]
+    return [(item, render(item["parts"], rng)) for item in items]
+
+
+def sessions(paths: list[str]) -> None:
+    sys.path.append(str(BASE_DIR.parent))  # `telemetry` lives at the repo root
+    from telemetry.session import SessionLog
+
+    for path in paths:
+        log = SessionLog(path)
+        results = {"fixed 1.8 s": [], "adaptive": []}
+        for event in log.select("mic/utterance"):
+            rate, pcm = event.meta["sample_rate"], event.data
+            if event.meta["sample_width"] != 2:
+                continue
+            probe = Endpointer(rate, energy_threshold=ENERGY_THRESHOLD, policy=FixedPolicy(1e9))
+            probe.feed(pcm)
+            speech_end = probe.last_speech_end
+            if speech_end is None:
+                continue
+            for name, policy in (("fixed 1.8 s", FixedPolicy(1.8)), ("adaptive", EndpointPolicy())):
+                endpointer = Endpointer(rate, energy_threshold=ENERGY_THRESHOLD, policy=policy)
+                endpointer.feed(pcm)
+                end = endpointer.t if endpointer.ended else None
+                results[name].append(None if end is not None and end < speech_end - 1e-6 else
+                                     (end if end is not None else probe.t) - speech_end)
+        for name, values in results.items():
+            ok = [v for v in values if v is not None]
+            if values:
+                print(f"{Path(path).name}: {name:<12} {len(values)} utterances, premature cuts {len(values) - len(ok)}, "
+                      f"mean delay {sum(ok) / max(1, len(ok)) * 1000:.0f} ms (capped by the recorded 1.8 s)")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Measure end-of-turn delay and premature cuts.")
+    parser.add_argument("--corpus", type=Path, default=BASE_DIR / "endpoint_corpus.jsonl")
+    parser.add_argument("--seed", type=int, default=1, help="Noise seed (default: %(default)s).")
+    parser.add_argument("--sessions", nargs="*", default=[], help="Recorded sessions (.tcol) to evaluate as well.")
+    args = parser.parse_args()
+
+    corpus = load_corpus(args.corpus, args.seed)
+    multi = sum(1 for item, _ in corpus if any("pause" in p for p in item["parts"]))
+    print(f"{len(corpus)} utterances ({multi} with pauses inside)")
+    policies = (
+        ("fixed 1.8 s (current)", lambda: FixedPolicy(1.8), False, False),
+        ("fixed 0.8 s", lambda: FixedPolicy(0.8), False, False),
+        ("fixed 0.5 s", lambda: FixedPolicy(0.5), False, False),
+        ("adaptive, acoustic only", EndpointPolicy, False, True),
+        ("adaptive, text only", EndpointPolicy, True, False),
+        ("adaptive, text + acoustic", EndpointPolicy, True, True),
+    )
+    for name, factory, use_text, use_acoustics in policies:
+        r = evaluate(factory, corpus, use_text, use_acoustics)
+        print(f"  {name:<26} delay mean {r['mean'] * 1000:5.0f} ms, p90 {r['p90'] * 1000:5.0f} ms, "
+              f"premature cuts {r['cuts']}/{len(corpus)} ({r['cut_rate']:.0%})")
+    if args.sessions:
+        sessions(args.sessions)
+
+
+if __name__ == "__main__":
+    main()
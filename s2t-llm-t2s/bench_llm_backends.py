@@ -0,0 +1,153 @@
+"""Embedded llama.cpp vs. llama-server over HTTP, same GGUF, same prompts.
+
+Runs a short conversation (system prompt + one user turn each) through
+`EmbeddedLlamaClient` and through `LlamaServerClient` and reports, per
+backend, the time to the first streamed piece (TTFT), the time per
+further piece and the whole reply. The difference between the two is the
+cost of the HTTP path: request setup, server-side queueing, SSE framing
+and JSON encoding/decoding of every token.
+
+The server is either one already running on the same model (`--server-url`)
+or started here (`--llama-server /path/to/llama-server`) with the same
+context size and thread count. Both keep the previous prompt's KV cache,
+so from the second turn on the system prompt is not re-evaluated by either.
+
+Run from this directory (requires llama-cpp-python and `requests`):
+    python bench_llm_backends.py --model ~/models/qwen2.5-0.5b-instruct-q4_k_m.gguf \\
+        --llama-server ~/llama.cpp/build/bin/llama-server --turns 10
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+BASE_DIR = Path(__file__).resolve().parent
+if str(BASE_DIR / "llm-app") not in sys.path:
+    sys.path.insert(0, str(BASE_DIR / "llm-app"))
+
+from app import LlamaServerClient, Message  # type: ignore  # vendored llm-app/app.py
+from embedded import EmbeddedLlamaClient  # type: ignore  # llm-app/embedded.py
+
+PROMPTS = (
+    "Hello, who are you?",
+    "What is SIGGRAPH Asia?",
+    "Tell me a very short joke.",
+    "What is path tracing, in one sentence?",
+    "Can you nod your head?",
+)
+
+
+def _turn(client, prompt: str, history, max_tokens: int) -> tuple[float, float, int]:
+    started = time.perf_counter()
+    first = None
+    pieces = 0
+    for _ in client.chat_stream(prompt=prompt, history=history, max_tokens=max_tokens):
+        if first is None:
+            first = time.perf_counter() - started
+        pieces += 1
+    total = time.perf_counter() - started
+    return first if first is not None else total, total, pieces
+
+
+def _run(name: str, client, args: argparse.Namespace, history) -> list[tuple[float, float, int]]:
+    results = []
+    for i in range(args.turns):
+        prompt = PROMPTS[i % len(PROMPTS)]
+        results.append(_turn(client, prompt, history, args.max_tokens))
+        first, total, pieces = results[-1]
+        print(f"  {name:<8} turn {i + 1:>2}: first {first * 1000:7.1f} ms, reply {total:6.2f} s, {pieces} pieces")
+    return results
+
+
+def _pct(values: list[float], q: float) -> float:
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * q))]
+
+
+def _summary(name: str, results: list[tuple[float, float, int]]) -> dict[str, float]:
+    warm = results[1:] or results  # turn 1 also evaluates the system prompt
+    firsts = [r[0] for r in warm]
+    per_piece = [(total - first) / (pieces - 1) for first, total, pieces in warm if pieces > 1]
+    row = {
+        "cold": results[0][0],
+        "p50": _pct(firsts, 0.5),
+        "p90": _pct(firsts, 0.9),
+        "per_piece": sum(per_piece) / len(per_piece) if per_piece else float("nan"),
+    }
+    print(f"{name:<8} TTFT cold {row['cold'] * 1000:7.1f} ms, warm p50 {row['p50'] * 1000:7.1f} ms, "
+          f"p90 {row['p90'] * 1000:7.1f} ms; {row['per_piece'] * 1000:6.2f} ms per further piece")
+    return row
+
+
+def _start_server(args: argparse.Namespace) -> tuple[subprocess.Popen, str]:
+    import requests
+
+    port = args.port
+    cmd = [args.llama_server, "-m", str(args.model), "--port", str(port), "-c", str(args.ctx),
+           "-t", str(args.threads), "-ngl", "0"]
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    url = f"http://127.0.0.1:{port}"
+    deadline = time.monotonic() + 120
+    while time.monotonic() < deadline:
+        if proc.poll() is not None:
+            raise RuntimeError(f"llama-server exited with {proc.returncode}")
+        try:
+            if requests.get(f"{url}/health", timeout=1).status_code == 200:
+                return proc, url
+        except requests.RequestException:
+            pass
+        time.sleep(0.25)
+    proc.terminate()
+    raise RuntimeError("llama-server did not become ready")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Compare the embedded and HTTP LLM backends.")
+    parser.add_argument("--model", type=Path, required=True, help="GGUF file (both backends load it).")
+    parser.add_argument("--server-url", help="A llama-server already serving --model.")
+    parser.add_argument("--llama-server", help="Start this llama-server binary on --model instead.")
+    parser.add_argument("--port", type=int, default=8099, help="Port for --llama-server (default: %(default)s).")
+    parser.add_argument("--turns", type=int, default=10, help="Turns per backend (default: %(default)s).")
+    parser.add_argument("--max-tokens", type=int, default=64, help="Reply cap (default: %(default)s).")
+    parser.add_argument("--ctx", type=int, default=4096, help="Context size (default: %(default)s).")
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 4, help="CPU threads (default: all).")
+    args = parser.parse_args()
+
+    # The robot's own system prompt, so the cached prefix is realistic.
+    system = json.loads((BASE_DIR / "system_prompt.json").read_text(encoding="utf-8"))
+    history = [Message(role="system", content=system["content"])]
+    started = time.perf_counter()
+    embedded = EmbeddedLlamaClient(str(args.model), n_ctx=args.ctx, n_threads=args.threads)
+    print(f"Embedded model mapped in {time.perf_counter() - started:.2f} s")
+    rows = {"embedded": _summary("embedded", _run("embedded", embedded, args, history))}
+    del embedded  # free the context before the server allocates its own
+
+    proc = None
+    url = args.server_url
+    if url is None and args.llama_server:
+        proc, url = _start_server(args)
+    try:
+        if url:
+            client = LlamaServerClient(base_url=url, timeout=120.0)
+            rows["http"] = _summary("http", _run("http", client, args, history))
+    finally:
+        if proc is not None:
+            proc.terminate()
+            proc.wait()
+
+    if "http" in rows:
+        e, h = rows["embedded"], rows["http"]
+        print(f"HTTP overhead: TTFT p50 {(h['p50'] - e['p50']) * 1000:+.1f} ms, "
+              f"{(h['per_piece'] - e['per_piece']) * 1000:+.2f} ms per piece")
+    else:
+        print("No --server-url or --llama-server: embedded backend only.")
+
+
+if __name__ == "__main__":
+    main()
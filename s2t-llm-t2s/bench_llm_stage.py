@@ -0,0 +1,119 @@
+"""LLM stage latency of the orchestrator against the stand-in server.
+
+Starts `llm-app/stub_server.py` in-process with a latency profile and runs
+the same LLM path as `main.py`: `LlamaServerClient.chat_stream` ->
+`ThinkBlockFilter` -> `TextStreamPublisher` (on a loopback broker). Per
+turn it reports the time to the first streamed chunk, to the first text
+the web UI shows (after any `<think>` block), and to the complete reply,
+plus errors and dropped streams.
+
+Each profile runs twice with the same seed; the second run's timings
+should match the first within scheduler noise (shown as max |delta|).
+
+Run from this directory (requires `requests`):
+    python bench_llm_stage.py --profiles instant gpu pi-cpu flaky --turns 20
+"""
+
+from __future__ import annotations
+
+import argparse
+import sys
+import time
+from pathlib import Path
+
+BASE_DIR = Path(__file__).resolve().parent
+REPO_ROOT = BASE_DIR.parent
+for p in (BASE_DIR / "llm-app",):
+    if str(p) not in sys.path:
+        sys.path.insert(0, str(p))
+# The repo root has `mqtt`; the standalone llm-app has the stub server. Both
+# are appended so the vendored `app` module above keeps precedence.
+for p in (REPO_ROOT, REPO_ROOT / "llm-app"):
+    if str(p) not in sys.path:
+        sys.path.append(str(p))
+
+from app import LlamaServerClient  # type: ignore  # vendored llm-app/app.py
+from mqtt.text_stream import TextStreamPublisher, ThinkBlockFilter
+from mqtt.transport import LoopbackBroker
+from stub_server import PROFILES, StubLlmServer  # type: ignore  # llm-app/stub_server.py
+
+PROMPTS = (
+    "Hello, who are you?",
+    "What is SIGGRAPH Asia?",
+    "Tell me a very short joke.",
+    "Can you nod your head?",
+)
+
+
+def _turn(client: LlamaServerClient, stream: TextStreamPublisher, prompt: str) -> tuple[float, float, float] | str:
+    started = time.perf_counter()
+    first_chunk = first_text = None
+    think_filter = ThinkBlockFilter()
+    stream.begin_turn()
+    try:
+        for chunk in client.chat_stream(prompt=prompt):
+            now = time.perf_counter() - started
+            if first_chunk is None:
+                first_chunk = now
+            visible = think_filter.feed(chunk)
+            if visible and first_text is None:
+                first_text = now
+            stream.append(visible)
+    except Exception as exc:  # noqa: BLE001 - HTTP errors and broken streams both count
+        return type(exc).__name__
+    finally:
+        stream.append(think_filter.flush())
+        stream.end_turn()
+    total = time.perf_counter() - started
+    if first_chunk is None:
+        return "empty"
+    return first_chunk, first_text if first_text is not None else total, total
+
+
+def _run(profile_name: str, args: argparse.Namespace) -> list[tuple[float, float, float] | str]:
+    server = StubLlmServer(port=0, profile=PROFILES[profile_name], seed=args.seed).start()
+    broker = LoopbackBroker()
+    publisher = broker.create_client("bench-llm-stage")
+    publisher.connect()
+    stream = TextStreamPublisher(lambda topic, payload: publisher.publish(topic, payload), topic="siggraph/pi/llm/text")
+    client = LlamaServerClient(base_url=server.url, timeout=30.0)
+    try:
+        return [_turn(client, stream, PROMPTS[i % len(PROMPTS)]) for i in range(args.turns)]
+    finally:
+        stream.close()
+        server.stop()
+
+
+def _pct(values: list[float], q: float) -> float:
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * q))] * 1000.0
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark the orchestrator's LLM stage against the stub server.")
+    parser.add_argument("--profiles", nargs="+", choices=sorted(PROFILES), default=["instant", "gpu", "flaky"])
+    parser.add_argument("--turns", type=int, default=10, help="Turns per run (default: %(default)s).")
+    parser.add_argument("--seed", type=int, default=1, help="Stub RNG seed (default: %(default)s).")
+    args = parser.parse_args()
+
+    for name in args.profiles:
+        first, second = _run(name, args), _run(name, args)
+        ok = [r for r in first if not isinstance(r, str)]
+        failures = [r for r in first if isinstance(r, str)]
+        line = f"{name:<8}: {len(ok)}/{len(first)} ok"
+        if ok:
+            line += "".join(
+                f", {label} p50 {_pct([r[i] for r in ok], 0.5):6.0f} p90 {_pct([r[i] for r in ok], 0.9):6.0f} ms"
+                for i, label in enumerate(("first chunk", "first text", "reply"))
+            )
+        if failures:
+            line += f", failures {sorted(set(failures))}"
+        pairs = [(a, b) for a, b in zip(first, second) if not isinstance(a, str) and not isinstance(b, str)]
+        if pairs:
+            drift = max(abs(x - y) for a, b in pairs for x, y in zip(a, b))
+            line += f", rerun max |delta| {drift * 1000:.1f} ms"
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+"""Time to first token after an eviction, with and without the prefix snapshot.
+
+For each backend, every trial runs one turn in three situations:
+
+- evicted: the KV cache was dropped (`erase_prefix`: a restart or another
+  client's request), so the system prompt is evaluated again;
+- restored: dropped, then the saved system prompt state loaded back
+  (`PrefixSnapshot.prepare`), whose time is reported separately;
+- warm: right after the previous turn, the prefix still cached.
+
+Backends: `--model` runs the embedded one (llama-cpp-python), `--server-url`
+a running llama-server started with `--slot-save-path DIR` on the same or
+another model.
+
+Run from this directory:
+    python bench_prefix_snapshot.py --model ~/models/qwen2.5-0.5b-instruct-q4_k_m.gguf --trials 5
+    python bench_prefix_snapshot.py --server-url http://localhost:8080 --trials 5
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import sys
+import time
+from pathlib import Path
+
+BASE_DIR = Path(__file__).resolve().parent
+if str(BASE_DIR / "llm-app") not in sys.path:
+    sys.path.insert(0, str(BASE_DIR / "llm-app"))
+
+from app import LlamaServerClient, Message  # type: ignore  # vendored llm-app/app.py
+from prefix_snapshot import PrefixSnapshot  # type: ignore  # llm-app/prefix_snapshot.py
+
+PROMPTS = ("Hello, who are you?", "What is SIGGRAPH Asia?", "Tell me a very short joke.")
+
+
+def _first_token(client, prompt: str, history, max_tokens: int) -> float:
+    started = time.perf_counter()
+    for _ in client.chat_stream(prompt=prompt, history=history, max_tokens=max_tokens):
+        break
+    return time.perf_counter() - started
+
+
+def _median(values: list[float]) -> float:
+    values = sorted(values)
+    return values[len(values) // 2]
+
+
+def bench(name: str, client, history, args: argparse.Namespace) -> None:
+    snapshot = PrefixSnapshot(client, history)
+    if not snapshot.prepare():
+        print(f"{name}: snapshot unavailable, skipped")
+        return
+    print(f"{name}: system prompt prefix {snapshot.prefix_tokens} tokens")
+    results: dict[str, list[float]] = {"evicted": [], "restored": [], "warm": [], "restore": []}
+    for i in range(args.trials):
+        prompt = PROMPTS[i % len(PROMPTS)]
+        client.erase_prefix()
+        results["evicted"].append(_first_token(client, prompt, history, args.max_tokens))
+        client.erase_prefix()
+        started = time.perf_counter()
+        snapshot.prepare()
+        results["restore"].append(time.perf_counter() - started)
+        results["restored"].append(_first_token(client, prompt, history, args.max_tokens))
+        results["warm"].append(_first_token(client, prompt, history, args.max_tokens))
+    print(f"  TTFT evicted  {_median(results['evicted']) * 1000:8.1f} ms")
+    print(f"  TTFT restored {_median(results['restored']) * 1000:8.1f} ms "
+          f"(+ {_median(results['restore']) * 1000:.1f} ms restore, overlapping STT in main.py)")
+    print(f"  TTFT warm     {_median(results['warm']) * 1000:8.1f} ms")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Measure TTFT with and without the system prompt snapshot.")
+    parser.add_argument("--model", type=Path, help="GGUF file for the embedded backend.")
+    parser.add_argument("--server-url", help="llama-server started with --slot-save-path.")
+    parser.add_argument("--trials", type=int, default=5, help="Trials per backend (default: %(default)s).")
+    parser.add_argument("--max-tokens", type=int, default=8, help="Reply cap (default: %(default)s).")
+    args = parser.parse_args()
+    if not args.model and not args.server_url:
+        parser.error("give --model and/or --server-url")
+
+    system = json.loads((BASE_DIR / "system_prompt.json").read_text(encoding="utf-8"))
+    history = [Message(role="system", content=system["content"])]
+    if args.model:
+        from embedded import EmbeddedLlamaClient  # type: ignore  # llm-app/embedded.py
+
+        bench("embedded", EmbeddedLlamaClient(str(args.model)), history, args)
+    if args.server_url:
+        bench("llama-server", LlamaServerClient(base_url=args.server_url, timeout=120.0), history, args)
+
+
+if __name__ == "__main__":
+    main()
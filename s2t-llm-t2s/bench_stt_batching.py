@@ -0,0 +1,118 @@
+"""STT throughput and latency, one utterance at a time vs dynamically batched.
+
+Feeds the pipeline server's STT stage directly (no sockets, no endpointing):
+utterances from `endpoint_corpus.jsonl` (trailing silence trimmed, as the
+server's endpointer hands them over) arrive as a Poisson process at each
+rate in `--rates`, each from one of `--sessions` robots, for `--seconds`.
+For each arrival rate and each batching setting it reports:
+
+- throughput: utterances transcribed per second of wall time
+- latency p50 / p95: submit to transcript, queueing included
+- mean batch size
+
+`--batch 1` is the sequential baseline; larger values are the `--stt-batch`
+of `pipeline_server.py`. Without `--whisper-model` the simulated STT
+(`SimCosts`) is used, whose batched pass costs the longest utterance plus
+`stt_batch_marginal` of it per extra row.
+
+Run from this directory:
+    python bench_stt_batching.py --rates 1 2 4 6 8 12 --batch 1 4 8
+    python bench_stt_batching.py --whisper-model base.en --rates 1 2 4 --seconds 60
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import threading
+import time
+from concurrent.futures import Future
+from pathlib import Path
+
+from bench_endpointing import SAMPLE_RATE, load_corpus
+from pipeline_server import BatchConfig, SimCosts, SimStt, WhisperStt, _ServerMetrics, stt_stage
+from telemetry.metrics import Registry
+
+
+def corpus_utterances(seed: int = 1) -> list[bytes]:
+    """The endpointing corpus as PCM, cut 0.3 s after the last word."""
+    corpus = load_corpus(Path(__file__).resolve().parent / "endpoint_corpus.jsonl", seed)
+    return [pcm[: int((speech_end + 0.3) * SAMPLE_RATE) * 2] for _, (pcm, _, speech_end) in corpus]
+
+
+def _pct(values: list[float], q: float) -> float:
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * q))] if ordered else float("nan")
+
+
+def run(engine, config: BatchConfig, rate: float, utterances: list[bytes], args: argparse.Namespace) -> dict:
+    metrics = _ServerMetrics(Registry())
+    stage = stt_stage([engine], metrics, config)
+    rng = random.Random(args.seed)
+    latencies: list[float] = []
+    lock = threading.Lock()
+    pending: list[Future] = []
+
+    def done(submitted: float, future: Future) -> None:
+        future.result()
+        with lock:
+            latencies.append(time.perf_counter() - submitted)
+
+    started = time.perf_counter()
+    due = started
+    n = 0
+    while (due := due + rng.expovariate(rate)) < started + args.seconds:
+        time.sleep(max(0.0, due - time.perf_counter()))
+        future = stage.submit(f"robot-{n % args.sessions}", (rng.choice(utterances), SAMPLE_RATE))
+        submitted = time.perf_counter()
+        future.add_done_callback(lambda f, t=submitted: done(t, f))
+        pending.append(future)
+        n += 1
+    for future in pending:
+        future.result()
+    while len(latencies) < len(pending):  # callbacks run just after result() wakes us
+        time.sleep(0.001)
+    elapsed = time.perf_counter() - started
+    stage.close()
+
+    counts, items = metrics.batch_size.labels("stt").get()  # per-bucket counts: one per batch
+    batches = sum(counts)
+    return {
+        "rate": rate,
+        "done": len(latencies),
+        "throughput": len(latencies) / elapsed,
+        "p50": _pct(latencies, 0.5),
+        "p95": _pct(latencies, 0.95),
+        "batch": items / batches if batches else 0.0,
+    }
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Sequential vs dynamically batched STT under Poisson arrivals.")
+    parser.add_argument("--rates", type=float, nargs="+", default=[1, 2, 4, 6, 8, 12],
+                        help="Utterances per second to offer (default: %(default)s).")
+    parser.add_argument("--batch", type=int, nargs="+", default=[1, 4, 8],
+                        help="Max batch sizes to compare, 1 = sequential (default: %(default)s).")
+    parser.add_argument("--wait-ms", type=float, default=50.0, help="Max batch wait (default: %(default)s).")
+    parser.add_argument("--max-padding", type=float, default=0.5, help="Padding allowed per batch (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=20.0, help="Arrival window per run (default: %(default)s).")
+    parser.add_argument("--sessions", type=int, default=16, help="Robots the arrivals come from (default: %(default)s).")
+    parser.add_argument("--whisper-model", help="Real Whisper model instead of the simulated STT.")
+    parser.add_argument("--seed", type=int, default=1, help="Random seed (default: %(default)s).")
+    args = parser.parse_args()
+
+    utterances = corpus_utterances(args.seed)
+    print(f"{len(utterances)} utterances, {sum(map(len, utterances)) / 2 / SAMPLE_RATE / len(utterances):.1f} s "
+          f"on average; {args.seconds:.0f} s of arrivals per run")
+    engine = WhisperStt(args.whisper_model) if args.whisper_model else SimStt(SimCosts())
+    for rate in args.rates:
+        for max_batch in args.batch:
+            config = BatchConfig(max_batch, args.wait_ms / 1000.0 if max_batch > 1 else 0.0, args.max_padding)
+            r = run(engine, config, rate, utterances, args)
+            label = "sequential" if max_batch == 1 else f"batch <= {max_batch}"
+            print(f"{rate:5.1f}/s {label:>11}: {r['throughput']:5.2f}/s done, latency p50 {r['p50'] * 1000:6.0f} ms "
+                  f"p95 {r['p95'] * 1000:6.0f} ms, mean batch {r['batch']:4.1f}")
+
+
+if __name__ == "__main__":
+    main()
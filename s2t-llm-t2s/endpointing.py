@@ -0,0 +1,375 @@
+"""Adaptive end-of-turn detection for microphone capture.
+
+`speech_recognition`'s `listen()` ends an utterance after a fixed
+`pause_threshold` of silence (1.8 s in `main.py`), so every turn waits
+that long after the user has finished, and a shorter value cuts people off
+when they pause mid-sentence. `Endpointer` instead picks the wait for each
+pause, between `min_wait` (0.3 s) and `max_wait` (2 s), from:
+
+- the partial transcript of the audio so far, when a recognizer is given:
+  a sentence ending in "and", "the", "to", "um" ... is not finished
+  (wait long); a finished question is (wait least); anything else that
+  looks finished waits a little longer than a question;
+- the final pitch movement of the last speech: a falling contour marks a
+  statement's end, a level held pitch with sustained energy is a
+  hesitation ("uhhh");
+- the final energy movement: speech that fades out has ended, speech that
+  stops abruptly at full level often has not.
+
+The partial transcript is requested once per pause, as soon as the pause
+reaches `min_wait`, in a background thread; until it arrives the decision
+uses the acoustic cues alone. If the pause then becomes the endpoint, the
+partial transcript is the transcript of the whole utterance and the caller
+can skip a second recognition (`Endpointer.transcript`).
+
+Voice activity is an energy threshold (use the recognizer's calibrated
+`energy_threshold`); pitch is estimated by autocorrelation only at the
+start of a pause, on the last 0.4 s of speech, so the per-frame cost is
+one RMS.
+
+`bench_endpointing.py` measures endpoint delay and premature cuts on a
+labelled corpus for this model and for fixed thresholds.
+"""
+
+from __future__ import annotations
+
+import math
+import re
+import threading
+from array import array
+from collections import deque
+from dataclasses import dataclass
+from typing import Callable
+
+DEFAULT_MIN_WAIT_S = 0.3
+DEFAULT_MAX_WAIT_S = 2.0
+DEFAULT_FRAME_S = 0.03
+PHRASE_LIMIT_S = 20.0
+PRE_ROLL_S = 0.3  # silence kept before the first speech frame
+
+# Waits (seconds) before acoustic adjustment.
+WAIT_NO_TEXT = 0.8
+WAIT_INCOMPLETE = 1.8
+WAIT_COMPLETE = 0.5
+WAIT_QUESTION = 0.35
+
+# Words after which an English sentence is almost never finished.
+INCOMPLETE_ENDINGS = frozenset(
+    "and or but so because if then than that which who whose the a an my your his her their our its "
+    "this these those to of in on at for with from about into onto like as is are was were am be been "
+    "can could would should will shall do does did have has had i we they he she um uh er erm hmm "
+    "well also just maybe really very plus".split()
+)
+QUESTION_WORDS = frozenset(
+    "what whats who whos where wheres when why how which whose can could would will do does did is are "
+    "was were should shall may might have has isnt arent dont doesnt didnt wont cant".split()
+)
+LEADING_FILLERS = frozenset("hey hi ok okay so and well um uh robot lafufu please".split())
+
+
+@dataclass(frozen=True)
+class TextCues:
+    complete: bool
+    question: bool
+
+
+def text_cues(text: str) -> TextCues:
+    """Whether a (partial) transcript reads as finished, and as a question."""
+    words = re.sub(r"[^a-z0-9?\s]", "", text.lower().replace("'", "")).split()
+    if not words:
+        return TextCues(complete=False, question=False)
+    last = words[-1].rstrip("?")
+    complete = last not in INCOMPLETE_ENDINGS
+    content = [w for w in words if w not in LEADING_FILLERS] or words
+    question = complete and (words[-1].endswith("?") or content[0].rstrip("?") in QUESTION_WORDS)
+    return TextCues(complete=complete, question=question)
+
+
+@dataclass(frozen=True)
+class EndpointDecision:
+    wait_s: float
+    reason: str
+    partial: str | None = None
+    pitch_slope: float | None = None  # semitones per second over the final speech
+    energy_slope: float | None = None  # dB per second over the final speech
+
+
+class EndpointPolicy:
+    """Maps the cues of one pause to how long to wait before ending the turn."""
+
+    def __init__(self, min_wait: float = DEFAULT_MIN_WAIT_S, max_wait: float = DEFAULT_MAX_WAIT_S) -> None:
+        self.min_wait = min_wait
+        self.max_wait = max_wait
+
+    def decide(self, partial: str | None, pitch_slope: float | None, energy_slope: float | None) -> EndpointDecision:
+        reasons = []
+        if partial is None:
+            wait = WAIT_NO_TEXT
+            reasons.append("no text")
+        else:
+            cues = text_cues(partial)
+            if not cues.complete:
+                wait = WAIT_INCOMPLETE
+                reasons.append("incomplete")
+            elif cues.question:
+                wait = WAIT_QUESTION
+                reasons.append("question")
+            else:
+                wait = WAIT_COMPLETE
+                reasons.append("complete")
+
+        if pitch_slope is not None:
+            if pitch_slope < -3.0:
+                wait -= 0.2
+                reasons.append("falling pitch")
+            elif abs(pitch_slope) < 1.5 and energy_slope is not None and energy_slope > -10.0:
+                wait += 0.4
+                reasons.append("held pitch")
+        if energy_slope is not None:
+            if energy_slope < -25.0:
+                wait -= 0.1
+                reasons.append("fade out")
+            elif energy_slope > -5.0:
+                wait += 0.2
+                reasons.append("abrupt stop")
+
+        wait = min(self.max_wait, max(self.min_wait, wait))
+        return EndpointDecision(round(wait, 3), ", ".join(reasons), partial, pitch_slope, energy_slope)
+
+
+class FixedPolicy(EndpointPolicy):
+    """The old behaviour: the same silence for every pause (for comparison)."""
+
+    def __init__(self, wait: float) -> None:
+        super().__init__(wait, wait)
+        self.wait = wait
+
+    def decide(self, partial, pitch_slope, energy_slope) -> EndpointDecision:
+        return EndpointDecision(self.wait, "fixed", partial, pitch_slope, energy_slope)
+
+
+class Endpointer:
+    """Feed microphone PCM (16-bit mono); `feed` returns True at the end of the turn."""
+
+    def __init__(
+        self,
+        sample_rate: int,
+        energy_threshold: float = 300.0,
+        policy: EndpointPolicy | None = None,
+        partial: Callable[[bytes], str | None] | None = None,
+        partial_async: bool = True,
+        frame_s: float = DEFAULT_FRAME_S,
+        phrase_limit_s: float = PHRASE_LIMIT_S,
+        use_acoustics: bool = True,
+    ) -> None:
+        self.sample_rate = sample_rate
+        self.energy_threshold = energy_threshold
+        self.policy = policy or EndpointPolicy()
+        self.partial = partial
+        self.partial_async = partial_async
+        self.use_acoustics = use_acoustics
+        self.frame_bytes = int(sample_rate * frame_s) * 2
+        self.frame_s = self.frame_bytes / 2 / sample_rate
+        self.phrase_limit_s = phrase_limit_s
+
+        self._pending = b""
+        self._audio = bytearray()
+        self._pre_roll: deque[bytes] = deque(maxlen=max(1, round(PRE_ROLL_S / self.frame_s)))
+        self._recent_speech: deque[tuple[bytes, float]] = deque(maxlen=max(1, round(0.4 / self.frame_s)))
+        self.t = 0.0  # seconds of audio fed
+        self.speech_started: float | None = None
+        self.last_speech_end: float | None = None
+        self.silence_s = 0.0
+        self.ended = False
+        self.decision: EndpointDecision | None = None
+        self.decisions: list[EndpointDecision] = []  # one per pause, for analysis
+        self._pause = 0  # generation: bumped when speech resumes
+        self._partial_text: str | None = None
+        self._partial_pause = -1
+        self._lock = threading.Lock()
+
+    # Feeding ---------------------------------------------------------------
+
+    def feed(self, pcm: bytes) -> bool:
+        if self.ended:
+            return True
+        data = self._pending + pcm
+        n = self.frame_bytes
+        offset = 0
+        while offset + n <= len(data):
+            if self._frame(data[offset:offset + n]):
+                self._pending = b""
+                return True
+            offset += n
+        self._pending = data[offset:]
+        return False
+
+    def _frame(self, frame: bytes) -> bool:
+        self.t += self.frame_s
+        rms = _rms(frame)
+        voiced = rms > self.energy_threshold
+
+        if self.speech_started is None:
+            self._pre_roll.append(frame)
+            if not voiced:
+                return False
+            self.speech_started = self.t - self.frame_s
+            for f in self._pre_roll:
+                self._audio += f
+            self._pre_roll.clear()
+        else:
+            self._audio += frame
+
+        if voiced:
+            if self.silence_s:
+                self._pause += 1  # speech resumed: the pending decision no longer applies
+                self.decision = None
+            self.silence_s = 0.0
+            self.last_speech_end = self.t
+            self._recent_speech.append((frame, rms))
+        else:
+            self.silence_s += self.frame_s
+            if self.silence_s >= self.policy.min_wait - 1e-9:
+                if self.decision is None or self._decision_stale():
+                    self._decide()
+                if self.silence_s >= self.decision.wait_s - 1e-9:
+                    return self._end(self.decision)
+
+        if self.t - self.speech_started >= self.phrase_limit_s:
+            return self._end(EndpointDecision(0.0, "phrase limit"))
+        return False
+
+    def _decision_stale(self) -> bool:
+        # A partial transcript arrived after the acoustic-only decision.
+        with self._lock:
+            return self.decision.partial is None and self._partial_pause == self._pause
+
+    def _decide(self) -> None:
+        if self.decision is None:
+            self._request_partial()
+            pitch, energy = self._acoustic_cues() if self.use_acoustics else (None, None)
+        else:
+            pitch, energy = self.decision.pitch_slope, self.decision.energy_slope
+        with self._lock:
+            partial = self._partial_text if self._partial_pause == self._pause else None
+        self.decision = self.policy.decide(partial, pitch, energy)
+        self.decisions.append(self.decision)
+
+    def _request_partial(self) -> None:
+        if self.partial is None:
+            return
+        pause = self._pause
+        audio = bytes(self._audio)
+
+        def run() -> None:
+            try:
+                text = self.partial(audio)
+            except Exception:  # noqa: BLE001 - no partial: decide on acoustics
+                text = None
+            if text is None:
+                return
+            with self._lock:
+                if pause == self._pause:
+                    self._partial_text, self._partial_pause = text, pause
+
+        if self.partial_async:
+            threading.Thread(target=run, name="endpoint-partial", daemon=True).start()
+        else:
+            run()
+
+    def _end(self, decision: EndpointDecision) -> bool:
+        self.decision = decision
+        self.ended = True
+        return True
+
+    # Results ---------------------------------------------------------------
+
+    @property
+    def audio(self) -> bytes:
+        """Captured PCM from just before the first speech to the endpoint."""
+        return bytes(self._audio)
+
+    @property
+    def endpoint_delay(self) -> float | None:
+        """Silence waited after the last speech (what the user experiences)."""
+        if not self.ended or self.last_speech_end is None:
+            return None
+        return self.t - self.last_speech_end
+
+    @property
+    def transcript(self) -> str | None:
+        """The partial transcript if it covers all of the captured speech."""
+        if not self.ended or self.decision is None:
+            return None
+        with self._lock:
+            return self._partial_text if self._partial_pause == self._pause else None
+
+    # Acoustic cues -----------------------------------------------------------
+
+    def _acoustic_cues(self) -> tuple[float | None, float | None]:
+        frames = list(self._recent_speech)
+        if len(frames) < 4:
+            return None, None
+        step = self.frame_s
+        energy = [(i * step, 20.0 * math.log10(max(rms, 1.0))) for i, (_, rms) in enumerate(frames)]
+        pitches = []
+        for i, (frame, _) in enumerate(frames):
+            f0 = estimate_pitch(frame, self.sample_rate)
+            if f0 is not None:
+                pitches.append((i * step, 12.0 * math.log2(f0 / 100.0)))
+        pitch_slope = _slope(pitches) if len(pitches) >= 4 else None
+        return pitch_slope, _slope(energy)
+
+
+def _rms(frame: bytes) -> float:
+    samples = array("h", frame)
+    if not samples:
+        return 0.0
+    return math.sqrt(sum(s * s for s in samples) / len(samples))
+
+
+def _slope(points: list[tuple[float, float]]) -> float | None:
+    n = len(points)
+    if n < 2:
+        return None
+    mx = sum(x for x, _ in points) / n
+    my = sum(y for _, y in points) / n
+    var = sum((x - mx) ** 2 for x, _ in points)
+    if var == 0:
+        return None
+    return sum((x - mx) * (y - my) for x, y in points) / var
+
+
+def estimate_pitch(frame: bytes, sample_rate: int, fmin: float = 70.0, fmax: float = 400.0) -> float | None:
+    """F0 of a voiced frame by autocorrelation on a 4 kHz copy; None if unvoiced."""
+    samples = array("h", frame)
+    decimate = max(1, sample_rate // 4000)
+    x = [sum(samples[i:i + decimate]) / decimate for i in range(0, len(samples) - decimate + 1, decimate)]
+    rate = sample_rate / decimate
+    mean = sum(x) / len(x) if x else 0.0
+    x = [v - mean for v in x]
+    energy = sum(v * v for v in x)
+    if energy <= 0:
+        return None
+    lo, hi = int(rate / fmax), min(int(rate / fmin), len(x) - 1)
+    best_lag, best = 0, 0.0
+    for lag in range(lo, hi + 1):
+        r = sum(x[i] * x[i + lag] for i in range(len(x) - lag)) / energy
+        if r > best:
+            best_lag, best = lag, r
+    if best < 0.3 or best_lag == 0:
+        return None
+    return rate / best_lag
+
+
+__all__ = [
+    "DEFAULT_MAX_WAIT_S",
+    "DEFAULT_MIN_WAIT_S",
+    "EndpointDecision",
+    "EndpointPolicy",
+    "Endpointer",
+    "FixedPolicy",
+    "TextCues",
+    "estimate_pitch",
+    "text_cues",
+]
@@ -100,6 +100,136 @@ class OllamaClient:
             "nothink": True,
         }
         return payload
+
+
+class LlamaServerClient:
+    """Minimal client for llama.cpp's `llama-server` OpenAI-compatible API.
+
+    Streams `/v1/chat/completions` server-sent events and yields the content
+    deltas, matching `OllamaClient.chat_stream`.
+
+    Requests go to slot `slot`; the `*_prefix` methods save and restore
+    that slot's KV cache, which needs the server started with
+    `--slot-save-path DIR` (files are named relative to DIR).
+    """
+
+    def __init__(
+        self,
+        base_url: str = "http://localhost:8080",
+        model: str = "default",
+        timeout: float = 300.0,
+        slot: int = 0,
+    ) -> None:
+        self.base_url = base_url.rstrip("/")
+        self.model = model
+        self.timeout = timeout
+        self.slot = slot
+        # The server's `timings` for the last streamed reply (prompt_n, cache_n, ...).
+        self.last_timings: dict = {}
+
+    def chat_stream(
+        self,
+        prompt: str,
+        history: list[Message] | None = None,
+        max_tokens: int | None = None,
+        timeout: float | None = None,
+    ):
+        """Yield the reply's content deltas.
+
+        `max_tokens` caps the reply length; `timeout` (seconds) bounds the
+        wait for the response and for each streamed chunk, so a stalled
+        server raises `requests.Timeout` instead of hanging the turn.
+        """
+        messages_payload: list[dict[str, str]] = []
+        if history:
+            for m in history:
+                messages_payload.append({"role": m.role, "content": m.content})
+        messages_payload.append({"role": "user", "content": prompt})
+
+        payload = {
+            "model": self.model,
+            "messages": messages_payload,
+            "stream": True,
+            "id_slot": self.slot,
+            "cache_prompt": True,
+        }
+        if max_tokens is not None:
+            payload["max_tokens"] = max_tokens
+
+        timeout = self.timeout if timeout is None else timeout
+        self.last_timings = {}
+        with requests.post(f"{self.base_url}/v1/chat/completions", json=payload, stream=True, timeout=timeout) as r:
+            r.raise_for_status()
+
+            for line in r.iter_lines(decode_unicode=True):
+                if not line or not line.startswith("data:"):
+                    continue
+                data = line[len("data:"):].strip()
+                if data == "[DONE]":
+                    break
+                try:
+                    json_chunk = json.loads(data)
+                except json.JSONDecodeError:
+                    continue
+
+                if "timings" in json_chunk:
+                    self.last_timings = json_chunk["timings"]
+                choices = json_chunk.get("choices") or []
+                if not choices:
+                    continue
+                content = (choices[0].get("delta") or {}).get("content")
+                if content:
+                    yield content
+
+    @property
+    def cached_tokens(self) -> int | None:
+        """Prompt tokens of the last reply served from the KV cache, if reported."""
+        return self.last_timings.get("cache_n")
+
+    def model_id(self) -> str:
+        """The served model file (from `/props`), or the model name."""
+        try:
+            r = requests.get(f"{self.base_url}/props", timeout=5)
+            r.raise_for_status()
+            props = r.json()
+        except (requests.RequestException, ValueError):
+            return self.model
+        return props.get("model_path") or props.get("default_generation_settings", {}).get("model") or self.model
+
+    def save_prefix(self, history: list[Message], name: str) -> int:
+        """Evaluate `history` in the slot and save its KV cache as `name`.
+
+        Returns the number of tokens saved.
+        """
+        payload = {
+            "model": self.model,
+            "messages": [{"role": m.role, "content": m.content} for m in history] + [{"role": "user", "content": ""}],
+            "max_tokens": 1,
+            "id_slot": self.slot,
+            "cache_prompt": True,
+        }
+        r = requests.post(f"{self.base_url}/v1/chat/completions", json=payload, timeout=self.timeout)
+        r.raise_for_status()
+        return self._slot_action("save", name).get("n_saved", 0)
+
+    def restore_prefix(self, name: str) -> int | None:
+        """Load the KV cache saved as `name` into the slot; None if there is none."""
+        try:
+            return self._slot_action("restore", name).get("n_restored", 0)
+        except requests.HTTPError:
+            return None  # no such file (or slot saving is disabled)
+
+    def erase_prefix(self) -> None:
+        """Drop the slot's KV cache (simulates an eviction in benchmarks)."""
+        self._slot_action("erase")
+
+    def _slot_action(self, action: str, name: str | None = None) -> dict:
+        body = {"filename": name} if name is not None else {}
+        r = requests.post(f"{self.base_url}/slots/{self.slot}?action={action}", json=body, timeout=self.timeout)
+        r.raise_for_status()
+        return r.json()
+
+
 def load_history_from_json(path: str) -> List[Message]:
     """Load conversation history from a JSON file.
 
@@ -0,0 +1,296 @@
+"""In-process LLM backend: llama.cpp through llama-cpp-python.
+
+`EmbeddedLlamaClient.chat_stream` has the same signature as
+`LlamaServerClient.chat_stream`, but runs the model inside this process:
+
+- the GGUF file is memory-mapped (`use_mmap=True`), so loading costs page
+  faults rather than a copy, and the pages are shared with any other
+  process mapping the same file;
+- one `Llama` context lives for the client's lifetime, and llama-cpp-python
+  keeps the KV cache of the previous prompt: the system prompt and any
+  shared history are not evaluated again on the next turn;
+- each sampled token is detokenized and handed to the caller directly
+  (a generator, or `chat(..., on_token=...)`), with no HTTP, SSE or JSON
+  in between.
+
+The `*_prefix` methods save the KV state of a prompt prefix to a file in
+`state_dir` and load it back, so a restarted process does not evaluate the
+system prompt again (`prefix_snapshot.py`).
+
+CPU only (`n_gpu_layers=0`); any GGUF works, including the tiny test
+models used in CI (see `tests/test_embedded.py`).
+
+Requires `pip install llama-cpp-python`.
+"""
+
+from __future__ import annotations
+
+import codecs
+import ctypes
+import os
+import threading
+import time
+from contextlib import contextmanager
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable, Iterator
+
+try:
+    import llama_cpp
+    from llama_cpp import Llama
+except ImportError:  # optional: only needed when LLM_MODEL_PATH is set
+    llama_cpp = None
+    Llama = None
+
+try:
+    from llama_cpp.llama_chat_format import Jinja2ChatFormatter
+except ImportError:
+    Jinja2ChatFormatter = None
+
+DEFAULT_STATE_DIR = Path(os.environ.get("LLM_STATE_DIR", Path.home() / ".cache" / "robot-llm"))
+
+# Used when the GGUF has no chat template (e.g. base or test models).
+CHATML_STOP = "<|im_end|>"
+
+
+def _chatml(messages: list[dict[str, str]]) -> str:
+    parts = [f"<|im_start|>{m['role']}\n{m['content']}{CHATML_STOP}\n" for m in messages]
+    return "".join(parts) + "<|im_start|>assistant\n"
+
+
+@dataclass
+class EmbeddedStats:
+    """Counters of the last reply, for benchmarks and logs."""
+
+    prompt_tokens: int = 0
+    reused_tokens: int = 0  # prompt prefix still in the KV cache from the previous turn
+    reply_tokens: int = 0
+    first_token_s: float | None = None
+    seconds: float = 0.0
+
+
+class EmbeddedLlamaClient:
+    """Runs a GGUF model in-process and streams the reply token by token."""
+
+    def __init__(
+        self,
+        model_path: str,
+        n_ctx: int = 4096,
+        n_threads: int | None = None,
+        max_tokens: int = 512,
+        temperature: float = 0.7,
+        top_p: float = 0.95,
+        top_k: int = 40,
+        seed: int = 0,
+        state_dir: str | Path = DEFAULT_STATE_DIR,
+    ) -> None:
+        if Llama is None:
+            raise ImportError("the embedded backend needs llama-cpp-python (pip install llama-cpp-python)")
+        self.llm = Llama(
+            model_path=str(model_path),
+            n_ctx=n_ctx,
+            n_threads=n_threads,
+            n_gpu_layers=0,
+            use_mmap=True,
+            use_mlock=False,
+            seed=seed,
+            verbose=False,
+        )
+        self.model_path = Path(model_path)
+        self.state_dir = Path(state_dir)
+        self.n_ctx = n_ctx
+        self.max_tokens = max_tokens
+        self.sampling = {"temp": temperature, "top_p": top_p, "top_k": top_k}
+        self.stats = EmbeddedStats()
+        self._eos = self.llm.token_eos()
+        self._formatter = self._chat_formatter()
+        # One context. The lock is held per step (prefill, each token, a
+        # snapshot call), never across a yield, so a caller that stops
+        # reading cannot block the others. `_epoch` counts the users of the
+        # context: a reply whose KV state someone else replaced ends there.
+        self._lock = threading.Lock()
+        self._epoch = 0
+
+    def _chat_formatter(self):
+        template = (getattr(self.llm, "metadata", None) or {}).get("tokenizer.chat_template")
+        if not template or Jinja2ChatFormatter is None:
+            return None
+
+        def piece(token: int) -> str:
+            return self.llm.detokenize([token], special=True).decode("utf-8", errors="ignore") if token >= 0 else ""
+
+        return Jinja2ChatFormatter(template=template, eos_token=piece(self._eos), bos_token=piece(self.llm.token_bos()))
+
+    def _prompt(self, messages: list[dict[str, str]]) -> tuple[list[int], list[str]]:
+        """Prompt tokens and the stop strings of the model's chat format."""
+        if self._formatter is None:
+            text, stops, add_bos = _chatml(messages), [CHATML_STOP], True
+        else:
+            result = self._formatter(messages=messages)
+            text = result.prompt
+            stops = result.stop if isinstance(result.stop, list) else [result.stop] if result.stop else []
+            add_bos = not getattr(result, "added_special", False)
+        tokens = self.llm.tokenize(text.encode("utf-8"), add_bos=add_bos, special=True)
+        return tokens, [s for s in stops if s]
+
+    def chat_stream(
+        self,
+        prompt: str,
+        history: list | None = None,
+        max_tokens: int | None = None,
+        timeout: float | None = None,
+    ) -> Iterator[str]:
+        """Yield the reply as text pieces, one per sampled token.
+
+        `max_tokens` caps the reply length. `timeout` (seconds) bounds the
+        whole reply, including waiting for the model: an in-process model
+        does not stall, but on a slow CPU generation stops at the deadline
+        and keeps what was produced. A deadline that passes before prefill
+        starts yields nothing.
+        """
+        messages = [{"role": m.role, "content": m.content} for m in history or ()]
+        messages.append({"role": "user", "content": prompt})
+        deadline = None if timeout is None else time.perf_counter() + timeout
+        return self._generate(messages, max_tokens or self.max_tokens, deadline)
+
+    def chat(
+        self,
+        prompt: str,
+        history: list | None = None,
+        on_token: Callable[[str], None] | None = None,
+        max_tokens: int | None = None,
+    ) -> str:
+        """Generate a whole reply, calling `on_token` with each piece."""
+        pieces = []
+        for piece in self.chat_stream(prompt, history=history, max_tokens=max_tokens):
+            if on_token is not None:
+                on_token(piece)
+            pieces.append(piece)
+        return "".join(pieces)
+
+    @property
+    def cached_tokens(self) -> int:
+        """Prompt tokens of the last reply that were already in the KV cache."""
+        return self.stats.reused_tokens
+
+    def model_id(self) -> str:
+        stat = self.model_path.stat()
+        return f"{self.model_path.name}:{stat.st_size}:{int(stat.st_mtime)}"
+
+    def save_prefix(self, history: list, name: str) -> int:
+        """Evaluate the prompt prefix `history` produces and save its KV state as `name`.
+
+        The prefix is what every prompt starting with `history` shares: the
+        tokens up to where the user's message begins. Returns its length.
+        """
+        def prompt_for(text: str) -> list[int]:
+            return self._prompt([{"role": m.role, "content": m.content} for m in history]
+                                + [{"role": "user", "content": text}])[0]
+
+        prefix = []
+        for a, b in zip(prompt_for("a"), prompt_for("b")):
+            if a != b:
+                break
+            prefix.append(a)
+        self.state_dir.mkdir(parents=True, exist_ok=True)
+        with self._context():
+            self.llm.reset()
+            self.llm.eval(prefix)
+            array = (llama_cpp.llama_token * len(prefix))(*prefix)
+            if not llama_cpp.llama_state_save_file(self.llm.ctx, str(self.state_dir / name).encode(), array, len(prefix)):
+                raise OSError(f"could not save the KV state to {self.state_dir / name}")
+        return len(prefix)
+
+    def restore_prefix(self, name: str) -> int | None:
+        """Load the KV state saved as `name`; None if there is none (or it does not fit)."""
+        path = self.state_dir / name
+        if not path.exists():
+            return None
+        with self._context():
+            tokens = (llama_cpp.llama_token * self.n_ctx)()
+            count = ctypes.c_size_t(0)
+            if not llama_cpp.llama_state_load_file(self.llm.ctx, str(path).encode(), tokens, self.n_ctx, ctypes.byref(count)):
+                self.llm.reset()
+                return None
+            # Tell llama-cpp-python what the cache holds, so generate() reuses it.
+            n = count.value
+            self.llm._input_ids[:n] = tokens[:n]  # `input_ids` is a view of the first n_tokens (none yet)
+            self.llm.n_tokens = n
+        return n
+
+    def erase_prefix(self) -> None:
+        """Forget the KV cache (simulates a fresh process in benchmarks)."""
+        with self._context():
+            self.llm.reset()
+
+    @contextmanager
+    def _context(self) -> Iterator[None]:
+        """Exclusive use of the context; a reply in progress ends at its next step."""
+        with self._lock:
+            self._epoch += 1
+            yield
+
+    def _acquire(self, deadline: float | None) -> bool:
+        if deadline is None:
+            return self._lock.acquire()
+        return self._lock.acquire(timeout=max(0.0, deadline - time.perf_counter()))
+
+    def _generate(self, messages: list[dict[str, str]], max_tokens: int, deadline: float | None) -> Iterator[str]:
+        started = time.perf_counter()
+        tokens, stops = self._prompt(messages)
+        budget = min(max_tokens, self.n_ctx - len(tokens))
+        if budget <= 0:
+            raise ValueError(f"prompt of {len(tokens)} tokens does not fit the {self.n_ctx}-token context")
+        if not self._acquire(deadline):
+            return
+        try:
+            cached = list(getattr(self.llm, "_input_ids", ()))[: getattr(self.llm, "n_tokens", 0)]
+            self._epoch += 1
+            epoch = self._epoch
+        finally:
+            self._lock.release()
+        reused = 0
+        for a, b in zip(cached, tokens[:-1]):  # the last prompt token is always evaluated
+            if a != b:
+                break
+            reused += 1
+        stats = self.stats = EmbeddedStats(prompt_tokens=len(tokens), reused_tokens=reused)
+
+        # Text is held back while it could be the start of a stop string.
+        hold = max((len(s) for s in stops), default=1) - 1
+        decoder = codecs.getincrementaldecoder("utf-8")(errors="ignore")
+        pending = ""
+        # generate() re-evaluates only the tokens after the cached prefix (on
+        # the first step: prefill).
+        steps = self.llm.generate(tokens, reset=True, **self.sampling)
+        try:
+            while deadline is None or time.perf_counter() < deadline:
+                if not self._acquire(deadline):
+                    break
+                try:
+                    if self._epoch != epoch:
+                        break  # another call took the context over
+                    token = next(steps, self._eos)
+                finally:
+                    self._lock.release()
+                if token == self._eos:
+                    break
+                stats.reply_tokens += 1
+                if stats.first_token_s is None:
+                    stats.first_token_s = time.perf_counter() - started
+                pending += decoder.decode(self.llm.detokenize([token]))
+                stop_at = min((i for i in (pending.find(s) for s in stops) if i >= 0), default=-1)
+                if stop_at >= 0:
+                    pending = pending[:stop_at]
+                    break
+                if len(pending) > hold:
+                    cut = len(pending) - hold
+                    yield pending[:cut]
+                    pending = pending[cut:]
+                if stats.reply_tokens >= budget:
+                    break
+            if pending:
+                yield pending
+        finally:
+            steps.close()
+            stats.seconds = time.perf_counter() - started
@@ -0,0 +1,108 @@
+"""Saved KV state of the system prompt, restored instead of re-evaluated.
+
+Every turn's prompt starts with the same system prompt. Both backends keep
+the previous prompt's KV cache, but a restart (of llama-server or of this
+process) or another client using the server's slot throws it away, and the
+next turn evaluates the whole system prompt again: seconds on a CPU.
+
+`PrefixSnapshot` evaluates the prefix once, saves its KV state under a name
+derived from the model and the system prompt (so a changed prompt or model
+never restores a stale state), and loads it back:
+
+- at startup (`prepare`), building the snapshot first if there is none;
+- before a turn (`before_turn`), if the previous reply had to evaluate the
+  prefix again (it was evicted) or the pipeline was idle for `idle_s`
+  (another client may have used the slot meanwhile; for llama-server that
+  also covers a server restart). In-process nothing else touches the
+  context, so the embedded backend passes `idle_s=None`.
+
+If saving fails (e.g. llama-server without `--slot-save-path`) the snapshot
+gives up and turns run as before.
+
+The client does the saving: `EmbeddedLlamaClient` writes to its
+`state_dir`, `LlamaServerClient` uses llama-server's slot save/restore
+(`--slot-save-path`). Both provide `model_id()`, `save_prefix(history,
+name)`, `restore_prefix(name)` and `cached_tokens`.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import json
+import threading
+import time
+from typing import Any
+
+try:
+    from telemetry.ringlog import get_logger
+except ImportError:  # llm-app used on its own
+    from logging import getLogger as get_logger
+
+log = get_logger("Prefix")
+
+
+def snapshot_name(model_id: str, history: list[Any]) -> str:
+    """File name for the prefix state of `history` on `model_id`."""
+    key = json.dumps([model_id, [[m.role, m.content] for m in history]], ensure_ascii=False)
+    return f"prefix-{hashlib.sha1(key.encode('utf-8')).hexdigest()[:16]}.bin"
+
+
+class PrefixSnapshot:
+    def __init__(self, client: Any, history: list[Any], idle_s: float | None = 30.0) -> None:
+        self.client = client
+        self.history = list(history)
+        self.idle_s = idle_s
+        self.name = snapshot_name(client.model_id(), self.history)
+        self.prefix_tokens = 0
+        self.restores = 0
+        self.builds = 0
+        self._stale = True
+        self._failed = False
+        self._last_turn = time.monotonic()
+        self._thread: threading.Thread | None = None
+
+    def prepare(self) -> bool:
+        """Restore the snapshot, building it first if needed; False if neither worked."""
+        started = time.perf_counter()
+        try:
+            n = self.client.restore_prefix(self.name)
+            if n is None:
+                n = self.client.save_prefix(self.history, self.name)
+                self.builds += 1
+                log.info("Saved the system prompt's KV state (%d tokens) as %s in %.2f s",
+                         n, self.name, time.perf_counter() - started)
+            else:
+                self.restores += 1
+                log.info("Restored the system prompt's KV state (%d tokens) in %.0f ms",
+                         n, (time.perf_counter() - started) * 1000)
+        except Exception as exc:  # noqa: BLE001 - the turn still works, just slower
+            log.warning("System prompt snapshot unavailable, not retrying: %s", exc)
+            self._failed = True
+            return False
+        self.prefix_tokens = n
+        self._stale = False
+        return True
+
+    def before_turn(self) -> None:
+        """Start restoring in the background if the prefix may be gone; see `wait`."""
+        if self._failed:
+            return
+        idle = self.idle_s is not None and time.monotonic() - self._last_turn > self.idle_s
+        if self._stale or idle:
+            self._thread = threading.Thread(target=self.prepare, name="prefix-restore", daemon=True)
+            self._thread.start()
+
+    def wait(self) -> None:
+        """Block until a restore started by `before_turn` is done."""
+        if self._thread is not None:
+            self._thread.join()
+            self._thread = None
+
+    def after_turn(self) -> None:
+        """Note whether the reply found the prefix in the cache."""
+        self._last_turn = time.monotonic()
+        cached = self.client.cached_tokens
+        if cached is not None and self.prefix_tokens and cached < self.prefix_tokens // 2:
+            log.info("System prompt was evaluated again (%d of %d tokens cached); restoring next turn",
+                     cached, self.prefix_tokens)
+            self._stale = True
@@ -0,0 +1,158 @@
+import ctypes
+import os
+import sys
+import threading
+from pathlib import Path
+from types import SimpleNamespace
+
+import pytest
+
+LLM_APP = Path(__file__).resolve().parents[1]
+if str(LLM_APP) not in sys.path:
+    sys.path.insert(0, str(LLM_APP))
+
+import embedded  # noqa: E402
+
+EOS = 0
+
+
+class FakeLlama:
+    """Byte-level stand-in for `llama_cpp.Llama` replying with a fixed text."""
+
+    def __init__(self, reply: str, **kwargs) -> None:
+        self.reply = reply.encode("utf-8")
+        self.kwargs = kwargs
+        self.metadata = {}
+        self._input_ids = []
+        self.n_tokens = 0
+
+    @property
+    def input_ids(self):
+        # Like llama-cpp-python: a view of the first n_tokens, empty in a fresh process.
+        return self._input_ids[: self.n_tokens]
+
+    def token_eos(self) -> int:
+        return EOS
+
+    def token_bos(self) -> int:
+        return 1
+
+    def tokenize(self, text: bytes, add_bos: bool = True, special: bool = False) -> list[int]:
+        return ([1] if add_bos else []) + [b + 2 for b in text]
+
+    def detokenize(self, tokens: list[int], special: bool = False) -> bytes:
+        return bytes(t - 2 for t in tokens if t > 1)
+
+    def reset(self) -> None:
+        self._input_ids = []
+        self.n_tokens = 0
+
+    def generate(self, tokens, reset=True, **sampling):
+        self.prefills = getattr(self, "prefills", 0) + 1
+        self._input_ids = list(tokens)
+        self.n_tokens = len(tokens)
+        for b in self.reply:
+            self._input_ids.append(b + 2)
+            self.n_tokens += 1
+            yield b + 2
+        yield EOS
+
+
+@pytest.fixture
+def make_client(monkeypatch):
+    def make(reply: str, **options):
+        monkeypatch.setattr(embedded, "Llama", lambda **kwargs: FakeLlama(reply, **kwargs))
+        return embedded.EmbeddedLlamaClient("model.gguf", **options)
+
+    return make
+
+
+def test_streams_pieces_and_stops_at_chat_stop_string(make_client):
+    client = make_client("Lafufu thinks: hé!<|im_end|>ignored")
+    assert client.llm.kwargs["use_mmap"] and client.llm.kwargs["n_gpu_layers"] == 0
+
+    tokens = []
+    text = client.chat("hi", on_token=tokens.append)
+
+    assert text == "Lafufu thinks: hé!"
+    assert len(tokens) > 1 and not any("<|" in t for t in tokens)  # stop string never leaks
+    assert client.stats.first_token_s is not None
+
+
+def test_max_tokens_caps_reply_and_next_turn_reuses_prompt_prefix(make_client):
+    client = make_client("0123456789")
+    system = [SimpleNamespace(role="system", content="You are a robot.")]  # app.Message
+
+    assert "".join(client.chat_stream("one", history=system, max_tokens=4)) == "0123"
+    first = client.stats
+    assert first.reused_tokens == 0
+
+    list(client.chat_stream("two", history=system))
+    # The system prompt (and the "<|im_start|>user\n" after it) is still cached.
+    assert client.stats.reused_tokens > len(system[0].content)
+    assert client.stats.reused_tokens < client.stats.prompt_tokens
+
+
+def test_abandoned_stream_does_not_block_the_model_and_ends_when_taken_over(make_client):
+    client = make_client("0123456789" * 3)
+    stalled = client.chat_stream("one")
+    assert next(stalled) == "0"  # the caller stops reading here
+
+    erased = threading.Thread(target=client.erase_prefix)
+    erased.start()
+    erased.join(timeout=1.0)
+    assert not erased.is_alive()
+    assert "".join(client.chat_stream("two")) == "0123456789" * 3
+    # Its KV state is gone: it flushes the text it held back and ends.
+    assert "".join(stalled) == "123456789"
+
+
+def test_deadline_is_checked_before_prefill(make_client):
+    client = make_client("0123456789")
+    assert list(client.chat_stream("hi", timeout=0.0)) == []
+    assert getattr(client.llm, "prefills", 0) == 0
+
+
+def test_restored_prefix_is_reused_in_a_fresh_process(make_client, monkeypatch, tmp_path):
+    saved = [1, 5, 6, 7]
+
+    def load_file(ctx, path, tokens, capacity, count):
+        tokens[: len(saved)] = saved
+        count._obj.value = len(saved)
+        return True
+
+    monkeypatch.setattr(embedded, "llama_cpp", SimpleNamespace(llama_token=ctypes.c_int32,
+                                                                llama_state_load_file=load_file))
+    (tmp_path / "p.bin").write_bytes(b"kv")
+    client = make_client("ok", state_dir=tmp_path)
+    client.llm.ctx = None
+
+    assert client.restore_prefix("p.bin") == len(saved)
+    assert client.llm.input_ids == saved and client.llm.n_tokens == len(saved)
+
+
+@pytest.mark.skipif(
+    embedded.Llama is None or not os.environ.get("LLM_TEST_MODEL"),
+    reason="needs llama-cpp-python and LLM_TEST_MODEL=<tiny .gguf>",
+)
+def test_real_model_streams_on_cpu():
+    client = embedded.EmbeddedLlamaClient(os.environ["LLM_TEST_MODEL"], n_ctx=256, max_tokens=8)
+    pieces = list(client.chat_stream("Once upon a time"))
+    assert pieces and client.stats.reply_tokens <= 8
+    list(client.chat_stream("Once upon a time"))
+    assert client.stats.reused_tokens > 0
+
+
+@pytest.mark.skipif(
+    embedded.Llama is None or not os.environ.get("LLM_TEST_MODEL"),
+    reason="needs llama-cpp-python and LLM_TEST_MODEL=<tiny .gguf>",
+)
+def test_real_model_restores_saved_prefix(tmp_path):
+    system = [SimpleNamespace(role="system", content="You are a small robot who tells stories.")]
+    model = os.environ["LLM_TEST_MODEL"]
+    saved = embedded.EmbeddedLlamaClient(model, n_ctx=256, max_tokens=4, state_dir=tmp_path).save_prefix(system, "p.bin")
+
+    client = embedded.EmbeddedLlamaClient(model, n_ctx=256, max_tokens=4, state_dir=tmp_path)
+    assert client.restore_prefix("p.bin") == saved > 0
+    list(client.chat_stream("Once upon a time", history=system))
+    assert client.stats.reused_tokens == saved
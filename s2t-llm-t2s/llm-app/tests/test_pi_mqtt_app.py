@@ -3,7 +3,7 @@ import sys
 import types
 from pathlib import Path
 from types import SimpleNamespace
-from unittest.mock import MagicMock, patch
+from unittest.mock import MagicMock, call, patch
 
 import pytest
 
@@ -29,6 +29,8 @@ if "paho.mqtt.client" not in sys.modules:
     sys.modules["paho.mqtt"] = mqtt_pkg
     sys.modules["paho.mqtt.client"] = client_mod
 
+from mqtt.clock_sync import TOPIC_CLOCK_PING
+from mqtt.commands import SpeakCommand
 from mqtt.pi_mqtt_app import (
     BROKER_HOST,
     BROKER_PORT,
@@ -41,11 +43,11 @@ from mqtt.pi_mqtt_app import (
 
 
 @pytest.fixture
-@patch("mqtt.pi_mqtt_app.mqtt.Client")
-def app_with_mock_client(mock_client_cls):
-    """Create a PiMqttApp instance whose underlying mqtt.Client is mocked."""
+@patch("mqtt.pi_mqtt_app.PahoTransport.create_client")
+def app_with_mock_client(mock_create_client):
+    """Create a PiMqttApp instance whose underlying paho client is mocked."""
     mock_client = MagicMock()
-    mock_client_cls.return_value = mock_client
+    mock_create_client.return_value = mock_client
 
     app = PiMqttApp(broker_host=BROKER_HOST, broker_port=BROKER_PORT)
     return app, mock_client
@@ -77,39 +79,60 @@ def test_start_connects_to_mqtt_broker_and_runs_loop_once(app_with_mock_client):
     publish_mock.assert_called_once()
 
 
-def test_on_connect_subscribes_to_command_topic(app_with_mock_client):
-    """PiMqttApp subscribes to the correct command topic on successful connect."""
+def test_on_connect_subscribes_to_command_clock_and_snapshot_topics(app_with_mock_client):
+    """PiMqttApp subscribes to the command, clock-ping and snapshot-request topics on successful connect."""
     app, mock_client = app_with_mock_client
 
     # rc == 0 indicates a successful connection
     app._on_connect(mock_client, userdata=None, flags={}, rc=0)
 
-    mock_client.subscribe.assert_called_once_with(TOPIC_COMMANDS, qos=0)
+    assert mock_client.subscribe.call_args_list == [
+        call(TOPIC_COMMANDS, qos=0),
+        call(TOPIC_CLOCK_PING, qos=0),
+        call("siggraph/pi/snapshot/request", qos=0),
+    ]
 
 
-def test_on_message_processes_incoming_command_message(app_with_mock_client, capsys):
-    """PiMqttApp processes incoming MQTT messages on the command topic.
+def test_on_message_queues_command_for_dispatch_off_network_thread(app_with_mock_client):
+    """PiMqttApp only queues incoming commands on paho's network thread.
 
-    Currently this means decoding the payload and printing a log line.
+    Parsing and handling happen when the dispatcher drains its queue.
     """
     app, _ = app_with_mock_client
 
+    received = []
+    app.commands.register(SpeakCommand.KIND, received.append)
+
     class Msg:
         topic = TOPIC_COMMANDS
-        payload = b'{"cmd": "test"}'
+        payload = b'{"cmd": "speak", "text": "hello"}'
+
+    app._on_message(client=None, userdata=None, msg=Msg())
+    assert received == []
+
+    assert app.commands.run_pending() == 1
+    assert received == [SpeakCommand(text="hello")]
+
+
+def test_set_publish_rate_command_changes_ticker_rate(app_with_mock_client):
+    app, _ = app_with_mock_client
 
-    msg = Msg()
+    class Msg:
+        topic = TOPIC_COMMANDS
+        payload = b'{"cmd": "set_publish_rate", "rate_hz": 120}'
 
-    app._on_message(client=None, userdata=None, msg=msg)
-    captured = capsys.readouterr()
+    app._on_message(client=None, userdata=None, msg=Msg())
+    app.commands.run_pending()
 
-    assert TOPIC_COMMANDS in captured.out
-    assert '{"cmd": "test"}' in captured.out
+    assert app.ticker.rate_hz == 120.0
 
 
-def test_publish_state_sends_pistate_json_to_state_topic(app_with_mock_client):
+@patch("mqtt.pi_mqtt_app.PahoTransport.create_client")
+def test_publish_state_sends_pistate_json_to_state_topic(mock_create_client):
     """PiMqttApp publishes PiState data to the correct topic in JSON format."""
-    app, mock_client = app_with_mock_client
+    mock_client = mock_create_client.return_value
+    # JSON is opt-in (PI_STATE_FORMATS=json,bin); the default is binary only.
+    app = PiMqttApp(broker_host=BROKER_HOST, broker_port=BROKER_PORT, state_formats=["json", "bin"])
 
     # Provide deterministic PiState so we can assert on the JSON payload.
     state = PiState(
@@ -139,11 +162,12 @@ def test_publish_state_sends_pistate_json_to_state_topic(app_with_mock_client):
 
         app.publish_state()
 
-    mock_client.publish.assert_called_once()
-    args, kwargs = mock_client.publish.call_args
-
-    # First positional argument is the topic.
-    assert args[0] == TOPIC_STATE
+    # One publish per configured format; the bare topic carries JSON. The
+    # first sample also refreshes the retained late-joiner snapshots.
+    topics = [c.args[0] for c in mock_client.publish.call_args_list]
+    assert topics == [TOPIC_STATE, TOPIC_STATE + "/bin", TOPIC_STATE + "/snapshot", TOPIC_STATE + "/bin/snapshot"]
+    assert [c.kwargs["retain"] for c in mock_client.publish.call_args_list] == [False, False, True, True]
+    args, kwargs = mock_client.publish.call_args_list[0]
 
     # Payload should be valid JSON representing the PiState fields.
     payload = kwargs["payload"]
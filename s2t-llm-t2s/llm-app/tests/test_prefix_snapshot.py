@@ -0,0 +1,76 @@
+import sys
+from pathlib import Path
+from types import SimpleNamespace
+
+LLM_APP = Path(__file__).resolve().parents[1]
+if str(LLM_APP) not in sys.path:
+    sys.path.insert(0, str(LLM_APP))
+
+from prefix_snapshot import PrefixSnapshot, snapshot_name  # noqa: E402
+
+SYSTEM = [SimpleNamespace(role="system", content="You are Lafufu.")]
+
+
+class FakeClient:
+    """Backend stand-in: a dict of saved states and the reply's cache hit."""
+
+    def __init__(self, saved=None, fail_save=False):
+        self.saved = dict(saved or {})
+        self.fail_save = fail_save
+        self.calls = []
+        self.cached_tokens = None
+
+    def model_id(self):
+        return "tiny.gguf"
+
+    def save_prefix(self, history, name):
+        self.calls.append("save")
+        if self.fail_save:
+            raise RuntimeError("slot saving disabled")
+        self.saved[name] = 40
+        return 40
+
+    def restore_prefix(self, name):
+        self.calls.append("restore")
+        return self.saved.get(name)
+
+
+def test_builds_once_then_restores_and_names_follow_prompt_and_model():
+    client = FakeClient()
+    snapshot = PrefixSnapshot(client, SYSTEM)
+    assert snapshot.prepare() and client.calls == ["restore", "save"]
+
+    restarted = PrefixSnapshot(FakeClient(saved=client.saved), SYSTEM)
+    assert restarted.prepare() and restarted.client.calls == ["restore"]
+    assert restarted.prefix_tokens == 40 and restarted.restores == 1
+
+    other = [SimpleNamespace(role="system", content="You are someone else.")]
+    assert snapshot_name("tiny.gguf", other) != snapshot.name != snapshot_name("big.gguf", SYSTEM)
+
+
+def test_restores_before_the_turn_after_an_eviction_only():
+    client = FakeClient()
+    snapshot = PrefixSnapshot(client, SYSTEM, idle_s=None)
+    snapshot.prepare()
+    client.calls.clear()
+
+    client.cached_tokens = 39  # prefix found in the cache
+    snapshot.after_turn()
+    snapshot.before_turn()
+    snapshot.wait()
+    assert client.calls == []
+
+    client.cached_tokens = 3  # evaluated again: evicted
+    snapshot.after_turn()
+    snapshot.before_turn()
+    snapshot.wait()
+    assert client.calls == ["restore"]
+
+
+def test_gives_up_when_the_backend_cannot_save():
+    client = FakeClient(fail_save=True)
+    snapshot = PrefixSnapshot(client, SYSTEM)
+    assert not snapshot.prepare()
+    snapshot.before_turn()
+    snapshot.wait()
+    assert client.calls == ["restore", "save"]
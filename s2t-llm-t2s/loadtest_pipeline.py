@@ -0,0 +1,181 @@
+"""How many robots can one pipeline server answer within the SLO?
+
+Starts `pipeline_server.py` in-process (simulated models by default) or
+targets a running one (`--server`), then for each robot count in `--robots`
+runs that many simulated robots over localhost. Each robot loops over the
+WAV files: streams one in real time as its microphone would (then silence
+until the server ends the turn), "plays" the reply from its first sentence
+on as `PcmPlayer` would, and starts the next once it has played. Turns
+finished during the `--seconds` window after `--warmup` are measured from
+the server's turn reports:
+
+- first audio (end of turn -> first reply PCM) p50 / p95
+- SLO attainment overall and for the worst robot
+- turns per minute served, and this process's CPU (server and robots)
+
+A robot count is sustained if at least `--attain` of all turns, and of
+each robot's turns, met the SLO. Without `--wav` the labelled utterances
+of `endpoint_corpus.jsonl` are rendered to WAV files first.
+
+The simulated models only model service times and concurrency (one
+Whisper batching up to `--stt-batch` utterances, `--llm-slots` replies,
+`--tts-workers` sentences at a time); use
+`--server` against a `pipeline_server.py` with real models for real numbers.
+
+Run from this directory:
+    python loadtest_pipeline.py --robots 1 4 8 16 32 --seconds 40
+    python loadtest_pipeline.py --server gpu-box:8770 --robots 4 8 12 --wav question-*.wav
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import tempfile
+import threading
+import time
+import wave
+from pathlib import Path
+
+from bench_endpointing import SAMPLE_RATE, load_corpus
+from pipeline_client import PcmPlayer, PipelineClient, read_wav, stream_until_turn
+from pipeline_server import BatchConfig, PipelineServer, SimCosts, load_history, sim_engines
+
+
+def render_corpus_wavs(directory: Path, seed: int = 1) -> list[Path]:
+    """Write the endpointing corpus as 16 kHz WAV files (trailing silence trimmed to 0.3 s)."""
+    paths = []
+    for item, (pcm, _, speech_end) in load_corpus(Path(__file__).resolve().parent / "endpoint_corpus.jsonl", seed):
+        path = directory / f"{item['id']}.wav"
+        with wave.open(str(path), "wb") as f:
+            f.setnchannels(1)
+            f.setsampwidth(2)
+            f.setframerate(SAMPLE_RATE)
+            f.writeframes(pcm[: int((speech_end + 0.3) * SAMPLE_RATE) * 2])
+        paths.append(path)
+    return paths
+
+
+def _robot(name: str, host: str, port: int, wavs: list[tuple[bytes, int]], stop: threading.Event,
+           reports: list, lock: threading.Lock, seed: int) -> None:
+    rng = random.Random(seed)
+    rate = wavs[0][1]
+    client = PipelineClient(host, port, name, rate).connect()
+    player = PcmPlayer(client.welcome["reply_sample_rate"], device=False)
+    client.on_pcm = player.write  # the reply "plays" from its first sentence on
+    try:
+        time.sleep(rng.uniform(0.0, 2.0))  # robots do not all start talking at once
+        while not stop.is_set():
+            pcm, _ = rng.choice(wavs)
+            turn = stream_until_turn(client, pcm, stop)
+            if turn is None:
+                break
+            with lock:
+                reports.append((time.monotonic(), turn.report))
+            # Still playing the reply: the robot's microphone is off meanwhile.
+            player.wait(stop)
+    finally:
+        client.close()
+
+
+def _pct(values: list[float], q: float) -> float:
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * q))] if ordered else float("nan")
+
+
+def run_step(robots: int, host: str, port: int, wavs: list[tuple[bytes, int]], args: argparse.Namespace) -> dict:
+    stop = threading.Event()
+    reports: list = []
+    lock = threading.Lock()
+    width = max(2, len(str(robots - 1)))
+    threads = [
+        threading.Thread(target=_robot, args=(f"robot-{i:0{width}d}", host, port, wavs, stop, reports, lock, args.seed + i),
+                         name=f"robot-{i}", daemon=True)
+        for i in range(robots)
+    ]
+    for t in threads:
+        t.start()
+    time.sleep(args.warmup)
+    window_start = time.monotonic()
+    cpu_start = time.process_time()
+    time.sleep(args.seconds)
+    window_end = time.monotonic()
+    cpu = (time.process_time() - cpu_start) / (window_end - window_start)
+    stop.set()
+    for t in threads:
+        t.join(timeout=30.0)
+
+    measured = [r for t, r in reports if window_start <= t <= window_end and r.get("transcript_s")]
+    first_audio = [r["first_audio_s"] if r["first_audio_s"] is not None else r["done_s"] for r in measured]
+    per_robot: dict[str, list[bool]] = {}
+    for r in measured:
+        per_robot.setdefault(r["robot"], []).append(bool(r["slo_met"]))
+    attainment = sum(r["slo_met"] for r in measured) / len(measured) if measured else 0.0
+    worst = min((sum(v) / len(v) for v in per_robot.values()), default=0.0)
+    if len(per_robot) < robots:
+        worst = 0.0  # a robot finished no turn in the window: starved
+    return {
+        "robots": robots,
+        "turns": len(measured),
+        "turns_per_min": len(measured) / (window_end - window_start) * 60.0,
+        "p50": _pct(first_audio, 0.5),
+        "p95": _pct(first_audio, 0.95),
+        "attainment": attainment,
+        "worst": worst,
+        "cpu": cpu,
+        "sustained": bool(measured) and attainment >= args.attain and worst >= args.attain,
+    }
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Simulated robots against one pipeline server.")
+    parser.add_argument("--server", help="host:port of a running pipeline_server.py (default: start one here).")
+    parser.add_argument("--robots", type=int, nargs="+", default=[1, 2, 4, 8, 16, 32],
+                        help="Robot counts to try (default: %(default)s).")
+    parser.add_argument("--wav", nargs="*", default=[], help="16-bit mono WAV utterances (default: rendered corpus).")
+    parser.add_argument("--seconds", type=float, default=40.0, help="Measured time per step (default: %(default)s).")
+    parser.add_argument("--warmup", type=float, default=8.0, help="Seconds before measuring (default: %(default)s).")
+    parser.add_argument("--slo", type=float, default=2.0, help="First-audio SLO for the in-process server (default: %(default)s).")
+    parser.add_argument("--attain", type=float, default=0.95, help="Share of turns that must meet the SLO (default: %(default)s).")
+    parser.add_argument("--llm-slots", type=int, default=2, help="Simulated replies at once (default: %(default)s).")
+    parser.add_argument("--tts-workers", type=int, default=4, help="Simulated sentences at once (default: %(default)s).")
+    parser.add_argument("--stt-batch", type=int, default=8, help="Utterances per STT pass, 1 = one at a time (default: %(default)s).")
+    parser.add_argument("--seed", type=int, default=1, help="Random seed (default: %(default)s).")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = args.wav or render_corpus_wavs(Path(tmp), args.seed)
+        wavs = [read_wav(p) for p in paths]
+    if len({rate for _, rate in wavs}) != 1:
+        parser.error("all WAV files need the same sample rate")
+    print(f"{len(wavs)} utterances, {sum(len(p) / 2 / r for p, r in wavs) / len(wavs):.1f} s on average")
+
+    server = None
+    if args.server:
+        host, _, port = args.server.rpartition(":")
+        port = int(port)
+    else:
+        engines = sim_engines(SimCosts(), llm_slots=args.llm_slots, tts_workers=args.tts_workers)
+        server = PipelineServer(engines, port=0, history=load_history(), slo_s=args.slo,
+                                stt_batch=BatchConfig(max_batch=args.stt_batch)).start()
+        host, port = server.address
+        print(f"In-process server with simulated models (stt batch {args.stt_batch}, llm x{args.llm_slots}, "
+              f"tts x{args.tts_workers}), SLO {args.slo:.1f} s")
+
+    best = 0
+    try:
+        for robots in args.robots:
+            r = run_step(robots, host, port, wavs, args)
+            print(f"{r['robots']:4d} robots: {r['turns']:4d} turns ({r['turns_per_min']:5.1f}/min), first audio "
+                  f"p50 {r['p50'] * 1000:6.0f} ms p95 {r['p95'] * 1000:6.0f} ms, within SLO {r['attainment']:4.0%} "
+                  f"(worst robot {r['worst']:4.0%}), CPU {r['cpu']:4.0%}  {'ok' if r['sustained'] else 'MISSED'}")
+            if r["sustained"]:
+                best = max(best, robots)
+    finally:
+        if server is not None:
+            server.stop()
+    print(f"Sustained at the SLO: {best} robots" if best else "No robot count met the SLO")
+
+
+if __name__ == "__main__":
+    main()
@@ -4,13 +4,37 @@
 2. Transcribe speech to text (STT)
 3. Send text to local Ollama LLM
 4. Speak the LLM reply using the robot TTS/motor system
+
+The pipeline writes its live state (app_state, dialogue, speaking, head pose)
+to an in-process `StateBus`, which the MQTT publisher samples for the
+digital twin.
+
+`--record session.tcol` captures the session (mic PCM, transcripts, LLM
+token stream, TTS audio, playback, motor commands, MQTT text/audio/command
+traffic; see `telemetry/session.py`). `--replay session.tcol` drives the
+pipeline from such a recording with stand-ins for the mic, STT, LLM, TTS,
+audio output and motors, at the original timing or `--speed N` times
+faster (0 = no waiting); `--live stt llm audio` uses the real component
+instead of a stand-in. Replays publish to an in-process broker unless
+`--publish` is given.
+
+Each turn runs against a time-to-first-audio budget (`turn_budget.py`):
+stages that are predicted to miss it degrade (Whisper instead of cloud
+STT, a backup LLM server, a shorter reply, a filler phrase) and every
+degradation is logged with the turn.
 """
 
 from __future__ import annotations
 
+import os
 import sys
 import json
 import re
+import argparse
+import importlib.util
+import threading
+import time
+from functools import partial
 from pathlib import Path
 from typing import List
 
@@ -29,9 +53,90 @@ for p in (S2T_DIR, LLM_DIR, T2S_DIR):
     if str(p) not in sys.path:
         sys.path.insert(0, str(p))
 
-
-from app import OllamaClient, Message  # type: ignore  # from llm-app/app.py
+# The shared `mqtt` package lives at the repository root. Appended (not
+# prepended) so the subproject modules above keep precedence.
+REPO_ROOT = BASE_DIR.parent
+if str(REPO_ROOT) not in sys.path:
+    sys.path.append(str(REPO_ROOT))
+# The local intent matcher is shared with LafufuTwins' assistant.
+INTENTS_DIR = REPO_ROOT / "LafufuTwins"
+if str(INTENTS_DIR) not in sys.path:
+    sys.path.append(str(INTENTS_DIR))
+
+
+from app import LlamaServerClient, Message  # type: ignore  # from llm-app/app.py
+from prefix_snapshot import PrefixSnapshot  # type: ignore  # from llm-app/prefix_snapshot.py
+from endpointing import Endpointer
+from turn_budget import (
+    DEGRADE_LLM_BACKUP,
+    DEGRADE_STT_FALLBACK,
+    DEGRADE_TRUNCATED,
+    LLM_BACKUP,
+    LLM_PRIMARY,
+    STT_FALLBACK,
+    LlmPlan,
+    STT_PRIMARY,
+    TtsCache,
+    TurnBudget,
+    TurnScheduler,
+    config_from_env,
+)
+import intents  # type: ignore  # from LafufuTwins/intents.py
+from audio_player import play_audio_blocking, set_output_volume  # type: ignore  # from t2s1/audio_player.py
 from robot_speech import RobotSpeaker  # type: ignore  # from t2s1/robot_speech.py
+from mqtt.audio_stream import AudioStreamPublisher
+from mqtt.commands import ActionWorker, GestureCommand, SetStateCommand, SpeakCommand
+from mqtt.state_bus import (
+    APP_STATE_IDLE,
+    APP_STATE_LISTENING,
+    APP_STATE_SPEAKING,
+    APP_STATE_THINKING,
+    StateBus,
+)
+from mqtt.text_stream import ThinkBlockFilter, TextStreamPublisher
+
+from mqtt.pi_mqtt_app import PiMqttApp
+from mqtt.topics import DEFAULT_DEVICE_ID
+from mqtt.transport import LoopbackBroker, Transport
+from telemetry.instruments import PipelineMetrics, mqtt_app_collector
+from telemetry.metrics import DEFAULT_METRICS_PORT, MetricsHttpServer, Registry, compact_payload
+from telemetry.ringlog import flush as flush_logs
+from telemetry.session import (
+    STREAM_TURN,
+    Pacer,
+    ReplayLlm,
+    ReplayMicrophone,
+    ReplayPlayer,
+    ReplayStt,
+    ReplayTts,
+    ReplayTurns,
+    SessionLog,
+    SessionRecorder,
+    replay_commands,
+)
+
+# OpenAI-compatible server used for replies; point it at `llm-app/stub_server.py`
+# to exercise the pipeline against a scripted, timed stand-in.
+LLM_BASE_URL = os.environ.get("LLM_BASE_URL", "http://localhost:8080")
+
+# A GGUF file here runs the model in-process instead (llm-app/embedded.py,
+# needs llama-cpp-python); LLM_BASE_URL is then unused.
+LLM_MODEL_PATH = os.environ.get("LLM_MODEL_PATH", "")
+
+# Save the system prompt's KV state and restore it after restarts and
+# evictions (llm-app/prefix_snapshot.py); llama-server needs --slot-save-path.
+LLM_PREFIX_SNAPSHOT = os.environ.get("LLM_PREFIX_SNAPSHOT", "1") != "0"
+
+# End of turn: "fixed" (1.8 s of silence) or "adaptive" (endpointing.py).
+# Adaptive stays opt-in until it is tuned on real mic audio: on the bench
+# corpus it still cuts some turns short. ENDPOINT_PARTIAL=google recognizes
+# the audio at each pause to judge whether the sentence is finished; "off"
+# uses pitch and energy only.
+ENDPOINTING = os.environ.get("ENDPOINTING", "fixed")
+ENDPOINT_PARTIAL = os.environ.get("ENDPOINT_PARTIAL", "google")
+
+# Prometheus endpoint on 127.0.0.1; METRICS_PORT=0 turns it off.
+METRICS_PORT = int(os.environ.get("METRICS_PORT", DEFAULT_METRICS_PORT))
 
 
 def load_system_prompt(base_dir: Path) -> List[Message] | None:
@@ -65,6 +170,23 @@ def load_system_prompt(base_dir: Path) -> List[Message] | None:
     return None
 
 
+def load_intents(base_dir: Path) -> intents.IntentMatcher:
+    """The default intents plus canned answers from `canned_answers.json` if present.
+
+    Expected format:
+        [{"ask": ["who made you", "who built you"], "say": "..."}]
+    """
+    extra: list[intents.Intent] = []
+    path = base_dir / "canned_answers.json"
+    if path.exists():
+        try:
+            extra = intents.load_canned(str(path))
+        except (OSError, ValueError, KeyError, TypeError) as exc:
+            print(f"Warning: could not load canned_answers.json: {exc}")
+    # Site-specific answers first: they win ties with the defaults.
+    return intents.IntentMatcher(tuple(extra) + intents.DEFAULT_INTENTS)
+
+
 def strip_think_blocks(text: str) -> str:
     """Remove <think>...</think> or <thinking>...</thinking> sections from the model output."""
     # Handle both <think> and <thinking> tags just in case
@@ -73,10 +195,11 @@ def strip_think_blocks(text: str) -> str:
     return text.strip()
 
 
-def listen_once(recognizer: sr.Recognizer) -> str | None:
-    """Capture a single utterance from the default microphone and return text.
+def capture_utterance(recognizer: sr.Recognizer) -> tuple[sr.AudioData, str | None]:
+    """Capture a single utterance from the default microphone.
 
-    Returns None if recognition fails.
+    Returns the audio and, if the endpointer's partial transcript already
+    covers all of it, that transcript (so STT can be skipped).
     """
 
     with sr.Microphone() as source:
@@ -84,66 +207,507 @@ def listen_once(recognizer: sr.Recognizer) -> str | None:
         recognizer.adjust_for_ambient_noise(source, duration=1)
         print("Calibration complete. Start speaking. You can talk for a while and pause briefly.\\n")
 
-        # Be more tolerant of pauses so you don't get cut off too quickly
-        recognizer.pause_threshold = 1.8  # seconds of silence before considering phrase complete
-        recognizer.non_speaking_duration = 0.8
+        if ENDPOINTING == "fixed":
+            # Be more tolerant of pauses so you don't get cut off too quickly
+            recognizer.pause_threshold = 1.8  # seconds of silence before considering phrase complete
+            recognizer.non_speaking_duration = 0.8
 
+            print("Listening (up to ~20 seconds)...")
+            return recognizer.listen(source, timeout=None, phrase_time_limit=20), None
+
+        def partial(pcm: bytes) -> str | None:
+            try:
+                return recognizer.recognize_google(sr.AudioData(pcm, source.SAMPLE_RATE, source.SAMPLE_WIDTH))
+            except (sr.UnknownValueError, sr.RequestError, TimeoutError):
+                return None
+
+        # The wait after each pause depends on what was said and how (see endpointing.py).
+        endpointer = Endpointer(
+            source.SAMPLE_RATE,
+            energy_threshold=recognizer.energy_threshold,
+            partial=partial if ENDPOINT_PARTIAL == "google" else None,
+        )
         print("Listening (up to ~20 seconds)...")
-        audio = recognizer.listen(source, timeout=None, phrase_time_limit=20)
-        print("Recognizing...")
+        while not endpointer.feed(source.stream.read(source.CHUNK)):
+            pass
+        print(f"End of turn after {endpointer.endpoint_delay or 0.0:.2f} s of silence ({endpointer.decision.reason})")
+        return sr.AudioData(endpointer.audio, source.SAMPLE_RATE, source.SAMPLE_WIDTH), endpointer.transcript
+
+
+def transcribe(
+    recognizer: sr.Recognizer,
+    audio: sr.AudioData,
+    scheduler: TurnScheduler | None = None,
+    turn: TurnBudget | None = None,
+) -> str | None:
+    """Return the recognized text, or None if recognition fails.
+
+    With a turn budget, Google STT gets the budget's STT share as its
+    timeout and local Whisper (`tiny.en`) stands in when Google is
+    predicted to be too slow, times out or is unreachable.
+    """
+    print("Recognizing...")
+    plan = scheduler.plan_stt(turn) if scheduler is not None and turn is not None else None
+    variant = plan.variant if plan is not None else STT_PRIMARY
+    while True:
+        started = time.perf_counter()
+        try:
+            if variant == STT_FALLBACK:
+                text = recognizer.recognize_whisper(audio, model="tiny.en").strip()
+            else:
+                recognizer.operation_timeout = plan.timeout if plan is not None else None
+                text = recognizer.recognize_google(audio)
+            if scheduler is not None:
+                scheduler.observe_stt(variant, time.perf_counter() - started)
+            print(f"You said: {text}")
+            return text or None
+        except sr.UnknownValueError:
+            print("Sorry, I could not understand the audio.")
+            return None
+        except (sr.RequestError, TimeoutError) as e:  # network / API error
+            if scheduler is not None:
+                scheduler.observe_stt(variant, time.perf_counter() - started)
+            if plan is not None and plan.fallback and variant == STT_PRIMARY:
+                turn.degrade(DEGRADE_STT_FALLBACK, f"primary failed: {e}")
+                variant = STT_FALLBACK
+                continue
+            print(f"Could not request results from the speech service: {e}")
+            return None
+
 
+def stream_reply(
+    clients: dict[str, object],
+    scheduler: TurnScheduler,
+    turn: TurnBudget,
+    plan: LlmPlan,
+    prompt: str,
+    history: List[Message] | None,
+    on_chunk,
+) -> list[str]:
+    """Stream the reply following the turn's LLM plan; returns the chunks.
+
+    If the chosen server times out before its first chunk, the backup (if
+    any) is asked instead; a timeout mid-reply keeps what has arrived.
+    """
+    variant = plan.variant
+    chunks: list[str] = []
+    while True:
+        started = time.perf_counter()
+        first = None
+        try:
+            for chunk in clients[variant].chat_stream(
+                prompt=prompt, history=history, max_tokens=plan.max_tokens, timeout=plan.timeout
+            ):
+                if first is None:
+                    first = time.perf_counter() - started
+                chunks.append(chunk)
+                on_chunk(chunk)
+        except (requests.Timeout, requests.ConnectionError) as exc:  # a stall mid-stream surfaces as ConnectionError
+            scheduler.observe_llm(variant, first, len(chunks), time.perf_counter() - started)
+            if chunks:
+                turn.degrade(DEGRADE_TRUNCATED, f"{variant} stalled mid-reply", chunks=len(chunks))
+                return chunks
+            if variant == LLM_PRIMARY and LLM_BACKUP in clients:
+                turn.degrade(DEGRADE_LLM_BACKUP, f"primary timed out or unreachable: {exc}")
+                variant = LLM_BACKUP
+                continue
+            raise
+        scheduler.observe_llm(variant, first, len(chunks), time.perf_counter() - started)
+        return chunks
+
+
+def start_twin_publisher(
+    bus: StateBus,
+    robot: RobotSpeaker,
+    speak_lock: threading.Lock,
+    recorder: SessionRecorder | None = None,
+    transport: Transport | None = None,
+    registry: Registry | None = None,
+) -> "PiMqttApp | None":
+    """Publish the bus to MQTT from a background thread and accept remote commands.
+
+    Returns None (and the pipeline runs without a twin) if paho-mqtt is
+    missing or the broker is unreachable.
+    """
     try:
-        text = recognizer.recognize_google(audio)
-        print(f"You said: {text}")
-        return text
-    except sr.UnknownValueError:
-        print("Sorry, I could not understand the audio.")
+        # PI_DEVICE_ID namespaces topics when several robots share a broker.
+        twin = PiMqttApp(
+            state_source=bus,
+            device_id=os.environ.get("PI_DEVICE_ID", DEFAULT_DEVICE_ID),
+            transport=transport,
+            metrics_payload=None if registry is None else partial(compact_payload, registry),
+        )
+    except ImportError:
+        print("paho-mqtt not installed; digital twin publishing disabled.")
         return None
-    except sr.RequestError as e:  # network / API error
-        print(f"Could not request results from the speech service: {e}")
+    if registry is not None:
+        registry.register_collector(mqtt_app_collector(twin))
+
+    # Speech and gestures take seconds: run them off the dispatcher thread so
+    # later commands are acknowledged (and applied) right away.
+    actions = ActionWorker()
+
+    def speak(command: SpeakCommand) -> None:
+        if recorder is not None:
+            recorder.record_command(command)
+        actions.submit(partial(speak_locked, robot, speak_lock, command.text, command.lang))
+
+    def gesture(command: GestureCommand) -> None:
+        if recorder is not None:
+            recorder.record_command(command)
+        actions.submit(partial(robot.motors.nod_head, times=command.times))
+
+    def set_state(command: SetStateCommand) -> None:
+        if recorder is not None:
+            recorder.record_command(command)
+        bus.set("app_state", command.app_state)  # validated against APP_STATES when parsed
+
+    twin.commands.register(SpeakCommand.KIND, speak)
+    twin.commands.register(GestureCommand.KIND, gesture)
+    twin.commands.register(SetStateCommand.KIND, set_state)
+
+    def run() -> None:
+        try:
+            twin.start()
+        except OSError as exc:
+            print(f"Digital twin publishing disabled: {exc}")
+
+    threading.Thread(target=run, name="pi-mqtt-app", daemon=True).start()
+    return twin
+
+
+def answer_locally(
+    match: intents.IntentMatch,
+    robot: RobotSpeaker,
+    speak_lock: threading.Lock,
+    bus: StateBus,
+    text_stream: TextStreamPublisher | None = None,
+) -> bool:
+    """Handle a matched intent without the LLM; False if the assistant should exit."""
+    if match.name == intents.NOD:
+        robot.motors.nod_head(times=max(1, min(match.numbers[0], 10)) if match.numbers else 2)
+        return True
+
+    if match.name == intents.EXIT:
+        reply = "Goodbye! Have a great day!"
+    elif match.name == intents.CLEAR_HISTORY:
+        reply = "I only remember the current question, so there is nothing to clear."
+    elif match.name == intents.TIME:
+        reply = intents.time_reply()
+    elif match.name == intents.DATE:
+        reply = intents.date_reply()
+    elif match.name in (intents.VOLUME_UP, intents.VOLUME_DOWN, intents.VOLUME_SET):
+        if match.name == intents.VOLUME_SET:
+            volume = set_output_volume(percent=match.numbers[0])
+        else:
+            volume = set_output_volume(step=10 if match.name == intents.VOLUME_UP else -10)
+        reply = "I can't change the volume here." if volume is None else f"Volume {volume} percent."
+    else:
+        reply = match.intent.reply or "Okay."
+
+    print(reply)
+    if text_stream is not None:
+        text_stream.begin_turn()
+        text_stream.append(reply)
+        text_stream.end_turn()
+    bus.set("dialogue", reply)
+    bus.set("app_state", APP_STATE_SPEAKING)
+    with speak_lock:
+        robot.speak(reply)
+    return match.name != intents.EXIT
+
+
+def replayed_match(
+    recorded: tuple[str, tuple[int, ...]] | None,
+    match: intents.IntentMatch | None,
+    matcher: intents.IntentMatcher,
+) -> intents.IntentMatch | None:
+    """The route a replayed turn took when recorded (the matcher's for older recordings)."""
+    if recorded is None:
+        return match
+    name, numbers = recorded
+    if name == "llm":
         return None
+    if match is not None and match.name == name:
+        return match
+    # The intents changed since recording; answer as recorded so the events still line up.
+    intent = next((i for i in matcher.intents if i.name == name), None) or intents.Intent(name, ())
+    return intents.IntentMatch(intent, phrase="", numbers=numbers)
 
 
-def main() -> None:
-    recognizer = sr.Recognizer()
+def start_filler(robot: RobotSpeaker, speak_lock: threading.Lock, text: str) -> None:
+    """Speak `text` on its own thread; returns once it holds speak_lock, so the reply speaks after it."""
+    holding = threading.Event()
 
-    # Motors disabled by default for desktop development; set True on Pi.
-    robot = RobotSpeaker(motor_enabled=True)
-    client = LlamaServerClient()  # uses local llama-server (GPU-accelerated) on port 8080
+    def run() -> None:
+        with speak_lock:
+            holding.set()
+            robot.speak(text)
 
-    try:
-        while True:
-            try:
-                inp = input("Press Enter to speak, or type 'quit' to exit: ").strip()
-            except (EOFError, KeyboardInterrupt):
-                print("\nExiting.")
-                break
+    threading.Thread(target=run, name="filler", daemon=True).start()
+    holding.wait(timeout=1.0)  # a remote `speak` may hold the lock; don't stall the turn behind it
 
-            if inp.lower() == "quit":
-                break
 
-            text = listen_once(recognizer)
-            if not text:
-                continue
+def speak_locked(robot: RobotSpeaker, speak_lock: threading.Lock, text: str, lang: str = "en") -> None:
+    with speak_lock:
+        robot.speak(text, lang=lang)
+
 
-            # Send to LLM and stream the reply to the console
-            print("Sending to LLM (streaming)...")
-            reply_chunks: list[str] = []
+def primary_llm_client():
+    """The embedded model if LLM_MODEL_PATH is set, else the llama-server at LLM_BASE_URL."""
+    if LLM_MODEL_PATH:
+        from embedded import EmbeddedLlamaClient  # type: ignore  # from llm-app/embedded.py
 
-            for chunk in client.chat_stream(prompt=text, history=system_messages):
-                reply_chunks.append(chunk)
+        print(f"Loading {LLM_MODEL_PATH} in-process...")
+        return EmbeddedLlamaClient(LLM_MODEL_PATH)
+    return LlamaServerClient(base_url=LLM_BASE_URL)  # local llama-server (GPU-accelerated) by default
 
-            full_reply = "".join(reply_chunks)
 
-            # Remove <think>/<thinking> sections for both display and speech
-            cleaned_reply = strip_think_blocks(full_reply)
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Voice assistant: microphone -> STT -> LLM -> robot speech.")
+    parser.add_argument("--record", metavar="PATH", help="Record the session to this file (.tcol).")
+    parser.add_argument("--replay", metavar="PATH", help="Drive the pipeline from a recorded session.")
+    parser.add_argument("--speed", type=float, default=1.0,
+                        help="Replay speed: 1 = original timing, 4 = four times faster, 0 = no waiting (default: %(default)s).")
+    parser.add_argument("--live", nargs="*", choices=("stt", "llm", "audio"), default=[],
+                        help="During replay, use the real STT / LLM server / audio player instead of the recording.")
+    parser.add_argument("--publish", action="store_true", help="During replay, publish to the MQTT broker (default: in-process).")
+    return parser.parse_args()
 
-            print(cleaned_reply)
-            print("Speaking reply...")
-            robot.speak(cleaned_reply)
+
+def main() -> None:
+    args = parse_args()
+    budget_config = config_from_env()
+    recognizer = sr.Recognizer()
+    bus = StateBus()
+    system_messages = load_system_prompt(BASE_DIR)
+
+    log = SessionLog(args.replay) if args.replay else None
+    pacer = Pacer(args.speed)
+    if log is None:
+        # Motors disabled by default for desktop development; set True on Pi.
+        robot = RobotSpeaker(motor_enabled=True, bus=bus)
+        client = primary_llm_client()
+        mic = stt = turns = None
+    else:
+        print(f"Replaying {args.replay}: {log.summary()}")
+        robot = RobotSpeaker(
+            motor_enabled=False,
+            bus=bus,
+            synthesize=ReplayTts(log, pacer).synthesize,
+            play=play_audio_blocking if "audio" in args.live else ReplayPlayer(log, pacer).play,
+        )
+        client = primary_llm_client() if "llm" in args.live else ReplayLlm(log, pacer)
+        mic = ReplayMicrophone(log, pacer)
+        stt = None if "stt" in args.live else ReplayStt(log, pacer)
+        turns = ReplayTurns(log)
+
+    # Metrics wrap the real (or stand-in) parts; the recorder wraps outside them.
+    registry = Registry()
+    metrics = PipelineMetrics(registry)
+    robot.synthesize = metrics.wrap_synthesize(robot.synthesize)
+    robot.play = metrics.wrap_play(robot.play)
+    robot.motors = metrics.wrap_motors(robot.motors)
+    snapshot = None
+    if LLM_PREFIX_SNAPSHOT and system_messages and (log is None or "llm" in args.live):
+        snapshot = PrefixSnapshot(client, system_messages, idle_s=None if LLM_MODEL_PATH else 30.0)
+        snapshot.prepare()
+    clients = {LLM_PRIMARY: client}
+    if budget_config["backup_url"] and (log is None or "llm" in args.live):
+        clients[LLM_BACKUP] = LlamaServerClient(base_url=budget_config["backup_url"])
+    clients = {variant: metrics.wrap_llm(c) for variant, c in clients.items()}
+    metrics_server = None
+    if METRICS_PORT:
+        try:
+            metrics_server = MetricsHttpServer(registry, port=METRICS_PORT).start()
+        except OSError as exc:
+            print(f"Metrics endpoint disabled: {exc}")
+
+    # Replays keep the recorded TTS and playback order, so no cache or fillers there.
+    tts_cache = None
+    fillers: tuple[str, ...] = ()
+    if log is None and budget_config["tts_cache_dir"]:
+        tts_cache = TtsCache(robot.synthesize, budget_config["tts_cache_dir"])
+        fillers = tuple(tts_cache.prewarm(budget_config["fillers"]))
+    # Commands and canned questions skip the LLM. Replay routes each turn as
+    # recorded, since the recording's LLM and TTS events follow that routing.
+    router = intents.IntentRouter(load_intents(BASE_DIR))
+    if tts_cache is not None:
+        threading.Thread(
+            target=tts_cache.prewarm, args=(tuple(intents.static_replies(router.matcher.intents)),),
+            name="tts-prewarm", daemon=True,
+        ).start()
+    scheduler = TurnScheduler(
+        target_s=budget_config["target_s"],
+        stt_share=budget_config["stt_share"],
+        max_tokens=budget_config["max_tokens"],
+        have_backup_llm=LLM_BACKUP in clients,
+        have_stt_fallback=stt is None and importlib.util.find_spec("whisper") is not None,
+        fillers=fillers,
+        registry=registry,
+    )
+    robot.synthesize = scheduler.wrap_synthesize(tts_cache or robot.synthesize)
+    robot.play = scheduler.wrap_play(robot.play)
+
+    recorder = None
+    if args.record:
+        recorder = SessionRecorder(args.record, meta={"replay_of": args.replay, "speed": args.speed if log else None})
+        robot.synthesize = recorder.wrap_synthesize(robot.synthesize)
+        robot.play = recorder.wrap_play(robot.play)
+        robot.motors = recorder.wrap_motors(robot.motors)
+        clients = {variant: recorder.wrap_llm(c) for variant, c in clients.items()}
+
+    # Remote `speak` commands and local turns must not talk over each other.
+    speak_lock = threading.Lock()
+    transport = LoopbackBroker() if log is not None and not args.publish else None
+    twin = start_twin_publisher(bus, robot, speak_lock, recorder, transport, registry)
+    # The reply is streamed to `siggraph/<device>/llm/text` (web UI) as it is generated.
+    text_stream = None
+    replay_stop = threading.Event()
+    if twin is not None:
+        publish = twin.outbound.publish if recorder is None else recorder.tap_publish(twin.outbound.publish)
+        text_stream = TextStreamPublisher(
+            publish,
+            topic=twin.topics.llm_text,
+        )
+        # Played speech goes to `siggraph/<device>/audio` so the twin can play along.
+        robot.audio_sink = AudioStreamPublisher(
+            publish,
+            topic=twin.topics.audio,
+        )
+        if log is not None:
+            replay_commands(log, twin.commands.offer, pacer, replay_stop)
+
+    try:
+        while True:
+            bus.set("app_state", APP_STATE_IDLE)
+            if mic is None:
+                flush_logs()  # so background log lines don't land after the prompt
+                try:
+                    inp = input("Press Enter to speak, or type 'quit' to exit: ").strip()
+                except (EOFError, KeyboardInterrupt):
+                    print("\nExiting.")
+                    break
+
+                if inp.lower() == "quit":
+                    break
+            elif not mic.next_turn():
+                print("Replay finished.")
+                break
+
+            if recorder is not None:
+                recorder.begin_turn()
+            metrics.turns.inc()
+            turn = None
+            try:
+                bus.set("app_state", APP_STATE_LISTENING)
+                started = time.perf_counter()
+                early_text = None
+                if mic is None:
+                    audio, early_text = capture_utterance(recognizer)
+                else:
+                    audio = sr.AudioData(*mic.listen())
+                heard = time.perf_counter()
+                metrics.listen_seconds.observe(heard - started)
+                if recorder is not None:
+                    recorder.record_utterance(
+                        audio.get_raw_data(), audio.sample_rate, audio.sample_width, heard - started
+                    )
+
+                turn = scheduler.begin_turn(heard)
+                if snapshot is not None:
+                    snapshot.before_turn()  # restores, if needed, while STT runs
+                started = time.perf_counter()
+                if early_text is not None:
+                    text = early_text  # recognized while deciding the turn was over
+                    turn.stage("stt", variant="endpointer", seconds=0.0)
+                elif stt is not None:
+                    text = stt.transcribe()
+                    scheduler.observe_stt(STT_PRIMARY, time.perf_counter() - started)
+                else:
+                    text = transcribe(recognizer, audio, scheduler, turn)
+                metrics.record_transcript(text, time.perf_counter() - started)
+                if recorder is not None:
+                    recorder.record_transcript(text, time.perf_counter() - started)
+                if not text:
+                    continue
+                bus.set("dialogue", text)
+
+                match = router.route(text)
+                if turns is not None:
+                    match = replayed_match(turns.route(mic.turn), match, router.matcher)
+                if recorder is not None:
+                    if match is None:
+                        recorder.record_route("llm")
+                    else:
+                        recorder.record_route(match.name, match.numbers)
+                metrics.record_route(match.name if match is not None else "llm")
+                if match is not None:
+                    if not answer_locally(match, robot, speak_lock, bus, text_stream):
+                        break
+                    continue
+
+                # Send to LLM and stream the reply to the console
+                bus.set("app_state", APP_STATE_THINKING)
+                print("Sending to LLM (streaming)...")
+                think_filter = ThinkBlockFilter()
+                if text_stream is not None:
+                    text_stream.begin_turn()
+
+                def on_chunk(chunk: str) -> None:
+                    if text_stream is not None:
+                        text_stream.append(think_filter.feed(chunk))
+
+                plan = scheduler.plan_llm(turn)
+                # Replays have no fillers to plan but speak the recorded one, whose
+                # TTS and playback events come before the reply's.
+                filler = turns.filler(mic.turn) if turns is not None else plan.filler
+                if filler is not None:
+                    start_filler(robot, speak_lock, filler)
+                if snapshot is not None:
+                    snapshot.wait()
+                reply_chunks = stream_reply(clients, scheduler, turn, plan, text, system_messages, on_chunk)
+                if snapshot is not None:
+                    snapshot.after_turn()
+
+                if text_stream is not None:
+                    text_stream.append(think_filter.flush())
+                    text_stream.end_turn()
+
+                full_reply = "".join(reply_chunks)
+
+                # Remove <think>/<thinking> sections for both display and speech
+                cleaned_reply = strip_think_blocks(full_reply)
+
+                print(cleaned_reply)
+                print("Speaking reply...")
+                bus.set("dialogue", cleaned_reply)
+                bus.set("app_state", APP_STATE_SPEAKING)
+                with speak_lock:
+                    robot.speak(cleaned_reply)
+                metrics.turn_seconds.observe(time.perf_counter() - heard)
+            finally:
+                if turn is not None:
+                    report = scheduler.end_turn(turn)
+                    if recorder is not None:
+                        recorder.record(STREAM_TURN, "budget", report.as_dict())
+                if recorder is not None:
+                    recorder.end_turn()
 
     finally:
+        replay_stop.set()
+        if metrics_server is not None:
+            metrics_server.stop()
+        if text_stream is not None:
+            text_stream.close()
+        if twin is not None:
+            twin.stop()
         robot.cleanup()
+        if router.turns:
+            print(router.summary())
+        if recorder is not None:
+            recorder.close()
+            print(f"Session recorded to {args.record}: {SessionLog(args.record).summary()}")
 
 
 if __name__ == "__main__":
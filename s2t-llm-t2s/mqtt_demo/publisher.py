@@ -1,28 +1,49 @@
 import os
+import sys
 import time
-import json
+from pathlib import Path
+
 import paho.mqtt.client as mqtt
 
+# The streaming publisher lives in the repo-level `mqtt` package.
+REPO_ROOT = Path(__file__).resolve().parents[2]
+if str(REPO_ROOT) not in sys.path:
+    sys.path.append(str(REPO_ROOT))
+
+from mqtt.text_stream import TextStreamPublisher  # noqa: E402
+
 BROKER_HOST = os.environ.get("MQTT_HOST", "localhost")
 BROKER_PORT = int(os.environ.get("MQTT_PORT", "1883"))
 TOPIC = os.environ.get("MQTT_TOPIC", "llm/text")
+TOKENS_PER_SECOND = float(os.environ.get("TOKENS_PER_SECOND", "30"))
 
 
-def get_llm_text() -> str:
-    """Replace this with your actual LLM output."""
-    return "Hello from the LLM at " + time.strftime("%H:%M:%S")
+def get_llm_tokens():
+    """Replace this with your actual LLM token stream."""
+    reply = "Hello from the LLM at " + time.strftime("%H:%M:%S") + ". I am streaming this reply word by word."
+    for word in reply.split(" "):
+        yield word + " "
 
 
 def main():
     client = mqtt.Client()
     client.connect(BROKER_HOST, BROKER_PORT, keepalive=60)
-
-    while True:
-        text = get_llm_text()
-        payload = {"text": text, "ts": time.time()}
-        client.publish(TOPIC, json.dumps(payload), qos=0, retain=False)
-        print("published:", payload)
-        time.sleep(1)
+    client.loop_start()
+
+    stream = TextStreamPublisher(lambda topic, payload: client.publish(topic, payload, qos=0), topic=TOPIC)
+    try:
+        while True:
+            turn = stream.begin_turn()
+            for token in get_llm_tokens():
+                stream.append(token)
+                time.sleep(1.0 / TOKENS_PER_SECOND)
+            stream.end_turn()
+            print(f"published turn {turn}: {stream.stats().summary()}")
+            time.sleep(1)
+    finally:
+        stream.close()
+        client.loop_stop()
+        client.disconnect()
 
 
 if __name__ == "__main__":
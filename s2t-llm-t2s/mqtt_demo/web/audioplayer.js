@@ -0,0 +1,125 @@
+// Plays the robot's speech from `siggraph/<device>/audio`. Mirrors the wire
+// format in mqtt/audio_stream.py: 20-byte header + PCM s16le or Opus payload,
+// 48 kHz mono, 20 ms per frame, stamped with the Pi time the robot plays it.
+//
+// Jitter buffer: each utterance is scheduled on the AudioContext clock from
+// its first frame, and every later frame at base + seq * 20 ms, so network
+// jitter never reaches the speaker as long as frames beat their slot.
+// With a synced ClockSync the base is the robot's own play time (the Pi
+// sends frames ahead of playback), so the twin speaks in step with the
+// robot; otherwise frames play `targetDelay` after the first one arrives.
+// Frames that miss their slot are dropped and the delay grows for the next
+// utterance.
+
+const AUDIO_SAMPLE_RATE = 48000;
+const AUDIO_FRAME_S = 0.02;
+const AUDIO_HEADER_SIZE = 20;
+const AUDIO_CODEC_PCM16 = 0;
+const AUDIO_CODEC_OPUS = 1;
+
+class PiAudioPlayer {
+  constructor(clock = null, targetDelay = 0.08) {
+    this.clock = clock;
+    this.targetDelay = targetDelay;
+    this.maxDelay = 0.4;
+    this.ctx = null;
+    this.utterance = -1;
+    this.base = 0;            // AudioContext time of seq 0
+    this.decoder = null;      // WebCodecs AudioDecoder for Opus
+    this.pending = new Map(); // seq -> scheduled time, while Opus decodes
+    this.stats = { frames: 0, late: 0, bytes: 0, unsupported: 0, lagMs: null };
+  }
+
+  // Browsers only start audio after a user gesture: call from a click handler.
+  start() {
+    if (!this.ctx) this.ctx = new AudioContext({ sampleRate: AUDIO_SAMPLE_RATE });
+    return this.ctx.resume();
+  }
+
+  handle(payload) {
+    if (!this.ctx) return;
+    const view = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+    if (payload.byteLength < AUDIO_HEADER_SIZE || view.getUint8(0) !== 0x50 || view.getUint8(1) !== 0x41 ||
+        view.getUint8(2) !== 1) return;
+    const codec = view.getUint8(3);
+    const utterance = view.getUint16(4, true);
+    const seq = view.getUint32(6, true);
+    const playTime = view.getFloat64(10, true);
+    const samples = view.getUint16(18, true);
+    this.stats.bytes += payload.byteLength;
+
+    if (samples === 0) {  // end of utterance
+      this.utterance = -1;
+      return;
+    }
+    if (utterance !== this.utterance) this.beginUtterance(utterance, codec, seq, playTime);
+
+    const when = this.base + seq * AUDIO_FRAME_S;
+    if (when < this.ctx.currentTime) {
+      this.stats.late++;
+      this.targetDelay = Math.min(this.maxDelay, this.targetDelay + AUDIO_FRAME_S);
+      return;
+    }
+    this.stats.frames++;
+    const data = payload.subarray(AUDIO_HEADER_SIZE);
+    if (codec === AUDIO_CODEC_PCM16) {
+      const pcm = new Int16Array(data.slice().buffer, 0, samples);
+      const f32 = new Float32Array(samples);
+      for (let i = 0; i < samples; i++) f32[i] = pcm[i] / 32768;
+      this.play(f32, when);
+    } else if (codec === AUDIO_CODEC_OPUS && this.decoder) {
+      this.pending.set(seq, { when, samples });
+      this.decoder.decode(new EncodedAudioChunk({ type: "key", timestamp: seq * 20000, data }));
+    } else {
+      this.stats.unsupported++;
+    }
+  }
+
+  beginUtterance(utterance, codec, seq, playTime) {
+    this.utterance = utterance;
+    const now = this.ctx.currentTime;
+    let start = now + this.targetDelay;
+    if (this.clock && this.clock.synced) {
+      // Local moment the robot plays this frame, minus the output latency.
+      const inSeconds = this.clock.toLocal(playTime) - this.clock.now() - (this.ctx.outputLatency || 0);
+      start = Math.max(now + 0.01, now + inSeconds);
+      this.stats.lagMs = Math.round((start - now - inSeconds) * 1000);
+    }
+    this.base = start - seq * AUDIO_FRAME_S;
+    this.pending.clear();
+    if (codec === AUDIO_CODEC_OPUS && typeof AudioDecoder !== "undefined") {
+      if (!this.decoder) {
+        this.decoder = new AudioDecoder({
+          output: (audioData) => this.onDecoded(audioData),
+          error: () => this.stats.unsupported++,
+        });
+      } else {
+        this.decoder.reset();
+      }
+      this.decoder.configure({ codec: "opus", sampleRate: AUDIO_SAMPLE_RATE, numberOfChannels: 1 });
+    }
+  }
+
+  onDecoded(audioData) {
+    const seq = Math.round(audioData.timestamp / 20000);
+    const slot = this.pending.get(seq);
+    this.pending.delete(seq);
+    if (slot && slot.when >= this.ctx.currentTime) {
+      const f32 = new Float32Array(audioData.numberOfFrames);
+      audioData.copyTo(f32, { planeIndex: 0, format: "f32-planar" });
+      this.play(f32.subarray(0, slot.samples), slot.when);
+    } else if (slot) {
+      this.stats.late++;
+    }
+    audioData.close();
+  }
+
+  play(samples, when) {
+    const buffer = this.ctx.createBuffer(1, samples.length, AUDIO_SAMPLE_RATE);
+    buffer.copyToChannel(samples, 0);
+    const source = this.ctx.createBufferSource();
+    source.buffer = buffer;
+    source.connect(this.ctx.destination);
+    source.start(when);
+  }
+}
@@ -0,0 +1,69 @@
+// NTP-style clock sync with a robot over MQTT. Mirrors mqtt/clock_sync.py:
+// ping on `siggraph/<device>/clock/ping`, pong on
+// `siggraph/<device>/clock/pong/<id>`.
+// The local clock is performance.now() (monotonic), in seconds.
+
+const CLOCK_WINDOW = 16;
+
+class ClockSync {
+  constructor(clientId, device = "pi") {
+    this.clientId = clientId;
+    this.pingTopic = "siggraph/" + device + "/clock/ping";
+    this.pongTopic = "siggraph/" + device + "/clock/pong/" + clientId;
+    this.seq = 0;
+    this.outstanding = new Map();  // seq -> t0
+    this.samples = [];
+    this.best = null;
+  }
+
+  now() {
+    return performance.now() / 1000;
+  }
+
+  makePing() {
+    this.seq++;
+    const t0 = this.now();
+    this.outstanding.set(this.seq, t0);
+    if (this.outstanding.size > 64) {
+      this.outstanding.delete(this.outstanding.keys().next().value);
+    }
+    return JSON.stringify({ id: this.clientId, seq: this.seq, t0: t0 });
+  }
+
+  onPong(payload) {
+    const t3 = this.now();
+    const pong = JSON.parse(payload.toString());
+    const t0 = this.outstanding.get(pong.seq);
+    if (t0 === undefined) return null;
+    this.outstanding.delete(pong.seq);
+
+    const sample = {
+      offset: ((pong.t1 - t0) + (pong.t2 - t3)) / 2,
+      rtt: Math.max(0, (t3 - t0) - (pong.t2 - pong.t1)),
+    };
+    this.samples.push(sample);
+    if (this.samples.length > CLOCK_WINDOW) this.samples.shift();
+    // The lowest-RTT sample has the tightest error bound (rtt / 2).
+    this.best = this.samples.reduce((a, b) => (b.rtt < a.rtt ? b : a));
+    return sample;
+  }
+
+  get synced() {
+    return this.best !== null;
+  }
+
+  // The Pi's time.time() right now.
+  piTimeNow() {
+    return this.now() + this.best.offset;
+  }
+
+  // A Pi timestamp on this page's clock (seconds, performance.now() based).
+  toLocal(piTime) {
+    return piTime - this.best.offset;
+  }
+
+  // Seconds from the Pi stamping a sample (PiState.timestamp) to now.
+  oneWayLatency(piTimestamp) {
+    return this.piTimeNow() - piTimestamp;
+  }
+}
@@ -0,0 +1,72 @@
+// Decoder for the compact binary PiState frames published on
+// `siggraph/pi/state/bin`. Mirrors mqtt/state_codec.py (format version 1).
+
+const PISTATE_VERSION = 1;
+const PISTATE_FIXED_SIZE = 67;
+const PISTATE_APP_STATES = ["", "Idle", "Listening", "Thinking", "Speaking"];
+const PISTATE_APP_STATE_INLINE = 0xff;
+const PISTATE_FLOAT_FIELDS = [
+  "arm_pos_x", "arm_pos_y", "arm_pos_z",
+  "arm_rot_pitch", "arm_rot_yaw", "arm_rot_roll",
+  "head_pos_x", "head_pos_y", "head_pos_z",
+  "head_rot_pitch", "head_rot_yaw", "head_rot_roll",
+  "audio_level",
+];
+
+const PISTATE_FLAG_EYES_OPEN = 0x01;
+const PISTATE_FLAG_IS_SPEAKING = 0x02;
+const PISTATE_FLAG_APP_STATE_INLINE = 0x04;
+const PISTATE_FLAG_DIALOGUE_DEF = 0x08;
+
+class PiStateDecoder {
+  constructor() {
+    this.dialogues = new Map([[0, ""]]);
+    this.utf8 = new TextDecoder("utf-8");
+  }
+
+  // `bytes` is a Uint8Array (mqtt.js hands out Buffer, which is one).
+  decode(bytes) {
+    if (bytes.length < PISTATE_FIXED_SIZE) {
+      throw new Error("PiState frame too short: " + bytes.length + " bytes");
+    }
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    if (bytes[0] !== 0x50 || bytes[1] !== 0x53) {  // "PS"
+      throw new Error("Not a PiState frame");
+    }
+    const version = view.getUint8(2);
+    if (version !== PISTATE_VERSION) {
+      throw new Error("Unsupported PiState format version " + version);
+    }
+
+    const flags = view.getUint8(3);
+    const state = { timestamp: view.getFloat64(4, true) };
+    PISTATE_FLOAT_FIELDS.forEach((name, i) => {
+      state[name] = view.getFloat32(12 + i * 4, true);
+    });
+
+    const appStateCode = view.getUint8(64);
+    const dialogueId = view.getUint16(65, true);
+    let pos = PISTATE_FIXED_SIZE;
+
+    if (flags & PISTATE_FLAG_APP_STATE_INLINE) {
+      const n = view.getUint8(pos);
+      pos += 1;
+      state.app_state = this.utf8.decode(bytes.subarray(pos, pos + n));
+      pos += n;
+    } else {
+      state.app_state = PISTATE_APP_STATES[appStateCode] ?? "";
+    }
+
+    if (flags & PISTATE_FLAG_DIALOGUE_DEF) {
+      const n = view.getUint16(pos, true);
+      pos += 2;
+      this.dialogues.set(dialogueId, this.utf8.decode(bytes.subarray(pos, pos + n)));
+      pos += n;
+    }
+
+    state.dialogue = this.dialogues.get(dialogueId) ?? "";
+    state.eyes_open = (flags & PISTATE_FLAG_EYES_OPEN) !== 0;
+    state.is_speaking = (flags & PISTATE_FLAG_IS_SPEAKING) !== 0;
+    return state;
+  }
+}
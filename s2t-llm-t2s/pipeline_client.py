@@ -0,0 +1,261 @@
+"""Thin robot client for `pipeline_server.py`.
+
+Streams microphone (or WAV) audio to the server and plays the reply PCM
+as each sentence arrives; no models run on the robot. The server decides
+when the turn is over. Microphone audio captured while the reply plays is
+discarded, so the robot does not hear itself.
+
+Run from this directory:
+    python pipeline_client.py --server 192.168.1.20:8770 --robot robot-07       # microphone
+    python pipeline_client.py --server localhost:8770 --wav question.wav         # one turn from a file
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import queue
+import shutil
+import socket
+import subprocess
+import threading
+import time
+import wave
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Callable
+
+from pipeline_server import (
+    AUDIO,
+    BYE,
+    DEFAULT_PORT,
+    ERROR,
+    HELLO,
+    REPLY_PCM,
+    REPLY_TEXT,
+    TRANSCRIPT,
+    TURN_END,
+    WELCOME,
+    recv_frame,
+    send_frame,
+)
+
+CHUNK_S = 0.03
+PLAYER_LATENCY_S = 0.25  # aplay's buffer: audio plays on this long after the last write
+
+
+@dataclass
+class TurnResult:
+    transcript: str = ""
+    reply: str = ""
+    pcm: bytearray = field(default_factory=bytearray)
+    report: dict[str, Any] = field(default_factory=dict)
+    error: str | None = None
+
+
+class PipelineClient:
+    """One robot session. Frames from the server are read on a background thread."""
+
+    def __init__(self, host: str, port: int = DEFAULT_PORT, robot: str = "robot", sample_rate: int = 16000) -> None:
+        self.host = host
+        self.port = port
+        self.robot = robot
+        self.sample_rate = sample_rate
+        self.welcome: dict[str, Any] = {}
+        self.turns: queue.Queue = queue.Queue()  # a TurnResult per finished turn, None when closed
+        self.on_pcm: Callable[[bytes], None] | None = None  # called on the reader thread per REPLY_PCM frame
+        self._sock: socket.socket | None = None
+        self._send_lock = threading.Lock()
+        self._reader: threading.Thread | None = None
+
+    def connect(self, timeout: float = 10.0) -> "PipelineClient":
+        self._sock = socket.create_connection((self.host, self.port), timeout=timeout)
+        self._sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        send_frame(self._sock, HELLO, json.dumps({"robot": self.robot, "sample_rate": self.sample_rate}).encode())
+        frame = recv_frame(self._sock)
+        if frame is None or frame[0] != WELCOME:
+            raise ConnectionError("pipeline server did not answer HELLO")
+        self.welcome = json.loads(frame[1])
+        self._sock.settimeout(None)
+        self._reader = threading.Thread(target=self._read, name=f"client-{self.robot}", daemon=True)
+        self._reader.start()
+        return self
+
+    def send_audio(self, pcm: bytes) -> None:
+        with self._send_lock:
+            send_frame(self._sock, AUDIO, pcm)
+
+    def close(self) -> None:
+        if self._sock is None:
+            return
+        try:
+            with self._send_lock:
+                send_frame(self._sock, BYE)
+            self._sock.shutdown(socket.SHUT_WR)
+        except OSError:
+            pass
+        if self._reader is not None:
+            self._reader.join(timeout=5.0)
+        self._sock.close()
+        self._sock = None
+
+    def _read(self) -> None:
+        turn = TurnResult()
+        while (frame := recv_frame(self._sock)) is not None:
+            kind, payload = frame
+            if kind == TRANSCRIPT:
+                turn.transcript = payload.decode()
+            elif kind == REPLY_TEXT:
+                turn.reply += payload.decode()
+            elif kind == REPLY_PCM:
+                turn.pcm += payload
+                if self.on_pcm is not None:
+                    self.on_pcm(payload)
+            elif kind == ERROR:
+                turn.error = payload.decode()
+            elif kind == TURN_END:
+                turn.report = json.loads(payload)
+                self.turns.put(turn)
+                turn = TurnResult()
+        self.turns.put(None)
+
+
+def read_wav(path: str | Path) -> tuple[bytes, int]:
+    """PCM and sample rate of a 16-bit mono WAV file."""
+    with wave.open(str(path), "rb") as f:
+        if f.getsampwidth() != 2 or f.getnchannels() != 1:
+            raise ValueError(f"{path}: need 16-bit mono, got {f.getsampwidth() * 8}-bit x{f.getnchannels()}")
+        return f.readframes(f.getnframes()), f.getframerate()
+
+
+def stream_until_turn(client: PipelineClient, pcm: bytes, stop: threading.Event | None = None,
+                      realtime: bool = True, timeout: float = 60.0) -> TurnResult | None:
+    """Send `pcm` as a microphone would, then silence, until the server ends the turn."""
+    step = int(client.sample_rate * CHUNK_S) * 2
+    silence = bytes(step)
+    started = time.monotonic()
+    sent = 0
+    offset = 0
+    while stop is None or not stop.is_set():
+        try:
+            return client.turns.get_nowait()
+        except queue.Empty:
+            pass
+        if time.monotonic() - started > timeout:
+            return None
+        chunk = pcm[offset:offset + step] if offset < len(pcm) else silence
+        offset += step
+        client.send_audio(chunk)
+        sent += 1
+        if realtime:
+            delay = started + sent * CHUNK_S - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+    return None
+
+
+class PcmPlayer:
+    """Plays reply PCM as it arrives through one long-lived `aplay`.
+
+    Tracks when the queued audio will have finished playing, so the caller
+    can keep the microphone muted until then. With `device=False` nothing
+    is played and only the timing is kept (simulated robots).
+    """
+
+    def __init__(self, sample_rate: int, device: bool = True) -> None:
+        self.sample_rate = sample_rate
+        self._proc: subprocess.Popen | None = None
+        self._lock = threading.Lock()
+        self._until = 0.0  # monotonic time the queued audio ends
+        if device:
+            player = shutil.which("aplay")
+            if player is None:
+                print("aplay not found; replies are not played")
+            else:
+                self._proc = subprocess.Popen([player, "-q", "-f", "S16_LE", "-c", "1", "-r", str(sample_rate)],
+                                              stdin=subprocess.PIPE)
+
+    def write(self, pcm: bytes) -> None:
+        with self._lock:
+            start = max(self._until, time.monotonic() + (PLAYER_LATENCY_S if self._proc is not None else 0.0))
+            self._until = start + len(pcm) / 2 / self.sample_rate
+        if self._proc is not None:
+            try:
+                self._proc.stdin.write(pcm)
+                self._proc.stdin.flush()
+            except (BrokenPipeError, OSError):
+                self._proc = None
+
+    @property
+    def busy(self) -> bool:
+        return self._remaining() > 0
+
+    def wait(self, stop: threading.Event | None = None) -> None:
+        """Block until the queued audio has played (or `stop` is set)."""
+        while (remaining := self._remaining()) > 0:
+            if stop is None:
+                time.sleep(remaining)
+            elif stop.wait(remaining):
+                return
+
+    def _remaining(self) -> float:
+        with self._lock:
+            return self._until - time.monotonic()
+
+    def close(self) -> None:
+        if self._proc is not None:
+            self._proc.stdin.close()
+            self._proc.wait(timeout=5.0)
+            self._proc = None
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Talk to a pipeline server.")
+    parser.add_argument("--server", default=f"localhost:{DEFAULT_PORT}", help="host:port (default: %(default)s).")
+    parser.add_argument("--robot", default=socket.gethostname(), help="Robot id (default: host name).")
+    parser.add_argument("--wav", help="Send this 16-bit mono WAV as one turn instead of the microphone.")
+    args = parser.parse_args()
+    host, _, port = args.server.rpartition(":")
+
+    if args.wav:
+        pcm, rate = read_wav(args.wav)
+        client = PipelineClient(host, int(port), args.robot, rate).connect()
+        player = PcmPlayer(client.welcome["reply_sample_rate"])
+        client.on_pcm = player.write
+        turn = stream_until_turn(client, pcm)
+        if turn is not None:
+            print(f"You: {turn.transcript}\nRobot: {turn.reply}\n{turn.report}")
+            player.wait()
+        client.close()
+        player.close()
+        return
+
+    import speech_recognition as sr
+
+    client = PipelineClient(host, int(port), args.robot, 16000).connect()
+    player = PcmPlayer(client.welcome["reply_sample_rate"])
+    client.on_pcm = player.write
+    print(f"Connected to {args.server}. Speak; Ctrl-C to quit.")
+    try:
+        with sr.Microphone(sample_rate=16000) as source:
+            while True:
+                # Keep reading the mic so no stale audio piles up; drop it while the reply plays.
+                chunk = source.stream.read(source.CHUNK)
+                if not player.busy:
+                    client.send_audio(chunk)
+                try:
+                    turn = client.turns.get_nowait()
+                except queue.Empty:
+                    continue
+                if turn is None:
+                    break
+                print(f"You: {turn.transcript}\nRobot: {turn.reply}")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.close()
+        player.close()
+
+
+if __name__ == "__main__":
+    main()
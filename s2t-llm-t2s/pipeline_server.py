@@ -0,0 +1,883 @@
+"""Pipeline server: one STT / LLM / TTS host shared by many thin robot clients.
+
+Every robot running `main.py` loads its own models, which sit idle between
+turns. In server mode the robots only stream microphone audio here and get
+text and PCM back (`pipeline_client.py`); this process keeps one copy of
+each model and shares it between the sessions:
+
+- end of turn is detected here, per session, with the same `Endpointer` as
+  `main.py` (acoustic cues only: a partial transcript would cost a shared
+  STT run per pause);
+- each model is a `Stage`: a fixed number of workers (one per loaded model
+  instance or llama-server slot) fed by a `FairQueue`, which serves the
+  sessions round-robin so a robot with a long reply cannot hold up the
+  first sentence of another robot's turn;
+- STT is a `BatchStage`: utterances that end within `--stt-batch-wait-ms`
+  of each other are transcribed in one batched inference (`BatchConfig`);
+- the reply is cut into sentences as it streams from the LLM, and each
+  sentence is synthesized while the next is generated;
+- `SloTracker` records, per session, the time from end of turn to the first
+  reply audio and whether it met the SLO (`--slo`), as metrics and in each
+  turn's report.
+
+Wire protocol (TCP): frames of `!BI` (kind, payload length) + payload.
+
+    client -> server   HELLO {"robot": id, "sample_rate": 16000}, AUDIO s16le mono, BYE
+    server -> client   WELCOME {"reply_sample_rate": 48000, "slo_s": ...},
+                       TRANSCRIPT utf-8, REPLY_TEXT utf-8 delta, REPLY_PCM s16le mono,
+                       TURN_END {report}, ERROR utf-8
+
+Microphone audio received while a turn is being answered is dropped: the
+robot is about to speak, as in `main.py`.
+
+There is no authentication: the server listens on 127.0.0.1 unless
+`--host` says otherwise, and should only be opened to the robots' network.
+
+Run from this directory:
+    python pipeline_server.py --host 0.0.0.0 --llm-slots 2       # whisper + llama-server + gTTS, for the robots
+    python pipeline_server.py --port 8770 --engines sim          # simulated models
+    python loadtest_pipeline.py --robots 1 4 8 16 32             # capacity at the SLO
+"""
+
+from __future__ import annotations
+
+import argparse
+import ipaddress
+import json
+import math
+import os
+import queue
+import re
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+from array import array
+from collections import deque
+from concurrent.futures import Future
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from typing import Any, Callable, Iterator
+
+BASE_DIR = Path(__file__).resolve().parent
+for p in (BASE_DIR / "llm-app", BASE_DIR / "t2s1"):
+    if str(p) not in sys.path:
+        sys.path.insert(0, str(p))
+# `mqtt` and `telemetry` live at the repository root; appended so the
+# subproject modules above keep precedence.
+REPO_ROOT = BASE_DIR.parent
+if str(REPO_ROOT) not in sys.path:
+    sys.path.append(str(REPO_ROOT))
+
+from endpointing import Endpointer
+from mqtt.text_stream import ThinkBlockFilter
+from telemetry.instruments import LONG_BUCKETS
+from telemetry.metrics import MetricsHttpServer, Registry
+
+try:
+    from telemetry.ringlog import get_logger
+except ImportError:
+    from logging import getLogger as get_logger
+
+log = get_logger("Server")
+
+DEFAULT_PORT = 8770
+# Same format as the robots' audio stream (t2s1/audio_tee.py): 48 kHz mono s16le.
+REPLY_SAMPLE_RATE = 48000
+REPLY_CHUNK_BYTES = REPLY_SAMPLE_RATE // 10 * 2  # 100 ms per REPLY_PCM frame
+ENERGY_THRESHOLD = 300.0
+
+# Frame kinds
+HELLO, AUDIO, BYE = 1, 2, 3
+WELCOME, TRANSCRIPT, REPLY_TEXT, REPLY_PCM, TURN_END, ERROR = 10, 11, 12, 13, 14, 15
+
+HEADER = struct.Struct("!BI")
+MAX_FRAME_BYTES = 1 << 22
+
+
+def send_frame(sock: socket.socket, kind: int, payload: bytes = b"") -> None:
+    sock.sendall(HEADER.pack(kind, len(payload)) + payload)
+
+
+def recv_frame(sock: socket.socket) -> tuple[int, bytes] | None:
+    """Next frame, or None when the peer closed the connection."""
+    header = _recv_exact(sock, HEADER.size)
+    if header is None:
+        return None
+    kind, length = HEADER.unpack(header)
+    if length > MAX_FRAME_BYTES:
+        raise ValueError(f"frame of {length} bytes")
+    payload = _recv_exact(sock, length) if length else b""
+    return None if payload is None else (kind, payload)
+
+
+def _recv_exact(sock: socket.socket, n: int) -> bytes | None:
+    buf = bytearray()
+    while len(buf) < n:
+        try:
+            chunk = sock.recv(n - len(buf))
+        except (ConnectionError, OSError):
+            return None
+        if not chunk:
+            return None
+        buf += chunk
+    return bytes(buf)
+
+
+# Fair scheduling -----------------------------------------------------------------
+
+
+class FairQueue:
+    """Jobs queued per session and handed out round-robin across sessions."""
+
+    def __init__(self) -> None:
+        self._jobs: dict[str, deque] = {}
+        self._order: deque[str] = deque()  # sessions with jobs, next first
+        self._cond = threading.Condition()
+        self._closed = False
+
+    def put(self, session: str, job: Any) -> None:
+        with self._cond:
+            jobs = self._jobs.get(session)
+            if jobs is None:
+                jobs = self._jobs[session] = deque()
+                self._order.append(session)
+            jobs.append(job)
+            self._cond.notify()
+
+    def get(self, timeout: float | None = None) -> Any | None:
+        """The next session's oldest job; None once closed or after `timeout` seconds."""
+        with self._cond:
+            if not self._cond.wait_for(lambda: self._order or self._closed, timeout):
+                return None
+            if not self._order:
+                return None
+            session = self._order.popleft()
+            jobs = self._jobs[session]
+            job = jobs.popleft()
+            if jobs:
+                self._order.append(session)
+            else:
+                del self._jobs[session]
+            return job
+
+    def close(self) -> None:
+        with self._cond:
+            self._closed = True
+            self._cond.notify_all()
+
+    def __len__(self) -> int:
+        with self._cond:
+            return sum(len(jobs) for jobs in self._jobs.values())
+
+
+class Stage:
+    """One shared model: a worker thread per engine instance behind a `FairQueue`."""
+
+    def __init__(self, name: str, engines: list[Any], metrics: "_ServerMetrics") -> None:
+        if not engines:
+            raise ValueError(f"stage {name} needs at least one engine")
+        self.name = name
+        self.queue = FairQueue()
+        self._wait = metrics.queue_seconds.labels(name)
+        self._busy = metrics.busy_seconds.labels(name)
+        self._threads = [
+            threading.Thread(target=self._work, args=(engine,), name=f"{name}-{i}", daemon=True)
+            for i, engine in enumerate(engines)
+        ]
+        for t in self._threads:
+            t.start()
+
+    def submit(self, session: str, job: Callable[[Any], Any]) -> Future:
+        """Run `job(engine)` on the next free engine, in the session's turn."""
+        future: Future = Future()
+        self.queue.put(session, (job, future, time.perf_counter()))
+        return future
+
+    def _work(self, engine: Any) -> None:
+        while (item := self.queue.get()) is not None:
+            job, future, queued = item
+            started = time.perf_counter()
+            self._wait.observe(started - queued)
+            if not future.set_running_or_notify_cancel():
+                continue
+            try:
+                future.set_result(job(engine))
+            except BaseException as exc:  # noqa: BLE001 - handed to the session
+                future.set_exception(exc)
+            finally:
+                self._busy.inc(time.perf_counter() - started)
+
+    def close(self) -> None:
+        self.queue.close()
+
+
+@dataclass
+class BatchConfig:
+    """How a `BatchStage` forms batches.
+
+    max_batch:    items per inference (1 = one at a time)
+    max_wait_s:   longest an item waits for others to join its batch; the
+                  window opens when the item is queued, so items that queued
+                  while the model was busy do not wait again
+    max_padding:  padding allowed in a batch, as a share of its real audio;
+                  items too far from the first one's length go in a later batch
+    """
+
+    max_batch: int = 8
+    max_wait_s: float = 0.05
+    max_padding: float = 0.5
+
+
+class BatchStage:
+    """Like `Stage`, but each worker runs `run(engine, items)` on up to `max_batch` items at once.
+
+    The first item of a batch is the `FairQueue`'s pick; more are taken (in
+    the same round-robin order) until the batch is full or the first item
+    has waited `max_wait_s`. The engine pads every item to the batch's
+    longest, so items whose `padded(item)` length would push the padding
+    past `max_padding` are put back, ahead of the queue, for the next batch.
+    """
+
+    def __init__(self, name: str, engines: list[Any], metrics: "_ServerMetrics", config: BatchConfig,
+                 run: Callable[[Any, list], list], padded: Callable[[Any], float]) -> None:
+        if not engines:
+            raise ValueError(f"stage {name} needs at least one engine")
+        self.name = name
+        self.config = config
+        self.queue = FairQueue()
+        self._run = run
+        self._padded = padded
+        self._held: deque = deque()  # jobs cut from a batch, served before the queue
+        self._held_lock = threading.Lock()
+        self._wait = metrics.queue_seconds.labels(name)
+        self._busy = metrics.busy_seconds.labels(name)
+        self._size = metrics.batch_size.labels(name)
+        self._threads = [
+            threading.Thread(target=self._work, args=(engine,), name=f"{name}-{i}", daemon=True)
+            for i, engine in enumerate(engines)
+        ]
+        for t in self._threads:
+            t.start()
+
+    def submit(self, session: str, item: Any) -> Future:
+        """Queue `item` for the next batch; the future gets its own result."""
+        future: Future = Future()
+        self.queue.put(session, (item, future, time.perf_counter()))
+        return future
+
+    def _next(self, timeout: float | None) -> tuple | None:
+        with self._held_lock:
+            if self._held:
+                return self._held.popleft()
+        return self.queue.get(timeout)
+
+    def collect(self) -> list[tuple]:
+        """The next batch of (item, future, queued) jobs; empty once closed."""
+        first = self._next(None)
+        if first is None:
+            return []
+        batch = [first]
+        deadline = first[2] + self.config.max_wait_s
+        while len(batch) < self.config.max_batch:
+            job = self._next(max(0.0, deadline - time.perf_counter()))
+            if job is None:
+                break
+            batch.append(job)
+        kept, cut = self.fit(batch)
+        if cut:
+            with self._held_lock:
+                self._held.extendleft(reversed(cut))
+        return kept
+
+    def fit(self, batch: list[tuple]) -> tuple[list[tuple], list[tuple]]:
+        """Split `batch` into the jobs to run now (the first one always) and those to put back.
+
+        Jobs closest in padded length to the first join it while the batch's
+        padding stays within `max_padding` of its real length.
+        """
+        first = self._padded(batch[0][0])
+        rest = sorted(batch[1:], key=lambda job: abs(self._padded(job[0]) - first))
+        kept, cut = [batch[0]], []
+        total = longest = first
+        for job in rest:
+            seconds = self._padded(job[0])
+            if max(longest, seconds) * (len(kept) + 1) <= (1.0 + self.config.max_padding) * (total + seconds):
+                kept.append(job)
+                total += seconds
+                longest = max(longest, seconds)
+            else:
+                cut.append(job)
+        cut.sort(key=lambda job: job[2])
+        return kept, cut
+
+    def _work(self, engine: Any) -> None:
+        while batch := self.collect():
+            started = time.perf_counter()
+            for _, _, queued in batch:
+                self._wait.observe(started - queued)
+            batch = [job for job in batch if job[1].set_running_or_notify_cancel()]
+            if not batch:
+                continue
+            self._size.observe(len(batch))
+            try:
+                results = self._run(engine, [item for item, _, _ in batch])
+            except BaseException as exc:  # noqa: BLE001 - handed to the sessions
+                for _, future, _ in batch:
+                    future.set_exception(exc)
+            else:
+                for (_, future, _), result in zip(batch, results):
+                    future.set_result(result)
+            finally:
+                self._busy.inc(time.perf_counter() - started)
+
+    def close(self) -> None:
+        self.queue.close()
+
+
+# Engines -----------------------------------------------------------------------------
+
+
+@dataclass
+class Engines:
+    """Model instances per stage; a stage runs as many jobs at once as it has instances.
+
+    stt:  `transcribe(pcm, sample_rate) -> str`; optionally `transcribe_batch([(pcm, rate), ...])`
+          and `padded_seconds(seconds)`, the input length it pads an utterance to
+    llm:  `chat_stream(prompt, history, max_tokens=...)`, as in `main.py`
+    tts:  `synthesize(text) -> bytes` (s16le mono at REPLY_SAMPLE_RATE)
+    """
+
+    stt: list[Any]
+    llm: list[Any]
+    tts: list[Any]
+
+
+class WhisperStt:
+    def __init__(self, model: str = "base.en") -> None:
+        import numpy
+        import whisper
+
+        self._np = numpy
+        self._whisper = whisper
+        self.model = whisper.load_model(model)
+
+    def _audio(self, pcm: bytes, sample_rate: int):
+        np = self._np
+        audio = np.frombuffer(pcm, dtype=np.int16).astype(np.float32) / 32768.0
+        if sample_rate != 16000:  # whisper expects 16 kHz
+            positions = np.arange(0, len(audio), sample_rate / 16000.0)
+            audio = np.interp(positions, np.arange(len(audio)), audio).astype(np.float32)
+        return audio
+
+    def transcribe(self, pcm: bytes, sample_rate: int) -> str:
+        return self.model.transcribe(self._audio(pcm, sample_rate), fp16=False, language="en")["text"].strip()
+
+    def transcribe_batch(self, items: list[tuple[bytes, int]]) -> list[str]:
+        """One decoder pass over all utterances (each up to 30 s; longer ones are cut)."""
+        import torch
+
+        whisper = self._whisper
+        mels = [
+            whisper.log_mel_spectrogram(whisper.pad_or_trim(self._audio(pcm, rate)), self.model.dims.n_mels)
+            for pcm, rate in items
+        ]
+        options = whisper.DecodingOptions(language="en", fp16=False, without_timestamps=True)
+        results = whisper.decode(self.model, torch.stack(mels).to(self.model.device), options)
+        return [r.text.strip() for r in results]
+
+    def padded_seconds(self, seconds: float) -> float:
+        return 30.0  # every window is padded to 30 s: any lengths batch together
+
+
+class GttsPcm:
+    """gTTS, decoded to PCM with ffmpeg."""
+
+    def synthesize(self, text: str) -> bytes:
+        from tts_service import synthesize_to_bytes  # t2s1/tts_service.py
+
+        cmd = ["ffmpeg", "-loglevel", "error", "-i", "-", "-f", "s16le", "-ac", "1", "-ar", str(REPLY_SAMPLE_RATE), "-"]
+        return subprocess.run(cmd, input=synthesize_to_bytes(text), capture_output=True, check=True).stdout
+
+
+def real_engines(whisper_model: str, llm_slots: int, tts_workers: int) -> Engines:
+    """One Whisper model, one LLM client per llama-server slot (or the embedded model), gTTS."""
+    model_path = os.environ.get("LLM_MODEL_PATH", "")
+    if model_path:
+        from embedded import EmbeddedLlamaClient  # llm-app/embedded.py
+
+        llm = [EmbeddedLlamaClient(model_path)]  # one context: one reply at a time
+    else:
+        from app import LlamaServerClient  # llm-app/app.py
+
+        base_url = os.environ.get("LLM_BASE_URL", "http://localhost:8080")
+        llm = [LlamaServerClient(base_url=base_url, slot=i) for i in range(llm_slots)]
+    return Engines(stt=[WhisperStt(whisper_model)], llm=llm, tts=[GttsPcm() for _ in range(tts_workers)])
+
+
+@dataclass
+class SimCosts:
+    """Service times of the simulated models (seconds)."""
+
+    stt_base_s: float = 0.05
+    stt_per_audio_s: float = 0.08  # Whisper base.en on a small GPU
+    stt_batch_marginal: float = 0.2  # each extra utterance in a batch, as a share of one alone
+    llm_first_token_s: float = 0.35
+    llm_tokens_per_s: float = 25.0
+    reply_words: int = 24
+    tts_base_s: float = 0.15
+    tts_per_char_s: float = 0.002
+    speech_chars_per_s: float = 14.0  # length of the synthesized audio
+
+
+SIM_REPLY = ("Lafufu thinks that is a fine question. The short answer is yes, mostly. "
+             "Lafufu would add that rendering is just light bouncing around until it gets bored. "
+             "Ask again if you want the long version.").split()
+
+
+class SimStt:
+    def __init__(self, costs: SimCosts) -> None:
+        self.costs = costs
+
+    def transcribe(self, pcm: bytes, sample_rate: int) -> str:
+        seconds = len(pcm) / 2 / sample_rate
+        time.sleep(self.costs.stt_base_s + self.costs.stt_per_audio_s * seconds)
+        return f"simulated utterance of {seconds:.1f} seconds"
+
+    def transcribe_batch(self, items: list[tuple[bytes, int]]) -> list[str]:
+        """One pass padded to the longest utterance; extra rows cost `stt_batch_marginal` each."""
+        longest = max(len(pcm) / 2 / rate for pcm, rate in items)
+        c = self.costs
+        time.sleep(c.stt_base_s + c.stt_per_audio_s * longest * (1.0 + c.stt_batch_marginal * (len(items) - 1)))
+        return [f"simulated utterance of {len(pcm) / 2 / rate:.1f} seconds" for pcm, rate in items]
+
+
+class SimLlm:
+    def __init__(self, costs: SimCosts) -> None:
+        self.costs = costs
+
+    def chat_stream(self, prompt: str, history: list | None = None, max_tokens: int | None = None, **_: Any) -> Iterator[str]:
+        words = SIM_REPLY[: min(self.costs.reply_words, max_tokens or self.costs.reply_words)]
+        time.sleep(self.costs.llm_first_token_s)
+        for i, word in enumerate(words):
+            if i:
+                time.sleep(1.0 / self.costs.llm_tokens_per_s)
+            yield word if i == 0 else " " + word
+
+
+class SimTts:
+    def __init__(self, costs: SimCosts) -> None:
+        self.costs = costs
+
+    def synthesize(self, text: str) -> bytes:
+        time.sleep(self.costs.tts_base_s + self.costs.tts_per_char_s * len(text))
+        n = int(len(text) / self.costs.speech_chars_per_s * REPLY_SAMPLE_RATE)
+        step = 2.0 * math.pi * 220.0 / REPLY_SAMPLE_RATE
+        return array("h", (int(2000 * math.sin(step * i)) for i in range(n))).tobytes()
+
+
+def sim_engines(costs: SimCosts | None = None, stt_workers: int = 1, llm_slots: int = 2, tts_workers: int = 2) -> Engines:
+    costs = costs or SimCosts()
+    return Engines(
+        stt=[SimStt(costs) for _ in range(stt_workers)],
+        llm=[SimLlm(costs) for _ in range(llm_slots)],
+        tts=[SimTts(costs) for _ in range(tts_workers)],
+    )
+
+
+def transcribe_all(stt: Any, items: list[tuple[bytes, int]]) -> list[str]:
+    """`stt.transcribe_batch(items)`, or one at a time for engines without it."""
+    if len(items) > 1 and hasattr(stt, "transcribe_batch"):
+        return stt.transcribe_batch(items)
+    return [stt.transcribe(pcm, rate) for pcm, rate in items]
+
+
+def stt_stage(engines: list[Any], metrics: "_ServerMetrics", config: BatchConfig) -> BatchStage:
+    """A `BatchStage` of `(pcm, sample_rate)` items over STT engines."""
+    pad = getattr(engines[0], "padded_seconds", lambda seconds: seconds)
+    return BatchStage("stt", engines, metrics, config, run=transcribe_all,
+                      padded=lambda item: pad(len(item[0]) / 2 / item[1]))
+
+
+# Turns ----------------------------------------------------------------------------
+
+
+class SentenceSplitter:
+    """Cuts streamed text into sentences, so each can be synthesized while the next streams."""
+
+    _END = re.compile(r"(?<=[.!?])\s+")
+
+    def __init__(self, min_chars: int = 12) -> None:
+        self.min_chars = min_chars
+        self._buf = ""
+
+    def feed(self, text: str) -> list[str]:
+        self._buf += text
+        out = []
+        start = 0
+        for m in self._END.finditer(self._buf):
+            if m.start() - start >= self.min_chars:  # "Dr." or "1." alone is not a sentence
+                out.append(self._buf[start:m.start()].strip())
+                start = m.end()
+        self._buf = self._buf[start:]
+        return out
+
+    def flush(self) -> list[str]:
+        rest, self._buf = self._buf.strip(), ""
+        return [rest] if rest else []
+
+
+@dataclass
+class TurnReport:
+    """Seconds from end of turn (the endpointer's decision) to each step."""
+
+    robot: str
+    turn: int
+    utterance_s: float
+    transcript_s: float
+    first_text_s: float | None = None
+    first_audio_s: float | None = None
+    done_s: float = 0.0
+    reply_audio_s: float = 0.0
+    slo_met: bool = False
+    error: str | None = None
+
+    def as_dict(self) -> dict[str, Any]:
+        return asdict(self)
+
+
+class _ServerMetrics:
+    def __init__(self, registry: Registry) -> None:
+        r = registry
+        self.sessions = r.gauge("pipeline_sessions", "Connected robot sessions")
+        self.queue_seconds = r.histogram("pipeline_queue_seconds", "Wait for a free model instance", ["stage"])
+        self.busy_seconds = r.counter("pipeline_busy_seconds_total", "Time model instances spent on jobs", ["stage"])
+        self.batch_size = r.histogram("pipeline_batch_size", "Jobs per batched inference", ["stage"],
+                                      buckets=(1, 2, 3, 4, 6, 8, 12, 16))
+        self.first_audio = r.histogram("pipeline_first_audio_seconds", "End of turn to first reply audio",
+                                       ["robot"], buckets=LONG_BUCKETS)
+        self.turns = r.counter("pipeline_turns_total", "Turns answered", ["robot"])
+        self.slo_missed = r.counter("pipeline_slo_missed_total", "Turns whose first audio missed the SLO", ["robot"])
+        self.errors = r.counter("pipeline_turn_errors_total", "Turns that failed", ["robot"])
+
+
+class SloTracker:
+    """Per-session first-audio latency against the SLO."""
+
+    def __init__(self, slo_s: float, metrics: _ServerMetrics) -> None:
+        self.slo_s = slo_s
+        self._metrics = metrics
+        self._lock = threading.Lock()
+        self._first_audio: dict[str, list[float]] = {}
+        self._missed: dict[str, int] = {}
+
+    def record(self, report: TurnReport) -> None:
+        m = self._metrics
+        robot = report.robot
+        latency = report.first_audio_s if report.first_audio_s is not None else report.done_s
+        report.slo_met = report.error is None and latency <= self.slo_s
+        m.turns.labels(robot).inc()
+        m.first_audio.labels(robot).observe(latency)
+        if report.error is not None:
+            m.errors.labels(robot).inc()
+        if not report.slo_met:
+            m.slo_missed.labels(robot).inc()
+        with self._lock:
+            self._first_audio.setdefault(robot, []).append(latency)
+            self._missed[robot] = self._missed.get(robot, 0) + (not report.slo_met)
+
+    def summary(self) -> dict[str, dict[str, float]]:
+        """Per robot: turns, p50 / p95 first audio and the share of turns within the SLO."""
+        with self._lock:
+            out = {}
+            for robot, values in sorted(self._first_audio.items()):
+                ordered = sorted(values)
+                out[robot] = {
+                    "turns": len(values),
+                    "p50": ordered[len(ordered) // 2],
+                    "p95": ordered[min(len(ordered) - 1, int(len(ordered) * 0.95))],
+                    "attainment": 1.0 - self._missed[robot] / len(values),
+                }
+            return out
+
+
+class Session:
+    """One robot connection: reader (endpointing), turn driver and writer threads."""
+
+    def __init__(self, server: "PipelineServer", conn: socket.socket, address: tuple) -> None:
+        self.server = server
+        self.conn = conn
+        self.robot = f"{address[0]}:{address[1]}"
+        self.sample_rate = 16000
+        self.turns = 0
+        self._outbox: queue.Queue = queue.Queue()
+        self._utterances: queue.Queue = queue.Queue()
+        self._busy = threading.Event()
+
+    def send(self, kind: int, payload: bytes = b"") -> None:
+        self._outbox.put((kind, payload))
+
+    def run(self) -> None:
+        frame = recv_frame(self.conn)
+        if frame is None or frame[0] != HELLO:
+            self.conn.close()
+            return
+        hello = json.loads(frame[1] or b"{}")
+        self.robot = str(hello.get("robot") or self.robot)
+        self.sample_rate = int(hello.get("sample_rate", self.sample_rate))
+        writer = threading.Thread(target=self._write, name=f"send-{self.robot}", daemon=True)
+        driver = threading.Thread(target=self._drive, name=f"turns-{self.robot}", daemon=True)
+        writer.start()
+        driver.start()
+        self.send(WELCOME, json.dumps({"reply_sample_rate": REPLY_SAMPLE_RATE, "slo_s": self.server.slo.slo_s}).encode())
+        log.info("Robot %s connected (%d Hz)", self.robot, self.sample_rate)
+        try:
+            self._read()
+        finally:
+            self._utterances.put(None)
+            driver.join()
+            self._outbox.put(None)
+            writer.join(timeout=5.0)
+            self.conn.close()
+            log.info("Robot %s disconnected after %d turns", self.robot, self.turns)
+
+    def _new_endpointer(self) -> Endpointer:
+        return Endpointer(self.sample_rate, energy_threshold=self.server.energy_threshold, partial=None)
+
+    def _read(self) -> None:
+        endpointer = self._new_endpointer()
+        while (frame := recv_frame(self.conn)) is not None:
+            kind, payload = frame
+            if kind == BYE:
+                break
+            if kind != AUDIO:
+                continue
+            if self._busy.is_set():
+                continue  # answering: the robot is about to speak
+            if endpointer.feed(payload):
+                self._busy.set()
+                self._utterances.put((endpointer.audio, time.perf_counter()))
+                endpointer = self._new_endpointer()
+
+    def _write(self) -> None:
+        while (item := self._outbox.get()) is not None:
+            try:
+                send_frame(self.conn, *item)
+            except OSError:
+                return
+
+    def _drive(self) -> None:
+        while (item := self._utterances.get()) is not None:
+            audio, ended = item
+            self.turns += 1
+            report = TurnReport(self.robot, self.turns, len(audio) / 2 / self.sample_rate, 0.0)
+            try:
+                self._turn(audio, ended, report)
+            except Exception as exc:  # noqa: BLE001 - one failed turn must not end the session
+                report.error = f"{type(exc).__name__}: {exc}"
+                self.send(ERROR, report.error.encode())
+                log.warning("Robot %s turn %d failed: %s", self.robot, self.turns, report.error)
+            report.done_s = time.perf_counter() - ended
+            if report.transcript_s or report.error:  # empty transcripts are not turns
+                self.server.slo.record(report)
+            self.send(TURN_END, json.dumps(report.as_dict()).encode())
+            self._busy.clear()
+
+    def _turn(self, audio: bytes, ended: float, report: TurnReport) -> None:
+        server = self.server
+        rate = self.sample_rate
+        text = server.stt.submit(self.robot, (audio, rate)).result()
+        self.send(TRANSCRIPT, (text or "").encode())
+        if not text:
+            return
+        report.transcript_s = time.perf_counter() - ended
+
+        sentences: queue.Queue = queue.Queue()  # TTS futures in reply order, then None
+
+        def speak(sentence: str) -> None:
+            sentences.put(server.tts.submit(self.robot, lambda tts: tts.synthesize(sentence)))
+
+        def generate(llm: Any) -> None:
+            think, splitter = ThinkBlockFilter(), SentenceSplitter()
+            for chunk in llm.chat_stream(prompt=text, history=server.history, max_tokens=server.max_tokens):
+                visible = think.feed(chunk)
+                if not visible:
+                    continue
+                if report.first_text_s is None:
+                    report.first_text_s = time.perf_counter() - ended
+                self.send(REPLY_TEXT, visible.encode())
+                for sentence in splitter.feed(visible):
+                    speak(sentence)
+            tail = think.flush()
+            if tail:
+                self.send(REPLY_TEXT, tail.encode())
+            for sentence in splitter.feed(tail) + splitter.flush():
+                speak(sentence)
+
+        reply = server.llm.submit(self.robot, generate)
+        reply.add_done_callback(lambda _: sentences.put(None))
+        samples = 0
+        while (future := sentences.get()) is not None:
+            pcm = future.result()
+            if report.first_audio_s is None and pcm:
+                report.first_audio_s = time.perf_counter() - ended
+            for offset in range(0, len(pcm), REPLY_CHUNK_BYTES):
+                self.send(REPLY_PCM, pcm[offset:offset + REPLY_CHUNK_BYTES])
+            samples += len(pcm) // 2
+        reply.result()  # re-raise an LLM error
+        report.reply_audio_s = samples / REPLY_SAMPLE_RATE
+
+
+class PipelineServer:
+    def __init__(
+        self,
+        engines: Engines,
+        host: str = "127.0.0.1",
+        port: int = DEFAULT_PORT,
+        history: list | None = None,
+        slo_s: float = 2.0,
+        max_tokens: int = 160,
+        energy_threshold: float = ENERGY_THRESHOLD,
+        registry: Registry | None = None,
+        stt_batch: BatchConfig | None = None,
+    ) -> None:
+        self.registry = registry or Registry()
+        self.metrics = _ServerMetrics(self.registry)
+        self.stt = stt_stage(engines.stt, self.metrics, stt_batch or BatchConfig())
+        self.llm = Stage("llm", engines.llm, self.metrics)
+        self.tts = Stage("tts", engines.tts, self.metrics)
+        self.history = history
+        self.max_tokens = max_tokens
+        self.energy_threshold = energy_threshold
+        self.slo = SloTracker(slo_s, self.metrics)
+        self._listener = socket.create_server((host, port))
+        self._sessions: set[Session] = set()
+        self._lock = threading.Lock()
+        self._thread: threading.Thread | None = None
+        self._stopping = False
+
+    @property
+    def address(self) -> tuple[str, int]:
+        return self._listener.getsockname()[:2]
+
+    @property
+    def session_count(self) -> int:
+        with self._lock:
+            return len(self._sessions)
+
+    def start(self) -> "PipelineServer":
+        self._thread = threading.Thread(target=self.serve_forever, name="pipeline-accept", daemon=True)
+        self._thread.start()
+        return self
+
+    def serve_forever(self) -> None:
+        while not self._stopping:
+            try:
+                conn, address = self._listener.accept()
+            except OSError:
+                break
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            session = Session(self, conn, address)
+            threading.Thread(target=self._serve, args=(session,), name="session", daemon=True).start()
+
+    def _serve(self, session: Session) -> None:
+        with self._lock:
+            self._sessions.add(session)
+            self.metrics.sessions.set(len(self._sessions))
+        try:
+            session.run()
+        finally:
+            with self._lock:
+                self._sessions.discard(session)
+                self.metrics.sessions.set(len(self._sessions))
+
+    def stop(self) -> None:
+        self._stopping = True
+        self._listener.close()
+        with self._lock:
+            sessions = list(self._sessions)
+        for session in sessions:
+            try:
+                session.conn.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+        for stage in (self.stt, self.llm, self.tts):
+            stage.close()
+
+    def summary(self) -> str:
+        lines = [f"SLO: first audio within {self.slo.slo_s:.1f} s of end of turn"]
+        for robot, s in self.slo.summary().items():
+            lines.append(f"  {robot:<16} {s['turns']:4d} turns, first audio p50 {s['p50'] * 1000:6.0f} ms, "
+                         f"p95 {s['p95'] * 1000:6.0f} ms, within SLO {s['attainment']:.0%}")
+        return "\n".join(lines)
+
+
+def load_history() -> list | None:
+    """`system_prompt.json` as the history every session's prompt starts with (as in `main.py`)."""
+    path = BASE_DIR / "system_prompt.json"
+    if not path.exists():
+        return None
+    content = json.loads(path.read_text(encoding="utf-8"))["content"]
+    return [SystemMessage("system", content)]
+
+
+@dataclass
+class SystemMessage:
+    """Same shape as llm-app's `Message`, without importing `requests` in sim mode."""
+
+    role: str
+    content: str
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Serve STT -> LLM -> TTS to many robot clients.")
+    parser.add_argument("--host", default="127.0.0.1",
+                        help="Listen address; 0.0.0.0 opens the unauthenticated server to the network "
+                             "(default: %(default)s).")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT, help="Listen port (default: %(default)s).")
+    parser.add_argument("--engines", choices=("real", "sim"), default="real",
+                        help="real = Whisper + LLM_BASE_URL/LLM_MODEL_PATH + gTTS; sim = simulated (default: %(default)s).")
+    parser.add_argument("--whisper-model", default="base.en", help="Whisper model (default: %(default)s).")
+    parser.add_argument("--llm-slots", type=int, default=2,
+                        help="Replies generated at once; match llama-server's -np (default: %(default)s).")
+    parser.add_argument("--tts-workers", type=int, default=4, help="Sentences synthesized at once (default: %(default)s).")
+    parser.add_argument("--slo", type=float, default=2.0, help="First-audio SLO in seconds (default: %(default)s).")
+    parser.add_argument("--max-tokens", type=int, default=160, help="Reply cap (default: %(default)s).")
+    parser.add_argument("--stt-batch", type=int, default=8,
+                        help="Utterances per Whisper pass, 1 = one at a time (default: %(default)s).")
+    parser.add_argument("--stt-batch-wait-ms", type=float, default=50.0,
+                        help="Longest an utterance waits for others to batch with (default: %(default)s).")
+    parser.add_argument("--metrics-port", type=int, default=0, help="Prometheus endpoint, 0 = off (default: %(default)s).")
+    return parser.parse_args()
+
+
+def main() -> None:
+    args = parse_args()
+    if not ipaddress.ip_address(socket.gethostbyname(args.host)).is_loopback:
+        log.warning("Listening on %s without authentication: any host that can reach it can use the models",
+                    args.host)
+    if args.engines == "sim":
+        engines = sim_engines(llm_slots=args.llm_slots, tts_workers=args.tts_workers)
+    else:
+        engines = real_engines(args.whisper_model, args.llm_slots, args.tts_workers)
+    server = PipelineServer(engines, args.host, args.port, history=load_history(), slo_s=args.slo,
+                            max_tokens=args.max_tokens,
+                            stt_batch=BatchConfig(args.stt_batch, args.stt_batch_wait_ms / 1000.0))
+    metrics_server = MetricsHttpServer(server.registry, port=args.metrics_port).start() if args.metrics_port else None
+    print(f"Serving on {args.host}:{server.address[1]} "
+          f"(stt x{len(engines.stt)}, llm x{len(engines.llm)}, tts x{len(engines.tts)})")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.stop()
+        if metrics_server is not None:
+            metrics_server.stop()
+        print(server.summary())
+
+
+if __name__ == "__main__":
+    main()
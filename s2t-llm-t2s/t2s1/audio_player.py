@@ -3,6 +3,7 @@ from __future__ import annotations
 from pathlib import Path
 from typing import Iterable, Union
 import os
+import re
 import shutil
 import subprocess
 
@@ -99,3 +100,24 @@ def play_audio_blocking(path: Union[str, Path]) -> None:
             f"Audio player '{player}' exited with status {exc.returncode} "
             f"while playing {audio_path!s}"
         ) from exc
+
+
+def set_output_volume(percent: int | None = None, step: int = 0) -> int | None:
+    """Set (or step) the ALSA `Master` volume with `amixer`.
+
+    Returns the new volume in percent, or None if there is no mixer to
+    control (no `amixer` in PATH, or no `Master` control).
+    """
+
+    amixer = shutil.which("amixer")
+    if amixer is None:
+        return None
+    if percent is not None:
+        value = f"{max(0, min(100, percent))}%"
+    else:
+        value = f"{abs(step)}%{'+' if step >= 0 else '-'}"
+    result = subprocess.run([amixer, "sset", "Master", value], capture_output=True, text=True)
+    if result.returncode != 0:
+        return None
+    levels = re.findall(r"\[(\d+)%\]", result.stdout)
+    return int(levels[-1]) if levels else None
@@ -0,0 +1,104 @@
+from __future__ import annotations
+
+import os
+import shutil
+import subprocess
+import threading
+import time
+from pathlib import Path
+from typing import Callable, Optional, Union
+
+
+# The tee decodes to the same format the audio stream carries (see
+# mqtt/audio_stream.py): 48 kHz mono s16le, in 20 ms chunks.
+SAMPLE_RATE = 48000
+CHUNK_SAMPLES = 960
+CHUNK_BYTES = CHUNK_SAMPLES * 2
+
+# Time from launching the external player to its first sample reaching the
+# speaker. Depends on the player and sound device; measure once per setup.
+PLAYER_LATENCY_S = float(os.environ.get("AUDIO_TEE_PLAYER_LATENCY_MS", "120")) / 1000.0
+
+# Chunks are handed over this long before they play, so a remote twin can
+# buffer them and still play in step with the robot.
+LEAD_S = float(os.environ.get("AUDIO_TEE_LEAD_MS", "60")) / 1000.0
+
+
+def tee_available() -> bool:
+    return shutil.which("ffmpeg") is not None
+
+
+def pcm_level(pcm: bytes) -> float:
+    """RMS of s16le samples, scaled to 0..1 of full scale."""
+    n = len(pcm) // 2
+    if n == 0:
+        return 0.0
+    samples = memoryview(pcm)[: n * 2].cast("h")
+    return min(1.0, (sum(s * s for s in samples) / n) ** 0.5 / 32768.0)
+
+
+class PcmTee:
+    """Decode an audio file to PCM alongside its playback, paced in real time.
+
+    The external player gives no access to its samples, so the tee decodes
+    the same file with ffmpeg and calls `on_chunk(pcm, play_time)` for each
+    20 ms chunk, `LEAD_S` ahead of the Pi wall-clock time the chunk is
+    expected to play. Start it right before launching the player.
+    """
+
+    def __init__(
+        self,
+        path: Union[str, Path],
+        on_chunk: Callable[[bytes, float], None],
+        player_latency_s: float = PLAYER_LATENCY_S,
+        lead_s: float = LEAD_S,
+    ) -> None:
+        self.path = Path(path)
+        self.on_chunk = on_chunk
+        self.player_latency_s = player_latency_s
+        self.lead_s = lead_s
+        self.chunks = 0
+        self._stop_event = threading.Event()
+        self._thread: Optional[threading.Thread] = None
+        self._proc: Optional[subprocess.Popen] = None
+
+    def start(self) -> None:
+        cmd = [
+            "ffmpeg", "-loglevel", "error", "-i", str(self.path),
+            "-f", "s16le", "-ac", "1", "-ar", str(SAMPLE_RATE), "-",
+        ]
+        self._proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stdin=subprocess.DEVNULL)
+        self._thread = threading.Thread(target=self._run, name="pcm-tee", daemon=True)
+        self._thread.start()
+
+    def _run(self) -> None:
+        # Both clocks are read together: pacing uses the monotonic one, the
+        # chunks are stamped with the wall clock that PiState uses.
+        start_mono = time.monotonic() + self.player_latency_s
+        start_wall = time.time() + self.player_latency_s
+        chunk_s = CHUNK_SAMPLES / SAMPLE_RATE
+        try:
+            while not self._stop_event.is_set():
+                pcm = self._proc.stdout.read(CHUNK_BYTES)
+                if not pcm:
+                    break
+                offset = self.chunks * chunk_s
+                delay = start_mono + offset - self.lead_s - time.monotonic()
+                if delay > 0 and self._stop_event.wait(delay):
+                    break
+                self.on_chunk(pcm, start_wall + offset)
+                self.chunks += 1
+        finally:
+            self._proc.stdout.close()
+            self._proc.wait()
+
+    def join(self, timeout: Optional[float] = None) -> None:
+        if self._thread is not None:
+            self._thread.join(timeout)
+
+    def stop(self) -> None:
+        """Stop early (e.g. playback failed) and wait for the thread."""
+        self._stop_event.set()
+        if self._proc is not None and self._proc.poll() is None:
+            self._proc.terminate()
+        self.join(timeout=1.0)
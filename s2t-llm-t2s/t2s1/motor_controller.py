@@ -1,4 +1,4 @@
-from typing import Optional
+from typing import TYPE_CHECKING, Optional
 
 try:
     import RPi.GPIO as GPIO
@@ -7,15 +7,21 @@ except ImportError:
 
 from stepper_28byj import Stepper28BYJ
 
+if TYPE_CHECKING:  # the bus lives in the repo-level `mqtt` package
+    from mqtt.state_bus import StateBus
+
 
 class MotorController:
     """High-level controller for robot steppers.
 
     - mouth_stepper moves continuously while the robot is "talking".
     - head_stepper can perform nodding gestures.
+
+    If a state bus is given, the head angle is bound to it so the digital
+    twin samples the real position without any work in the step loop.
     """
 
-    def __init__(self, enabled: bool = True) -> None:
+    def __init__(self, enabled: bool = True, bus: Optional["StateBus"] = None) -> None:
         # Mouth: your chosen pins for ULN2003 IN1..IN4
         self.mouth_stepper = Stepper28BYJ(
             pins=[18, 23, 24, 25],  # IN1..IN4 -> GPIO17,27,22,23
@@ -33,6 +39,9 @@ class MotorController:
             name="head",
         )
 
+        if bus is not None and self.head_stepper is not None:
+            bus.bind("head_rot_pitch", self.head_stepper.position_degrees)
+
     def start_talking_motion(self) -> None:
         """Start mouth motion to accompany speech."""
         # Alternate ~30° forward/back while the robot is talking
@@ -1,25 +1,87 @@
+from pathlib import Path
+from typing import TYPE_CHECKING, Callable, Optional
+
 from tts_service import synthesize_to_file
 from audio_player import play_audio_blocking
+from audio_tee import PcmTee, pcm_level, tee_available
 from motor_controller import MotorController
 
+if TYPE_CHECKING:  # the bus and audio stream live in the repo-level `mqtt` package
+    from mqtt.audio_stream import AudioStreamPublisher
+    from mqtt.state_bus import StateBus
+
+
+# Without ffmpeg there is no PCM to measure (playback goes through an
+# external player); report a constant level while audio is playing.
+SPEAKING_AUDIO_LEVEL = 1.0
+
 
 class RobotSpeaker:
-    """Coordinates text-to-speech audio playback with robot motor motion."""
+    """Coordinates text-to-speech audio playback with robot motor motion.
+
+    With a state bus attached, playback reports `is_speaking`/`audio_level`
+    and the motors report their pose. With an audio sink attached, the
+    played audio is also streamed to the digital twin.
+
+    `synthesize` and `play` default to gTTS and the system audio player;
+    session recording wraps them and replay swaps in stand-ins.
+    """
+
+    def __init__(
+        self,
+        motor_enabled: bool = False,
+        bus: Optional["StateBus"] = None,
+        audio_sink: Optional["AudioStreamPublisher"] = None,
+        synthesize: Callable[..., Path] = synthesize_to_file,
+        play: Callable[[Path], None] = play_audio_blocking,
+    ) -> None:
+        self.bus = bus
+        self.audio_sink = audio_sink
+        self.synthesize = synthesize
+        self.play = play
+        self.motors = MotorController(enabled=motor_enabled, bus=bus)
+        self._tee_enabled = tee_available()
+        if not self._tee_enabled and (bus is not None or audio_sink is not None):
+            print("ffmpeg not found; audio level is constant and audio is not streamed.")
 
-    def __init__(self, motor_enabled: bool = False) -> None:
-        self.motors = MotorController(enabled=motor_enabled)
+    def _on_pcm_chunk(self, pcm: bytes, play_time: float) -> None:
+        if self.bus is not None:
+            self.bus.set("audio_level", pcm_level(pcm))
+        if self.audio_sink is not None:
+            self.audio_sink.send(pcm, play_time)
 
     def speak(self, text: str, lang: str = "en", audio_path: str = "speech.mp3") -> None:
         """Generate speech audio from text, play it back, and move motors while playing."""
-        mp3_path = synthesize_to_file(text, audio_path, lang=lang)
+        mp3_path = self.synthesize(text, audio_path, lang=lang)
 
+        tee = None
+        if self._tee_enabled and (self.bus is not None or self.audio_sink is not None):
+            tee = PcmTee(mp3_path, self._on_pcm_chunk)
         try:
             # Optional: perform a head nod before speaking
             # self.motors.nod_head(times=1)
 
             self.motors.start_talking_motion()
-            play_audio_blocking(mp3_path)
+            if self.bus is not None:
+                self.bus.set("is_speaking", True)
+                if tee is None:
+                    self.bus.set("audio_level", SPEAKING_AUDIO_LEVEL)
+            if tee is not None:
+                if self.audio_sink is not None:
+                    self.audio_sink.begin_utterance()
+                tee.start()
+            self.play(mp3_path)
+            if tee is not None:
+                # The tee runs slightly ahead of playback; it is normally done.
+                tee.join(timeout=1.0)
         finally:
+            if tee is not None:
+                tee.stop()
+                if self.audio_sink is not None:
+                    self.audio_sink.end_utterance()
+            if self.bus is not None:
+                self.bus.set("is_speaking", False)
+                self.bus.set("audio_level", 0.0)
             self.motors.stop_talking_motion()
 
     def cleanup(self) -> None:
@@ -8,6 +8,11 @@ try:
 except ImportError:  # pragma: no cover - dependency issue
     DigitalOutputDevice = None  # type: ignore
 
+try:  # asynchronous logger when run from the orchestrator (repo root on sys.path)
+    from telemetry.ringlog import get_logger
+except ImportError:  # standalone
+    from logging import getLogger as get_logger
+
 
 class Stepper28BYJ:
     """Control a 28BYJ-48 stepper motor using a ULN2003 driver board.
@@ -50,11 +55,17 @@ class Stepper28BYJ:
         self._continuous = False
         self._thread: Optional[threading.Thread] = None
 
+        # Net half-steps moved since start-up (positive = direction 1). Only
+        # the thread driving the motor writes it; readers just sample it.
+        self.position_steps = 0
+
         # gpiozero DigitalOutputDevice instances, one per pin
         self._devices: List[DigitalOutputDevice] = []
 
+        # Step loops must not wait on the terminal; simulated motion is debug output.
+        self._log = get_logger(self.name)
         if not self.enabled:
-            print(f"[{self.name}] (sim) initialized on pins {self.pins}")
+            self._log.info("(sim) initialized on pins %s", self.pins)
             return
 
         if DigitalOutputDevice is None:
@@ -68,7 +79,7 @@ class Stepper28BYJ:
             dev = DigitalOutputDevice(pin=pin, active_high=True, initial_value=False)
             self._devices.append(dev)
 
-        print(f"[{self.name}] initialized on pins {self.pins} (gpiozero)")
+        self._log.info("initialized on pins %s (gpiozero)", self.pins)
 
     # ------------------------------------------------------------------
     # Low-level helpers
@@ -109,23 +120,25 @@ class Stepper28BYJ:
         if steps == 0:
             return
 
-        if not self.enabled:
-            print(f"[{self.name}] (sim) step {steps} dir={direction}")
-            # Still sleep to simulate timing so callers behave similarly
-            time.sleep(abs(steps) * self.step_delay)
-            return
-
         actual_dir = 1 if direction >= 0 else -1
         if steps < 0:
             steps = -steps
             actual_dir *= -1
 
+        if not self.enabled:
+            self._log.debug("(sim) step %d dir=%d", steps, actual_dir)
+            # Still sleep to simulate timing so callers behave similarly
+            time.sleep(steps * self.step_delay)
+            self.position_steps += steps * actual_dir
+            return
+
         sequence = self._HALF_STEP_SEQUENCE
         seq_len = len(sequence)
 
         for i in range(steps):
             idx = (i * actual_dir) % seq_len
             self._set_step(sequence[idx])
+            self.position_steps += actual_dir
             time.sleep(self.step_delay)
 
         self._off()
@@ -139,6 +152,10 @@ class Stepper28BYJ:
         """
         return int(round(abs(degrees) * steps_per_rev / 360.0))
 
+    def position_degrees(self, steps_per_rev: int = 4096) -> float:
+        """Current output-shaft angle relative to start-up, in degrees."""
+        return self.position_steps * 360.0 / steps_per_rev
+
     def _oscillate_loop(self, swing_steps: int, start_direction: int) -> None:
         sequence = self._HALF_STEP_SEQUENCE
         seq_len = len(sequence)
@@ -158,6 +175,7 @@ class Stepper28BYJ:
                 time.sleep(self.step_delay)
 
                 idx = (idx + direction) % seq_len
+                self.position_steps += direction
                 steps_taken += 1
 
                 if steps_taken >= swing_steps:
@@ -183,8 +201,8 @@ class Stepper28BYJ:
             self._continuous = True
 
         if not self.enabled:
-            print(
-                f"[{self.name}] (sim) start_oscillating degrees={swing_degrees} steps={swing_steps} dir={start_direction}"
+            self._log.debug(
+                "(sim) start_oscillating degrees=%s steps=%d dir=%d", swing_degrees, swing_steps, start_direction
             )
 
         self._thread = threading.Thread(
@@ -216,6 +234,7 @@ class Stepper28BYJ:
 
                 idx = (i * direction) % seq_len
                 self._set_step(sequence[idx])
+                self.position_steps += direction
                 time.sleep(self.step_delay)
                 i += 1
         finally:
@@ -228,7 +247,7 @@ class Stepper28BYJ:
             self._continuous = True
 
         if not self.enabled:
-            print(f"[{self.name}] (sim) start_continuous dir={direction}")
+            self._log.debug("(sim) start_continuous dir=%d", direction)
             # No thread needed; but to keep API consistent, we still start one
 
         self._thread = threading.Thread(
@@ -245,7 +264,7 @@ class Stepper28BYJ:
             self._continuous = False
 
         if not self.enabled:
-            print(f"[{self.name}] (sim) stop_continuous")
+            self._log.debug("(sim) stop_continuous")
 
         if self._thread is not None:
             self._thread.join(timeout=1.0)
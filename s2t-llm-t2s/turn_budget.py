@@ -0,0 +1,428 @@
+"""Per-turn latency budget with graceful degradation.
+
+Each turn gets a target for time-to-first-audio, counted from the end of
+the utterance (`TURN_TARGET_S`). `TurnScheduler.begin_turn` turns the
+target into a deadline and each stage asks for a plan against what is
+left of it:
+
+- STT gets a share of the target (`TURN_STT_SHARE`) as its request
+  timeout. If Google STT is predicted to miss it, or times out, the local
+  Whisper `tiny.en` model is used instead (when `whisper` is installed).
+- The LLM reply and its synthesis must fit in the rest. The reply is
+  capped at as many tokens as the predicted decode and TTS rates allow
+  (at most `TURN_MAX_TOKENS`); if even a short reply does not fit, the
+  backup server (`LLM_BACKUP_URL`) is tried, and if that does not fit
+  either a cached filler phrase is played while the reply is generated.
+- Synthesized phrases are cached on disk (`TTS_CACHE_DIR`), so fillers and
+  repeated replies cost no TTS round trip.
+
+Predictions come from `LatencyModel`: the p90 of recent observations per
+stage and variant, times a safety factor. After every turn the factor is
+nudged so that the p99 of time-to-first-audio over recent turns stays
+under the target: up when it is above, slowly back down when the p99 is
+well below.
+
+Every plan that deviates from the full-quality path is recorded as a
+degradation on the turn's `TurnReport`, which is logged, exported as
+metrics and written to the session recording.
+
+Environment: TURN_TARGET_S (default 6), TURN_STT_SHARE (0.3),
+TURN_MAX_TOKENS (256), LLM_BACKUP_URL (unset = no backup),
+TTS_CACHE_DIR (default ~/.cache/robot-tts, empty = no cache),
+TURN_FILLERS ("|"-separated phrases).
+"""
+
+from __future__ import annotations
+
+import hashlib
+import math
+import os
+import shutil
+import threading
+import time
+from collections import deque
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Callable
+
+try:
+    from telemetry.ringlog import get_logger
+except ImportError:  # run without the repo root on sys.path
+    from logging import getLogger as get_logger
+
+log = get_logger("Budget")
+
+DEFAULT_TARGET_S = 6.0
+DEFAULT_STT_SHARE = 0.3
+DEFAULT_MAX_TOKENS = 256
+MIN_REPLY_TOKENS = 24  # shorter than this is not worth waiting for; degrade further
+CHARS_PER_TOKEN = 4.0  # English, for turning a token cap into TTS time
+DEFAULT_FILLERS = ("Let me think about that.", "Hmm, one moment.")
+
+# Stage variants.
+STT_PRIMARY = "google"
+STT_FALLBACK = "whisper"
+LLM_PRIMARY = "primary"
+LLM_BACKUP = "backup"
+
+# Degradation actions (the `action` label of robot_degradations_total).
+DEGRADE_STT_FALLBACK = "stt_fallback"
+DEGRADE_LLM_BACKUP = "llm_backup"
+DEGRADE_MAX_TOKENS = "max_tokens"
+DEGRADE_FILLER = "filler"
+DEGRADE_TRUNCATED = "llm_truncated"
+
+# Used until a stage has been observed (seconds; rates in seconds per unit).
+PRIORS: dict[str, float] = {
+    "stt:" + STT_PRIMARY: 1.2,
+    "stt:" + STT_FALLBACK: 2.0,
+    "llm_ttft:" + LLM_PRIMARY: 0.8,
+    "llm_ttft:" + LLM_BACKUP: 0.5,
+    "llm_token:" + LLM_PRIMARY: 0.05,
+    "llm_token:" + LLM_BACKUP: 0.02,
+    "tts_overhead": 0.4,
+    "tts_char": 0.004,
+}
+
+SAFETY_MIN = 1.0
+SAFETY_MAX = 2.0
+
+
+class LatencyModel:
+    """Recent observations per key; predicts their p90 times `safety`."""
+
+    def __init__(self, window: int = 50, priors: dict[str, float] | None = None, safety: float = 1.2) -> None:
+        self.window = window
+        self.priors = dict(PRIORS if priors is None else priors)
+        self.safety = safety
+        self._samples: dict[str, deque[float]] = {}
+        self._lock = threading.Lock()
+
+    def observe(self, key: str, value: float) -> None:
+        with self._lock:
+            samples = self._samples.get(key)
+            if samples is None:
+                samples = self._samples[key] = deque(maxlen=self.window)
+            samples.append(value)
+
+    def observe_rate(self, key: str, units: float, seconds: float) -> None:
+        if units > 0:
+            self.observe(key, max(seconds, 0.0) / units)
+
+    def predict(self, key: str) -> float:
+        with self._lock:
+            samples = sorted(self._samples.get(key) or ())
+        if not samples:
+            return self.priors.get(key, 0.0) * self.safety
+        return samples[min(len(samples) - 1, int(len(samples) * 0.9))] * self.safety
+
+    def tts_seconds(self, chars: float) -> float:
+        return self.predict("tts_overhead") + self.predict("tts_char") * chars
+
+    def observe_tts(self, chars: int, seconds: float) -> None:
+        self.observe_rate("tts_char", chars, seconds - self.priors.get("tts_overhead", 0.0))
+
+
+@dataclass
+class SttPlan:
+    variant: str
+    timeout: float
+    fallback: bool  # try STT_FALLBACK if the primary fails or times out
+
+
+@dataclass
+class LlmPlan:
+    variant: str
+    max_tokens: int
+    timeout: float  # per read (connect, first chunk, each later chunk)
+    filler: str | None = None
+
+
+@dataclass
+class TurnReport:
+    turn: int
+    target_s: float
+    first_audio_s: float | None = None
+    met: bool | None = None
+    stages: dict[str, dict[str, Any]] = field(default_factory=dict)
+    degradations: list[dict[str, Any]] = field(default_factory=list)
+
+    def as_dict(self) -> dict[str, Any]:
+        return asdict(self)
+
+
+class TurnBudget:
+    """One turn's deadline and record. Created by `TurnScheduler.begin_turn`."""
+
+    def __init__(self, scheduler: "TurnScheduler", turn: int, heard: float) -> None:
+        self.scheduler = scheduler
+        self.heard = heard
+        self.deadline = heard + scheduler.target_s
+        self.report = TurnReport(turn=turn, target_s=scheduler.target_s)
+
+    def remaining(self) -> float:
+        return self.deadline - self.scheduler.clock()
+
+    def stage(self, name: str, **values: Any) -> None:
+        self.report.stages.setdefault(name, {}).update(values)
+
+    def degrade(self, action: str, reason: str, **details: Any) -> None:
+        self.report.degradations.append({"action": action, "reason": reason, **details})
+        self.scheduler.on_degrade(action)
+
+    def mark_first_audio(self) -> None:
+        if self.report.first_audio_s is None:
+            self.report.first_audio_s = round(self.scheduler.clock() - self.heard, 3)
+
+
+class TurnScheduler:
+    """Plans each stage against the turn's deadline and learns stage latencies."""
+
+    def __init__(
+        self,
+        target_s: float = DEFAULT_TARGET_S,
+        stt_share: float = DEFAULT_STT_SHARE,
+        max_tokens: int = DEFAULT_MAX_TOKENS,
+        have_backup_llm: bool = False,
+        have_stt_fallback: bool = False,
+        fillers: tuple[str, ...] = (),
+        model: LatencyModel | None = None,
+        registry: Any = None,
+        clock: Callable[[], float] = time.perf_counter,
+    ) -> None:
+        self.target_s = target_s
+        self.stt_share = stt_share
+        self.max_tokens = max_tokens
+        self.have_backup_llm = have_backup_llm
+        self.have_stt_fallback = have_stt_fallback
+        self.fillers = fillers  # only ones that are ready to play instantly
+        self.model = model or LatencyModel()
+        self.clock = clock  # `heard` passed to begin_turn is on this clock
+        self.first_audio = deque(maxlen=100)
+        self.current: TurnBudget | None = None
+        self._turns = 0
+        self._fillers_used = 0
+        self._metrics = _BudgetMetrics(registry) if registry is not None else None
+
+    # Planning -------------------------------------------------------------
+
+    def begin_turn(self, heard: float) -> TurnBudget:
+        self._turns += 1
+        self.current = TurnBudget(self, self._turns, heard)
+        return self.current
+
+    def plan_stt(self, turn: TurnBudget) -> SttPlan:
+        allowance = self.stt_share * self.target_s
+        if self.have_stt_fallback and self.model.predict("stt:" + STT_PRIMARY) > allowance:
+            if self.model.predict("stt:" + STT_FALLBACK) < self.model.predict("stt:" + STT_PRIMARY):
+                turn.degrade(DEGRADE_STT_FALLBACK, "primary predicted over its share")
+                return SttPlan(STT_FALLBACK, allowance, fallback=False)
+        return SttPlan(STT_PRIMARY, allowance, fallback=self.have_stt_fallback)
+
+    def token_cap(self, variant: str, remaining: float) -> int:
+        """Most reply tokens whose decode plus synthesis fits in `remaining` seconds."""
+        m = self.model
+        fixed = m.predict("llm_ttft:" + variant) + m.predict("tts_overhead")
+        per_token = m.predict("llm_token:" + variant) + m.predict("tts_char") * CHARS_PER_TOKEN
+        if per_token <= 0:
+            return self.max_tokens
+        return max(0, min(self.max_tokens, math.floor((remaining - fixed) / per_token)))
+
+    def plan_llm(self, turn: TurnBudget) -> LlmPlan:
+        remaining = turn.remaining()
+        variants = [LLM_PRIMARY] + ([LLM_BACKUP] if self.have_backup_llm else [])
+        caps = {v: self.token_cap(v, remaining) for v in variants}
+        for variant in variants:
+            cap = caps[variant]
+            if cap < MIN_REPLY_TOKENS:
+                continue
+            if variant == LLM_BACKUP:
+                turn.degrade(DEGRADE_LLM_BACKUP, "primary predicted late", primary_cap=caps[LLM_PRIMARY])
+            if cap < self.max_tokens:
+                turn.degrade(DEGRADE_MAX_TOKENS, "reply would not fit", max_tokens=cap)
+            return LlmPlan(variant, cap, timeout=max(remaining, 1.0))
+
+        # Nothing fits. Speak a filler now and give the reply a fresh budget.
+        filler = None
+        if self.fillers:
+            filler = self.fillers[self._fillers_used % len(self.fillers)]
+            self._fillers_used += 1
+            turn.degrade(DEGRADE_FILLER, "no reply fits the deadline", filler=filler, remaining_s=round(remaining, 3))
+            remaining = self.target_s
+        variant = max(variants, key=lambda v: self.token_cap(v, remaining))
+        if variant == LLM_BACKUP:
+            turn.degrade(DEGRADE_LLM_BACKUP, "primary predicted late", primary_cap=caps[LLM_PRIMARY])
+        cap = max(MIN_REPLY_TOKENS, self.token_cap(variant, remaining))
+        if cap < self.max_tokens:
+            turn.degrade(DEGRADE_MAX_TOKENS, "reply would not fit", max_tokens=cap)
+        return LlmPlan(variant, cap, timeout=max(remaining, 1.0), filler=filler)
+
+    # Observations -----------------------------------------------------------
+
+    def observe_stt(self, variant: str, seconds: float) -> None:
+        self.model.observe("stt:" + variant, seconds)
+        if self.current is not None:
+            self.current.stage("stt", variant=variant, seconds=round(seconds, 3))
+
+    def observe_llm(self, variant: str, first_chunk_s: float | None, chunks: int, seconds: float) -> None:
+        if first_chunk_s is not None:
+            self.model.observe("llm_ttft:" + variant, first_chunk_s)
+            self.model.observe_rate("llm_token:" + variant, chunks - 1, seconds - first_chunk_s)
+        if self.current is not None:
+            self.current.stage("llm", variant=variant, chunks=chunks, seconds=round(seconds, 3),
+                               first_chunk_s=None if first_chunk_s is None else round(first_chunk_s, 3))
+
+    def wrap_synthesize(self, synthesize: Callable[..., Path]) -> Callable[..., Path]:
+        """Feeds synthesis time per character into the model."""
+        def observed(text: str, output_path: Any, lang: str = "en") -> Path:
+            started = self.clock()
+            path = synthesize(text, output_path, lang=lang)
+            seconds = self.clock() - started
+            if not getattr(synthesize, "last_hit", False):
+                self.model.observe_tts(len(text), seconds)
+            if self.current is not None:
+                self.current.stage("tts", chars=len(text), seconds=round(seconds, 3))
+            return path
+        return observed
+
+    def wrap_play(self, play: Callable[[Any], None]) -> Callable[[Any], None]:
+        """Stamps the current turn's first audio."""
+        def stamped(path: Any) -> None:
+            if self.current is not None:
+                self.current.mark_first_audio()
+            play(path)
+        return stamped
+
+    # End of turn ------------------------------------------------------------
+
+    def end_turn(self, turn: TurnBudget) -> TurnReport:
+        report = turn.report
+        if report.first_audio_s is not None:
+            report.met = report.first_audio_s <= self.target_s
+            self.first_audio.append(report.first_audio_s)
+            self._adapt()
+        if self._metrics is not None:
+            self._metrics.record(report)
+        actions = ",".join(d["action"] for d in report.degradations) or "none"
+        log.info("Turn %d: first audio %s s (target %.1f s), degraded: %s", report.turn,
+                 report.first_audio_s, report.target_s, actions)
+        if self.current is turn:
+            self.current = None
+        return report
+
+    def p99_first_audio(self) -> float | None:
+        if not self.first_audio:
+            return None
+        ordered = sorted(self.first_audio)
+        return ordered[min(len(ordered) - 1, int(len(ordered) * 0.99))]
+
+    def _adapt(self) -> None:
+        p99 = self.p99_first_audio()
+        model = self.model
+        if p99 > self.target_s:
+            model.safety = min(SAFETY_MAX, model.safety * 1.1)
+        elif p99 < 0.8 * self.target_s:
+            model.safety = max(SAFETY_MIN, model.safety * 0.97)
+
+    def on_degrade(self, action: str) -> None:
+        if self._metrics is not None:
+            self._metrics.degradations.labels(action).inc()
+
+
+class _BudgetMetrics:
+    def __init__(self, registry: Any) -> None:
+        from telemetry.instruments import LONG_BUCKETS
+
+        self.first_audio = registry.histogram(
+            "robot_first_audio_seconds", "End of utterance to first audio played", buckets=LONG_BUCKETS)
+        self.degradations = registry.counter("robot_degradations_total", "Turn plans degraded to meet the budget", ["action"])
+        self.missed = registry.counter("robot_turn_budget_missed_total", "Turns whose first audio missed the target")
+
+    def record(self, report: TurnReport) -> None:
+        if report.first_audio_s is not None:
+            self.first_audio.observe(report.first_audio_s)
+        if report.met is False:
+            self.missed.inc()
+
+
+class TtsCache:
+    """Disk cache in front of `synthesize`, keyed by language and text.
+
+    `last_hit` tells the caller whether the previous call was served from
+    the cache (so its time is not taken as a synthesis measurement).
+    """
+
+    def __init__(self, synthesize: Callable[..., Path], directory: str | os.PathLike) -> None:
+        self.synthesize = synthesize
+        self.directory = Path(directory)
+        self.directory.mkdir(parents=True, exist_ok=True)
+        self.last_hit = False
+        self.hits = 0
+        self.misses = 0
+
+    def path_for(self, text: str, lang: str = "en") -> Path:
+        key = hashlib.sha1(f"{lang}\n{text.strip()}".encode("utf-8")).hexdigest()
+        return self.directory / f"{key}.mp3"
+
+    def has(self, text: str, lang: str = "en") -> bool:
+        return self.path_for(text, lang).exists()
+
+    def __call__(self, text: str, output_path: Any, lang: str = "en") -> Path:
+        cached = self.path_for(text, lang)
+        if cached.exists():
+            self.last_hit = True
+            self.hits += 1
+            return cached
+        self.last_hit = False
+        self.misses += 1
+        path = Path(self.synthesize(text, output_path, lang=lang))
+        tmp = cached.with_suffix(".tmp")
+        shutil.copyfile(path, tmp)
+        os.replace(tmp, cached)
+        return path
+
+    def prewarm(self, phrases: tuple[str, ...], lang: str = "en") -> list[str]:
+        """Synthesize `phrases` into the cache; returns the ones that are ready."""
+        ready = []
+        for phrase in phrases:
+            if not self.has(phrase, lang):
+                try:
+                    self(phrase, self.directory / "prewarm.mp3", lang=lang)
+                except Exception as exc:  # noqa: BLE001 - offline: skip this filler
+                    log.warning("Could not synthesize filler %r: %s", phrase, exc)
+                    continue
+            ready.append(phrase)
+        return ready
+
+
+def config_from_env() -> dict[str, Any]:
+    fillers = os.environ.get("TURN_FILLERS")
+    return {
+        "target_s": float(os.environ.get("TURN_TARGET_S", DEFAULT_TARGET_S)),
+        "stt_share": float(os.environ.get("TURN_STT_SHARE", DEFAULT_STT_SHARE)),
+        "max_tokens": int(os.environ.get("TURN_MAX_TOKENS", DEFAULT_MAX_TOKENS)),
+        "backup_url": os.environ.get("LLM_BACKUP_URL") or None,
+        "tts_cache_dir": os.environ.get("TTS_CACHE_DIR", str(Path.home() / ".cache" / "robot-tts")) or None,
+        "fillers": tuple(p.strip() for p in fillers.split("|") if p.strip()) if fillers else DEFAULT_FILLERS,
+    }
+
+
+__all__ = [
+    "DEGRADE_FILLER",
+    "DEGRADE_LLM_BACKUP",
+    "DEGRADE_MAX_TOKENS",
+    "DEGRADE_STT_FALLBACK",
+    "DEGRADE_TRUNCATED",
+    "LLM_BACKUP",
+    "LLM_PRIMARY",
+    "STT_FALLBACK",
+    "STT_PRIMARY",
+    "LatencyModel",
+    "LlmPlan",
+    "SttPlan",
+    "TtsCache",
+    "TurnBudget",
+    "TurnReport",
+    "TurnScheduler",
+    "config_from_env",
+]
@@ -7,6 +7,11 @@ try:
 except ImportError:
     GPIO = None  # Allows import on non-Pi systems
 
+try:  # asynchronous logger when run from the orchestrator (repo root on sys.path)
+    from telemetry.ringlog import get_logger
+except ImportError:  # standalone
+    from logging import getLogger as get_logger
+
 
 class Stepper28BYJ:
     """Controller for a 28BYJ-48 stepper motor driven by ULN2003 on Raspberry Pi.
@@ -53,6 +58,8 @@ class Stepper28BYJ:
         self._thread: Optional[threading.Thread] = None
         self._lock = threading.Lock()
 
+        # Step loops must not wait on the terminal; simulated motion is debug output.
+        self._log = get_logger(self.name)
         if self.enabled:
             if GPIO is None:
                 raise RuntimeError(
@@ -65,7 +72,7 @@ class Stepper28BYJ:
                 GPIO.setup(pin, GPIO.OUT)
                 GPIO.output(pin, GPIO.LOW)
         else:
-            print(f"[{self.name}] (sim) initialized on pins {self.pins}")
+            self._log.info("(sim) initialized on pins %s", self.pins)
 
     # --- Low-level helpers -------------------------------------------------
 
@@ -137,7 +144,7 @@ class Stepper28BYJ:
             self._continuous = True
 
         if not self.enabled:
-            print(f"[{self.name}] (sim) start_continuous dir={direction}")
+            self._log.debug("(sim) start_continuous dir=%d", direction)
             return
 
         self._thread = threading.Thread(
@@ -155,7 +162,7 @@ class Stepper28BYJ:
             self._continuous = False
 
         if not self.enabled:
-            print(f"[{self.name}] (sim) stop_continuous")
+            self._log.debug("(sim) stop_continuous")
             return
 
         if self._thread is not None:
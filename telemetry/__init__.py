@@ -0,0 +1,10 @@
+"""Recording and analysis of what the robots did during a show.
+
+Sits next to the `mqtt` package: the recorder follows the same topics as
+dashboards do, and the files it writes can be queried offline without any
+broker or robot around.
+
+Also home to the live-side helpers every package may use: the metrics
+registry (`metrics.py`) and the asynchronous logger (`ringlog.py`), which
+depend on nothing else in the repo.
+"""
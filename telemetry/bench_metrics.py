@@ -0,0 +1,101 @@
+"""Cost of recording a metric sample, and of reading the registry.
+
+Times `--samples` calls of each recording operation (counter inc, gauge
+set, histogram observe, histogram timer, labelled child inc) against an
+empty loop, on one thread and on `--threads` threads hammering the same
+series (the worst case for the per-series lock). Then fills a registry
+with `--series` labelled series and times `render()` (Prometheus scrape)
+and `compact()` (MQTT snapshot), with the payload sizes.
+
+Run from the repository root:
+    python3 -m telemetry.bench_metrics --samples 1000000 --threads 4
+"""
+
+from __future__ import annotations
+
+import argparse
+import threading
+import time
+from typing import Callable
+
+from .metrics import Registry, compact_payload
+
+
+def _per_call_ns(fn: Callable[[], None], n: int) -> float:
+    started = time.perf_counter()
+    for _ in range(n):
+        fn()
+    return (time.perf_counter() - started) / n * 1e9
+
+
+def _threaded_ns(fn: Callable[[], None], n: int, threads: int) -> float:
+    """Wall time per call with `threads` threads each doing n / threads calls."""
+    per_thread = n // threads
+    barrier = threading.Barrier(threads + 1)
+
+    def worker() -> None:
+        barrier.wait()
+        for _ in range(per_thread):
+            fn()
+
+    workers = [threading.Thread(target=worker) for _ in range(threads)]
+    for w in workers:
+        w.start()
+    barrier.wait()
+    started = time.perf_counter()
+    for w in workers:
+        w.join()
+    return (time.perf_counter() - started) / (per_thread * threads) * 1e9
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark metric recording and export.")
+    parser.add_argument("--samples", type=int, default=1_000_000, help="Calls per operation (default: %(default)s).")
+    parser.add_argument("--threads", type=int, default=4, help="Threads for the contended run (default: %(default)s).")
+    parser.add_argument("--series", type=int, default=200, help="Labelled series for the export timing (default: %(default)s).")
+    args = parser.parse_args()
+
+    registry = Registry()
+    counter = registry.counter("bench_total", "Counter")
+    gauge = registry.gauge("bench_gauge", "Gauge")
+    histogram = registry.histogram("bench_seconds", "Histogram")
+    child = registry.counter("bench_labelled_total", "Labelled counter", ["topic"]).labels("siggraph/pi/state")
+
+    def timed() -> None:
+        with histogram.time():
+            pass
+
+    operations: list[tuple[str, Callable[[], None]]] = [
+        ("empty call", lambda: None),
+        ("counter.inc()", counter.inc),
+        ("gauge.set(v)", lambda: gauge.set(0.5)),
+        ("histogram.observe(v)", lambda: histogram.observe(0.042)),
+        ("with histogram.time()", timed),
+        ("labelled child.inc()", child.inc),
+    ]
+    n = args.samples
+    baseline = _per_call_ns(operations[0][1], n)
+    print(f"{n} calls each; 'net' subtracts the empty-call loop ({baseline:.0f} ns)")
+    for name, fn in operations[1:]:
+        single = _per_call_ns(fn, n)
+        contended = _threaded_ns(fn, n, args.threads)
+        print(f"  {name:<24} {single:6.0f} ns/call (net {single - baseline:5.0f}), {args.threads} threads {contended:6.0f} ns/call")
+    assert counter.get() >= n
+
+    export = Registry()
+    hist = export.histogram("bench_export_seconds", "Histogram", ["topic"])
+    count = export.counter("bench_export_total", "Counter", ["topic"])
+    for i in range(args.series):
+        hist.labels(f"siggraph/robot{i}/state").observe(i / args.series)
+        count.labels(f"siggraph/robot{i}/state").inc(i)
+    for name, render in (("render() (Prometheus)", export.render), ("compact() (MQTT)", lambda: compact_payload(export))):
+        runs = 50
+        started = time.perf_counter()
+        for _ in range(runs):
+            payload = render()
+        per_run = (time.perf_counter() - started) / runs
+        print(f"  {name:<24} {per_run * 1000:6.2f} ms for {2 * args.series} series, {len(payload.encode())} bytes")
+
+
+if __name__ == "__main__":
+    main()
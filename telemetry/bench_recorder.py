@@ -0,0 +1,146 @@
+"""Recorder ingest cost and query speed.
+
+Ingest: feeds `--robots` x `--frames` binary state frames through the
+recorder's message callback (as the MQTT network thread would) and
+reports the time per row on the network thread and on the writer thread,
+the implied CPU share at `--rate` Hz per robot, and bytes per row on disk.
+
+Query: writes `--hours` of synthetic 200 Hz-style state for one robot into
+hourly segments (the way the recorder would over a show), then times the
+query summary over the whole range and over a range that cuts groups.
+
+Run from the repository root:
+    python3 -m telemetry.bench_recorder --robots 4 --rate 200
+    python3 -m telemetry.bench_recorder --hours 24      # a full day (slow to generate)
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import os
+import tempfile
+import time
+from dataclasses import replace
+from pathlib import Path
+from types import SimpleNamespace
+
+from mqtt.state_bus import StateBus
+from mqtt.state_codec import StateEncoder
+from mqtt.transport import LoopbackBroker
+
+from .colfile import ColumnWriter
+from .query import summarize_table
+from .recorder import (
+    SEGMENT_SECONDS,
+    STATE_HIST_COLUMNS,
+    STATE_SCHEMA,
+    STATE_TABLE,
+    TIME_COLUMN,
+    TelemetryRecorder,
+    _new_segment_path,
+    segment_name,
+)
+
+
+def _frames(n: int) -> list[bytes]:
+    encoder = StateEncoder()
+    base = StateBus().sample()
+    frames = []
+    for i in range(n):
+        speaking = (i // 600) % 2 == 1
+        frames.append(encoder.encode(replace(
+            base,
+            timestamp=time.time(),
+            dialogue=f"line {i // 600}",
+            app_state="Speaking" if speaking else "Listening",
+            head_rot_pitch=10.0 * math.sin(i / 50.0),
+            head_rot_yaw=20.0 * math.sin(i / 170.0),
+            audio_level=0.3 + 0.2 * math.sin(i / 7.0) if speaking else 0.0,
+            is_speaking=speaking,
+        )))
+    return frames
+
+
+def bench_ingest(args: argparse.Namespace, out_dir: str) -> None:
+    recorder = TelemetryRecorder(out_dir, transport=LoopbackBroker())
+    frames = _frames(args.frames)
+    topics = [f"siggraph/robot{r}/state/bin" for r in range(args.robots)]
+
+    cpu_start, thread_start = time.process_time(), time.thread_time()
+    for payload in frames:
+        for topic in topics:
+            recorder._on_message(None, None, SimpleNamespace(topic=topic, payload=payload))
+    network = time.thread_time() - thread_start
+    recorder.close()
+    total = time.process_time() - cpu_start
+
+    rows = len(frames) * len(topics)
+    size = sum(os.path.getsize(os.path.join(d, f)) for d, _, files in os.walk(out_dir) for f in files)
+    per_row = total / rows
+    print(
+        f"ingest  : {rows} rows from {len(topics)} robots, network thread {network / rows * 1e6:.1f} us/row, "
+        f"writer {(total - network) / rows * 1e6:.1f} us/row, {size / rows:.1f} B/row on disk"
+    )
+    print(
+        f"          at {args.rate:g} Hz x {args.robots} robots: {100.0 * per_row * args.rate * args.robots:.1f}% of one core, "
+        f"{size / rows * args.rate * args.robots * 86400 / 1e6:.0f} MB/day"
+    )
+
+
+def bench_query(args: argparse.Namespace, out_dir: str) -> None:
+    start = (time.time() // SEGMENT_SECONDS - args.hours) * SEGMENT_SECONDS
+    directory = Path(out_dir, "pi", STATE_TABLE)
+    rows = int(args.hours * 3600 * args.rate)
+    started = time.perf_counter()
+    writer = None
+    segment = -1
+    for i in range(rows):
+        t = start + i / args.rate
+        if int(t // SEGMENT_SECONDS) != segment:
+            if writer is not None:
+                writer.close()
+            segment = int(t // SEGMENT_SECONDS)
+            writer = ColumnWriter(_new_segment_path(directory, segment_name(t)),
+                                  STATE_SCHEMA, TIME_COLUMN, hist_columns=STATE_HIST_COLUMNS)
+        speaking = (i // 600) % 3 == 0
+        writer.append((
+            t, t - 0.002, 2.0 + (i % 7) * 0.3,
+            0.0, 0.0, 0.0, 5.0 * math.sin(i / 90.0), 0.0, 0.0,
+            0.0, 0.0, 0.0, 10.0 * math.sin(i / 50.0), 20.0 * math.sin(i / 170.0), 0.0,
+            0.4 if speaking else 0.0,
+            1, speaking, "Speaking" if speaking else "Listening", f"line {i // 600}",
+        ))
+    writer.close()
+    print(f"generate: {rows} rows ({args.hours:g} h at {args.rate:g} Hz) in {time.perf_counter() - started:.1f} s")
+
+    end = start + args.hours * 3600
+    for label, t_from, t_to in (
+        ("all", None, None),
+        ("cut", start + 123.4, end - 567.8),
+    ):
+        started = time.perf_counter()
+        summary = summarize_table(out_dir, "pi", STATE_TABLE, t_from, t_to)
+        elapsed = time.perf_counter() - started
+        print(
+            f"query {label}: {summary.stats['rows']} rows, {summary.files} files, {summary.groups} groups "
+            f"({summary.decoded_groups} decoded) in {elapsed * 1000:.0f} ms"
+        )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark the telemetry recorder and query.")
+    parser.add_argument("--robots", type=int, default=4, help="Robots for the ingest run (default: %(default)s).")
+    parser.add_argument("--frames", type=int, default=20000, help="Frames per robot for the ingest run (default: %(default)s).")
+    parser.add_argument("--rate", type=float, default=200.0, help="State rate per robot in Hz (default: %(default)s).")
+    parser.add_argument("--hours", type=float, default=1.0, help="Hours of data for the query run (default: %(default)s).")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as out_dir:
+        bench_ingest(args, os.path.join(out_dir, "ingest"))
+    with tempfile.TemporaryDirectory() as out_dir:
+        bench_query(args, out_dir)
+
+
+if __name__ == "__main__":
+    main()
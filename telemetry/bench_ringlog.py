@@ -0,0 +1,116 @@
+"""Caller-side cost of logging: `print` versus the ring-buffer logger.
+
+Per-call cost: `--calls` log calls of a short formatted message through
+`print` into a pipe, a ring logger at an enabled level, a disabled level
+(call-site filtering), and one rate-limited call site.
+
+Stalls: a sink whose writes block for `--stall-ms` every `--stall-every`
+writes (a busy terminal, journald rotating) is logged to at 200 Hz from a
+"network thread". Reports the caller's worst and p99 time per call, which
+for `print` is the sink's stall and for the ring logger is not.
+
+Run from the repository root:
+    python3 -m telemetry.bench_ringlog --calls 200000 --stall-ms 50
+"""
+
+from __future__ import annotations
+
+import argparse
+import io
+import os
+import time
+
+from .ringlog import DEBUG, INFO, Logger, RingLog
+
+
+class StallingSink(io.TextIOBase):
+    def __init__(self, stall_s: float, every: int) -> None:
+        self.stall_s = stall_s
+        self.every = every
+        self.writes = 0
+
+    def write(self, text: str) -> int:
+        self.writes += 1
+        if self.writes % self.every == 0:
+            time.sleep(self.stall_s)
+        return len(text)
+
+
+def _per_call_ns(fn, n: int) -> float:
+    started = time.perf_counter()
+    for i in range(n):
+        fn("[MQTT] Outbound %s: sent %d", "siggraph/pi/state", i)
+    return (time.perf_counter() - started) / n * 1e9
+
+
+def _caller_latencies(log_call, n: int, rate_hz: float) -> list[float]:
+    period = 1.0 / rate_hz
+    latencies = []
+    next_at = time.perf_counter()
+    for i in range(n):
+        started = time.perf_counter()
+        log_call("[MQTT] Outbound %s: sent %d", "siggraph/pi/state", i)
+        latencies.append(time.perf_counter() - started)
+        next_at += period
+        delay = next_at - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+    return sorted(latencies)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark print vs. the ring-buffer logger.")
+    parser.add_argument("--calls", type=int, default=200_000, help="Calls per variant (default: %(default)s).")
+    parser.add_argument("--stall-ms", type=float, default=50.0, help="Sink stall per blocked write (default: %(default)s).")
+    parser.add_argument("--stall-every", type=int, default=100, help="Block every Nth write (default: %(default)s).")
+    parser.add_argument("--seconds", type=float, default=3.0, help="Duration of the stall run (default: %(default)s).")
+    args = parser.parse_args()
+
+    n = args.calls
+    read_fd, write_fd = os.pipe()
+    os.set_blocking(read_fd, False)
+    pipe = os.fdopen(write_fd, "w", buffering=1)  # line buffered, like a terminal
+
+    def print_to_pipe(msg: str, *a: object) -> None:
+        print(msg % a, file=pipe)
+        try:
+            while os.read(read_fd, 1 << 16):
+                pass
+        except BlockingIOError:
+            pass
+
+    ring = RingLog(capacity=1 << 16, stream=io.StringIO()).start()
+    enabled = Logger("MQTT", ring, INFO, rate_limit=0)
+    limited = Logger("MQTT", ring, INFO, rate_limit=20)
+    disabled = Logger("MQTT", ring, INFO, rate_limit=0)
+    print(f"{n} calls each, ns per call on the calling thread")
+    for name, fn in (
+        ("print (pipe)", lambda msg, *a: print_to_pipe(msg, *a)),
+        ("ring info()", enabled.info),
+        ("ring info(), rate-limited", limited.info),
+        ("ring debug() disabled", disabled.debug),
+    ):
+        print(f"  {name:<28} {_per_call_ns(fn, n):7.0f}")
+        ring.stream = io.StringIO()  # don't keep the formatted text around
+    assert not disabled.isEnabledFor(DEBUG)
+    ring.close()
+    pipe.close()
+    os.close(read_fd)
+
+    calls = int(args.seconds * 200)
+    sink = StallingSink(args.stall_ms / 1000.0, args.stall_every)
+    print(f"\n200 Hz for {args.seconds:.0f} s into a sink blocking {args.stall_ms:.0f} ms every {args.stall_every} writes")
+    results = {"print": _caller_latencies(lambda msg, *a: print(msg % a, file=sink, flush=True), calls, 200.0)}
+    sink.writes = 0
+    ring = RingLog(stream=sink, flush_interval=0.01).start()
+    results["ring logger"] = _caller_latencies(Logger("MQTT", ring, INFO, rate_limit=0).info, calls, 200.0)
+    ring.close()
+    for name, lat in results.items():
+        print(
+            f"  {name:<12} caller p50 {lat[len(lat) // 2] * 1e6:7.1f} us, "
+            f"p99 {lat[int(len(lat) * 0.99)] * 1e3:6.2f} ms, max {lat[-1] * 1e3:6.2f} ms"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+"""Metrics for the voice pipeline (`s2t-llm-t2s/main.py`) and the MQTT app.
+
+`PipelineMetrics` creates the pipeline's metrics in a `Registry` and wraps
+the pipeline's parts the same way `SessionRecorder` does (`wrap_llm`,
+`wrap_synthesize`, `wrap_play`, `wrap_motors`), so neither the LLM
+client nor `RobotSpeaker` needs to know about metrics. STT and turn
+timings are recorded by the turn loop itself.
+
+`mqtt_app_collector` exports the stats `PiMqttApp` already keeps (publish
+ticker, outbound queues, command dispatcher) when the registry is read.
+"""
+
+from __future__ import annotations
+
+from pathlib import Path
+from typing import Any, Callable, Iterable, Iterator
+
+from .metrics import COUNTER, GAUGE, LATENCY_BUCKETS, MetricFamily, Registry
+
+# LLM replies and playback run for seconds, not milliseconds.
+LONG_BUCKETS: tuple[float, ...] = (0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 7.5, 10.0, 15.0, 20.0, 30.0, 60.0)
+
+
+class PipelineMetrics:
+    def __init__(self, registry: Registry) -> None:
+        self.registry = registry
+        r = registry
+        self.turns = r.counter("robot_turns_total", "Voice turns started")
+        self.routes = r.counter("robot_turn_routes_total", "Turns by route: the local intent that answered, or llm", ["route"])
+        self.turn_seconds = r.histogram("robot_turn_seconds", "End of utterance to end of spoken reply", buckets=LONG_BUCKETS)
+        self.listen_seconds = r.histogram("robot_listen_seconds", "Time spent capturing an utterance", buckets=LONG_BUCKETS)
+        self.stt_seconds = r.histogram("robot_stt_seconds", "Speech recognition latency")
+        stt_results = r.counter("robot_stt_results_total", "Speech recognition outcomes", ["result"])
+        self.stt_ok = stt_results.labels("ok")
+        self.stt_empty = stt_results.labels("empty")
+        self.llm_first_token_seconds = r.histogram("robot_llm_first_token_seconds", "LLM request to first streamed chunk")
+        self.llm_reply_seconds = r.histogram("robot_llm_reply_seconds", "LLM request to end of reply", buckets=LONG_BUCKETS)
+        self.llm_chunks = r.counter("robot_llm_chunks_total", "Streamed LLM chunks received")
+        self.llm_errors = r.counter("robot_llm_errors_total", "LLM requests that raised")
+        self.tts_seconds = r.histogram("robot_tts_seconds", "Text-to-speech synthesis latency")
+        self.tts_chars = r.counter("robot_tts_characters_total", "Characters synthesized")
+        self.playback_seconds = r.histogram("robot_playback_seconds", "Speech playback duration", buckets=LONG_BUCKETS)
+        self.speaking = r.gauge("robot_speaking", "1 while speech is playing")
+        motions = r.counter("robot_motor_motions_total", "Motor motions started", ["motion"])
+        self.motion_talk = motions.labels("talk")
+        self.motion_nod = motions.labels("nod")
+
+    def record_transcript(self, text: str | None, latency_s: float) -> None:
+        self.stt_seconds.observe(latency_s)
+        (self.stt_ok if text else self.stt_empty).inc()
+
+    def record_route(self, route: str) -> None:
+        self.routes.labels(route).inc()
+
+    def wrap_llm(self, client: Any) -> "MeteredLlm":
+        return MeteredLlm(client, self)
+
+    def wrap_synthesize(self, synthesize: Callable[..., Path]) -> Callable[..., Path]:
+        def metered(text: str, output_path: Any, lang: str = "en") -> Path:
+            with self.tts_seconds.time():
+                path = synthesize(text, output_path, lang=lang)
+            self.tts_chars.inc(len(text))
+            return path
+        return metered
+
+    def wrap_play(self, play: Callable[[Any], None]) -> Callable[[Any], None]:
+        def metered(path: Any) -> None:
+            self.speaking.set(1)
+            try:
+                with self.playback_seconds.time():
+                    play(path)
+            finally:
+                self.speaking.set(0)
+        return metered
+
+    def wrap_motors(self, motors: Any) -> "MeteredMotors":
+        return MeteredMotors(motors, self)
+
+
+class MeteredLlm:
+    """`chat_stream` passthrough timing the first chunk and the whole reply."""
+
+    def __init__(self, client: Any, metrics: PipelineMetrics) -> None:
+        self.client = client
+        self.metrics = metrics
+
+    def chat_stream(self, prompt: str, history: list[Any] | None = None, **options: Any) -> Iterator[str]:
+        m = self.metrics
+        first = m.llm_first_token_seconds
+        chunks = 0
+        with m.llm_reply_seconds.time() as timer:
+            try:
+                for chunk in self.client.chat_stream(prompt=prompt, history=history, **options):
+                    if not chunks:
+                        first.observe(timer.elapsed())
+                    chunks += 1
+                    yield chunk
+            except Exception:
+                m.llm_errors.inc()
+                raise
+            finally:
+                m.llm_chunks.inc(chunks)
+
+
+class MeteredMotors:
+    """Counts the motions issued to a `MotorController` and forwards them."""
+
+    def __init__(self, motors: Any, metrics: PipelineMetrics) -> None:
+        self._motors = motors
+        self._metrics = metrics
+
+    def start_talking_motion(self) -> None:
+        self._metrics.motion_talk.inc()
+        self._motors.start_talking_motion()
+
+    def nod_head(self, times: int = 2) -> None:
+        self._metrics.motion_nod.inc()
+        self._motors.nod_head(times=times)
+
+    def __getattr__(self, name: str) -> Any:
+        return getattr(self._motors, name)
+
+
+def mqtt_app_collector(app: Any) -> Callable[[], Iterable[MetricFamily]]:
+    """Collector exporting a `PiMqttApp`'s publish, outbound and command stats."""
+
+    def collect() -> Iterable[MetricFamily]:
+        tick = app.ticker.stats()
+        yield MetricFamily("mqtt_publish_rate_hz", GAUGE, "State publish rate achieved").add(tick.actual_hz)
+        yield MetricFamily("mqtt_publish_ticks_dropped_total", COUNTER, "Publish ticks skipped because the loop ran late").add(tick.dropped)
+        yield MetricFamily("mqtt_publish_jitter_p99_seconds", GAUGE, "Publish tick lateness, p99").add(tick.jitter_p99_ms / 1000.0)
+
+        outbound = app.outbound.stats()
+        labels = ("topic",)
+        families = {
+            "offered": MetricFamily("mqtt_outbound_offered_total", COUNTER, "Messages handed to the outbound queue", labels),
+            "sent": MetricFamily("mqtt_outbound_sent_total", COUNTER, "Messages passed to the MQTT client", labels),
+            "dropped": MetricFamily("mqtt_outbound_dropped_total", COUNTER, "Messages superseded or pushed out of a full queue", labels),
+            "failed": MetricFamily("mqtt_outbound_failed_total", COUNTER, "Publishes the client refused", labels),
+            "lost": MetricFamily("mqtt_outbound_lost_total", COUNTER, "Messages in flight when the connection dropped", labels),
+            "depth": MetricFamily("mqtt_outbound_depth", GAUGE, "Messages pending per topic", labels),
+        }
+        ack = MetricFamily("mqtt_outbound_ack_p99_seconds", GAUGE, "Publish-to-ack latency, p99", labels)
+        for topic, stats in sorted(outbound.items()):
+            for field, family in families.items():
+                family.add(getattr(stats, field), topic)
+            ack.add(stats.ack_p99_ms / 1000.0, topic)
+        yield from families.values()
+        yield ack
+
+        commands = app.commands.stats()
+        count = MetricFamily("mqtt_commands_total", COUNTER, "Commands handled", ("kind",))
+        errors = MetricFamily("mqtt_command_errors_total", COUNTER, "Commands whose handler raised", ("kind",))
+        latency = MetricFamily("mqtt_command_p99_seconds", GAUGE, "Command receive-to-handled latency, p99", ("kind",))
+        for kind, stats in sorted(commands.items()):
+            count.add(stats.count, kind)
+            errors.add(stats.errors, kind)
+            latency.add(stats.total_p99_ms / 1000.0, kind)
+        yield from (count, errors, latency)
+
+    return collect
+
+
+__all__ = ["LATENCY_BUCKETS", "LONG_BUCKETS", "MeteredLlm", "MeteredMotors", "PipelineMetrics", "mqtt_app_collector"]
@@ -0,0 +1,474 @@
+"""In-process metrics: counters, gauges and fixed-bucket histograms.
+
+Every subsystem records into one `Registry`; nothing is formatted or sent
+on the hot path. Two exporters read it:
+
+- `MetricsHttpServer`: Prometheus text format (0.0.4) on
+  `http://127.0.0.1:<port>/metrics`, for a local Prometheus/Grafana or curl.
+- `compact()`: a small JSON snapshot that `PiMqttApp` publishes to
+  `siggraph/<device>/metrics` every few seconds for the dashboards.
+
+Recording a sample takes one uncontended lock and an add (histograms also
+bisect the bucket bounds); see `bench_metrics.py` for the cost. Labelled
+series are looked up once with `labels(...)` and the child kept by the
+caller, so the lookup is not repeated per sample.
+
+Stats that modules already keep (outbound queues, command latencies,
+publish ticker) are exported with `register_collector`, which is called
+only when the registry is read.
+
+Usage:
+    registry = Registry()
+    turns = registry.counter("robot_turns_total", "Completed voice turns")
+    stt = registry.histogram("robot_stt_seconds", "Speech recognition time")
+    turns.inc()
+    with stt.time():
+        ...
+    MetricsHttpServer(registry, port=9108).start()
+"""
+
+from __future__ import annotations
+
+import json
+import math
+import re
+import threading
+import time
+from bisect import bisect_left
+from dataclasses import dataclass, field
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Callable, Iterable, Sequence
+
+from .ringlog import get_logger
+
+
+COUNTER = "counter"
+GAUGE = "gauge"
+HISTOGRAM = "histogram"
+
+# Seconds; covers a 5 ms MQTT publish up to a 30 s LLM reply.
+LATENCY_BUCKETS: tuple[float, ...] = (0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0)
+
+DEFAULT_METRICS_PORT = 9108
+METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+
+_NAME_RE = re.compile(r"^[a-zA-Z_:][a-zA-Z0-9_:]*$")
+_LABEL_RE = re.compile(r"^[a-zA-Z_][a-zA-Z0-9_]*$")
+
+log = get_logger("Metrics")
+
+
+# The series keep their lock's bound acquire/release: about half the cost of
+# `with lock:` per sample on CPython 3.11.
+
+
+class _Value:
+    """One gauge series."""
+
+    __slots__ = ("_acquire", "_release", "_value")
+
+    def __init__(self) -> None:
+        lock = threading.Lock()
+        self._acquire = lock.acquire
+        self._release = lock.release
+        self._value = 0.0
+
+    def inc(self, amount: float = 1.0) -> None:
+        self._acquire()
+        try:
+            self._value += amount
+        finally:
+            self._release()
+
+    def dec(self, amount: float = 1.0) -> None:
+        self.inc(-amount)
+
+    def set(self, value: float) -> None:
+        value = float(value)
+        self._acquire()
+        self._value = value
+        self._release()
+
+    def get(self) -> float:
+        return self._value
+
+
+class _CounterValue(_Value):
+    """One counter series."""
+
+    __slots__ = ()
+
+    def inc(self, amount: float = 1.0) -> None:
+        if amount < 0:
+            raise ValueError("Counters only go up")
+        self._acquire()
+        try:
+            self._value += amount
+        finally:
+            self._release()
+
+
+class _Buckets:
+    """One histogram series: per-bucket counts (not cumulative) plus the sum."""
+
+    __slots__ = ("_acquire", "_release", "_bounds", "_counts", "_sum")
+
+    def __init__(self, bounds: tuple[float, ...]) -> None:
+        lock = threading.Lock()
+        self._acquire = lock.acquire
+        self._release = lock.release
+        self._bounds = bounds
+        self._counts = [0] * (len(bounds) + 1)  # last one is +Inf
+        self._sum = 0.0
+
+    def observe(self, value: float) -> None:
+        i = bisect_left(self._bounds, value)
+        self._acquire()
+        try:
+            self._counts[i] += 1
+            self._sum += value
+        finally:
+            self._release()
+
+    def time(self) -> "_Timer":
+        """Context manager observing the time spent in its block."""
+        return _Timer(self)
+
+    def get(self) -> tuple[list[int], float]:
+        self._acquire()
+        try:
+            return list(self._counts), self._sum
+        finally:
+            self._release()
+
+
+class _Timer:
+    __slots__ = ("_series", "_started")
+
+    def __init__(self, series: _Buckets) -> None:
+        self._series = series
+
+    def __enter__(self) -> "_Timer":
+        self._started = time.perf_counter()
+        return self
+
+    def elapsed(self) -> float:
+        return time.perf_counter() - self._started
+
+    def __exit__(self, *exc: object) -> None:
+        self._series.observe(time.perf_counter() - self._started)
+
+
+class _Metric:
+    """A named family of series, one per combination of label values."""
+
+    def __init__(self, kind: str, name: str, help: str, labelnames: Sequence[str], factory: Callable[[], object]) -> None:
+        if not _NAME_RE.match(name):
+            raise ValueError(f"Invalid metric name {name!r}")
+        for label in labelnames:
+            if not _LABEL_RE.match(label) or label.startswith("__") or label == "le":
+                raise ValueError(f"Invalid label name {label!r} for {name}")
+        self.kind = kind
+        self.name = name
+        self.help = help
+        self.labelnames = tuple(labelnames)
+        self._factory = factory
+        self._children: dict[tuple[str, ...], object] = {}
+        self._lock = threading.Lock()
+        if not self.labelnames:
+            self._default = self._children[()] = factory()
+
+    def labels(self, *values: object):
+        """The series for these label values (created on first use); keep it for the hot path."""
+        key = tuple(str(v) for v in values)
+        child = self._children.get(key)
+        if child is None:
+            if len(key) != len(self.labelnames):
+                raise ValueError(f"{self.name} expects labels {self.labelnames}, got {key}")
+            with self._lock:
+                child = self._children.setdefault(key, self._factory())
+        return child
+
+    def series(self) -> list[tuple[tuple[str, ...], object]]:
+        with self._lock:
+            return list(self._children.items())
+
+
+class Counter(_Metric):
+    def __init__(self, name: str, help: str, labelnames: Sequence[str] = ()) -> None:
+        super().__init__(COUNTER, name, help, labelnames, _CounterValue)
+        if not self.labelnames:
+            self.inc = self._default.inc  # type: ignore[method-assign]  # skip one call per sample
+
+    def inc(self, amount: float = 1.0) -> None:
+        raise ValueError(f"{self.name} has labels {self.labelnames}; use labels(...).inc()")
+
+    def get(self) -> float:
+        return self._default.get()
+
+
+class Gauge(_Metric):
+    def __init__(self, name: str, help: str, labelnames: Sequence[str] = ()) -> None:
+        super().__init__(GAUGE, name, help, labelnames, _Value)
+        if not self.labelnames:
+            self.inc = self._default.inc  # type: ignore[method-assign]
+            self.dec = self._default.dec  # type: ignore[method-assign]
+            self.set = self._default.set  # type: ignore[method-assign]
+
+    def inc(self, amount: float = 1.0) -> None:
+        raise ValueError(f"{self.name} has labels {self.labelnames}; use labels(...).inc()")
+
+    def dec(self, amount: float = 1.0) -> None:
+        raise ValueError(f"{self.name} has labels {self.labelnames}; use labels(...).dec()")
+
+    def set(self, value: float) -> None:
+        raise ValueError(f"{self.name} has labels {self.labelnames}; use labels(...).set()")
+
+    def get(self) -> float:
+        return self._default.get()
+
+
+class Histogram(_Metric):
+    def __init__(
+        self, name: str, help: str, labelnames: Sequence[str] = (), buckets: Sequence[float] = LATENCY_BUCKETS
+    ) -> None:
+        bounds = tuple(float(b) for b in buckets if not math.isinf(b))
+        if not bounds or list(bounds) != sorted(set(bounds)):
+            raise ValueError(f"Histogram {name} needs strictly increasing buckets")
+        self.bounds = bounds
+        super().__init__(HISTOGRAM, name, help, labelnames, lambda: _Buckets(bounds))
+        if not self.labelnames:
+            self.observe = self._default.observe  # type: ignore[method-assign]
+
+    def observe(self, value: float) -> None:
+        raise ValueError(f"{self.name} has labels {self.labelnames}; use labels(...).observe()")
+
+    def time(self) -> _Timer:
+        return self._default.time()
+
+    def get(self) -> tuple[list[int], float]:
+        return self._default.get()
+
+
+@dataclass
+class MetricFamily:
+    """Values produced by a collector at read time (gauges or counters only)."""
+
+    name: str
+    kind: str
+    help: str
+    labelnames: tuple[str, ...] = ()
+    samples: list[tuple[tuple[object, ...], float]] = field(default_factory=list)
+
+    def add(self, value: float, *labels: object) -> "MetricFamily":
+        self.samples.append((labels, value))
+        return self
+
+
+Collector = Callable[[], Iterable[MetricFamily]]
+
+
+class Registry:
+    """All metrics of one process. Creating a metric twice returns the existing one."""
+
+    def __init__(self) -> None:
+        self._metrics: dict[str, _Metric] = {}
+        self._collectors: list[Collector] = []
+        self._lock = threading.Lock()
+
+    def _get_or_create(self, cls: type, name: str, help: str, labelnames: Sequence[str], **kwargs) -> _Metric:
+        with self._lock:
+            metric = self._metrics.get(name)
+            if metric is None:
+                metric = self._metrics[name] = cls(name, help, labelnames, **kwargs)
+            elif type(metric) is not cls or metric.labelnames != tuple(labelnames):
+                raise ValueError(f"Metric {name} already registered as {metric.kind} {metric.labelnames}")
+            return metric
+
+    def counter(self, name: str, help: str, labelnames: Sequence[str] = ()) -> Counter:
+        return self._get_or_create(Counter, name, help, labelnames)  # type: ignore[return-value]
+
+    def gauge(self, name: str, help: str, labelnames: Sequence[str] = ()) -> Gauge:
+        return self._get_or_create(Gauge, name, help, labelnames)  # type: ignore[return-value]
+
+    def histogram(
+        self, name: str, help: str, labelnames: Sequence[str] = (), buckets: Sequence[float] = LATENCY_BUCKETS
+    ) -> Histogram:
+        return self._get_or_create(Histogram, name, help, labelnames, buckets=buckets)  # type: ignore[return-value]
+
+    def register_collector(self, collector: Collector) -> None:
+        """Call `collector()` whenever the registry is read; it returns `MetricFamily`s."""
+        with self._lock:
+            self._collectors.append(collector)
+
+    def _collected(self) -> list[MetricFamily]:
+        with self._lock:
+            collectors = list(self._collectors)
+        families: list[MetricFamily] = []
+        for collector in collectors:
+            try:
+                families.extend(collector())
+            except Exception as exc:  # noqa: BLE001 - one broken collector must not hide the rest
+                log.error("Collector %r failed: %s", collector, exc)
+        return families
+
+    # Exporters -----------------------------------------------------------
+
+    def render(self) -> str:
+        """Prometheus text exposition format."""
+        with self._lock:
+            metrics = sorted(self._metrics.values(), key=lambda m: m.name)
+        lines: list[str] = []
+        for metric in metrics:
+            lines.append(f"# HELP {metric.name} {_escape_help(metric.help)}")
+            lines.append(f"# TYPE {metric.name} {metric.kind}")
+            for key, child in sorted(metric.series()):
+                labels = list(zip(metric.labelnames, key))
+                if metric.kind == HISTOGRAM:
+                    counts, total = child.get()  # type: ignore[attr-defined]
+                    cumulative = 0
+                    for bound, count in zip(metric.bounds + (math.inf,), counts):  # type: ignore[attr-defined]
+                        cumulative += count
+                        le = "+Inf" if math.isinf(bound) else _format_value(bound)
+                        lines.append(f"{metric.name}_bucket{_format_labels(labels + [('le', le)])} {cumulative}")
+                    lines.append(f"{metric.name}_sum{_format_labels(labels)} {_format_value(total)}")
+                    lines.append(f"{metric.name}_count{_format_labels(labels)} {cumulative}")
+                else:
+                    lines.append(f"{metric.name}{_format_labels(labels)} {_format_value(child.get())}")  # type: ignore[attr-defined]
+        for family in self._collected():
+            lines.append(f"# HELP {family.name} {_escape_help(family.help)}")
+            lines.append(f"# TYPE {family.name} {family.kind}")
+            for values, value in family.samples:
+                labels = list(zip(family.labelnames, (str(v) for v in values)))
+                lines.append(f"{family.name}{_format_labels(labels)} {_format_value(value)}")
+        return "\n".join(lines) + "\n"
+
+    def compact(self) -> dict[str, object]:
+        """Snapshot for the MQTT metrics topic.
+
+        Keys are series names in Prometheus notation (`name{label="v"}` ->
+        `name{v}` to save bytes); values are numbers, except histograms,
+        which become `[count, sum, p50, p90, p99]` estimated from the buckets.
+        Series that have never been touched are left out.
+        """
+        with self._lock:
+            metrics = list(self._metrics.values())
+        values: dict[str, object] = {}
+        for metric in metrics:
+            for key, child in metric.series():
+                name = metric.name + ("{" + ",".join(key) + "}" if key else "")
+                if metric.kind == HISTOGRAM:
+                    counts, total = child.get()  # type: ignore[attr-defined]
+                    n = sum(counts)
+                    if n:
+                        values[name] = [n, round(total, 6)] + [
+                            round(bucket_quantile(metric.bounds, counts, q), 6) for q in (0.5, 0.9, 0.99)  # type: ignore[attr-defined]
+                        ]
+                else:
+                    value = child.get()  # type: ignore[attr-defined]
+                    if value or metric.kind == GAUGE:
+                        values[name] = value
+        for family in self._collected():
+            for labels, value in family.samples:
+                key = ",".join(str(v) for v in labels)
+                values[family.name + ("{" + key + "}" if key else "")] = value
+        return {"ts": round(time.time(), 3), "m": values}
+
+
+def bucket_quantile(bounds: Sequence[float], counts: Sequence[int], q: float) -> float:
+    """Estimate the q-quantile by linear interpolation inside its bucket (as PromQL does)."""
+    total = sum(counts)
+    if not total:
+        return 0.0
+    rank = q * total
+    seen = 0
+    for i, count in enumerate(counts):
+        if count and seen + count >= rank:
+            if i == len(bounds):  # +Inf bucket: the best we can say is "above the last bound"
+                return bounds[-1]
+            lower = bounds[i - 1] if i else 0.0
+            return lower + (bounds[i] - lower) * (rank - seen) / count
+        seen += count
+    return bounds[-1]
+
+
+def _format_value(value: float) -> str:
+    if math.isinf(value):
+        return "+Inf" if value > 0 else "-Inf"
+    if math.isnan(value):
+        return "NaN"
+    if float(value).is_integer() and abs(value) < 1e15:
+        return str(int(value))
+    return repr(float(value))
+
+
+def _escape_help(text: str) -> str:
+    return text.replace("\\", "\\\\").replace("\n", "\\n")
+
+
+def _format_labels(labels: Sequence[tuple[str, str]]) -> str:
+    if not labels:
+        return ""
+    escaped = (
+        f'{name}="' + value.replace("\\", "\\\\").replace("\n", "\\n").replace('"', '\\"') + '"' for name, value in labels
+    )
+    return "{" + ",".join(escaped) + "}"
+
+
+def compact_payload(registry: Registry) -> str:
+    return json.dumps(registry.compact(), separators=(",", ":"))
+
+
+class _Handler(BaseHTTPRequestHandler):
+    server: "_MetricsHTTPServer"
+
+    def do_GET(self) -> None:  # noqa: N802 - http.server naming
+        if self.path.split("?", 1)[0] not in ("/metrics", "/"):
+            self.send_error(404)
+            return
+        body = self.server.registry.render().encode("utf-8")
+        self.send_response(200)
+        self.send_header("Content-Type", METRICS_CONTENT_TYPE)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format: str, *args: object) -> None:  # scrapes every few seconds; keep the console quiet
+        pass
+
+
+class _MetricsHTTPServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address: tuple[str, int], registry: Registry) -> None:
+        self.registry = registry
+        super().__init__(address, _Handler)
+
+
+class MetricsHttpServer:
+    """Serves `registry.render()` at /metrics from a background thread.
+
+    Binds to 127.0.0.1 by default: the endpoint is for a scraper on the Pi
+    itself (or an SSH tunnel), not for the show network.
+    """
+
+    def __init__(self, registry: Registry, host: str = "127.0.0.1", port: int = DEFAULT_METRICS_PORT) -> None:
+        self._server = _MetricsHTTPServer((host, port), registry)
+        self._thread: threading.Thread | None = None
+
+    @property
+    def url(self) -> str:
+        host, port = self._server.server_address[:2]
+        return f"http://{host}:{port}/metrics"
+
+    def start(self) -> "MetricsHttpServer":
+        self._thread = threading.Thread(target=self._server.serve_forever, name="metrics-http", daemon=True)
+        self._thread.start()
+        log.info("Serving %s", self.url)
+        return self
+
+    def stop(self) -> None:
+        self._server.shutdown()
+        self._server.server_close()
+        if self._thread is not None:
+            self._thread.join(timeout=1.0)
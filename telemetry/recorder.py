@@ -0,0 +1,339 @@
+"""Recorder service: persist every robot's state and event topics to disk.
+
+Subscribes to `siggraph/+/state<suffix>` for one wire format plus the
+event topics (`commands`, `llm/text` by default) and appends one row per
+message to columnar files (see colfile.py):
+
+    <out>/<device_id>/state/<YYYYmmdd-HH>.tcol    one file per robot and UTC hour
+    <out>/<device_id>/events/<YYYYmmdd-HH>.tcol
+
+The state table has the `PiState` fields plus `recv_ts` (recorder clock,
+the time column) and `latency_ms` (receive minus Pi timestamp; includes the
+clock offset unless the recorder runs on the Pi or the clocks are synced).
+The events table keeps `kind` ("commands:speak", "llm/text:begin", ...)
+and the raw payload text.
+
+The network thread only decodes the frame and appends a row to per-column
+lists, a few microseconds per message. Compression and file writes run on
+one background writer thread, so hundreds of Hz per robot cost a few
+percent of a core at most (see `bench_recorder.py`). Audio is not
+recorded here.
+
+Run from the repository root:
+    python3 -m telemetry.recorder --out recordings --format bin
+"""
+
+from __future__ import annotations
+
+import argparse
+import calendar
+import json
+import os
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from operator import attrgetter
+from pathlib import Path
+from typing import Any
+
+from mqtt.pi_mqtt_app import BROKER_HOST, BROKER_PORT, KEEPALIVE
+from mqtt.pi_state import PI_STATE_FLOAT_FIELDS, PiState
+from mqtt.state_codec import STATE_FORMAT_SUFFIXES, StateDecoder
+from mqtt.topics import TOPIC_ROOT, all_devices, device_from_topic
+from mqtt.transport import PahoTransport, Transport
+
+from .colfile import CATEGORY, DEFAULT_GROUP_ROWS, TEXT, ColumnWriter
+from .ringlog import get_logger
+
+
+log = get_logger("MQTT")
+
+RECORD_FORMATS = ("json", "bin")
+DEFAULT_EVENT_SUFFIXES = ("commands", "llm/text")
+SEGMENT_SECONDS = 3600
+SEGMENT_SUFFIX = ".tcol"
+
+STATE_TABLE = "state"
+EVENTS_TABLE = "events"
+TIME_COLUMN = "recv_ts"
+
+STATE_SCHEMA: list[tuple[str, str]] = [
+    (TIME_COLUMN, "d"),
+    ("timestamp", "d"),
+    ("latency_ms", "f"),
+    *[(name, "f") for name in PI_STATE_FLOAT_FIELDS],
+    ("eyes_open", "B"),
+    ("is_speaking", "B"),
+    ("app_state", CATEGORY),
+    ("dialogue", CATEGORY),
+]
+STATE_HIST_COLUMNS = ("latency_ms",)
+
+EVENTS_SCHEMA: list[tuple[str, str]] = [
+    (TIME_COLUMN, "d"),
+    ("kind", CATEGORY),
+    ("payload", TEXT),
+]
+
+_state_floats = attrgetter(*PI_STATE_FLOAT_FIELDS)
+
+
+def segment_name(t: float) -> str:
+    return time.strftime("%Y%m%d-%H", time.gmtime(t))
+
+
+def segment_start(name: str) -> float:
+    """UTC start time of a segment named by `segment_name`."""
+    return float(calendar.timegm(time.strptime(name, "%Y%m%d-%H")))
+
+
+def list_segments(root: str | os.PathLike, device_id: str, table: str,
+                  t_from: float | None = None, t_to: float | None = None) -> list[Path]:
+    """Segment files of one robot's table that may hold rows in `[t_from, t_to)`."""
+    found = []
+    for path in Path(root, device_id, table).glob("*" + SEGMENT_SUFFIX):
+        name, _, restart = path.name[:-len(SEGMENT_SUFFIX)].partition(".")
+        try:
+            start = segment_start(name)
+        except ValueError:
+            continue
+        if (t_to is None or start < t_to) and (t_from is None or start + SEGMENT_SECONDS > t_from):
+            found.append((start, int(restart or 0), path))
+    return [path for _, _, path in sorted(found)]
+
+
+def list_devices(root: str | os.PathLike) -> list[str]:
+    return sorted(p.name for p in Path(root).iterdir() if p.is_dir()) if Path(root).is_dir() else []
+
+
+def _new_segment_path(directory: Path, name: str) -> Path:
+    """Never overwrite: a restart within the same hour starts `name.1.tcol`, ..."""
+    directory.mkdir(parents=True, exist_ok=True)
+    path = directory / (name + SEGMENT_SUFFIX)
+    n = 0
+    while path.exists():
+        n += 1
+        path = directory / f"{name}.{n}{SEGMENT_SUFFIX}"
+    return path
+
+
+class _Table:
+    """One robot's table: the open segment writer, rotated every UTC hour."""
+
+    __slots__ = ("directory", "schema", "hist_columns", "meta", "writer", "segment")
+
+    def __init__(self, directory: Path, schema: list[tuple[str, str]], hist_columns: tuple[str, ...], meta: dict) -> None:
+        self.directory = directory
+        self.schema = schema
+        self.hist_columns = hist_columns
+        self.meta = meta
+        self.writer: ColumnWriter | None = None
+        self.segment = -1
+
+
+class TelemetryRecorder:
+    """Follows all robots and appends their state and events to segment files."""
+
+    def __init__(
+        self,
+        out_dir: str | os.PathLike,
+        broker_host: str = BROKER_HOST,
+        broker_port: int = BROKER_PORT,
+        fmt: str = "bin",
+        event_suffixes: tuple[str, ...] = DEFAULT_EVENT_SUFFIXES,
+        transport: Transport | None = None,
+        client_id: str = "telemetry-recorder",
+        group_rows: int = DEFAULT_GROUP_ROWS,
+    ) -> None:
+        if fmt not in RECORD_FORMATS:
+            raise ValueError(f"Can record {RECORD_FORMATS} state streams, not {fmt!r}")
+        self.out_dir = Path(out_dir)
+        self.broker_host = broker_host
+        self.broker_port = broker_port
+        self.fmt = fmt
+        self.state_filter = all_devices("state" + STATE_FORMAT_SUFFIXES[fmt])
+        self.event_suffixes = tuple(event_suffixes)
+        self.group_rows = group_rows
+
+        self._decoders: dict[str, Any] = {}
+        self._tables: dict[tuple[str, str], _Table] = {}
+        self._lock = threading.Lock()  # tables are rotated/closed from the main thread too
+        self._executor = ThreadPoolExecutor(max_workers=1, thread_name_prefix="tcol-writer")
+        self.rows: dict[str, int] = {}
+        self.decode_errors = 0
+        self.unrouted = 0
+
+        transport = transport if transport is not None else PahoTransport()
+        self.client = transport.create_client(client_id)
+        self.client.on_connect = self._on_connect
+        self.client.on_message = self._on_message
+
+    # MQTT ---------------------------------------------------------------
+
+    def _on_connect(self, client, userdata, flags, rc):  # type: ignore[override]
+        if rc != 0:
+            log.error("Recorder failed to connect, return code %s", rc)
+            return
+        # Binary decoders intern dialogue strings; start afresh after a gap.
+        self._decoders.clear()
+        client.subscribe(self.state_filter, qos=0)
+        for suffix in self.event_suffixes:
+            client.subscribe(all_devices(suffix), qos=0)
+        log.info("Recorder subscribed to %s and %s -> %s", self.state_filter, ", ".join(self.event_suffixes), self.out_dir)
+
+    def _on_message(self, client, userdata, msg):  # type: ignore[override]
+        received_at = time.time()
+        device_id = device_from_topic(msg.topic)
+        if device_id is None:
+            self.unrouted += 1
+            return
+        if msg.topic == f"{TOPIC_ROOT}/{device_id}/state{STATE_FORMAT_SUFFIXES[self.fmt]}":
+            self.record_state(device_id, msg.payload, received_at)
+        else:
+            self.record_event(device_id, msg.topic[len(TOPIC_ROOT) + len(device_id) + 2:], msg.payload, received_at)
+
+    # Recording ----------------------------------------------------------
+
+    def record_state(self, device_id: str, payload: bytes, received_at: float) -> None:
+        try:
+            if self.fmt == "bin":
+                decoder = self._decoders.get(device_id)
+                if decoder is None:
+                    decoder = self._decoders[device_id] = StateDecoder()
+                state = decoder.decode(payload)
+            else:
+                state = PiState(**json.loads(payload))
+        except (ValueError, TypeError, KeyError) as exc:
+            self.decode_errors += 1
+            if self.decode_errors == 1:
+                log.warning("Recorder: bad state frame from %s: %s", device_id, exc)
+            return
+        self._append(device_id, STATE_TABLE, received_at, (
+            received_at,
+            state.timestamp,
+            (received_at - state.timestamp) * 1000.0,
+            *_state_floats(state),
+            state.eyes_open,
+            state.is_speaking,
+            state.app_state,
+            state.dialogue,
+        ))
+
+    def record_event(self, device_id: str, suffix: str, payload: bytes | str, received_at: float) -> None:
+        text = payload.decode("utf-8", errors="replace") if isinstance(payload, (bytes, bytearray)) else str(payload)
+        try:
+            message = json.loads(text)
+            op = (message.get("cmd") or message.get("op")) if isinstance(message, dict) else None
+        except json.JSONDecodeError:
+            op = None
+        kind = f"{suffix}:{op}" if isinstance(op, str) else suffix
+        self._append(device_id, EVENTS_TABLE, received_at, (received_at, kind, text))
+
+    def _append(self, device_id: str, table_name: str, t: float, row: tuple) -> None:
+        with self._lock:
+            table = self._tables.get((device_id, table_name))
+            if table is None:
+                table = self._tables[(device_id, table_name)] = self._new_table(device_id, table_name)
+            segment = int(t // SEGMENT_SECONDS)
+            if segment != table.segment:
+                self._rotate(table, segment, t)
+            table.writer.append(row)
+            self.rows[device_id] = self.rows.get(device_id, 0) + 1
+
+    def _new_table(self, device_id: str, table_name: str) -> _Table:
+        meta = {"device_id": device_id, "table": table_name, "format": self.fmt}
+        if table_name == STATE_TABLE:
+            return _Table(self.out_dir / device_id / table_name, STATE_SCHEMA, STATE_HIST_COLUMNS, meta)
+        return _Table(self.out_dir / device_id / table_name, EVENTS_SCHEMA, (), meta)
+
+    def _rotate(self, table: _Table, segment: int, t: float) -> None:
+        if table.writer is not None:
+            table.writer.close()
+        table.segment = segment
+        table.writer = ColumnWriter(
+            _new_segment_path(table.directory, segment_name(t)),
+            table.schema,
+            TIME_COLUMN,
+            group_rows=self.group_rows,
+            hist_columns=table.hist_columns,
+            meta=table.meta,
+            executor=self._executor,
+        )
+
+    def close_idle_segments(self, now: float | None = None) -> None:
+        """Finish segments whose hour is over (robots that went quiet)."""
+        segment = int((time.time() if now is None else now) // SEGMENT_SECONDS)
+        with self._lock:
+            for table in self._tables.values():
+                if table.writer is not None and table.segment < segment:
+                    table.writer.close()
+                    table.writer = None
+                    table.segment = -1
+
+    def open_writers(self) -> list[ColumnWriter]:
+        with self._lock:
+            return [t.writer for t in self._tables.values() if t.writer is not None]
+
+    # Public API ---------------------------------------------------------
+
+    def connect(self) -> None:
+        self.client.connect(self.broker_host, self.broker_port, KEEPALIVE)
+        self.client.loop_start()
+
+    def stop(self) -> None:
+        try:
+            self.client.disconnect()
+        finally:
+            self.client.loop_stop()
+            self.close()
+
+    def close(self) -> None:
+        """Seal every open segment (writes partial groups and footers)."""
+        with self._lock:
+            for table in self._tables.values():
+                if table.writer is not None:
+                    table.writer.close()
+                    table.writer = None
+                    table.segment = -1
+        self._executor.shutdown(wait=True)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Record all robots' state and event topics to columnar files.")
+    parser.add_argument("--out", default="recordings", help="Output directory (default: %(default)s).")
+    parser.add_argument("--host", default=BROKER_HOST, help="Broker host (default: %(default)s).")
+    parser.add_argument("--port", type=int, default=BROKER_PORT, help="Broker port (default: %(default)s).")
+    parser.add_argument("--format", dest="fmt", choices=RECORD_FORMATS, default="bin",
+                        help="State stream to record (default: %(default)s).")
+    parser.add_argument("--events", nargs="*", default=list(DEFAULT_EVENT_SUFFIXES),
+                        help="Per-device event topic suffixes to record (default: %(default)s).")
+    parser.add_argument("--group-rows", type=int, default=DEFAULT_GROUP_ROWS, help="Rows per row group (default: %(default)s).")
+    parser.add_argument("--print-interval", type=float, default=10.0, help="Seconds between status lines (default: %(default)s).")
+    args = parser.parse_args()
+
+    recorder = TelemetryRecorder(args.out, args.host, args.port, fmt=args.fmt,
+                                 event_suffixes=tuple(args.events), group_rows=args.group_rows)
+    recorder.connect()
+    stop = threading.Event()
+    last_rows = 0
+    last_wall, last_cpu = time.monotonic(), time.process_time()
+    try:
+        while not stop.wait(args.print_interval):
+            recorder.close_idle_segments()
+            wall, cpu = time.monotonic(), time.process_time()
+            rows = sum(recorder.rows.values())
+            written = sum(w.bytes_written for w in recorder.open_writers())
+            print(
+                f"[MQTT] Recorder: {len(recorder.rows)} robots, {(rows - last_rows) / (wall - last_wall):.0f} rows/s, "
+                f"CPU {100.0 * (cpu - last_cpu) / (wall - last_wall):.1f}%, open segments {written / 1e6:.1f} MB, "
+                f"decode errors {recorder.decode_errors}"
+            )
+            last_rows, last_wall, last_cpu = rows, wall, cpu
+    except KeyboardInterrupt:
+        pass
+    finally:
+        recorder.stop()
+
+
+if __name__ == "__main__":
+    main()
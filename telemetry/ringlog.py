@@ -0,0 +1,278 @@
+"""Asynchronous logger: callers append to a ring buffer, a thread writes.
+
+A `print` on the MQTT network thread, in a step loop or in `chat_stream`
+writes synchronously to the terminal or journald; when that sink is slow
+the caller stalls with it. Here a log call only appends a fixed-shape
+record `(seq, time, level, logger, format, args, suppressed)` to a
+preallocated ring of slots. The slot index comes from an `itertools.count`
+(atomic under the GIL) and the store is a single list assignment, so
+producers never take a lock. A background thread formats the records
+(`format % args`) and writes them in batches every `flush_interval`
+(immediately for errors).
+
+- Level filtering happens at the call site: disabled levels are bound to a
+  no-op, so `log.debug(...)` costs one empty call. Guard expensive
+  arguments with `if log.isEnabledFor(DEBUG):`.
+- Rate limiting: each call site (format string) may log at most
+  `rate_limit` records per second; the rest are counted, and the next
+  record that gets through says how many were suppressed.
+- When producers outrun the writer the oldest records are overwritten and
+  the writer reports how many were dropped; logging never blocks.
+
+Arguments are formatted later on the writer thread, so pass values, not
+objects that the caller goes on mutating.
+
+The calls used here (`debug/info/warning/error/exception`, `isEnabledFor`,
+`setLevel`) match `logging.Logger`, so modules that also run standalone
+can fall back to it:
+
+    try:
+        from telemetry.ringlog import get_logger
+    except ImportError:  # run without the repo root on sys.path
+        from logging import getLogger as get_logger
+
+Environment: LOG_LEVEL (default INFO), LOG_RATE_LIMIT (records per second
+per call site, default 20; 0 = unlimited).
+"""
+
+from __future__ import annotations
+
+import atexit
+import itertools
+import os
+import sys
+import threading
+import time
+import traceback
+from logging import DEBUG, ERROR, INFO, WARNING
+from typing import Any, Callable, TextIO
+
+DEFAULT_CAPACITY = 8192
+DEFAULT_FLUSH_INTERVAL_SECONDS = 0.05
+DEFAULT_RATE_LIMIT = 20.0  # per call site per second
+
+LEVEL_NAMES = {DEBUG: "DEBUG", INFO: "INFO", WARNING: "WARNING", ERROR: "ERROR"}
+_LEVEL_TAGS = {DEBUG: "D", INFO: "I", WARNING: "W", ERROR: "E"}
+
+
+def parse_level(level: int | str) -> int:
+    if isinstance(level, int):
+        return level
+    for value, name in LEVEL_NAMES.items():
+        if name == level.upper() or (name == "WARNING" and level.upper() == "WARN"):
+            return value
+    raise ValueError(f"Unknown log level {level!r}")
+
+
+def _noop(msg: str, *args: Any) -> None:
+    pass
+
+
+class RingLog:
+    """The shared ring and its writer thread."""
+
+    def __init__(
+        self,
+        capacity: int = DEFAULT_CAPACITY,
+        stream: TextIO | None = None,
+        flush_interval: float = DEFAULT_FLUSH_INTERVAL_SECONDS,
+    ) -> None:
+        if capacity < 2 or capacity & (capacity - 1):
+            raise ValueError("capacity must be a power of two")
+        self.capacity = capacity
+        self.stream = stream  # None = sys.stdout at write time (so redirection still works)
+        self.flush_interval = flush_interval
+        self.slots: list[tuple | None] = [None] * capacity
+        self.mask = capacity - 1
+        self.next_seq = itertools.count().__next__
+        self.wake = threading.Event()
+        self.written = 0
+        self.dropped = 0
+        self._read = 0
+        self._drain_lock = threading.Lock()  # writer thread vs flush() from other threads
+        self._stop = threading.Event()
+        self._thread: threading.Thread | None = None
+
+    def start(self) -> "RingLog":
+        if self._thread is None:
+            self._thread = threading.Thread(target=self._run, name="ringlog-writer", daemon=True)
+            self._thread.start()
+        return self
+
+    def _run(self) -> None:
+        while not self._stop.is_set():
+            self.wake.wait(self.flush_interval)
+            self.wake.clear()
+            self.flush()
+
+    def flush(self) -> None:
+        """Format and write every record published so far (callable from any thread)."""
+        with self._drain_lock:
+            lines = self._drain()
+            if lines:
+                stream = self.stream or sys.stdout
+                try:
+                    stream.write("".join(lines))
+                    stream.flush()
+                except (OSError, ValueError):  # closed or broken sink; nothing sensible left to do
+                    pass
+
+    def _drain(self) -> list[str]:
+        slots, mask, capacity = self.slots, self.mask, self.capacity
+        lines: list[str] = []
+        read = self._read
+        written = 0
+        while True:
+            record = slots[read & mask]
+            if record is None or record[0] < read:
+                break  # not written yet (or a producer is between its seq and its store)
+            seq = record[0]
+            if seq > read:
+                # Lapped. Only the newest `capacity` records survive; find the
+                # newest (a scan of the ring, but only when records were lost).
+                newest = max(r[0] for r in slots if r is not None)
+                skip_to = newest - capacity + 1
+                self.dropped += skip_to - read
+                lines.append(f"{_clock(time.time())} W [log] {skip_to - read} records dropped (writer fell behind)\n")
+                read = skip_to
+                continue
+            lines.append(_format(record))
+            written += 1
+            read += 1
+        self.written += written
+        self._read = read
+        return lines
+
+    def close(self) -> None:
+        self._stop.set()
+        self.wake.set()
+        if self._thread is not None:
+            self._thread.join(timeout=1.0)
+            self._thread = None
+        self.flush()
+
+
+def _clock(t: float) -> str:
+    return time.strftime("%H:%M:%S", time.localtime(t)) + f".{int(t * 1000) % 1000:03d}"
+
+
+def _format(record: tuple) -> str:
+    _, t, level, name, msg, args, suppressed = record
+    if args:
+        try:
+            msg = msg % args
+        except (TypeError, ValueError) as exc:
+            msg = f"{msg!r} % {args!r} failed: {exc}"
+    if suppressed:
+        msg += f" ({suppressed} similar suppressed)"
+    return f"{_clock(t)} {_LEVEL_TAGS.get(level, '?')} [{name}] {msg}\n"
+
+
+class Logger:
+    """Named view onto the ring. Obtain with `get_logger(name)`."""
+
+    def __init__(self, name: str, ring: RingLog, level: int, rate_limit: float) -> None:
+        self.name = name
+        self.ring = ring
+        self.rate_limit = rate_limit
+        # format string -> [window start, records in window, suppressed]
+        self._sites: dict[str, list] = {}
+        self.level = level
+        self.setLevel(level)
+
+    def setLevel(self, level: int | str) -> None:  # noqa: N802 - logging.Logger compatible
+        self.level = parse_level(level)
+        for value, method in ((DEBUG, "debug"), (INFO, "info"), (WARNING, "warning"), (ERROR, "error")):
+            setattr(self, method, self._emitter(value) if value >= self.level else _noop)
+
+    def isEnabledFor(self, level: int) -> bool:  # noqa: N802 - logging.Logger compatible
+        return level >= self.level
+
+    def exception(self, msg: str, *args: Any) -> None:
+        """`error` with the current traceback appended (formatted here: errors are rare)."""
+        self.error(msg + "\n%s", *args, traceback.format_exc().rstrip())
+
+    def _emitter(self, level: int) -> Callable[..., None]:
+        ring = self.ring
+        slots, mask, next_seq = ring.slots, ring.mask, ring.next_seq
+        name = self.name
+        sites = self._sites
+        limit = self.rate_limit
+        wake = ring.wake if level >= ERROR else None
+        clock = time.time
+
+        def emit(msg: str, *args: Any) -> None:
+            now = clock()
+            suppressed = 0
+            if limit:
+                site = sites.get(msg)
+                if site is None:
+                    site = sites[msg] = [now, 0, 0]
+                elif now - site[0] >= 1.0:
+                    suppressed = site[2]
+                    site[0], site[1], site[2] = now, 0, 0
+                if site[1] >= limit:
+                    site[2] += 1
+                    return
+                site[1] += 1
+            seq = next_seq()
+            slots[seq & mask] = (seq, now, level, name, msg, args, suppressed)
+            if wake is not None:
+                wake.set()
+
+        return emit
+
+    # Replaced per instance by setLevel(); declared for type checkers and readers.
+    debug: Callable[..., None]
+    info: Callable[..., None]
+    warning: Callable[..., None]
+    error: Callable[..., None]
+
+
+_ring: RingLog | None = None
+_loggers: dict[str, Logger] = {}
+_config_lock = threading.Lock()
+_level = parse_level(os.environ.get("LOG_LEVEL", "INFO"))
+_rate_limit = float(os.environ.get("LOG_RATE_LIMIT", DEFAULT_RATE_LIMIT))
+
+
+def _shared_ring() -> RingLog:
+    global _ring
+    if _ring is None:
+        _ring = RingLog().start()
+        atexit.register(_ring.close)
+    return _ring
+
+
+def get_logger(name: str) -> Logger:
+    """The logger for `name` (e.g. "MQTT", "stepper"); starts the writer thread on first use."""
+    logger = _loggers.get(name)
+    if logger is None:
+        with _config_lock:
+            logger = _loggers.get(name)
+            if logger is None:
+                logger = _loggers[name] = Logger(name, _shared_ring(), _level, _rate_limit)
+    return logger
+
+
+def configure(level: int | str | None = None, rate_limit: float | None = None, stream: TextIO | None = None) -> None:
+    """Change the level / rate limit of every logger (existing and future) and the output stream."""
+    global _level, _rate_limit
+    with _config_lock:
+        if rate_limit is not None:
+            _rate_limit = rate_limit
+            for logger in _loggers.values():
+                logger.rate_limit = rate_limit
+        if level is not None:
+            _level = parse_level(level)
+        for logger in _loggers.values():
+            # Also rebinds the emitters to the new rate limit.
+            logger.setLevel(_level if level is not None else logger.level)
+        if stream is not None:
+            _shared_ring().stream = stream
+
+
+def flush() -> None:
+    """Write everything logged so far (e.g. before printing an interactive prompt)."""
+    if _ring is not None:
+        _ring.flush()
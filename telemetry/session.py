@@ -0,0 +1,453 @@
+"""Record a full voice session and replay it without the hardware.
+
+A session file is one `.tcol` container (see colfile.py) with one row per
+event, in order:
+
+    t       f64   seconds since the recording started (perf_counter)
+    stream  cat   turn, mic, stt, llm, tts, play, motor, mqtt_out, mqtt_in
+    kind    cat   e.g. llm/token, tts/synthesized, motor/start_talking
+    turn    u32   conversation turn (0 before the first)
+    meta    str   JSON: text, latencies, sample format, topic, ...
+    data    bin   raw bytes: mic PCM, TTS MP3, MQTT payloads
+
+Row groups carry the time-range index and per-stream counts, and a
+recording cut short (crash, power loss) is still readable up to its last
+sealed group.
+
+Recording wraps the pipeline's seams: `wrap_llm`, `wrap_synthesize`,
+`wrap_play`, `wrap_motors`, `tap_publish` and `record_command`; the mic,
+transcript and route are recorded by the caller (`record_utterance`,
+`record_transcript`, `record_route`).
+
+Replay swaps in stand-ins built from a `SessionLog`: `ReplayMicrophone`
+(recorded PCM after the recorded listening time), `ReplayStt`,
+`ReplayLlm` (recorded tokens at their recorded offsets), `ReplayTts`,
+`ReplayPlayer`, `ReplayTurns` (each turn's recorded route and filler) and
+`replay_commands` for remote MQTT commands. Each
+stand-in hands out its stream's events in order and waits the recorded
+durations through a `Pacer`, so `speed=1` reproduces the original timing,
+`speed=4` runs four times faster and `speed=0` does not wait at all.
+Everything between the stand-ins (bus, text/audio streaming, MQTT, the
+command dispatcher) runs for real and can be profiled.
+"""
+
+from __future__ import annotations
+
+import json
+import os
+import threading
+import time
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from typing import Any, Callable, Iterator
+
+from .colfile import BLOB, CATEGORY, TEXT, ColumnReader, ColumnWriter
+from .ringlog import get_logger
+
+
+SESSION_SCHEMA: list[tuple[str, str]] = [
+    ("t", "d"),
+    ("stream", CATEGORY),
+    ("kind", CATEGORY),
+    ("turn", "I"),
+    ("meta", TEXT),
+    ("data", BLOB),
+]
+SESSION_GROUP_ROWS = 256  # rows carry audio; keep groups (and what a crash loses) small
+
+STREAM_TURN = "turn"
+STREAM_MIC = "mic"
+STREAM_STT = "stt"
+STREAM_LLM = "llm"
+STREAM_TTS = "tts"
+STREAM_PLAY = "play"
+STREAM_MOTOR = "motor"
+STREAM_MQTT_OUT = "mqtt_out"
+STREAM_MQTT_IN = "mqtt_in"
+
+log = get_logger("Session")
+
+
+class SessionReplayError(RuntimeError):
+    """Raised when the pipeline asks a stand-in for more than was recorded."""
+
+
+# Recording ------------------------------------------------------------------
+
+
+class SessionRecorder:
+    """Thread-safe event log for one session (pipeline, MQTT and command threads)."""
+
+    def __init__(self, path: str | os.PathLike, meta: dict[str, Any] | None = None,
+                 clock: Callable[[], float] = time.perf_counter) -> None:
+        self.path = Path(path)
+        self.clock = clock
+        self.turn = 0
+        self._llm_requests = 0
+        self._start = clock()
+        self._lock = threading.Lock()
+        self._writer = ColumnWriter(
+            self.path, SESSION_SCHEMA, "t", group_rows=SESSION_GROUP_ROWS,
+            meta={"started_at": time.time(), **(meta or {})}, max_group_seconds=10.0,
+        )
+
+    def now(self) -> float:
+        return self.clock() - self._start
+
+    def record(self, stream: str, kind: str, meta: dict[str, Any] | None = None,
+               data: bytes = b"", t: float | None = None) -> None:
+        text = json.dumps(meta or {}, ensure_ascii=False)
+        with self._lock:
+            self._writer.append((self.now() if t is None else t, stream, f"{stream}/{kind}", self.turn, text, data))
+
+    def next_llm_request(self) -> int:
+        """Id tying an LLM request to its tokens (a turn may make several, e.g. a backup fallback)."""
+        with self._lock:
+            self._llm_requests += 1
+            return self._llm_requests
+
+    def begin_turn(self) -> None:
+        with self._lock:
+            self.turn += 1
+        self.record(STREAM_TURN, "begin")
+
+    def end_turn(self) -> None:
+        self.record(STREAM_TURN, "end")
+
+    def record_utterance(self, pcm: bytes, sample_rate: int, sample_width: int, listen_s: float) -> None:
+        self.record(STREAM_MIC, "utterance",
+                    {"sample_rate": sample_rate, "sample_width": sample_width, "listen_s": listen_s}, pcm)
+
+    def record_transcript(self, text: str | None, latency_s: float) -> None:
+        self.record(STREAM_STT, "transcript", {"text": text, "latency_s": latency_s})
+
+    def record_route(self, route: str, numbers: tuple[int, ...] = ()) -> None:
+        """Who answered the turn: an intent name (with its numbers) or "llm"."""
+        self.record(STREAM_TURN, "route", {"route": route, "numbers": list(numbers)})
+
+    def record_command(self, command: Any) -> None:
+        """A remote command as received (re-offered to the dispatcher on replay)."""
+        self.record(STREAM_MQTT_IN, "command", {"cmd": command.KIND, **asdict(command)})
+
+    def wrap_llm(self, client: Any) -> "RecordingLlm":
+        return RecordingLlm(client, self)
+
+    def wrap_synthesize(self, synthesize: Callable[..., Path]) -> Callable[..., Path]:
+        def recorded(text: str, output_path: str | os.PathLike, lang: str = "en") -> Path:
+            started = self.clock()
+            path = synthesize(text, output_path, lang=lang)
+            latency = self.clock() - started
+            self.record(STREAM_TTS, "synthesized", {"text": text, "lang": lang, "latency_s": latency},
+                        Path(path).read_bytes())
+            return path
+        return recorded
+
+    def wrap_play(self, play: Callable[[Any], None]) -> Callable[[Any], None]:
+        def recorded(path: Any) -> None:
+            started = self.clock()
+            try:
+                play(path)
+            finally:
+                self.record(STREAM_PLAY, "played", {"duration_s": self.clock() - started})
+        return recorded
+
+    def wrap_motors(self, motors: Any) -> "RecordingMotors":
+        return RecordingMotors(motors, self)
+
+    def tap_publish(self, publish: Callable[..., Any]) -> Callable[..., Any]:
+        """Record outgoing MQTT publishes (lazily encoded payloads are noted, not encoded)."""
+        def recorded(topic: str, payload: Any, retain: bool = False) -> Any:
+            if callable(payload):
+                self.record(STREAM_MQTT_OUT, "publish", {"topic": topic, "lazy": True})
+            else:
+                data = payload.encode("utf-8") if isinstance(payload, str) else bytes(payload)
+                self.record(STREAM_MQTT_OUT, "publish", {"topic": topic}, data)
+            return publish(topic, payload, retain=retain)
+        return recorded
+
+    def close(self) -> None:
+        with self._lock:
+            self._writer.close()
+
+
+class RecordingLlm:
+    """`chat_stream` passthrough that records the request and every token's arrival."""
+
+    def __init__(self, client: Any, recorder: SessionRecorder) -> None:
+        self.client = client
+        self.recorder = recorder
+
+    def chat_stream(self, prompt: str, history: list[Any] | None = None, **options: Any) -> Iterator[str]:
+        recorder = self.recorder
+        messages = [{"role": m.role, "content": m.content} for m in history or []]
+        request = recorder.next_llm_request()
+        recorder.record(STREAM_LLM, "request",
+                        {"request": request, "prompt": prompt, "history": messages, "options": options})
+        started = recorder.now()
+        chunks = 0
+        first = None
+        for chunk in self.client.chat_stream(prompt=prompt, history=history, **options):
+            t = recorder.now()
+            if first is None:
+                first = t - started
+            chunks += 1
+            recorder.record(STREAM_LLM, "token", {"request": request, "text": chunk}, t=t)
+            yield chunk
+        recorder.record(STREAM_LLM, "done", {"request": request, "chunks": chunks, "ttft_s": first,
+                                             "total_s": recorder.now() - started})
+
+
+class RecordingMotors:
+    """Records the motor commands issued to a `MotorController` and forwards them."""
+
+    def __init__(self, motors: Any, recorder: SessionRecorder) -> None:
+        self._motors = motors
+        self._recorder = recorder
+
+    def start_talking_motion(self) -> None:
+        self._recorder.record(STREAM_MOTOR, "start_talking")
+        self._motors.start_talking_motion()
+
+    def stop_talking_motion(self) -> None:
+        self._recorder.record(STREAM_MOTOR, "stop_talking")
+        self._motors.stop_talking_motion()
+
+    def nod_head(self, times: int = 2) -> None:
+        self._recorder.record(STREAM_MOTOR, "nod", {"times": times})
+        self._motors.nod_head(times=times)
+
+    def __getattr__(self, name: str) -> Any:
+        return getattr(self._motors, name)
+
+
+# Reading --------------------------------------------------------------------
+
+
+@dataclass(frozen=True)
+class SessionEvent:
+    t: float
+    stream: str
+    kind: str
+    turn: int
+    meta: dict[str, Any]
+    data: bytes
+
+
+class SessionLog:
+    """All events of a recorded session, in recording order."""
+
+    def __init__(self, path: str | os.PathLike) -> None:
+        with ColumnReader(path) as reader:
+            self.meta = reader.meta
+            self.complete = reader.complete
+            columns = reader.read(["stream", "kind", "turn", "meta", "data"])
+        self.events = [
+            SessionEvent(t, stream, kind, turn, json.loads(meta), bytes(data))
+            for t, stream, kind, turn, meta, data in zip(
+                columns["t"], columns["stream"], columns["kind"], columns["turn"], columns["meta"], columns["data"]
+            )
+        ]
+
+    def select(self, kind: str) -> list[SessionEvent]:
+        return [e for e in self.events if e.kind == kind]
+
+    @property
+    def duration(self) -> float:
+        return self.events[-1].t if self.events else 0.0
+
+    def summary(self) -> str:
+        counts: dict[str, int] = {}
+        for event in self.events:
+            counts[event.kind] = counts.get(event.kind, 0) + 1
+        turns = len(self.select("turn/begin"))
+        listed = ", ".join(f"{kind} {n}" for kind, n in sorted(counts.items()))
+        return f"{turns} turns over {self.duration:.1f} s{'' if self.complete else ' (truncated)'}: {listed}"
+
+
+# Replay ---------------------------------------------------------------------
+
+
+class Pacer:
+    """Waits recorded durations scaled by 1/speed (speed 0: no waiting)."""
+
+    def __init__(self, speed: float = 1.0) -> None:
+        self.speed = speed
+        self._start = time.perf_counter()
+
+    def sleep(self, seconds: float) -> None:
+        if self.speed > 0 and seconds > 0:
+            time.sleep(seconds / self.speed)
+
+    def wait_until(self, t: float, stop: threading.Event | None = None) -> bool:
+        """Wait until recorded session time `t`; False if `stop` was set first."""
+        if self.speed <= 0:
+            return not (stop is not None and stop.is_set())
+        delay = self._start + t / self.speed - time.perf_counter()
+        if stop is not None:
+            return not stop.wait(max(delay, 0.0))
+        if delay > 0:
+            time.sleep(delay)
+        return True
+
+
+class _Cursor:
+    def __init__(self, events: list[SessionEvent], what: str) -> None:
+        self._events = events
+        self._next = 0
+        self._what = what
+
+    def remaining(self) -> int:
+        return len(self._events) - self._next
+
+    @property
+    def taken(self) -> int:
+        return self._next
+
+    def take(self) -> SessionEvent:
+        if self._next >= len(self._events):
+            raise SessionReplayError(f"Recording has no more {self._what} events")
+        event = self._events[self._next]
+        self._next += 1
+        return event
+
+
+class ReplayMicrophone:
+    """Stands in for pressing Enter and speaking into the microphone."""
+
+    def __init__(self, log: SessionLog, pacer: Pacer) -> None:
+        self._turns = _Cursor(log.select("turn/begin"), "turn")
+        self._ends = {e.turn: e.t for e in log.select("turn/end")}
+        self._utterances = _Cursor(log.select("mic/utterance"), "mic")
+        self._pacer = pacer
+        self._last_end = 0.0
+        self.turn = 0  # the recorded turn number being replayed
+
+    def next_turn(self) -> bool:
+        """Wait the recorded idle time before the next turn; False when none are left."""
+        if not self._turns.remaining():
+            return False
+        begin = self._turns.take()
+        self.turn = begin.turn
+        self._pacer.sleep(begin.t - self._last_end)
+        self._last_end = self._ends.get(begin.turn, begin.t)
+        return True
+
+    def listen(self) -> tuple[bytes, int, int]:
+        """Recorded `(pcm, sample_rate, sample_width)` after the recorded listening time."""
+        event = self._utterances.take()
+        self._pacer.sleep(event.meta["listen_s"])
+        return event.data, event.meta["sample_rate"], event.meta["sample_width"]
+
+
+class ReplayTurns:
+    """Per-turn decisions taken while recording, for replay to take again.
+
+    The recorded LLM, TTS and playback events follow the recording's routing:
+    a turn answered by an intent has no LLM request. Replay must route each
+    turn the same way or every later turn gets the wrong events.
+    """
+
+    def __init__(self, log: SessionLog) -> None:
+        self._routes = {e.turn: e.meta for e in log.select("turn/route")}
+        # A filler leaves its own TTS and playback events ahead of the reply's.
+        self._fillers = {
+            e.turn: d["filler"]
+            for e in log.select("turn/budget")
+            for d in e.meta.get("degradations", ())
+            if d.get("action") == "filler" and d.get("filler")
+        }
+
+    def route(self, turn: int) -> tuple[str, tuple[int, ...]] | None:
+        """`(intent name or "llm", numbers)` of a recorded turn; None if not recorded."""
+        meta = self._routes.get(turn)
+        return None if meta is None else (meta["route"], tuple(meta.get("numbers", ())))
+
+    def filler(self, turn: int) -> str | None:
+        """The filler spoken before the reply of a recorded turn, if any."""
+        return self._fillers.get(turn)
+
+
+class ReplayStt:
+    def __init__(self, log: SessionLog, pacer: Pacer) -> None:
+        self._transcripts = _Cursor(log.select("stt/transcript"), "transcript")
+        self._pacer = pacer
+
+    def transcribe(self) -> str | None:
+        event = self._transcripts.take()
+        self._pacer.sleep(event.meta["latency_s"])
+        return event.meta["text"]
+
+
+class ReplayLlm:
+    """`chat_stream` stand-in: the recorded reply at the recorded token timing."""
+
+    def __init__(self, log: SessionLog, pacer: Pacer) -> None:
+        self._requests = _Cursor(log.select("llm/request"), "llm request")
+        # Tokens per request, in request order. A turn can make several requests
+        # (a backup LLM after the primary fails); recordings without request ids
+        # give each token to the request before it.
+        self._tokens: list[list[SessionEvent]] = []
+        positions: dict[int, int] = {}
+        for event in log.events:
+            if event.kind == "llm/request":
+                if "request" in event.meta:
+                    positions[event.meta["request"]] = len(self._tokens)
+                self._tokens.append([])
+            elif event.kind == "llm/token" and self._tokens:
+                index = positions.get(event.meta["request"], -1) if "request" in event.meta else -1
+                self._tokens[index].append(event)
+        self._pacer = pacer
+
+    def chat_stream(self, prompt: str, history: list[Any] | None = None, **options: Any) -> Iterator[str]:
+        """`options` (max_tokens, timeout) are accepted and ignored: the recorded reply is replayed as is."""
+        tokens = self._tokens[self._requests.taken] if self._requests.remaining() else []
+        request = self._requests.take()
+        if prompt != request.meta["prompt"]:
+            log.warning("Replayed LLM prompt differs from the recording: %r vs %r", prompt, request.meta["prompt"])
+        previous = request.t
+        for token in tokens:
+            self._pacer.sleep(token.t - previous)
+            previous = token.t
+            yield token.meta["text"]
+
+
+class ReplayTts:
+    """`synthesize_to_file` stand-in: writes the recorded MP3 after the recorded latency."""
+
+    def __init__(self, log: SessionLog, pacer: Pacer) -> None:
+        self._outputs = _Cursor(log.select("tts/synthesized"), "tts")
+        self._pacer = pacer
+
+    def synthesize(self, text: str, output_path: str | os.PathLike, lang: str = "en") -> Path:
+        event = self._outputs.take()
+        self._pacer.sleep(event.meta["latency_s"])
+        path = Path(output_path)
+        path.write_bytes(event.data)
+        return path
+
+
+class ReplayPlayer:
+    """`play_audio_blocking` stand-in: silent, for the recorded playback time."""
+
+    def __init__(self, log: SessionLog, pacer: Pacer) -> None:
+        self._plays = _Cursor(log.select("play/played"), "playback")
+        self._pacer = pacer
+
+    def play(self, path: Any) -> None:
+        self._pacer.sleep(self._plays.take().meta["duration_s"])
+
+
+def replay_commands(log: SessionLog, offer: Callable[[bytes], None], pacer: Pacer,
+                    stop: threading.Event) -> threading.Thread:
+    """Re-offer recorded remote commands to a dispatcher at their recorded times."""
+    commands = log.select("mqtt_in/command")
+
+    def run() -> None:
+        for event in commands:
+            if not pacer.wait_until(event.t, stop):
+                return
+            offer(json.dumps(event.meta).encode("utf-8"))
+
+    thread = threading.Thread(target=run, name="replay-commands", daemon=True)
+    thread.start()
+    return thread